@@ -0,0 +1,260 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#include "application_bench.h"
+#include <xil_types.h>
+#include <xil_printf.h>
+#include <xil_io.h>
+#include <xtime_l.h>
+#include "axi_1wire_host.h"
+#include "w1_bench.h"
+#include "w1_crc.h"
+#include "w1_temp.h"
+#include "sleep.h"
+
+#define BENCH_PATH		"baremetal"
+#define BENCH_MAX_ROMS		16
+#define BENCH_MAX_SAMPLES	1024
+
+#define W1_FAMILY_DS2431	0x2D
+#define W1_FAMILY_DS2433	0x23
+#define W1_FAMILY_DS28EC20	0x43
+
+static u64 lat_ns[BENCH_MAX_SAMPLES];
+static u8 roms[BENCH_MAX_ROMS][8];
+static u8 eeprom[W1_BENCH_EEPROM_BYTES];
+
+/* Elapsed time between two XTime_GetTime() samples, in ns */
+static u64 bench_ns(XTime start, XTime end)
+{
+	XTime d = end - start;
+
+	return (d / COUNTS_PER_SECOND) * 1000000000ULL +
+	       (d % COUNTS_PER_SECOND) * 1000000000ULL / COUNTS_PER_SECOND;
+}
+
+/* Reset and address one device, rom NULL for Skip ROM. Returns 0, 1 if no device answered */
+static u8 bench_select(u32 baseaddr, const u8 *rom)
+{
+	int i;
+
+	if (AXI_1WIRE_HOST_ResetBus(baseaddr) != 0)
+		return 1;
+	if (rom) {
+		AXI_1WIRE_HOST_WriteByte(baseaddr, 0x55);
+		for (i = 0; i < 8; i++)
+			AXI_1WIRE_HOST_WriteByte(baseaddr, rom[i]);
+	} else {
+		AXI_1WIRE_HOST_WriteByte(baseaddr, 0xCC);
+	}
+	return 0;
+}
+
+/*
+ * Convert T, rom NULL for all the devices. As the application and the Linux
+ * driver, leave the bus alone for tCONV then confirm with read slots.
+ */
+static u8 bench_convert(u32 baseaddr, const u8 *rom)
+{
+	unsigned int tconv_ms = w1_temp_conv_time_ms(rom ? rom[0] : W1_FAMILY_DS18B20, 0);
+
+	if (bench_select(baseaddr, rom) != 0)
+		return 1;
+	AXI_1WIRE_HOST_WriteByte(baseaddr, 0x44);
+	usleep(tconv_ms * 1000);
+	/* Read slots every ms, up to another tCONV */
+	return !AXI_1WIRE_HOST_PollBit(baseaddr, 1000, tconv_ms + 1);
+}
+
+/* Read Scratchpad, CRC checked. Returns 0, 1 on error */
+static u8 bench_read_scratchpad(u32 baseaddr, const u8 *rom)
+{
+	u8 sp[W1_SCRATCHPAD_SIZE];
+	int i;
+
+	if (bench_select(baseaddr, rom) != 0)
+		return 1;
+	AXI_1WIRE_HOST_WriteByte(baseaddr, 0xBE);
+	for (i = 0; i < W1_SCRATCHPAD_SIZE; i++)
+		sp[i] = AXI_1WIRE_HOST_ReadByte(baseaddr);
+	return w1_crc8(0, sp, sizeof(sp)) != 0;
+}
+
+/* Search ROM with the touch-bit primitive, returns the number of ROM IDs found */
+static int bench_search(u32 baseaddr)
+{
+	u8 rom[8] = { 0 };
+	int last_discrepancy = -1, n = 0, bit, marker, i;
+	u8 id, cmp, dir;
+
+	do {
+		if (AXI_1WIRE_HOST_ResetBus(baseaddr) != 0)
+			return n;
+		AXI_1WIRE_HOST_WriteByte(baseaddr, 0xF0);
+		marker = -1;
+		for (bit = 0; bit < 64; bit++) {
+			id = AXI_1WIRE_HOST_TouchBit(baseaddr, 1);
+			cmp = AXI_1WIRE_HOST_TouchBit(baseaddr, 1);
+			if (id && cmp)
+				return n;	/* Nobody left */
+			if (id != cmp)
+				dir = id;
+			else if (bit == last_discrepancy)
+				dir = 1;
+			else if (bit > last_discrepancy)
+				dir = 0;
+			else
+				dir = (rom[bit >> 3] >> (bit & 7)) & 1;
+			if (id == cmp && dir == 0)
+				marker = bit;
+			rom[bit >> 3] = (rom[bit >> 3] & ~(1 << (bit & 7))) | (dir << (bit & 7));
+			AXI_1WIRE_HOST_TouchBit(baseaddr, dir);
+		}
+		if (w1_crc8(0, rom, 8) == 0 && n < BENCH_MAX_ROMS) {
+			for (i = 0; i < 8; i++)
+				roms[n][i] = rom[i];
+			n++;
+		}
+		last_discrepancy = marker;
+	} while (last_discrepancy >= 0);
+
+	return n;
+}
+
+static int bench_is_sensor(const u8 *rom)
+{
+	return rom[0] == W1_FAMILY_DS18B20 || rom[0] == W1_FAMILY_DS1822 ||
+	       rom[0] == W1_FAMILY_DS18S20 || rom[0] == W1_FAMILY_MAX31850;
+}
+
+static int bench_is_eeprom(const u8 *rom)
+{
+	return rom[0] == W1_FAMILY_DS2431 || rom[0] == W1_FAMILY_DS2433 ||
+	       rom[0] == W1_FAMILY_DS28EC20;
+}
+
+/* Read Memory from address 0 */
+static u8 bench_read_eeprom(u32 baseaddr, const u8 *rom)
+{
+	int i;
+
+	if (bench_select(baseaddr, rom) != 0)
+		return 1;
+	AXI_1WIRE_HOST_WriteByte(baseaddr, 0xF0);
+	AXI_1WIRE_HOST_WriteByte(baseaddr, 0x00);
+	AXI_1WIRE_HOST_WriteByte(baseaddr, 0x00);
+	for (i = 0; i < W1_BENCH_EEPROM_BYTES; i++)
+		eeprom[i] = AXI_1WIRE_HOST_ReadByte(baseaddr);
+	return 0;
+}
+
+static void bench_print(struct w1_bench *b)
+{
+	char line[W1_BENCH_LINE_SIZE];
+
+	/* No OS and a polled driver: no syscalls nor IRQs, the CPU spins all along */
+	b->syscalls = 0;
+	b->irqs = 0;
+	b->cpu_ns = b->elapsed_ns;
+	w1_bench_format(b, line, sizeof(line));
+	xil_printf("%s\n\r", line);
+}
+
+static void bench_print_skipped(const char *workload, const char *reason)
+{
+	char line[W1_BENCH_LINE_SIZE];
+
+	w1_bench_format_skipped(BENCH_PATH, workload, reason, line, sizeof(line));
+	xil_printf("%s\n\r", line);
+}
+
+XStatus benchmark_suite(u32 baseaddr, u32 iterations)
+{
+	struct w1_bench b;
+	XTime start, t0, t1;
+	const u8 *sensor = NULL, *mem = NULL;
+	int nroms, i, errors = 0;
+	u32 it;
+	u8 err;
+
+	nroms = bench_search(baseaddr);
+	if (nroms == 0) {
+		xil_printf("Error no device detected.\n\r");
+		return XST_FAILURE;
+	}
+	for (i = 0; i < nroms; i++) {
+		if (bench_is_sensor(roms[i])) {
+			if (!sensor)
+				sensor = roms[i];
+		} else if (bench_is_eeprom(roms[i]) && !mem) {
+			mem = roms[i];
+		}
+	}
+
+	/* Single sensor sample */
+	if (sensor) {
+		w1_bench_init(&b, BENCH_PATH, W1_BENCH_SAMPLE, lat_ns, BENCH_MAX_SAMPLES);
+		XTime_GetTime(&start);
+		for (it = 0; it < iterations; it++) {
+			XTime_GetTime(&t0);
+			err = bench_convert(baseaddr, sensor) || bench_read_scratchpad(baseaddr, sensor);
+			XTime_GetTime(&t1);
+			w1_bench_add(&b, bench_ns(t0, t1), err);
+		}
+		b.elapsed_ns = bench_ns(start, t1);
+		errors += b.errors;
+		bench_print(&b);
+
+		/* Sweep: one conversion for all the sensors, then each scratchpad */
+		w1_bench_init(&b, BENCH_PATH, W1_BENCH_SWEEP, lat_ns, BENCH_MAX_SAMPLES);
+		XTime_GetTime(&start);
+		for (it = 0; it < iterations; it++) {
+			XTime_GetTime(&t0);
+			err = bench_convert(baseaddr, NULL);
+			for (i = 0; i < nroms; i++)
+				if (bench_is_sensor(roms[i]))
+					err |= bench_read_scratchpad(baseaddr, roms[i]);
+			XTime_GetTime(&t1);
+			w1_bench_add(&b, bench_ns(t0, t1), err);
+		}
+		b.elapsed_ns = bench_ns(start, t1);
+		errors += b.errors;
+		bench_print(&b);
+	} else {
+		bench_print_skipped(W1_BENCH_SAMPLE, "no temperature sensor");
+		bench_print_skipped(W1_BENCH_SWEEP, "no temperature sensor");
+	}
+
+	/* ROM search */
+	w1_bench_init(&b, BENCH_PATH, W1_BENCH_SEARCH, lat_ns, BENCH_MAX_SAMPLES);
+	XTime_GetTime(&start);
+	for (it = 0; it < iterations; it++) {
+		XTime_GetTime(&t0);
+		err = bench_search(baseaddr) != nroms;
+		XTime_GetTime(&t1);
+		w1_bench_add(&b, bench_ns(t0, t1), err);
+	}
+	b.elapsed_ns = bench_ns(start, t1);
+	errors += b.errors;
+	bench_print(&b);
+
+	/* EEPROM dump */
+	if (mem) {
+		w1_bench_init(&b, BENCH_PATH, W1_BENCH_EEPROM, lat_ns, BENCH_MAX_SAMPLES);
+		XTime_GetTime(&start);
+		for (it = 0; it < iterations; it++) {
+			XTime_GetTime(&t0);
+			err = bench_read_eeprom(baseaddr, mem);
+			XTime_GetTime(&t1);
+			w1_bench_add(&b, bench_ns(t0, t1), err);
+		}
+		b.elapsed_ns = bench_ns(start, t1);
+		errors += b.errors;
+		bench_print(&b);
+	} else {
+		bench_print_skipped(W1_BENCH_EEPROM, "no EEPROM device");
+	}
+
+	return errors ? XST_FAILURE : XST_SUCCESS;
+}
@@ -0,0 +1,22 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef APPLICATION_BENCH_H
+#define APPLICATION_BENCH_H
+
+#include <xil_types.h>
+#include <xstatus.h>
+
+/*
+ * Run the benchmark suite of w1_bench.h on a bus with the baremetal driver
+ * and print a JSON line per workload. The driver polls the IP and there is
+ * no operating system, so there are no syscalls nor IRQs and the CPU time is
+ * the elapsed time.
+ *
+ * Returns XST_SUCCESS, or XST_FAILURE if an operation failed or no device
+ * answered.
+ */
+XStatus benchmark_suite(u32 baseaddr, u32 iterations);
+
+#endif
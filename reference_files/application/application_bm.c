@@ -7,10 +7,17 @@ SPDX-License-Identifier: MIT
 #include <xil_printf.h>
 #include <xil_io.h>
 #include "axi_1wire_host.h"
+#include "w1_crc.h"
+#include "w1_temp.h"
 #include "xparameters.h"
+#include "sleep.h"
 
 #define ba XPAR_AXI_1WIRE_HOST_0_BASEADDR
 
+static read_profile_t read_profile = READ_PROFILE_FULL_CRC;
+static u32 full_crc_interval = 0;
+static u32 conv_time_ms = 750;
+
 void thermistor_config(s8 t_high, s8 t_low, int resolution) {
     u8 config;
     if (t_high <= t_low){
@@ -55,8 +62,9 @@ void thermistor_config(s8 t_high, s8 t_low, int resolution) {
 				AXI_1WIRE_HOST_WriteByte(ba, 0xCC);
 				// Copy scratchpad to EEPROM
 				AXI_1WIRE_HOST_WriteByte(ba, 0x48);
-				// Read Bit until 1 received from device
-				while(AXI_1WIRE_HOST_TouchBit(ba, 0x01) == 0){}
+				// Read Bit every ms until 1 received from device, twice tWR at most
+				if (!AXI_1WIRE_HOST_PollBit(ba, 1000, 2 * W1_TEMP_COPY_TIME_MS))
+					xil_printf( "Error EEPROM copy timed out.\n\r");
 			}
 			else {
 				xil_printf( "Error no device detected.\n\r");
@@ -70,34 +78,41 @@ void thermistor_config(s8 t_high, s8 t_low, int resolution) {
     }
 }
 
-void thermistor_temp_reading(u8* byte0, u8* byte1, u8* byte2, u8* byte3, u8* byte4, u8* byte5, u8* byte6, u8* byte7, u8* byte8) {
+/*
+ * Convert and read the first nbytes of the scratchpad into scratchpad[].
+ * When fewer than the 9 scratchpad bytes are requested, the read is
+ * terminated early by a bus reset, the device ignoring the remaining bytes.
+ * Returns 0 on success, 1 if no device answered.
+ */
+static u8 thermistor_temp_reading(u8* scratchpad, int nbytes) {
+	int i;
+
     // Initialization
     if (AXI_1WIRE_HOST_ResetBus(ba) != 1){
     	// Skip ROM command
 		AXI_1WIRE_HOST_WriteByte(ba, 0xCC);
 		// Convert temperature command
 		AXI_1WIRE_HOST_WriteByte(ba, 0x44);
-		// Read Bit until 1 receive from device
-		while(AXI_1WIRE_HOST_TouchBit(ba, 1) == 0){}
+		// Leave the bus alone for the conversion time instead of spinning on read slots
+		usleep(conv_time_ms * 1000);
+		// Read Bit every ms until 1 receive from device, another conversion time at most
+		if (!AXI_1WIRE_HOST_PollBit(ba, 1000, conv_time_ms + 1)) {
+			xil_printf( "Error conversion timed out.\n\r");
+			return 1;
+		}
 		// Initialization
 		if (AXI_1WIRE_HOST_ResetBus(ba) != 1){
 			// Skip ROM command
 			AXI_1WIRE_HOST_WriteByte(ba, 0xCC);
 			// Read Scratchpad command
 			AXI_1WIRE_HOST_WriteByte(ba, 0xBE);
-			// Read 2 Bytes of temperature
-			*byte0 = AXI_1WIRE_HOST_ReadByte(ba);
-			*byte1 = AXI_1WIRE_HOST_ReadByte(ba);
-			// Read 3 Bytes of config
-			*byte2 = AXI_1WIRE_HOST_ReadByte(ba);
-			*byte3 = AXI_1WIRE_HOST_ReadByte(ba);
-			*byte4 = AXI_1WIRE_HOST_ReadByte(ba);
-			// Read 3 reserved Bytes
-			*byte5 = AXI_1WIRE_HOST_ReadByte(ba);
-			*byte6 = AXI_1WIRE_HOST_ReadByte(ba);
-			*byte7 = AXI_1WIRE_HOST_ReadByte(ba);
-			// Read CRC
-			*byte8 = AXI_1WIRE_HOST_ReadByte(ba);
+			// Read 2 Bytes of temperature, 3 Bytes of config, 3 reserved Bytes and CRC
+			for (i = 0; i < nbytes; i++)
+				scratchpad[i] = AXI_1WIRE_HOST_ReadByte(ba);
+			// Stop the device from sending the bytes not needed
+			if (nbytes < W1_SCRATCHPAD_SIZE)
+				AXI_1WIRE_HOST_ResetBus(ba);
+			return 0;
 		}
 		else {
 			xil_printf( "Error no device detected.\n\r");
@@ -106,89 +121,52 @@ void thermistor_temp_reading(u8* byte0, u8* byte1, u8* byte2, u8* byte3, u8* byt
 	else {
 		xil_printf( "Error no device detected.\n\r");
 	}
+	return 1;
 }
 
-void continuous_temperature_reading(s8 t_high, s8 t_low, int resolution) {
-	u8 crc_table[256] = {0, 94, 188, 226, 97, 63, 221, 131, 194, 156, 126, 32, 163, 253, 31, 65,
-				157, 195, 33, 127, 252, 162, 64, 30, 95, 1, 227, 189, 62, 96, 130, 220,
-				35, 125, 159, 193, 66, 28, 254, 160, 225, 191, 93, 3, 128, 222, 60, 98,
-				190, 224, 2, 92, 223, 129, 99, 61, 124, 34, 192, 158, 29, 67, 161, 255,
-				70, 24, 250, 164, 39, 121, 155, 197, 132, 218, 56, 102, 229, 187, 89, 7,
-				219, 133, 103, 57, 186, 228, 6, 88, 25, 71, 165, 251, 120, 38, 196, 154,
-				101, 59, 217, 135, 4, 90, 184, 230, 167, 249, 27, 69, 198, 152, 122, 36,
-				248, 166, 68, 26, 153, 199, 37, 123, 58, 100, 134, 216, 91, 5, 231, 185,
-				140, 210, 48, 110, 237, 179, 81, 15, 78, 16, 242, 172, 47, 113, 147, 205,
-				17, 79, 173, 243, 112, 46, 204, 146, 211, 141, 111, 49, 178, 236, 14, 80,
-				175, 241, 19, 77, 206, 144, 114, 44, 109, 51, 209, 143, 12, 82, 176, 238,
-				50, 108, 142, 208, 83, 13, 239, 177, 240, 174, 76, 18, 145, 207, 45, 115,
-				202, 148, 118, 40, 171, 245, 23, 73, 8, 86, 180, 234, 105, 55, 213, 139,
-				87, 9, 235, 181, 54, 104, 138, 212, 149, 203, 41, 119, 244, 170, 72, 22,
-				233, 183, 85, 11, 136, 214, 52, 106, 43, 117, 151, 201, 74, 20, 246, 168,
-				116, 42, 200, 150, 21, 75, 169, 247, 182, 232, 10, 84, 215, 137, 107, 53};
+void set_read_profile(read_profile_t profile, u32 crc_interval) {
+	read_profile = profile;
+	full_crc_interval = crc_interval;
+}
 
-	u8 byte0_read, byte1_read, byte2_read, byte3_read, byte4_read, byte5_read, byte6_read, byte7_read, byte8_read;
-	u16 bytes_read;
-	int dec_p, int_p;
-	u8 crc;
+void continuous_temperature_reading(s8 t_high, s8 t_low, int resolution) {
+	u8 scratchpad[W1_SCRATCHPAD_SIZE];
+	char temp_str[W1_TEMP_STR_SIZE];
+	u32 sample = 0;
+	int full, valid;
 
 	thermistor_config(t_high, t_low, resolution);
+	conv_time_ms = w1_temp_conv_time_ms(W1_FAMILY_DS18B20, resolution);
 	xil_printf("Configuration done\n\r");
 
 	while (1){
-		thermistor_temp_reading(&byte0_read, &byte1_read, &byte2_read, &byte3_read, &byte4_read, &byte5_read, &byte6_read, &byte7_read, &byte8_read);
-		// Verify CRC
-		crc = crc_table[byte0_read];
-		crc = crc_table[byte1_read ^ crc];
-		crc = crc_table[byte2_read ^ crc];
-		crc = crc_table[byte3_read ^ crc];
-		crc = crc_table[byte4_read ^ crc];
-		crc = crc_table[byte5_read ^ crc];
-		crc = crc_table[byte6_read ^ crc];
-		crc = crc_table[byte7_read ^ crc];
+		// Full scratchpad reads are done on every sample with the full profile,
+		// and every full_crc_interval samples with the temperature only profile
+		full = (read_profile == READ_PROFILE_FULL_CRC) ||
+			(full_crc_interval != 0 && (sample % full_crc_interval) == 0);
+		sample++;
 
-		if (crc == byte8_read){
-			// Concatenate both bytes and apply 2 complement
-			if ((byte1_read & 0x80) != 0){
-				bytes_read = (((byte1_read << 8) + byte0_read) ^ 0xFFFF) + 1;
-			}
-			else {
-				bytes_read = ((byte1_read << 8) +  byte0_read);
-			}
+		if (thermistor_temp_reading(scratchpad, full ? W1_SCRATCHPAD_SIZE : W1_SCRATCHPAD_TEMP_SIZE) != 0)
+			continue;
 
-			// Get the integer part
-			if ((byte1_read & 0x80) != 0){
-				int_p = -1 * (bytes_read >> 4);
-			}
-			else {
-				int_p = bytes_read >> 4;
-			}
-
-			// Get the decimal part
-			switch (resolution) {
-				case 9:
-					dec_p = (((bytes_read & 0x8) >> 3) * 5000);
-					break;
-				case 10:
-					dec_p = (((bytes_read & 0x8) >> 3) * 5000) + (((bytes_read & 0x4) >> 2) * 2500);
-					break;
-				case 11:
-					dec_p = (((bytes_read & 0x8) >> 3) * 5000) + (((bytes_read & 0x4) >> 2) * 2500)
-						+ (((bytes_read & 0x2) >> 1) * 1250);
-					break;
-				case 12:
-					dec_p = (((bytes_read & 0x8) >> 3) * 5000) + (((bytes_read & 0x4) >> 2) * 2500)
-						+ (((bytes_read & 0x2) >> 1) * 1250) + ((bytes_read & 0x1) * 625);
-					break;
-				default:
-					xil_printf( "Error when configuring resolution, will be assume resolution of 9 bits.\n\r");
-					dec_p = (((bytes_read & 0x8) >> 3) * 5000);
-					break;
-			}
-
-			xil_printf("Temperature is: %d.%04d\r", int_p, dec_p);
+		if (full){
+			// Verify CRC
+			valid = (w1_crc8(0, scratchpad, W1_SCRATCHPAD_SIZE) == 0);
 		}
 		else {
+			// No CRC on a partial read, only reject a floating bus (all ones)
+			valid = ((scratchpad[0] & scratchpad[1]) != 0xFF);
+		}
+
+		if (valid){
+			w1_temp_format(w1_temp_decode(W1_FAMILY_DS18B20, resolution, scratchpad), temp_str);
+			xil_printf("Temperature is: %s\r", temp_str);
+		}
+		else if (full) {
 			xil_printf("CRC does not match\n\r");
 		}
+		else {
+			xil_printf("Invalid temperature read\n\r");
+		}
 	}
 }
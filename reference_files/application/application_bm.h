@@ -7,6 +7,12 @@ SPDX-License-Identifier: MIT
 
 #include <xil_types.h>
 
+typedef enum {
+	READ_PROFILE_FULL_CRC = 0,	/* Read the 9 scratchpad bytes and verify the CRC */
+	READ_PROFILE_TEMP_ONLY,		/* Read the 2 temperature bytes then reset the bus */
+} read_profile_t;
+
+void set_read_profile(read_profile_t, u32);
 void continuous_temperature_reading(s8, s8, int);
 
 #endif
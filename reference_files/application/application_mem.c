@@ -0,0 +1,259 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#include "application_mem.h"
+#include <string.h>
+#include <xil_types.h>
+#include <xtime_l.h>
+#include "axi_1wire_host.h"
+#include "w1_mem.h"
+#include "sleep.h"
+
+#define MEM_VERIFY_LEN		64	/* Bytes compared per Read Memory at the end of a job */
+
+static XTime mem_now(void)
+{
+	XTime t;
+
+	XTime_GetTime(&t);
+	return t;
+}
+
+/* Reset and address one device, rom NULL for Skip ROM. Returns 0, 1 if no device answered */
+static u8 mem_select(u32 baseaddr, const u8 *rom)
+{
+	int i;
+
+	if (AXI_1WIRE_HOST_ResetBus(baseaddr) != 0)
+		return 1;
+	if (rom) {
+		AXI_1WIRE_HOST_WriteByte(baseaddr, 0x55);
+		for (i = 0; i < 8; i++)
+			AXI_1WIRE_HOST_WriteByte(baseaddr, rom[i]);
+	} else {
+		AXI_1WIRE_HOST_WriteByte(baseaddr, 0xCC);
+	}
+	return 0;
+}
+
+/* Reset and address again the device of the last mem_select() */
+static u8 mem_resume(u32 baseaddr, const u8 *rom)
+{
+	if (AXI_1WIRE_HOST_ResetBus(baseaddr) != 0)
+		return 1;
+	AXI_1WIRE_HOST_WriteByte(baseaddr, rom ? W1_MEM_RESUME : 0xCC);
+	return 0;
+}
+
+static void mem_write_bytes(u32 baseaddr, const u8 *buf, u32 len)
+{
+	u32 i;
+
+	for (i = 0; i < len; i++)
+		AXI_1WIRE_HOST_WriteByte(baseaddr, buf[i]);
+}
+
+static void mem_read_bytes(u32 baseaddr, u8 *buf, u32 len)
+{
+	u32 i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = AXI_1WIRE_HOST_ReadByte(baseaddr);
+}
+
+XStatus eeprom_read(u32 baseaddr, const u8 *rom, u16 addr, u8 *buf, u32 len)
+{
+	u8 frame[3];
+
+	if (mem_select(baseaddr, rom) != 0)
+		return XST_DEVICE_NOT_FOUND;
+	w1_mem_read_frame(frame, addr);
+	mem_write_bytes(baseaddr, frame, sizeof(frame));
+	mem_read_bytes(baseaddr, buf, len);
+	/* Stop the device from sending the rest of the memory */
+	AXI_1WIRE_HOST_ResetBus(baseaddr);
+	return XST_SUCCESS;
+}
+
+static const struct w1_mem_type *mem_job_type(const eeprom_job_t *job)
+{
+	if (job->type != NULL)
+		return job->type;
+	return job->rom ? w1_mem_type(job->rom[0]) : NULL;
+}
+
+/* Page holding the next byte of a job, and the bytes of the job in it */
+static u32 mem_page(const eeprom_job_t *job, const struct w1_mem_type *type, u16 *base)
+{
+	u16 addr = (u16)(job->addr + job->done);
+	u32 n;
+
+	*base = addr & ~(type->page - 1);
+	n = type->page - (addr - *base);
+	return n < job->len - job->done ? n : job->len - job->done;
+}
+
+/* Write the next page to the scratchpad, check it and start its copy */
+static XStatus mem_stage(eeprom_job_t *job, const struct w1_mem_type *type)
+{
+	u8 page[W1_MEM_PAGE_MAX], frame[W1_MEM_WRITE_FRAME_MAX], sp[W1_MEM_READ_SP_MAX];
+	u8 crc[2], copy[W1_MEM_COPY_FRAME_SIZE];
+	u16 base;
+	u32 n, len;
+	XStatus status;
+
+	n = mem_page(job, type, &base);
+	if (n < type->page) {
+		status = eeprom_read(job->baseaddr, job->rom, base, page, type->page);
+		if (status != XST_SUCCESS)
+			return status;
+	}
+	memcpy(&page[job->addr + job->done - base], job->data + job->done, n);
+	len = w1_mem_write_frame(type, frame, base, page);
+
+	if (mem_select(job->baseaddr, job->rom) != 0)
+		return XST_DEVICE_NOT_FOUND;
+	mem_write_bytes(job->baseaddr, frame, len);
+	mem_read_bytes(job->baseaddr, crc, sizeof(crc));
+	if (mem_resume(job->baseaddr, job->rom) != 0)
+		return XST_DEVICE_NOT_FOUND;
+	AXI_1WIRE_HOST_WriteByte(job->baseaddr, W1_MEM_READ_SCRATCHPAD);
+	mem_read_bytes(job->baseaddr, sp, w1_mem_read_sp_len(type));
+	if (!w1_mem_check_write(frame, len, crc) || !w1_mem_check_scratchpad(type, sp, base, page))
+		return XST_FAILURE;
+
+	w1_mem_copy_frame(type, copy, base);
+	if (mem_resume(job->baseaddr, job->rom) != 0)
+		return XST_DEVICE_NOT_FOUND;
+	mem_write_bytes(job->baseaddr, copy, sizeof(copy));
+	job->deadline = mem_now() + type->tprog_ms * (COUNTS_PER_SECOND / 1000);
+	return XST_SUCCESS;
+}
+
+/* After tPROG, the device sends 0xAA once the page is programmed */
+static XStatus mem_confirm(eeprom_job_t *job)
+{
+	u8 status = AXI_1WIRE_HOST_ReadByte(job->baseaddr);
+
+	AXI_1WIRE_HOST_ResetBus(job->baseaddr);
+	return status == W1_MEM_COPY_DONE ? XST_SUCCESS : XST_FAILURE;
+}
+
+static XStatus mem_verify(eeprom_job_t *job)
+{
+	u8 buf[MEM_VERIFY_LEN];
+	u32 off, n;
+	XStatus status;
+
+	for (off = 0; off < job->len; off += n) {
+		n = job->len - off < sizeof(buf) ? job->len - off : sizeof(buf);
+		status = eeprom_read(job->baseaddr, job->rom, (u16)(job->addr + off), buf, n);
+		if (status != XST_SUCCESS)
+			return status;
+		if (memcmp(buf, job->data + off, n) != 0)
+			return XST_FAILURE;
+	}
+	return XST_SUCCESS;
+}
+
+/* Run the next step of a job: stage a page, or confirm its copy once tPROG is over */
+static void mem_step(eeprom_job_t *job, const struct w1_mem_type *type)
+{
+	XStatus status;
+	u16 base;
+
+	if (job->busy) {
+		job->busy = 0;
+		status = mem_confirm(job);
+		if (status == XST_SUCCESS) {
+			job->done += mem_page(job, type, &base);
+			job->retries = 0;
+		}
+	} else {
+		status = mem_stage(job, type);
+		if (status == XST_SUCCESS) {
+			job->busy = 1;
+			return;
+		}
+	}
+	/* A corrupted frame or a failed copy, the page is written again */
+	if (status == XST_FAILURE && ++job->retries < EEPROM_RETRIES)
+		return;
+	if (status != XST_SUCCESS)
+		job->status = status;
+	else if (job->done == job->len)
+		job->status = mem_verify(job);
+}
+
+XStatus eeprom_program(eeprom_job_t *jobs, int n)
+{
+	const struct w1_mem_type *type;
+	eeprom_job_t *job;
+	XTime now, next;
+	int i, j, left = 0, idle;
+
+	for (i = 0; i < n; i++) {
+		job = &jobs[i];
+		type = mem_job_type(job);
+		job->done = 0;
+		job->busy = 0;
+		job->retries = 0;
+		if (type == NULL || job->addr + job->len > type->size) {
+			job->status = XST_INVALID_PARAM;
+		} else if (job->len == 0) {
+			job->status = XST_SUCCESS;
+		} else {
+			job->status = XST_DEVICE_BUSY;
+			left++;
+		}
+	}
+
+	while (left) {
+		now = mem_now();
+		next = 0;
+		idle = 1;
+		for (i = 0; i < n; i++) {
+			job = &jobs[i];
+			if (job->status != XST_DEVICE_BUSY)
+				continue;
+			/* The bus stays idle while a device programs a page: one job per bus */
+			for (j = 0; j < i; j++)
+				if (jobs[j].baseaddr == job->baseaddr && jobs[j].status == XST_DEVICE_BUSY)
+					break;
+			if (j < i)
+				continue;
+			if (!job->busy || now >= job->deadline) {
+				mem_step(job, mem_job_type(job));
+				if (job->status != XST_DEVICE_BUSY) {
+					left--;
+					continue;
+				}
+				if (!job->busy) {
+					idle = 0;
+					continue;
+				}
+			}
+			if (next == 0 || job->deadline < next)
+				next = job->deadline;
+		}
+		/* Every bus waits for a copy: sleep until the first one is over */
+		now = mem_now();
+		if (left && idle && next > now)
+			usleep((next - now) * 1000000 / COUNTS_PER_SECOND + 1);
+	}
+
+	for (i = 0; i < n; i++)
+		if (jobs[i].status != XST_SUCCESS)
+			return jobs[i].status;
+	return XST_SUCCESS;
+}
+
+XStatus eeprom_write(u32 baseaddr, const u8 *rom, u16 addr, const u8 *data, u32 len)
+{
+	eeprom_job_t job = {
+		.baseaddr = baseaddr, .rom = rom, .addr = addr, .data = data, .len = len,
+	};
+
+	return eeprom_program(&job, 1);
+}
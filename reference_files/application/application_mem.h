@@ -0,0 +1,58 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef APPLICATION_MEM_H
+#define APPLICATION_MEM_H
+
+#include <xil_types.h>
+#include <xstatus.h>
+#include <xtime_l.h>
+#include "w1_mem.h"
+
+/*
+ * DS2431 and DS28EC20 EEPROMs (w1_mem.h) on one or several instances of the
+ * IP, a bus each. Several EEPROMs are programmed at once with
+ * eeprom_program(): a page is written to the scratchpad, read back and
+ * checked with its CRC-16, retried if it does not match, then copied. The
+ * bus of a device must stay idle while it programs the page (tPROG, 10 ms),
+ * so the jobs of a bus run one after the other, but the copies on the other
+ * buses go on meanwhile: n buses are programmed in about the time of the
+ * largest image. A job ends with a Read Memory of its range compared with
+ * the data. The partial pages at the ends of a range are read first and
+ * completed with the memory contents.
+ */
+
+#define EEPROM_RETRIES		3	/* Attempts at a page before giving up */
+
+typedef struct {
+	u32 baseaddr;
+	const u8 *rom;			/* NULL for the only device of the bus */
+	const struct w1_mem_type *type;	/* NULL to look it up from rom */
+	u16 addr;
+	const u8 *data;
+	u32 len;
+	XStatus status;			/* Result of the job */
+	/* Private */
+	u32 done;			/* Bytes programmed */
+	int busy;			/* A page is being copied */
+	int retries;
+	XTime deadline;			/* End of its tPROG */
+} eeprom_job_t;
+
+/* Read len bytes from addr with one Read Memory. XST_DEVICE_NOT_FOUND if no device answered */
+XStatus eeprom_read(u32 baseaddr, const u8 *rom, u16 addr, u8 *buf, u32 len);
+
+/*
+ * Program the jobs, the status of each one set. Returns XST_SUCCESS or the
+ * status of the first job failing: XST_INVALID_PARAM for a range outside
+ * the memory or an unknown device, XST_DEVICE_NOT_FOUND if no device
+ * answered, XST_FAILURE for a page whose scratchpad or copy could not be
+ * verified.
+ */
+XStatus eeprom_program(eeprom_job_t *jobs, int n);
+
+/* Program a single range, a job of its own, the device type given by rom */
+XStatus eeprom_write(u32 baseaddr, const u8 *rom, u16 addr, const u8 *data, u32 len);
+
+#endif
@@ -5,6 +5,27 @@ SPDX-License-Identifier: MIT
 /***************************** Include Files *******************************/
 #include "axi_1wire_host.h"
 #include "xparameters.h"
+#include "sleep.h"
+
+/************************** Variable Definitions ***************************/
+#ifdef AXI_1WIRE_HOST_TRACE
+/* Rings of the instances recording, free when Ring is NULL */
+static struct {
+	u32 BaseAddress;
+	struct w1_trace_ring *Ring;
+} TraceInstances[AXI_1WIRE_HOST_TRACE_INSTANCES];
+
+#define TRACE_VARS		XTime TraceStart, TraceIssue
+#define TRACE_BEGIN()		XTime_GetTime(&TraceStart)
+#define TRACE_ISSUE()		XTime_GetTime(&TraceIssue)
+#define TRACE_END(baseaddr, Instr, Rx) \
+	AXI_1WIRE_HOST_TraceRecord(baseaddr, TraceStart, TraceIssue, Instr, Rx, 0)
+#else
+#define TRACE_VARS
+#define TRACE_BEGIN()
+#define TRACE_ISSUE()
+#define TRACE_END(baseaddr, Instr, Rx)
+#endif
 
 /************************** Function Definitions ***************************/
 /**
@@ -34,7 +55,9 @@ void AXI_1WIRE_HOST_Reset(u32 baseaddr) {
  */
 u8 AXI_1WIRE_HOST_TouchBit(u32 baseaddr, u8 bit) {
 	u8 val = 0;
+	TRACE_VARS;
 
+	TRACE_BEGIN();
 	/* Wait for READY signal to be 1 to ensure 1-wire IP is ready */
     while((AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_STAT_REG_OFFSET) & 0x00000010) == 0){}
 
@@ -46,6 +69,7 @@ u8 AXI_1WIRE_HOST_TouchBit(u32 baseaddr, u8 bit) {
 		AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_INSTR_REG_OFFSET, AXI_1WIRE_HOST_WRITEBIT + (bit & 0x01));
 
 	/* Write Go signal and clear control reset signal in control register */
+	TRACE_ISSUE();
 	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0x00000001);
 
 	/* Wait for done signal to be 1 */
@@ -57,6 +81,7 @@ u8 AXI_1WIRE_HOST_TouchBit(u32 baseaddr, u8 bit) {
 
 	/* Clear Go signal in register 1 */
 	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0x00000000);
+	TRACE_END(baseaddr, bit ? AXI_1WIRE_HOST_READBIT : AXI_1WIRE_HOST_WRITEBIT, val);
 
 	return val;
 }
@@ -72,7 +97,9 @@ u8 AXI_1WIRE_HOST_TouchBit(u32 baseaddr, u8 bit) {
  */
 u8 AXI_1WIRE_HOST_ReadByte(u32 baseaddr) {
 	u8 val = 0;
+	TRACE_VARS;
 
+	TRACE_BEGIN();
 	/* Wait for READY signal to be 1 to ensure 1-wire IP is ready */
     while((AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_STAT_REG_OFFSET) & 0x00000010) == 0){}
 
@@ -80,6 +107,7 @@ u8 AXI_1WIRE_HOST_ReadByte(u32 baseaddr) {
 	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_INSTR_REG_OFFSET, AXI_1WIRE_HOST_READBYTE);
 
 	/* Write Go signal and clear control reset signal in control register */
+	TRACE_ISSUE();
 	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0x00000001);
 
 	/* Wait for done signal to be 1 */
@@ -89,6 +117,7 @@ u8 AXI_1WIRE_HOST_ReadByte(u32 baseaddr) {
 
 	/* Clear Go signal in register 1 */
 	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0x00000000);
+	TRACE_END(baseaddr, AXI_1WIRE_HOST_READBYTE, val);
 
 	return val;
 }
@@ -102,7 +131,9 @@ u8 AXI_1WIRE_HOST_ReadByte(u32 baseaddr) {
  * 
  */
 void AXI_1WIRE_HOST_WriteByte(u32 baseaddr, u8 byte) {
+	TRACE_VARS;
 
+	TRACE_BEGIN();
 	/* Wait for READY signal to be 1 to ensure 1-wire IP is ready */
     while((AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_STAT_REG_OFFSET) & 0x00000010) == 0){}
 
@@ -110,6 +141,7 @@ void AXI_1WIRE_HOST_WriteByte(u32 baseaddr, u8 byte) {
 	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_INSTR_REG_OFFSET, AXI_1WIRE_HOST_WRITEBYTE + (byte & 0xFF));
 
 	/* Write Go signal and clear control reset signal in control register */
+	TRACE_ISSUE();
 	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0x00000001);
 
 	/* Wait for done signal to be 1 */
@@ -117,6 +149,43 @@ void AXI_1WIRE_HOST_WriteByte(u32 baseaddr, u8 byte) {
 
 	/* Clear Go signal in register 1 */
 	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0x00000000);
+	TRACE_END(baseaddr, AXI_1WIRE_HOST_WRITEBYTE + byte, 0);
+
+	return;
+}
+
+/**
+ *
+ * Performs the write-byte function followed by a strong pull-up.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          byte is the byte to write
+ *          duration_us is the strong pull-up duration in us (24 bits)
+ *
+ */
+void AXI_1WIRE_HOST_WriteByteStrongPullup(u32 baseaddr, u8 byte, u32 duration_us) {
+	TRACE_VARS;
+
+	TRACE_BEGIN();
+	/* Wait for READY signal to be 1 to ensure 1-wire IP is ready */
+    while((AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_STAT_REG_OFFSET) & 0x00000010) == 0){}
+
+	/* Program the strong pull-up duration */
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_SPU_REG_OFFSET, duration_us & 0x00FFFFFF);
+
+	/* Write. Write tx Byte command with the strong pull-up flag in instruction register */
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_INSTR_REG_OFFSET, AXI_1WIRE_HOST_WRITEBYTE + AXI_1WIRE_HOST_SPU + (byte & 0xFF));
+
+	/* Write Go signal and clear control reset signal in control register */
+	TRACE_ISSUE();
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0x00000001);
+
+	/* Wait for done signal to be 1, raised once the bus is released */
+	while((AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_STAT_REG_OFFSET) & 0x00000001) == 0){}
+
+	/* Clear Go signal in register 1 */
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0x00000000);
+	TRACE_END(baseaddr, AXI_1WIRE_HOST_WRITEBYTE + AXI_1WIRE_HOST_SPU + byte, 0);
 
 	return;
 }
@@ -132,7 +201,9 @@ void AXI_1WIRE_HOST_WriteByte(u32 baseaddr, u8 byte) {
  */
 u8 AXI_1WIRE_HOST_ResetBus(u32 baseaddr) {
     u8 val = 0;
+    TRACE_VARS;
 
+    TRACE_BEGIN();
     /* Reset 1-wire Axi IP */
     AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, AXI_1WIRE_HOST_RESET);
 
@@ -143,6 +214,7 @@ u8 AXI_1WIRE_HOST_ResetBus(u32 baseaddr) {
     AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_INSTR_REG_OFFSET, AXI_1WIRE_HOST_INITPRES);
 
 	/* Write Go signal and clear control reset signal in control register */
+	TRACE_ISSUE();
 	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0x00000001);
 
     /* Wait for done signal to be 1 */
@@ -154,6 +226,310 @@ u8 AXI_1WIRE_HOST_ResetBus(u32 baseaddr) {
 
     /* Clear Go signal in register 1 */
 	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0x00000000);
+	TRACE_END(baseaddr, AXI_1WIRE_HOST_INITPRES, val);
+
+	return val;
+}
+
+/* Timing registers, in the order of the fields of AXI_1WIRE_HOST_Timing */
+static const u32 TimingRegs[7] = {
+	AXI_1WIRE_HOST_TRSTL_REG_OFFSET, AXI_1WIRE_HOST_TMSP_REG_OFFSET,
+	AXI_1WIRE_HOST_TW0L_REG_OFFSET, AXI_1WIRE_HOST_TREC_REG_OFFSET,
+	AXI_1WIRE_HOST_TRDV_REG_OFFSET, AXI_1WIRE_HOST_TW1L_REG_OFFSET,
+	AXI_1WIRE_HOST_TSLOT_REG_OFFSET
+};
+
+/* Register reader of w1_caps_detect(), Ctx points to the base address */
+static uint32_t CapsRead(void *Ctx, uint32_t Offset) {
+	return AXI_1WIRE_HOST_mReadReg(*(u32 *)Ctx, Offset);
+}
+
+/**
+ *
+ * Get the optional features of the IP.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *
+ * @return  The W1_CAP_* bits and the ROM ID table entries
+ *
+ */
+u32 AXI_1WIRE_HOST_Capabilities(u32 baseaddr) {
+	return w1_caps_detect(CapsRead, &baseaddr);
+}
+
+/*
+ * AXI clock cycles per us, or 0 before v01.4: the smaller address window of
+ * the older IPs aliases TCLK to the instruction register.
+ */
+static u32 TimingClk(u32 baseaddr) {
+	if (!(AXI_1WIRE_HOST_Capabilities(baseaddr) & W1_CAP_TIMING))
+		return 0;
+	return AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_TCLK_REG_OFFSET);
+}
+
+/**
+ *
+ * Program the slot timing, a field of 0 keeps the current value.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          Timing is the slot timing in ns.
+ *
+ * @return  XST_SUCCESS, or XST_FAILURE without timing registers or if a
+ *          duration does not fit
+ *
+ */
+XStatus AXI_1WIRE_HOST_SetTiming(u32 baseaddr, const AXI_1WIRE_HOST_Timing *Timing) {
+	const u32 *Ns = &Timing->ResetLowNs;
+	u32 Cycles[7];
+	u32 Clk;
+	int i;
+
+	Clk = TimingClk(baseaddr);
+	if (Clk == 0)
+		return XST_FAILURE;
+
+	/* Check all the durations before writing any */
+	for (i = 0; i < 7; i++) {
+		Cycles[i] = (u32)(((u64)Ns[i] * Clk + 999) / 1000);
+		if (Cycles[i] > AXI_1WIRE_HOST_TIMING_MAX)
+			return XST_FAILURE;
+	}
+	for (i = 0; i < 7; i++)
+		if (Ns[i] != 0)
+			AXI_1WIRE_HOST_mWriteReg(baseaddr, TimingRegs[i], Cycles[i]);
+
+	return XST_SUCCESS;
+}
+
+/**
+ *
+ * Read the slot timing.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          Timing receives the slot timing in ns.
+ *
+ * @return  XST_SUCCESS, or XST_FAILURE without timing registers
+ *
+ */
+XStatus AXI_1WIRE_HOST_GetTiming(u32 baseaddr, AXI_1WIRE_HOST_Timing *Timing) {
+	u32 *Ns = &Timing->ResetLowNs;
+	u32 Clk;
+	int i;
+
+	Clk = TimingClk(baseaddr);
+	if (Clk == 0)
+		return XST_FAILURE;
+
+	for (i = 0; i < 7; i++)
+		Ns[i] = (u32)((u64)(AXI_1WIRE_HOST_mReadReg(baseaddr, TimingRegs[i]) &
+				    AXI_1WIRE_HOST_TIMING_MAX) * 1000 / Clk);
+
+	return XST_SUCCESS;
+}
+
+/**
+ *
+ * Check whether the IP runs the block instructions.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *
+ * @return  1 if the block instructions are available, 0 otherwise
+ *
+ */
+u32 AXI_1WIRE_HOST_HasBlockStream(u32 baseaddr) {
+	return (AXI_1WIRE_HOST_Capabilities(baseaddr) & W1_CAP_BLOCK) != 0;
+}
+
+/**
+ *
+ * Start a block instruction, the DMA transfer being started.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          Instr is the block instruction, with the strong pull-up flag.
+ *          Bytes is the number of bytes.
+ *
+ * @return  XST_SUCCESS, or XST_FAILURE without block instructions or if
+ *          Bytes is too large
+ *
+ */
+XStatus AXI_1WIRE_HOST_BlockStart(u32 baseaddr, u32 Instr, u32 Bytes) {
+	if (Bytes > AXI_1WIRE_HOST_BLOCK_MAX || !AXI_1WIRE_HOST_HasBlockStream(baseaddr))
+		return XST_FAILURE;
+
+	/* Wait for READY signal to be 1 to ensure 1-wire IP is ready */
+	while((AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_STAT_REG_OFFSET) & 0x00000010) == 0){}
+
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_BLEN_REG_OFFSET, Bytes);
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_INSTR_REG_OFFSET, Instr & 0x1F00);
+
+	/* Write Go signal, DONE is raised once after the last byte */
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0x00000001);
+
+	return XST_SUCCESS;
+}
+
+/**
+ *
+ * Wait for the block instruction in progress.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *
+ * @return  The number of bytes transferred
+ *
+ */
+u32 AXI_1WIRE_HOST_BlockWait(u32 baseaddr) {
+	/* Wait for done signal to be 1 */
+	while((AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_STAT_REG_OFFSET) & 0x00000001) == 0){}
+
+	/* Clear Go signal in register 1 */
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0x00000000);
+
+	return AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_BCNT_REG_OFFSET) &
+	       AXI_1WIRE_HOST_BLOCK_MAX;
+}
+
+/**
+ *
+ * Get the number of entries of the ROM ID table.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *
+ * @return  The number of entries, 0 without ROM ID table
+ *
+ */
+u32 AXI_1WIRE_HOST_RomTableSize(u32 baseaddr) {
+	return W1_CAPS_ROM_ENTRIES(AXI_1WIRE_HOST_Capabilities(baseaddr));
+}
+
+/**
+ *
+ * Load the ROM ID table.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          Roms is the ROM IDs, family code first.
+ *          Count is the number of ROM IDs.
+ *
+ * @return  XST_SUCCESS, or XST_FAILURE without table or if Count is too large
+ *
+ */
+XStatus AXI_1WIRE_HOST_RomTableLoad(u32 baseaddr, const u8 (*Roms)[8], u32 Count) {
+	u32 i;
+
+	if (Count > AXI_1WIRE_HOST_RomTableSize(baseaddr))
+		return XST_FAILURE;
+
+	for (i = 0; i < Count; i++) {
+		AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_ROMIDX_REG_OFFSET, i);
+		AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_ROMLO_REG_OFFSET,
+					 Roms[i][0] | Roms[i][1] << 8 | Roms[i][2] << 16 |
+					 (u32)Roms[i][3] << 24);
+		/* Writing ROMHI stores the entry */
+		AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_ROMHI_REG_OFFSET,
+					 Roms[i][4] | Roms[i][5] << 8 | Roms[i][6] << 16 |
+					 (u32)Roms[i][7] << 24);
+	}
+
+	return XST_SUCCESS;
+}
+
+/*
+ * Sequenced instruction (ROM table, POLL_BIT), DONE raised once at the end.
+ * Returns the status.
+ */
+static u32 SeqInstr(u32 baseaddr, u32 Instr) {
+	u32 Stat;
+
+	/* Wait for READY signal to be 1 to ensure 1-wire IP is ready */
+	while((AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_STAT_REG_OFFSET) & 0x00000010) == 0){}
+
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_INSTR_REG_OFFSET, Instr);
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0x00000001);
+
+	/* Wait for done signal to be 1 */
+	while(((Stat = AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_STAT_REG_OFFSET)) & 0x00000001) == 0){}
+
+	/* Clear Go signal in register 1 */
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0x00000000);
+
+	return Stat;
+}
+
+/**
+ *
+ * Select the device of a ROM ID table entry.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          Index is the table entry.
+ *
+ * @return  0=Device present, 1=No device present
+ *
+ */
+u8 AXI_1WIRE_HOST_SelectRom(u32 baseaddr, u32 Index) {
+	/* The failure bit is set, and nothing sent after the reset, if no presence */
+	return (SeqInstr(baseaddr, AXI_1WIRE_HOST_SELECTROM | (Index & 0x3F)) &
+		AXI_1WIRE_HOST_PRESENCE) != 0;
+}
+
+/**
+ *
+ * Check which devices of the first entries of the ROM ID table are on the bus.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          Count is the number of entries.
+ *
+ * @return  One bit per entry, set if the device was found
+ *
+ */
+u64 AXI_1WIRE_HOST_PingAll(u32 baseaddr, u32 Count) {
+	if (Count > AXI_1WIRE_HOST_ROM_TABLE_MAX)
+		Count = AXI_1WIRE_HOST_ROM_TABLE_MAX;
+	SeqInstr(baseaddr, AXI_1WIRE_HOST_PINGALL | Count);
+
+	return (u64)AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_PING1_REG_OFFSET) << 32 |
+	       AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_PING0_REG_OFFSET);
+}
+
+/**
+ *
+ * Wait for a device to release the bus with read slots.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          IntervalUs is the time between two slots.
+ *          MaxSlots is the number of slots before giving up.
+ *
+ * @return  1 if a slot read 1, 0 if the device was still busy after MaxSlots
+ *
+ */
+u8 AXI_1WIRE_HOST_PollBit(u32 baseaddr, u32 IntervalUs, u32 MaxSlots) {
+	u32 i;
+	u8 val;
+	TRACE_VARS;
+
+	if (IntervalUs > AXI_1WIRE_HOST_POLL_MAX)
+		IntervalUs = AXI_1WIRE_HOST_POLL_MAX;
+	if (MaxSlots == 0)
+		MaxSlots = 1;
+	else if (MaxSlots > AXI_1WIRE_HOST_POLL_MAX)
+		MaxSlots = AXI_1WIRE_HOST_POLL_MAX;
+
+	/* POLL is aliased to another register before v01.7 */
+	if (!(AXI_1WIRE_HOST_Capabilities(baseaddr) & W1_CAP_POLL_BIT)) {
+		for (i = 0; i < MaxSlots; i++) {
+			if (i != 0 && IntervalUs != 0)
+				usleep(IntervalUs);
+			if (AXI_1WIRE_HOST_TouchBit(baseaddr, 1))
+				return 1;
+		}
+		return 0;
+	}
+
+	TRACE_BEGIN();
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_POLL_REG_OFFSET,
+				 IntervalUs << 16 | MaxSlots);
+	TRACE_ISSUE();
+	/* The failure bit is set if the last slot still read 0 */
+	val = (SeqInstr(baseaddr, AXI_1WIRE_HOST_POLLBIT) & AXI_1WIRE_HOST_PRESENCE) == 0;
+	TRACE_END(baseaddr, AXI_1WIRE_HOST_POLLBIT, !val);
 
 	return val;
 }
@@ -195,4 +571,63 @@ void AXI_1WIRE_HOST_GPIO_Write(u32 baseaddr, u8 bit) {
 	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_INSTR_REG_OFFSET, (bit & 0x1) ? 0x80010000 : 0x80000000 );
 
 	return;
-}
\ No newline at end of file
+}
+
+#ifdef AXI_1WIRE_HOST_TRACE
+XStatus AXI_1WIRE_HOST_TraceStart(u32 baseaddr, void *Mem, u32 Bytes) {
+	u32 Size = w1_trace_fit(Bytes);
+	int i, Free = -1;
+
+	if (Size == 0)
+		return XST_FAILURE;
+
+	for (i = 0; i < AXI_1WIRE_HOST_TRACE_INSTANCES; i++) {
+		if (TraceInstances[i].Ring == NULL || TraceInstances[i].BaseAddress == baseaddr) {
+			Free = i;
+			if (TraceInstances[i].Ring != NULL)
+				break;
+		}
+	}
+	if (Free < 0)
+		return XST_FAILURE;
+
+	/* Stop the previous recording of the instance while the ring is reset */
+	TraceInstances[Free].Ring = NULL;
+	w1_trace_init(Mem, Size, (u32)COUNTS_PER_SECOND);
+	TraceInstances[Free].BaseAddress = baseaddr;
+	TraceInstances[Free].Ring = Mem;
+
+	return XST_SUCCESS;
+}
+
+void AXI_1WIRE_HOST_TraceStop(u32 baseaddr) {
+	int i;
+
+	for (i = 0; i < AXI_1WIRE_HOST_TRACE_INSTANCES; i++)
+		if (TraceInstances[i].Ring != NULL && TraceInstances[i].BaseAddress == baseaddr)
+			TraceInstances[i].Ring = NULL;
+}
+
+void AXI_1WIRE_HOST_TraceRecord(u32 baseaddr, XTime Start, XTime Issue, u32 Instr, u8 Rx,
+				u8 Flags) {
+	struct w1_trace_rec Rec;
+	XTime End;
+	int i;
+
+	XTime_GetTime(&End);
+	for (i = 0; i < AXI_1WIRE_HOST_TRACE_INSTANCES; i++) {
+		if (TraceInstances[i].Ring != NULL && TraceInstances[i].BaseAddress == baseaddr)
+			break;
+	}
+	if (i == AXI_1WIRE_HOST_TRACE_INSTANCES)
+		return;
+
+	Rec.t = Start;
+	Rec.ready = (u32)(Issue - Start);
+	Rec.done = (u32)(End - Issue);
+	Rec.instr = (u16)Instr;
+	Rec.rx = Rx;
+	Rec.flags = Flags;
+	w1_trace_put(TraceInstances[i].Ring, &Rec);
+}
+#endif
@@ -11,6 +11,11 @@ SPDX-License-Identifier: MIT
 #include "xstatus.h"
 #include "xparameters.h"
 #include "xil_io.h"
+#include "w1_caps.h"
+#ifdef AXI_1WIRE_HOST_TRACE
+#include "xtime_l.h"
+#include "w1_trace.h"
+#endif
 
 #define AXI_1WIRE_HOST_INSTR_REG_OFFSET 0x0
 #define AXI_1WIRE_HOST_CTRL_REG_OFFSET 0x4
@@ -20,15 +25,77 @@ SPDX-License-Identifier: MIT
 #define AXI_1WIRE_HOST_GPIODATA_REG_OFFSET 0x14
 #define AXI_1WIRE_HOST_IPVER_REG_OFFSET 0x18
 #define AXI_1WIRE_HOST_IPID_REG_OFFSET 0x1C
+#define AXI_1WIRE_HOST_SPU_REG_OFFSET 0x20
+/* Slot timing, in AXI clock cycles, IP v01.4 or later */
+#define AXI_1WIRE_HOST_TRSTL_REG_OFFSET 0x24
+#define AXI_1WIRE_HOST_TMSP_REG_OFFSET 0x28
+#define AXI_1WIRE_HOST_TW0L_REG_OFFSET 0x2C
+#define AXI_1WIRE_HOST_TREC_REG_OFFSET 0x30
+#define AXI_1WIRE_HOST_TRDV_REG_OFFSET 0x34
+#define AXI_1WIRE_HOST_TW1L_REG_OFFSET 0x38
+#define AXI_1WIRE_HOST_TSLOT_REG_OFFSET 0x3C
+#define AXI_1WIRE_HOST_TCLK_REG_OFFSET 0x40	/* Read only, AXI clock cycles per us */
+#define AXI_1WIRE_HOST_TIMING_MAX	0x000FFFFF
+/* Block instructions, IP v01.5 or later built with the AXI4-Stream ports */
+#define AXI_1WIRE_HOST_BLEN_REG_OFFSET 0x44
+#define AXI_1WIRE_HOST_BCNT_REG_OFFSET 0x48	/* Read only */
+#define AXI_1WIRE_HOST_BCNT_STREAM	0x80000000	/* Stream ports present */
+#define AXI_1WIRE_HOST_BLOCK_MAX	0x0000FFFF
+/* ROM ID table, IP v01.6 or later built with ROM_TABLE entries */
+#define AXI_1WIRE_HOST_ROMIDX_REG_OFFSET 0x4C	/* Entry, number of entries in the MSB */
+#define AXI_1WIRE_HOST_ROMLO_REG_OFFSET 0x50
+#define AXI_1WIRE_HOST_ROMHI_REG_OFFSET 0x54	/* Written last, stores the entry */
+#define AXI_1WIRE_HOST_PING0_REG_OFFSET 0x58	/* Read only */
+#define AXI_1WIRE_HOST_PING1_REG_OFFSET 0x5C	/* Read only */
+#define AXI_1WIRE_HOST_ROM_TABLE_MAX	64
+/* Read slots polled by the IP, v01.7 or later */
+#define AXI_1WIRE_HOST_POLL_REG_OFFSET 0x60	/* Slots in the LSB, interval in us in the MSB */
+#define AXI_1WIRE_HOST_POLLCNT_REG_OFFSET 0x64	/* Read only, slots of the last POLL_BIT */
+#define AXI_1WIRE_HOST_POLL_MAX	0x0000FFFF
+/* Optional features of the instance, IP v01.8 or later, W1_CAP_* of w1_caps.h */
+#define AXI_1WIRE_HOST_CAPS_REG_OFFSET 0x68	/* Read only */
 
 #define AXI_1WIRE_HOST_INITPRES	0x0800
 #define AXI_1WIRE_HOST_READBIT	0x0C00
 #define AXI_1WIRE_HOST_WRITEBIT	0x0E00
 #define AXI_1WIRE_HOST_READBYTE	0x0D00
 #define AXI_1WIRE_HOST_WRITEBYTE	0x0F00
+#define AXI_1WIRE_HOST_READBLOCK	0x0900	/* BLEN bytes to the RX stream */
+#define AXI_1WIRE_HOST_WRITEBLOCK	0x0B00	/* BLEN bytes from the TX stream */
+#define AXI_1WIRE_HOST_SELECTROM	0x0A00	/* Reset and Match ROM of a table entry */
+#define AXI_1WIRE_HOST_PINGALL	0x0600	/* Search ROM along the first entries */
+#define AXI_1WIRE_HOST_POLLBIT	0x0700	/* Read slots until one reads 1 */
 #define AXI_1WIRE_HOST_RESET    0x80000000
+/* Instruction flag: drive the bus high for SPU_REG us after the byte/bit sent */
+#define AXI_1WIRE_HOST_SPU	0x1000
+
+/* Status register and interrupt enable register bits */
+#define AXI_1WIRE_HOST_DONE	0x00000001
+#define AXI_1WIRE_HOST_READY	0x00000010
+#define AXI_1WIRE_HOST_PRESENCE	0x80000000
+/* Control register go bit */
+#define AXI_1WIRE_HOST_GO	0x00000001
+
+/* Instances of the IP recording a bus trace at once */
+#define AXI_1WIRE_HOST_TRACE_INSTANCES	4
 
 /**************************** Type Definitions *****************************/
+/*
+ * Slot timing of the IP, in ns. The reset values of the IP are the standard
+ * speed ones: 480 us reset low, presence sampled 70 us after its release,
+ * 60 us write-0 low, 1 us recovery, read sampled at 15 us, 6 us write-1 and
+ * read low, 80 us slots.
+ */
+typedef struct {
+	u32 ResetLowNs;		/* Reset pulse low, and presence window after it */
+	u32 PresenceSampleNs;	/* Presence sampled, from the release of the reset */
+	u32 Write0LowNs;	/* Write-0 low, end of the data phase of a slot */
+	u32 RecoveryNs;		/* Recovery between two slots */
+	u32 ReadSampleNs;	/* Read sampled, from the start of the slot */
+	u32 Write1LowNs;	/* Write-1 and read low */
+	u32 SlotNs;		/* Slot, at least Write0LowNs + RecoveryNs */
+} AXI_1WIRE_HOST_Timing;
+
 /**
  *
  * Write a value to a AXI_1WIRE_HOST register. A 32 bit write is performed.
@@ -115,6 +182,19 @@ u8 AXI_1WIRE_HOST_ReadByte(u32 baseaddr);
  */
 void AXI_1WIRE_HOST_WriteByte(u32 baseaddr, u8 byte);
 
+/**
+ *
+ * Performs the write-byte function, then actively drives the bus high to
+ * power parasite powered devices (temperature conversion, EEPROM copy).
+ * Requires IP v01.3 or later.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          byte is the byte to write
+ *          duration_us is the strong pull-up duration in us (24 bits)
+ * 
+ */
+void AXI_1WIRE_HOST_WriteByteStrongPullup(u32 baseaddr, u8 byte, u32 duration_us);
+
 /**
  *
  * Performs the Reset-Presence function.
@@ -147,6 +227,196 @@ u8 AXI_1WIRE_HOST_ResetBus(u32 baseaddr);
  */
 XStatus AXI_1WIRE_HOST_SelfTest(u32 baseaddr);
 
+/**
+ *
+ * Run a benchmark of the driver/device. It measures the latency of each
+ * primitive, the MMIO access cost, the handshake overhead versus the bus time
+ * of the IP and the presence pulse margin, and prints them with histograms.
+ * The time is taken with XTime_GetTime().
+ *
+ * The bus is reset and driven through the GPIO mode during the benchmark, the
+ * devices are left idle waiting for a reset.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          iterations is the number of samples of each measurement, at most 256.
+ *
+ * @return
+ *
+ *    - XST_SUCCESS   if the IP was detected and benchmarked
+ *    - XST_FAILURE   if the self-test failed
+ *
+ */
+XStatus AXI_1WIRE_HOST_SelfTestBenchmark(u32 baseaddr, u32 iterations);
+
+/**
+ *
+ * Program the slot timing, to trim the slots and the recovery to what a short
+ * bus tolerates, or lengthen them for a long one. The durations are rounded
+ * up to the AXI clock cycle. Requires IP v01.4 or later, and the IP to be
+ * idle.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          Timing is the slot timing, a field of 0 keeps the current value.
+ *
+ * @return
+ *
+ *    - XST_SUCCESS   if the timing was programmed
+ *    - XST_FAILURE   if the IP has no timing registers or a duration does
+ *                    not fit in them
+ *
+ */
+XStatus AXI_1WIRE_HOST_SetTiming(u32 baseaddr, const AXI_1WIRE_HOST_Timing *Timing);
+
+/**
+ *
+ * Read the slot timing. Requires IP v01.4 or later.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          Timing receives the slot timing.
+ *
+ * @return
+ *
+ *    - XST_SUCCESS   if the timing was read
+ *    - XST_FAILURE   if the IP has no timing registers
+ *
+ */
+XStatus AXI_1WIRE_HOST_GetTiming(u32 baseaddr, AXI_1WIRE_HOST_Timing *Timing);
+
+/**
+ *
+ * Get the optional features of the IP, from its CAPS register from v01.8,
+ * else from its version and the registers added with each feature. The
+ * functions below check them before using an instruction the IP may lack.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *
+ * @return  The W1_CAP_* bits and the W1_CAPS_ROM_ENTRIES field of w1_caps.h,
+ *          0 if the IP version is unknown to this driver
+ *
+ */
+u32 AXI_1WIRE_HOST_Capabilities(u32 baseaddr);
+
+/**
+ *
+ * Check whether the IP runs the block instructions: IP v01.5 or later, built
+ * with the AXI4-Stream ports (BULK_STREAM).
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *
+ * @return  1 if the block instructions are available, 0 otherwise
+ *
+ */
+u32 AXI_1WIRE_HOST_HasBlockStream(u32 baseaddr);
+
+/**
+ *
+ * Start a block instruction and return without waiting for it. The bytes
+ * read are sent on the RX stream, the bytes written taken from the TX
+ * stream, so the DMA transfer must be started first, for Bytes bytes. The
+ * whole block costs the same few register accesses whatever its length.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          Instr is AXI_1WIRE_HOST_READBLOCK or AXI_1WIRE_HOST_WRITEBLOCK,
+ *          with AXI_1WIRE_HOST_SPU for a strong pull-up of SPU_REG us after
+ *          the last byte written.
+ *          Bytes is the number of bytes, at most AXI_1WIRE_HOST_BLOCK_MAX.
+ *
+ * @return
+ *
+ *    - XST_SUCCESS   if the block started
+ *    - XST_FAILURE   if the IP has no block instructions or Bytes is too large
+ *
+ */
+XStatus AXI_1WIRE_HOST_BlockStart(u32 baseaddr, u32 Instr, u32 Bytes);
+
+/**
+ *
+ * Wait for the block instruction started by AXI_1WIRE_HOST_BlockStart. It
+ * only completes once every byte went through the streams: a DMA transfer
+ * shorter than the block stalls it until AXI_1WIRE_HOST_Reset.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *
+ * @return  The number of bytes transferred
+ *
+ */
+u32 AXI_1WIRE_HOST_BlockWait(u32 baseaddr);
+
+/**
+ *
+ * Get the number of entries of the ROM ID table: IP v01.6 or later, built
+ * with ROM_TABLE entries.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *
+ * @return  The number of entries, 0 without ROM ID table
+ *
+ */
+u32 AXI_1WIRE_HOST_RomTableSize(u32 baseaddr);
+
+/**
+ *
+ * Load the ROM ID table with the ROM IDs found by a Search ROM, in entries 0
+ * to Count - 1. The table keeps them until the next load.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          Roms is the ROM IDs, family code first as on the bus.
+ *          Count is the number of ROM IDs.
+ *
+ * @return
+ *
+ *    - XST_SUCCESS   if the table was loaded
+ *    - XST_FAILURE   if the IP has no table or Count is larger than it
+ *
+ */
+XStatus AXI_1WIRE_HOST_RomTableLoad(u32 baseaddr, const u8 (*Roms)[8], u32 Count);
+
+/**
+ *
+ * Select the device of a table entry with a single SELECT_ROM instruction:
+ * reset, Match ROM and its ROM ID, as AXI_1WIRE_HOST_ResetBus followed by
+ * nine AXI_1WIRE_HOST_WriteByte.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          Index is the table entry.
+ *
+ * @return  0=Device present, 1=No device present
+ *
+ */
+u8 AXI_1WIRE_HOST_SelectRom(u32 baseaddr, u32 Index);
+
+/**
+ *
+ * Check which devices of the table entries 0 to Count - 1 are on the bus,
+ * with a single PING_ALL instruction: a Search ROM pass along the ROM ID of
+ * each entry, which only completes if the device answers.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          Count is the number of entries.
+ *
+ * @return  One bit per entry, set if the device was found
+ *
+ */
+u64 AXI_1WIRE_HOST_PingAll(u32 baseaddr, u32 Count);
+
+/**
+ *
+ * Wait for a device to release the bus, at the end of a conversion or of a
+ * copy to its EEPROM: read slots IntervalUs apart until one reads 1, at most
+ * MaxSlots. From IP v01.7 a single POLL_BIT instruction runs the slots, DONE
+ * (and its interrupt) being raised once at the end; before, it is a loop of
+ * AXI_1WIRE_HOST_TouchBit and usleep.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          IntervalUs is the time between two slots, up to AXI_1WIRE_HOST_POLL_MAX.
+ *          MaxSlots is the number of slots before giving up, 1 to
+ *          AXI_1WIRE_HOST_POLL_MAX.
+ *
+ * @return  1 if a slot read 1, 0 if the device was still busy after MaxSlots
+ *
+ */
+u8 AXI_1WIRE_HOST_PollBit(u32 baseaddr, u32 IntervalUs, u32 MaxSlots);
+
 /**
  *
  * Read the 1-Wire bus level. The 1-Wire bus is controlled through GPIO.
@@ -170,4 +440,51 @@ u8 AXI_1WIRE_HOST_GPIO_Read(u32 baseaddr);
  */
 void AXI_1WIRE_HOST_GPIO_Write(u32 baseaddr, u8 bit);
 
+#ifdef AXI_1WIRE_HOST_TRACE
+/**
+ *
+ * Start recording every primitive of an instance in a ring, see w1_trace.h.
+ * The ring is left in memory when stopped, to be dumped from the target:
+ *     xsdb% mrd -bin -file trace.bin <Mem> <Bytes / 4>
+ * Built with AXI_1WIRE_HOST_TRACE only, the times are XTime_GetTime() ticks.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          Mem is the memory of the ring, 8 bytes aligned.
+ *          Bytes is the size of Mem, W1_TRACE_RING_BYTES(records).
+ *
+ * @return
+ *
+ *    - XST_SUCCESS   if the recording started
+ *    - XST_FAILURE   if Mem is too small or AXI_1WIRE_HOST_TRACE_INSTANCES
+ *                    instances are already recording
+ *
+ */
+XStatus AXI_1WIRE_HOST_TraceStart(u32 baseaddr, void *Mem, u32 Bytes);
+
+/**
+ *
+ * Stop recording the primitives of an instance.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *
+ */
+void AXI_1WIRE_HOST_TraceStop(u32 baseaddr);
+
+/**
+ *
+ * Record a primitive ending now, if the instance is recording. Called by the
+ * driver layers.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          Start is the time before the READY wait.
+ *          Issue is the time of the instruction write.
+ *          Instr is the instruction.
+ *          Rx is the data read, or the presence failure bit of INITPRES.
+ *          Flags are the W1_TRACE_* flags.
+ *
+ */
+void AXI_1WIRE_HOST_TraceRecord(u32 baseaddr, XTime Start, XTime Issue, u32 Instr, u8 Rx,
+				u8 Flags);
+#endif
+
 #endif // AXI_1WIRE_HOST_H
\ No newline at end of file
@@ -0,0 +1,280 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+/***************************** Include Files *******************************/
+#include "xil_types.h"
+#ifndef AXI_1WIRE_HOST_RTOS
+#include "bspconfig.h"
+#endif
+
+/* Only built with FreeRTOS, empty in a standalone BSP */
+#if defined(FREERTOS_BSP) || defined(AXI_1WIRE_HOST_RTOS)
+#include "axi_1wire_host_rtos.h"
+
+/************************** Function Definitions ***************************/
+/*
+ * Wait for a status bit (AXI_1WIRE_HOST_READY or AXI_1WIRE_HOST_DONE) to be
+ * set, blocking the task on the interrupt semaphore instead of polling. The
+ * interrupt enable bits have the same position as the status bits.
+ */
+static XStatus AXI_1WIRE_HOST_RTOS_WaitStatus(AXI_1WIRE_HOST_Rtos *InstancePtr, u32 Mask,
+					      TickType_t Timeout)
+{
+	u32 baseaddr = InstancePtr->BaseAddress;
+
+	while ((AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_STAT_REG_OFFSET) & Mask) == 0) {
+		/* Drop a stale give left by an earlier timed out wait */
+		(void)xSemaphoreTake(InstancePtr->IrqSem, 0);
+		/* The interrupt is level triggered, it fires at once if the bit got set meanwhile */
+		AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_IRQCTRL_REG_OFFSET, Mask);
+		if (xSemaphoreTake(InstancePtr->IrqSem, Timeout) != pdTRUE) {
+			AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_IRQCTRL_REG_OFFSET, 0);
+			return XST_TIMEOUT;
+		}
+	}
+	return XST_SUCCESS;
+}
+
+/*
+ * Run one instruction through the READY/GO/DONE handshake, the bus mutex
+ * being held. DoneTimeout is the timeout of the DONE wait, RxData receives
+ * the data register when not NULL.
+ */
+static XStatus AXI_1WIRE_HOST_RTOS_Execute(AXI_1WIRE_HOST_Rtos *InstancePtr, u32 Instr,
+					   TickType_t DoneTimeout, u32 *Stat, u32 *RxData)
+{
+	u32 baseaddr = InstancePtr->BaseAddress;
+	XStatus Status;
+#ifdef AXI_1WIRE_HOST_TRACE
+	XTime TraceStart, TraceIssue;
+	u8 Rx;
+#endif
+
+	if (AXI_1WIRE_HOST_RTOS_Lock(InstancePtr) != XST_SUCCESS)
+		return XST_DEVICE_BUSY;
+
+#ifdef AXI_1WIRE_HOST_TRACE
+	XTime_GetTime(&TraceStart);
+	TraceIssue = TraceStart;
+#endif
+	/* Wait for READY signal to be 1 to ensure 1-wire IP is ready */
+	Status = AXI_1WIRE_HOST_RTOS_WaitStatus(InstancePtr, AXI_1WIRE_HOST_READY,
+						InstancePtr->Timeout);
+	if (Status != XST_SUCCESS)
+		goto out;
+
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_INSTR_REG_OFFSET, Instr);
+
+	/* Write Go signal and clear control reset signal in control register */
+#ifdef AXI_1WIRE_HOST_TRACE
+	XTime_GetTime(&TraceIssue);
+#endif
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, AXI_1WIRE_HOST_GO);
+
+	/* Sleep until the done signal is 1, the bus slot time is given to other tasks */
+	Status = AXI_1WIRE_HOST_RTOS_WaitStatus(InstancePtr, AXI_1WIRE_HOST_DONE, DoneTimeout);
+	if (Status != XST_SUCCESS)
+		goto out;
+
+	if (Stat != NULL)
+		*Stat = AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_STAT_REG_OFFSET);
+	if (RxData != NULL)
+		*RxData = AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_RXDATA_REG_OFFSET);
+
+	/* Clear Go signal in control register */
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0x00000000);
+
+out:
+#ifdef AXI_1WIRE_HOST_TRACE
+	/* The DONE wait sleeps on the interrupt */
+	if (Status != XST_SUCCESS)
+		Rx = 0xFF;
+	else if (Stat != NULL)
+		Rx = (*Stat & AXI_1WIRE_HOST_PRESENCE) ? 1 : 0;
+	else
+		Rx = RxData != NULL ? (u8)*RxData : 0;
+	AXI_1WIRE_HOST_TraceRecord(baseaddr, TraceStart, TraceIssue, Instr, Rx,
+				   W1_TRACE_IRQ | (Status != XST_SUCCESS ? W1_TRACE_ERROR : 0));
+#endif
+	AXI_1WIRE_HOST_RTOS_Unlock(InstancePtr);
+	return Status;
+}
+
+XStatus AXI_1WIRE_HOST_RTOS_Initialize(AXI_1WIRE_HOST_Rtos *InstancePtr, u32 baseaddr,
+				       TickType_t Timeout)
+{
+	InstancePtr->BaseAddress = baseaddr;
+	InstancePtr->Timeout = Timeout;
+	InstancePtr->IrqSem = xSemaphoreCreateBinary();
+	InstancePtr->BusMutex = xSemaphoreCreateRecursiveMutex();
+	if (InstancePtr->IrqSem == NULL || InstancePtr->BusMutex == NULL)
+		return XST_FAILURE;
+
+	InstancePtr->Caps = AXI_1WIRE_HOST_Capabilities(baseaddr);
+
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_IRQCTRL_REG_OFFSET, 0);
+	AXI_1WIRE_HOST_Reset(baseaddr);
+
+	return XST_SUCCESS;
+}
+
+void AXI_1WIRE_HOST_RTOS_IntrHandler(void *CallBackRef)
+{
+	AXI_1WIRE_HOST_Rtos *InstancePtr = CallBackRef;
+	BaseType_t HigherPriorityTaskWoken = pdFALSE;
+
+	/* Reset interrupt trigger */
+	AXI_1WIRE_HOST_mWriteReg(InstancePtr->BaseAddress, AXI_1WIRE_HOST_IRQCTRL_REG_OFFSET, 0);
+
+	xSemaphoreGiveFromISR(InstancePtr->IrqSem, &HigherPriorityTaskWoken);
+	portYIELD_FROM_ISR(HigherPriorityTaskWoken);
+}
+
+XStatus AXI_1WIRE_HOST_RTOS_Lock(AXI_1WIRE_HOST_Rtos *InstancePtr)
+{
+	if (xSemaphoreTakeRecursive(InstancePtr->BusMutex, InstancePtr->Timeout) != pdTRUE)
+		return XST_DEVICE_BUSY;
+	return XST_SUCCESS;
+}
+
+void AXI_1WIRE_HOST_RTOS_Unlock(AXI_1WIRE_HOST_Rtos *InstancePtr)
+{
+	(void)xSemaphoreGiveRecursive(InstancePtr->BusMutex);
+}
+
+XStatus AXI_1WIRE_HOST_RTOS_ResetBus(AXI_1WIRE_HOST_Rtos *InstancePtr, u8 *Presence)
+{
+	XStatus Status;
+	u32 Stat;
+
+	if (AXI_1WIRE_HOST_RTOS_Lock(InstancePtr) != XST_SUCCESS)
+		return XST_DEVICE_BUSY;
+
+	/* Reset 1-wire Axi IP */
+	AXI_1WIRE_HOST_mWriteReg(InstancePtr->BaseAddress, AXI_1WIRE_HOST_CTRL_REG_OFFSET,
+				 AXI_1WIRE_HOST_RESET);
+
+	Status = AXI_1WIRE_HOST_RTOS_Execute(InstancePtr, AXI_1WIRE_HOST_INITPRES,
+					     InstancePtr->Timeout, &Stat, NULL);
+	if (Status == XST_SUCCESS)
+		*Presence = ((Stat & AXI_1WIRE_HOST_PRESENCE) != 0) ? 1 : 0;
+
+	AXI_1WIRE_HOST_RTOS_Unlock(InstancePtr);
+	return Status;
+}
+
+XStatus AXI_1WIRE_HOST_RTOS_TouchBit(AXI_1WIRE_HOST_Rtos *InstancePtr, u8 bit, u8 *Value)
+{
+	XStatus Status;
+	u32 RxData;
+
+	if (bit) {
+		Status = AXI_1WIRE_HOST_RTOS_Execute(InstancePtr, AXI_1WIRE_HOST_READBIT,
+						     InstancePtr->Timeout, NULL, &RxData);
+		if (Status == XST_SUCCESS)
+			*Value = (u8)(RxData & 0x00000001);
+	} else {
+		Status = AXI_1WIRE_HOST_RTOS_Execute(InstancePtr, AXI_1WIRE_HOST_WRITEBIT,
+						     InstancePtr->Timeout, NULL, NULL);
+		if (Status == XST_SUCCESS)
+			*Value = 0;
+	}
+	return Status;
+}
+
+XStatus AXI_1WIRE_HOST_RTOS_ReadByte(AXI_1WIRE_HOST_Rtos *InstancePtr, u8 *Value)
+{
+	XStatus Status;
+	u32 RxData;
+
+	Status = AXI_1WIRE_HOST_RTOS_Execute(InstancePtr, AXI_1WIRE_HOST_READBYTE,
+					     InstancePtr->Timeout, NULL, &RxData);
+	if (Status == XST_SUCCESS)
+		*Value = (u8)(RxData & 0x000000FF);
+	return Status;
+}
+
+XStatus AXI_1WIRE_HOST_RTOS_WriteByte(AXI_1WIRE_HOST_Rtos *InstancePtr, u8 byte)
+{
+	return AXI_1WIRE_HOST_RTOS_Execute(InstancePtr, AXI_1WIRE_HOST_WRITEBYTE + byte,
+					   InstancePtr->Timeout, NULL, NULL);
+}
+
+XStatus AXI_1WIRE_HOST_RTOS_WaitConversion(AXI_1WIRE_HOST_Rtos *InstancePtr, u32 ConvTimeMs)
+{
+	u32 baseaddr = InstancePtr->BaseAddress;
+	TickType_t Start;
+	XStatus Status;
+	u32 Stat;
+	u8 Value;
+
+	vTaskDelay(pdMS_TO_TICKS(ConvTimeMs));
+
+	/* From v01.7, the IP runs the read slots, the task sleeps until DONE */
+	if (InstancePtr->Caps & W1_CAP_POLL_BIT) {
+		if (AXI_1WIRE_HOST_RTOS_Lock(InstancePtr) != XST_SUCCESS)
+			return XST_DEVICE_BUSY;
+		AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_POLL_REG_OFFSET,
+					 (AXI_1WIRE_HOST_RTOS_CONV_POLL_MS * 1000) << 16 |
+					 (ConvTimeMs / AXI_1WIRE_HOST_RTOS_CONV_POLL_MS + 1));
+		Status = AXI_1WIRE_HOST_RTOS_Execute(InstancePtr, AXI_1WIRE_HOST_POLLBIT,
+						     InstancePtr->Timeout + pdMS_TO_TICKS(ConvTimeMs),
+						     &Stat, NULL);
+		AXI_1WIRE_HOST_RTOS_Unlock(InstancePtr);
+		if (Status == XST_SUCCESS && (Stat & AXI_1WIRE_HOST_PRESENCE))
+			Status = XST_TIMEOUT;
+		return Status;
+	}
+
+	Start = xTaskGetTickCount();
+	for (;;) {
+		Status = AXI_1WIRE_HOST_RTOS_TouchBit(InstancePtr, 1, &Value);
+		if (Status != XST_SUCCESS || Value != 0)
+			return Status;
+		if (xTaskGetTickCount() - Start > pdMS_TO_TICKS(ConvTimeMs))
+			return XST_TIMEOUT;
+		vTaskDelay(AXI_1WIRE_HOST_RTOS_CONV_POLL);
+	}
+}
+
+XStatus AXI_1WIRE_HOST_RTOS_PioWrite(AXI_1WIRE_HOST_Rtos *InstancePtr, const u8 *Rom, u8 Value,
+				     u8 *State)
+{
+	u8 Frame[12], Confirm = 0, PioState = 0, Presence;
+	XStatus Status;
+	int i;
+
+	Frame[0] = 0x55;
+	for (i = 0; i < 8; i++)
+		Frame[1 + i] = Rom[i];
+	Frame[9] = 0x5A;
+	Frame[10] = Value;
+	Frame[11] = (u8)~Value;
+
+	if (AXI_1WIRE_HOST_RTOS_Lock(InstancePtr) != XST_SUCCESS)
+		return XST_DEVICE_BUSY;
+
+	Status = AXI_1WIRE_HOST_RTOS_ResetBus(InstancePtr, &Presence);
+	if (Status == XST_SUCCESS && Presence != 0)
+		Status = XST_DEVICE_NOT_FOUND;
+	/* The latch changes once the complement is received */
+	for (i = 0; i < (int)sizeof(Frame) && Status == XST_SUCCESS; i++)
+		Status = AXI_1WIRE_HOST_RTOS_WriteByte(InstancePtr, Frame[i]);
+	if (Status == XST_SUCCESS)
+		Status = AXI_1WIRE_HOST_RTOS_ReadByte(InstancePtr, &Confirm);
+	if (Status == XST_SUCCESS)
+		Status = AXI_1WIRE_HOST_RTOS_ReadByte(InstancePtr, &PioState);
+	/* The switch sends the PIO state until a reset */
+	if (Status == XST_SUCCESS)
+		Status = AXI_1WIRE_HOST_RTOS_ResetBus(InstancePtr, &Presence);
+
+	AXI_1WIRE_HOST_RTOS_Unlock(InstancePtr);
+	if (Status == XST_SUCCESS && Confirm != 0xAA)
+		Status = XST_FAILURE;
+	if (Status == XST_SUCCESS && State != NULL)
+		*State = PioState;
+	return Status;
+}
+
+#endif /* FREERTOS_BSP || AXI_1WIRE_HOST_RTOS */
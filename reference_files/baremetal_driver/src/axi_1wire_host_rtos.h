@@ -0,0 +1,175 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef AXI_1WIRE_HOST_RTOS_H
+#define AXI_1WIRE_HOST_RTOS_H
+
+/*
+ * FreeRTOS port layer of the AXI_1WIRE_HOST driver.
+ *
+ * Instead of busy waiting on the READY and DONE status bits, the calling task
+ * enables the matching interrupt and blocks on a semaphore given by
+ * AXI_1WIRE_HOST_RTOS_IntrHandler(), which must be connected to the w1_irq
+ * output of the IP (XScuGic_Connect() or xPortInstallInterruptHandler()).
+ * Every primitive holds a recursive bus mutex so several tasks can share one
+ * host; a task holds it across a whole transaction with
+ * AXI_1WIRE_HOST_RTOS_Lock() and AXI_1WIRE_HOST_RTOS_Unlock().
+ *
+ * The layer is built with the FreeRTOS BSP (FREERTOS_BSP), or with any other
+ * FreeRTOS port such as the POSIX one by defining AXI_1WIRE_HOST_RTOS.
+ */
+
+/****************** Include Files ********************/
+#include "axi_1wire_host.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+/* Default timeout of every READY/DONE wait, as the Linux driver */
+#define AXI_1WIRE_HOST_RTOS_TIMEOUT	pdMS_TO_TICKS(100)
+
+/* Read slot period once the conversion time has elapsed */
+#define AXI_1WIRE_HOST_RTOS_CONV_POLL_MS	10
+#define AXI_1WIRE_HOST_RTOS_CONV_POLL	pdMS_TO_TICKS(AXI_1WIRE_HOST_RTOS_CONV_POLL_MS)
+
+/**************************** Type Definitions *****************************/
+typedef struct {
+	u32 BaseAddress;		/* Base address of the AXI_1WIRE_HOST instance */
+	TickType_t Timeout;		/* Timeout of every READY/DONE wait */
+	SemaphoreHandle_t IrqSem;	/* Given from the interrupt handler */
+	SemaphoreHandle_t BusMutex;	/* Recursive, serializes the bus users */
+	u32 Caps;			/* AXI_1WIRE_HOST_Capabilities(), read at initialization */
+} AXI_1WIRE_HOST_Rtos;
+
+/************************** Function Prototypes ****************************/
+/**
+ *
+ * Initialize an instance of the FreeRTOS port layer, read the optional
+ * features of the IP and reset it. It needs configUSE_RECURSIVE_MUTEXES.
+ *
+ * @param   InstancePtr is the instance to initialize.
+ *          baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          Timeout is the timeout of every READY/DONE wait, in ticks.
+ *
+ * @return  XST_SUCCESS, or XST_FAILURE if the semaphores could not be created
+ *
+ */
+XStatus AXI_1WIRE_HOST_RTOS_Initialize(AXI_1WIRE_HOST_Rtos *InstancePtr, u32 baseaddr,
+				       TickType_t Timeout);
+
+/**
+ *
+ * Interrupt handler of the w1_irq output. Clears the interrupt enables and
+ * wakes up the waiting task.
+ *
+ * @param   CallBackRef is the AXI_1WIRE_HOST_Rtos instance.
+ *
+ */
+void AXI_1WIRE_HOST_RTOS_IntrHandler(void *CallBackRef);
+
+/**
+ *
+ * Take/give the bus mutex to keep the bus across several primitives, e.g.
+ * from the reset to the last byte read of a transaction.
+ *
+ * @param   InstancePtr is the instance to be worked on.
+ *
+ * @return  XST_SUCCESS, or XST_DEVICE_BUSY if the bus could not be taken
+ *          within the instance timeout
+ *
+ */
+XStatus AXI_1WIRE_HOST_RTOS_Lock(AXI_1WIRE_HOST_Rtos *InstancePtr);
+void AXI_1WIRE_HOST_RTOS_Unlock(AXI_1WIRE_HOST_Rtos *InstancePtr);
+
+/**
+ *
+ * Performs the Reset-Presence function.
+ *
+ * @param   InstancePtr is the instance to be worked on.
+ *          Presence receives 0=Device present, 1=No device present.
+ *
+ * @return  XST_SUCCESS, XST_DEVICE_BUSY or XST_TIMEOUT
+ *
+ */
+XStatus AXI_1WIRE_HOST_RTOS_ResetBus(AXI_1WIRE_HOST_Rtos *InstancePtr, u8 *Presence);
+
+/**
+ *
+ * Performs the touch-bit function - write a 0 or 1 and reads the bus level.
+ *
+ * @param   InstancePtr is the instance to be worked on.
+ *          bit is the level to write. To read the bus level, bit is set to 1.
+ *          Value receives the level read.
+ *
+ * @return  XST_SUCCESS, XST_DEVICE_BUSY or XST_TIMEOUT
+ *
+ */
+XStatus AXI_1WIRE_HOST_RTOS_TouchBit(AXI_1WIRE_HOST_Rtos *InstancePtr, u8 bit, u8 *Value);
+
+/**
+ *
+ * Performs the read-byte function.
+ *
+ * @param   InstancePtr is the instance to be worked on.
+ *          Value receives the value read.
+ *
+ * @return  XST_SUCCESS, XST_DEVICE_BUSY or XST_TIMEOUT
+ *
+ */
+XStatus AXI_1WIRE_HOST_RTOS_ReadByte(AXI_1WIRE_HOST_Rtos *InstancePtr, u8 *Value);
+
+/**
+ *
+ * Performs the write-byte function.
+ *
+ * @param   InstancePtr is the instance to be worked on.
+ *          byte is the byte to write.
+ *
+ * @return  XST_SUCCESS, XST_DEVICE_BUSY or XST_TIMEOUT
+ *
+ */
+XStatus AXI_1WIRE_HOST_RTOS_WriteByte(AXI_1WIRE_HOST_Rtos *InstancePtr, u8 byte);
+
+/**
+ *
+ * Waits for the end of a temperature conversion (or an EEPROM copy): the task
+ * sleeps ConvTimeMs with the bus free for the other tasks, then reads slots
+ * every AXI_1WIRE_HOST_RTOS_CONV_POLL until the device reads 1. From IP
+ * v01.7 the slots are a single POLL_BIT instruction, the task sleeping on its
+ * DONE interrupt with the bus held.
+ *
+ * @param   InstancePtr is the instance to be worked on.
+ *          ConvTimeMs is the conversion time, see w1_temp_conv_time_ms().
+ *
+ * @return  XST_SUCCESS, XST_DEVICE_BUSY, or XST_TIMEOUT if the device is still
+ *          busy after another ConvTimeMs
+ *
+ */
+XStatus AXI_1WIRE_HOST_RTOS_WaitConversion(AXI_1WIRE_HOST_Rtos *InstancePtr, u32 ConvTimeMs);
+
+/**
+ *
+ * Sets the PIO output latch of a DS2413 or DS2408 switch: reset, Match ROM,
+ * PIO Access Write (0x5A, Value, ~Value), then the confirmation byte (0xAA)
+ * and the PIO state are read and a reset ends the access, the bus mutex
+ * held throughout. The mutex hands the bus to the highest priority task
+ * waiting for it, at the end of the transaction of the task holding it, and
+ * lends that task the priority meanwhile: calling it from a task of higher
+ * priority than the sensor tasks bounds the wait to the longest of their
+ * Lock()/Unlock() sections.
+ *
+ * @param   InstancePtr is the instance to be worked on.
+ *          Rom is the ROM ID of the switch.
+ *          Value is the latch byte.
+ *          State receives the PIO status byte, NULL if not needed.
+ *
+ * @return  XST_SUCCESS, XST_DEVICE_NOT_FOUND if no device answered the reset,
+ *          XST_FAILURE if the switch did not confirm (the latch is unchanged),
+ *          XST_DEVICE_BUSY or XST_TIMEOUT
+ *
+ */
+XStatus AXI_1WIRE_HOST_RTOS_PioWrite(AXI_1WIRE_HOST_Rtos *InstancePtr, const u8 *Rom, u8 Value,
+				     u8 *State);
+
+#endif // AXI_1WIRE_HOST_RTOS_H
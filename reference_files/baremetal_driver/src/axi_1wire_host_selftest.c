@@ -7,8 +7,33 @@ SPDX-License-Identifier: MIT
 #include "xparameters.h"
 #include "stdio.h"
 #include "xil_io.h"
+#include "xtime_l.h"
 
 /************************** Constant Definitions ***************************/
+/*
+ * Nominal GO to DONE time of each primitive with a 1 MHz time base, in us:
+ * the IP starts on the 1 MHz edge following GO and raises DONE 60 us into
+ * the last 80 us slot, the slot recovery overlapping the handshake.
+ */
+#define BENCH_RESET_SLOT_US	961
+#define BENCH_BIT_SLOT_US	61
+#define BENCH_BYTE_SLOT_US	(7 * 80 + BENCH_BIT_SLOT_US)
+/* Presence pulse sampling point of the IP after the reset pulse release, in us */
+#define BENCH_PRESENCE_SAMPLE_NS	(70 * 1000)
+
+#define BENCH_MAX_SAMPLES	256
+#define BENCH_HIST_BUCKETS	8
+
+/**************************** Type Definitions *****************************/
+typedef struct {
+	const char *name;
+	u32 nominal_ns;		/* Pure bus time, 0 if not applicable */
+	u32 count;
+	u32 samples[BENCH_MAX_SAMPLES];	/* ns */
+} bench_stat;
+
+static bench_stat bench_stats[9];
+
 /************************** Function Definitions ***************************/
 /**
  *
@@ -33,6 +58,7 @@ XStatus AXI_1WIRE_HOST_SelfTest(u32 baseaddr)
 {
 	u32 ip_id;
 	u32 ip_ver;
+	u32 caps;
 
 	xil_printf("******************************\n\r");
 	xil_printf("* AXI 1-Wire Host Self Test\n\r");
@@ -51,6 +77,275 @@ XStatus AXI_1WIRE_HOST_SelfTest(u32 baseaddr)
 	}
 	xil_printf("* IP Subsystem vendor ID is 0x%x\n\r* ID is 0x%x\n\r", ((ip_id >> 16) & 0xFFFF), (ip_id & 0xFFFF));
 	xil_printf("* IP version is %x.%x\n\r", ((ip_ver >> 8) & 0xFFFF), (ip_ver & 0xFF));
+	caps = AXI_1WIRE_HOST_Capabilities(baseaddr);
+	xil_printf("* Features:%s%s%s%s%s\n\r", (caps & W1_CAP_SPU) ? " SPU" : "",
+		   (caps & W1_CAP_TIMING) ? " TIMING" : "", (caps & W1_CAP_BLOCK) ? " BLOCK" : "",
+		   (caps & W1_CAP_ROM_TABLE) ? " ROM_TABLE" : "",
+		   (caps & W1_CAP_POLL_BIT) ? " POLL_BIT" : "");
+	if (caps & W1_CAP_ROM_TABLE)
+		xil_printf("* ROM ID table of %d entries\n\r", (int)W1_CAPS_ROM_ENTRIES(caps));
+	xil_printf("******************************\n\n\r");
+
+	return XST_SUCCESS;
+}
+
+
+/*
+ * Elapsed time between two XTime_GetTime() samples, in ns.
+ */
+static u32 bench_ns(XTime start, XTime end)
+{
+	return (u32)(((end - start) * 1000000000ULL) / COUNTS_PER_SECOND);
+}
+
+static void bench_add(bench_stat *stat, XTime start, XTime end)
+{
+	if (stat->count < BENCH_MAX_SAMPLES)
+		stat->samples[stat->count++] = bench_ns(start, end);
+}
+
+static u32 bench_avg(const bench_stat *stat)
+{
+	u64 sum = 0;
+	u32 i;
+
+	for (i = 0; i < stat->count; i++)
+		sum += stat->samples[i];
+	return (stat->count != 0) ? (u32)(sum / stat->count) : 0;
+}
+
+/*
+ * Print min/avg/max of a measurement, its overhead over the nominal bus time
+ * and a linear histogram of the samples between min and max.
+ */
+static void bench_print(const bench_stat *stat)
+{
+	u32 min = 0xFFFFFFFF, max = 0, bucket, width, i, j;
+	u32 hist[BENCH_HIST_BUCKETS] = {0};
+	int overhead, permille;
+	u32 avg;
+
+	if (stat->count == 0)
+		return;
+
+	for (i = 0; i < stat->count; i++) {
+		if (stat->samples[i] < min)
+			min = stat->samples[i];
+		if (stat->samples[i] > max)
+			max = stat->samples[i];
+	}
+	avg = bench_avg(stat);
+	width = (max - min) / BENCH_HIST_BUCKETS + 1;
+	for (i = 0; i < stat->count; i++) {
+		bucket = (stat->samples[i] - min) / width;
+		hist[bucket]++;
+	}
+
+	xil_printf("* %s: min %d ns, avg %d ns, max %d ns (%d samples)\n\r",
+		   stat->name, min, avg, max, stat->count);
+	if (stat->nominal_ns != 0) {
+		overhead = (int)avg - (int)stat->nominal_ns;
+		permille = (int)(((s64)overhead * 1000) / stat->nominal_ns);
+		xil_printf("*   bus time %d ns, host overhead %d ns (%d.%d%%)\n\r",
+			   stat->nominal_ns, overhead, permille / 10,
+			   (permille < 0) ? -permille % 10 : permille % 10);
+	}
+	for (i = 0; i < BENCH_HIST_BUCKETS; i++) {
+		xil_printf("*   [%8d, %8d[ %4d ", min + i * width, min + (i + 1) * width, hist[i]);
+		for (j = 0; j < (hist[i] * 40) / stat->count; j++)
+			xil_printf("#");
+		xil_printf("\n\r");
+	}
+}
+
+/*
+ * Issue an instruction through the GO/DONE handshake, splitting the time
+ * spent by the IP executing it (GO to DONE) from the time spent in the
+ * handshake (READY wait, register accesses).
+ */
+static void bench_handshake(u32 baseaddr, u32 instr, bench_stat *total, bench_stat *engine)
+{
+	XTime t0, t1, t2, t3;
+
+	XTime_GetTime(&t0);
+	while((AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_STAT_REG_OFFSET) & 0x00000010) == 0){}
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_INSTR_REG_OFFSET, instr);
+	XTime_GetTime(&t1);
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0x00000001);
+	while((AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_STAT_REG_OFFSET) & 0x00000001) == 0){}
+	XTime_GetTime(&t2);
+	(void)AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_RXDATA_REG_OFFSET);
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0x00000000);
+	XTime_GetTime(&t3);
+
+	bench_add(total, t0, t3);
+	bench_add(engine, t1, t2);
+}
+
+/*
+ * Measure the presence pulse through the GPIO mode of the IP: drive a 480 us
+ * reset pulse, release the bus and timestamp the presence pulse edges.
+ * Returns 0 if no presence pulse was seen.
+ */
+static u8 bench_presence(u32 baseaddr, u32 *start_ns, u32 *end_ns)
+{
+	XTime t0, t;
+	u8 present = 0;
+	u32 ns;
+
+	AXI_1WIRE_HOST_GPIO_Write(baseaddr, 0);
+	XTime_GetTime(&t0);
+	do {
+		XTime_GetTime(&t);
+	} while (bench_ns(t0, t) < 480000);
+
+	/* Release the bus, sample it for 480 us */
+	XTime_GetTime(&t0);
+	*start_ns = 0;
+	*end_ns = 0;
+	do {
+		XTime_GetTime(&t);
+		ns = bench_ns(t0, t);
+		if (AXI_1WIRE_HOST_GPIO_Read(baseaddr) == 0) {
+			if (!present)
+				*start_ns = ns;
+			present = 1;
+			*end_ns = ns;
+		}
+	} while (ns < 480000);
+
+	/* Give the bus back to the 1-Wire master */
+	AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_INSTR_REG_OFFSET, 0x00000000);
+
+	return present;
+}
+
+/**
+ *
+ * Run a benchmark of the driver/device. It measures the latency of each
+ * primitive, the MMIO access cost, the handshake overhead versus the bus time
+ * of the IP and the presence pulse margin, and prints them with histograms.
+ *
+ * @param   baseaddr is the base address of the AXI_1WIRE_HOST instance to be worked on.
+ *          iterations is the number of samples of each measurement, at most 256.
+ *
+ * @return
+ *
+ *    - XST_SUCCESS   if the IP was detected and benchmarked
+ *    - XST_FAILURE   if the self-test failed
+ *
+ */
+XStatus AXI_1WIRE_HOST_SelfTestBenchmark(u32 baseaddr, u32 iterations)
+{
+	bench_stat *reset = &bench_stats[0], *read_bit = &bench_stats[1];
+	bench_stat *write_bit = &bench_stats[2], *read_byte = &bench_stats[3];
+	bench_stat *write_byte = &bench_stats[4], *mmio_rd = &bench_stats[5];
+	bench_stat *mmio_wr = &bench_stats[6], *hs_total = &bench_stats[7];
+	bench_stat *hs_engine = &bench_stats[8];
+	u32 pp_start, pp_end, pp_min_margin = 0xFFFFFFFF, pp_detected = 0;
+	u32 pp_last_start = 0, pp_last_end = 0;	/* Last pulse detected */
+	u32 i, margin;
+	XTime t0, t1;
+
+	if (AXI_1WIRE_HOST_SelfTest(baseaddr) != XST_SUCCESS)
+		return XST_FAILURE;
+
+	if (iterations > BENCH_MAX_SAMPLES)
+		iterations = BENCH_MAX_SAMPLES;
+
+	reset->name = "Reset/presence";
+	reset->nominal_ns = BENCH_RESET_SLOT_US * 1000;
+	read_bit->name = "Read bit";
+	read_bit->nominal_ns = BENCH_BIT_SLOT_US * 1000;
+	write_bit->name = "Write bit";
+	write_bit->nominal_ns = BENCH_BIT_SLOT_US * 1000;
+	read_byte->name = "Read byte";
+	read_byte->nominal_ns = BENCH_BYTE_SLOT_US * 1000;
+	write_byte->name = "Write byte";
+	write_byte->nominal_ns = BENCH_BYTE_SLOT_US * 1000;
+	mmio_rd->name = "MMIO read";
+	mmio_rd->nominal_ns = 0;
+	mmio_wr->name = "MMIO write";
+	mmio_wr->nominal_ns = 0;
+	hs_total->name = "Read bit, full handshake";
+	hs_total->nominal_ns = BENCH_BIT_SLOT_US * 1000;
+	hs_engine->name = "Read bit, GO to DONE";
+	hs_engine->nominal_ns = BENCH_BIT_SLOT_US * 1000;
+	for (i = 0; i < sizeof(bench_stats) / sizeof(bench_stats[0]); i++)
+		bench_stats[i].count = 0;
+
+	xil_printf("******************************\n\r");
+	xil_printf("* AXI 1-Wire Host Benchmark, %d iterations\n\r", iterations);
+
+	for (i = 0; i < iterations; i++) {
+		/* MMIO cost, the IRQ enable register is left cleared */
+		XTime_GetTime(&t0);
+		(void)AXI_1WIRE_HOST_mReadReg(baseaddr, AXI_1WIRE_HOST_STAT_REG_OFFSET);
+		XTime_GetTime(&t1);
+		bench_add(mmio_rd, t0, t1);
+		XTime_GetTime(&t0);
+		AXI_1WIRE_HOST_mWriteReg(baseaddr, AXI_1WIRE_HOST_IRQCTRL_REG_OFFSET, 0);
+		XTime_GetTime(&t1);
+		bench_add(mmio_wr, t0, t1);
+
+		XTime_GetTime(&t0);
+		AXI_1WIRE_HOST_ResetBus(baseaddr);
+		XTime_GetTime(&t1);
+		bench_add(reset, t0, t1);
+
+		/*
+		 * 0xFF is not a valid ROM command, the devices ignore the
+		 * following slots until the next reset
+		 */
+		XTime_GetTime(&t0);
+		AXI_1WIRE_HOST_WriteByte(baseaddr, 0xFF);
+		XTime_GetTime(&t1);
+		bench_add(write_byte, t0, t1);
+
+		XTime_GetTime(&t0);
+		AXI_1WIRE_HOST_ReadByte(baseaddr);
+		XTime_GetTime(&t1);
+		bench_add(read_byte, t0, t1);
+
+		XTime_GetTime(&t0);
+		AXI_1WIRE_HOST_TouchBit(baseaddr, 1);
+		XTime_GetTime(&t1);
+		bench_add(read_bit, t0, t1);
+
+		XTime_GetTime(&t0);
+		AXI_1WIRE_HOST_TouchBit(baseaddr, 0);
+		XTime_GetTime(&t1);
+		bench_add(write_bit, t0, t1);
+
+		bench_handshake(baseaddr, AXI_1WIRE_HOST_READBIT, hs_total, hs_engine);
+
+		/* Presence pulse margin around the IP sampling point */
+		if (bench_presence(baseaddr, &pp_start, &pp_end)) {
+			pp_detected++;
+			pp_last_start = pp_start;
+			pp_last_end = pp_end;
+			if (pp_start > BENCH_PRESENCE_SAMPLE_NS || pp_end < BENCH_PRESENCE_SAMPLE_NS)
+				margin = 0;	/* The IP would miss this pulse */
+			else if (BENCH_PRESENCE_SAMPLE_NS - pp_start < pp_end - BENCH_PRESENCE_SAMPLE_NS)
+				margin = BENCH_PRESENCE_SAMPLE_NS - pp_start;
+			else
+				margin = pp_end - BENCH_PRESENCE_SAMPLE_NS;
+			if (margin < pp_min_margin)
+				pp_min_margin = margin;
+		}
+	}
+
+	for (i = 0; i < sizeof(bench_stats) / sizeof(bench_stats[0]); i++)
+		bench_print(&bench_stats[i]);
+
+	/* A wrong CLK_DIV_VAL_TO_1MHz shows as a 1-Wire time base away from 1000 ns */
+	xil_printf("* 1-Wire time base: %d ns per us\n\r",
+		   (int)(bench_avg(hs_engine) / BENCH_BIT_SLOT_US));
+	if (pp_detected != 0)
+		xil_printf("* Presence pulse seen %d/%d times, last %d-%d ns, minimum margin %d ns\n\r",
+			   pp_detected, iterations, pp_last_start, pp_last_end, pp_min_margin);
+	else
+		xil_printf("* No presence pulse\n\r");
 	xil_printf("******************************\n\n\r");
 
 	return XST_SUCCESS;
@@ -0,0 +1,105 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef W1_CAPS_H
+#define W1_CAPS_H
+
+/*
+ * Optional features of the AXI 1-Wire Host IP, read once by the drivers when
+ * they probe or initialize an instance to pick the implementation of each
+ * primitive:
+ *   W1_CAP_SPU        strong pull-up flag of TX_BIT/TX_BYTE (v1.3)
+ *   W1_CAP_TIMING     slot timing registers (v1.4)
+ *   W1_CAP_BLOCK      RX_BLOCK/TX_BLOCK and their AXI4-Stream ports for a
+ *                     DMA, built with BULK_STREAM (v1.5)
+ *   W1_CAP_ROM_TABLE  SELECT_ROM and PING_ALL, built with ROM_TABLE entries
+ *                     (v1.6), the number of entries in W1_CAPS_ROM_ENTRIES
+ *   W1_CAP_POLL_BIT   POLL_BIT (v1.7)
+ * From v1.8 the IP reports them in its read only CAPS register, the bits
+ * not listed reading 0. Before, w1_caps_detect() derives them from the minor
+ * version and from the registers added with each feature, which alias other
+ * registers on the older IPs and are only read once the version has them.
+ *
+ * The file is shared by the Linux drivers and the baremetal driver, it only
+ * has inline functions. It lives with the baremetal driver, which is
+ * packaged in the IP and built on its own.
+ */
+
+/****************** Include Files ********************/
+#ifdef __KERNEL__
+#include <linux/types.h>
+#else
+#include <stdint.h>
+#endif
+
+/* Registers read by w1_caps_detect() */
+#define W1_CAPS_IPVER_REG	0x18
+#define W1_CAPS_BCNT_REG	0x48
+#define W1_CAPS_ROMIDX_REG	0x4C
+#define W1_CAPS_REG		0x68	/* Read only, v1.8 or later */
+
+#define W1_CAPS_IPVER_FORMAT	0x76	/* IPVER[31:24] */
+#define W1_CAPS_MINORVER	8	/* First minor version with the CAPS register */
+
+#define W1_CAP_SPU		0x00000001
+#define W1_CAP_TIMING		0x00000002
+#define W1_CAP_BLOCK		0x00000004
+#define W1_CAP_ROM_TABLE	0x00000008
+#define W1_CAP_POLL_BIT		0x00000010
+#define W1_CAPS_ROM_SHIFT	8		/* ROM ID table entries, CAPS[15:8] */
+#define W1_CAPS_ROM_MASK	0x0000FF00
+
+#define W1_CAPS_ROM_ENTRIES(caps)	(((caps) & W1_CAPS_ROM_MASK) >> W1_CAPS_ROM_SHIFT)
+
+/* Feature registers of the IP before v1.8 */
+#define W1_CAPS_BCNT_STREAM	0x80000000	/* Stream ports built in */
+#define W1_CAPS_ROMIDX_SHIFT	24		/* ROM ID table entries, ROMIDX[31:24] */
+
+/**************************** Type Definitions *****************************/
+/* Reads the register at offset of the instance ctx */
+typedef uint32_t (*w1_caps_read_fn)(void *ctx, uint32_t offset);
+
+/************************** Function Prototypes ****************************/
+static inline uint32_t w1_caps_major(uint32_t ipver)
+{
+	return (ipver >> 8) & 0xFFFF;
+}
+
+static inline uint32_t w1_caps_minor(uint32_t ipver)
+{
+	return ipver & 0xFF;
+}
+
+/*
+ * Capabilities of an instance, 0 if its IPVER is not a 1.x version of the
+ * IP: the driver then only runs the bit and byte primitives.
+ */
+static inline uint32_t w1_caps_detect(w1_caps_read_fn read, void *ctx)
+{
+	uint32_t ipver = read(ctx, W1_CAPS_IPVER_REG);
+	uint32_t minor = w1_caps_minor(ipver);
+	uint32_t caps = 0, entries;
+
+	if ((ipver >> 24) != W1_CAPS_IPVER_FORMAT || w1_caps_major(ipver) != 1)
+		return 0;
+	if (minor >= W1_CAPS_MINORVER)
+		return read(ctx, W1_CAPS_REG);
+
+	if (minor >= 3)
+		caps |= W1_CAP_SPU;
+	if (minor >= 4)
+		caps |= W1_CAP_TIMING;
+	if (minor >= 5 && (read(ctx, W1_CAPS_BCNT_REG) & W1_CAPS_BCNT_STREAM))
+		caps |= W1_CAP_BLOCK;
+	if (minor >= 6) {
+		entries = read(ctx, W1_CAPS_ROMIDX_REG) >> W1_CAPS_ROMIDX_SHIFT;
+		if (entries)
+			caps |= W1_CAP_ROM_TABLE | entries << W1_CAPS_ROM_SHIFT;
+	}
+	if (minor >= 7)
+		caps |= W1_CAP_POLL_BIT;
+	return caps;
+}
+
+#endif // W1_CAPS_H
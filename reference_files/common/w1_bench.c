@@ -0,0 +1,171 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+/***************************** Include Files *******************************/
+#include <stdlib.h>
+#include "w1_bench.h"
+
+/**************************** Type Definitions *****************************/
+struct w1_bench_buf {
+	char *p;
+	size_t left;	/* Room left, terminating 0 included */
+	size_t len;
+};
+
+/************************** Function Definitions ***************************/
+void w1_bench_init(struct w1_bench *b, const char *path, const char *workload,
+		   uint64_t *lat_ns, unsigned int cap)
+{
+	b->path = path;
+	b->workload = workload;
+	b->lat_ns = lat_ns;
+	b->cap = cap;
+	b->ops = 0;
+	b->errors = 0;
+	b->elapsed_ns = 0;
+	b->syscalls = W1_BENCH_NA;
+	b->irqs = W1_BENCH_NA;
+	b->cpu_ns = W1_BENCH_NA;
+}
+
+void w1_bench_add(struct w1_bench *b, uint64_t lat_ns, int error)
+{
+	if (b->ops < b->cap)
+		b->lat_ns[b->ops] = lat_ns;
+	b->ops++;
+	if (error)
+		b->errors++;
+}
+
+static int w1_bench_cmp(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+uint64_t w1_bench_percentile(struct w1_bench *b, unsigned int per_mille)
+{
+	unsigned int n = b->ops < b->cap ? b->ops : b->cap;
+	unsigned int rank;
+
+	if (n == 0)
+		return 0;
+	qsort(b->lat_ns, n, sizeof(b->lat_ns[0]), w1_bench_cmp);
+	rank = (unsigned int)(((uint64_t)per_mille * n + 999) / 1000);
+	return b->lat_ns[rank ? rank - 1 : 0];
+}
+
+static void w1_bench_put(struct w1_bench_buf *buf, const char *s)
+{
+	while (*s) {
+		if (buf->left > 1) {
+			*buf->p++ = *s;
+			buf->left--;
+			buf->len++;
+		}
+		s++;
+	}
+	if (buf->left)
+		*buf->p = '\0';
+}
+
+static void w1_bench_put_u64(struct w1_bench_buf *buf, uint64_t v)
+{
+	char digits[21];
+	int i = sizeof(digits) - 1;
+
+	digits[i] = '\0';
+	do {
+		digits[--i] = (char)('0' + v % 10);
+		v /= 10;
+	} while (v);
+	w1_bench_put(buf, &digits[i]);
+}
+
+/* v / 1000 with 3 decimals, null if not measured */
+static void w1_bench_put_milli(struct w1_bench_buf *buf, uint64_t v)
+{
+	char frac[5];
+
+	if (v == W1_BENCH_NA) {
+		w1_bench_put(buf, "null");
+		return;
+	}
+	w1_bench_put_u64(buf, v / 1000);
+	frac[0] = '.';
+	frac[1] = (char)('0' + v / 100 % 10);
+	frac[2] = (char)('0' + v / 10 % 10);
+	frac[3] = (char)('0' + v % 10);
+	frac[4] = '\0';
+	w1_bench_put(buf, frac);
+}
+
+/* Total per operation, with 3 decimals */
+static void w1_bench_put_per_op(struct w1_bench_buf *buf, uint64_t total, unsigned int ops)
+{
+	if (total == W1_BENCH_NA || ops == 0)
+		w1_bench_put(buf, "null");
+	else
+		w1_bench_put_milli(buf, total * 1000 / ops);
+}
+
+static void w1_bench_put_names(struct w1_bench_buf *buf, const char *path, const char *workload)
+{
+	w1_bench_put(buf, "{\"path\":\"");
+	w1_bench_put(buf, path);
+	w1_bench_put(buf, "\",\"workload\":\"");
+	w1_bench_put(buf, workload);
+	w1_bench_put(buf, "\"");
+}
+
+size_t w1_bench_format(struct w1_bench *b, char *line, size_t size)
+{
+	struct w1_bench_buf buf = { line, size, 0 };
+	unsigned int n = b->ops < b->cap ? b->ops : b->cap;
+
+	w1_bench_put_names(&buf, b->path, b->workload);
+	w1_bench_put(&buf, ",\"ops\":");
+	w1_bench_put_u64(&buf, b->ops);
+	w1_bench_put(&buf, ",\"errors\":");
+	w1_bench_put_u64(&buf, b->errors);
+	w1_bench_put(&buf, ",\"elapsed_us\":");
+	w1_bench_put_milli(&buf, b->elapsed_ns);
+	w1_bench_put(&buf, ",\"ops_per_s\":");
+	if (b->elapsed_ns)
+		w1_bench_put_milli(&buf, (uint64_t)b->ops * 1000000000000ULL / b->elapsed_ns);
+	else
+		w1_bench_put(&buf, "null");
+	w1_bench_put(&buf, ",\"lat_us\":{\"p50\":");
+	w1_bench_put_milli(&buf, w1_bench_percentile(b, 500));
+	w1_bench_put(&buf, ",\"p99\":");
+	w1_bench_put_milli(&buf, w1_bench_percentile(b, 990));
+	w1_bench_put(&buf, ",\"p999\":");
+	w1_bench_put_milli(&buf, w1_bench_percentile(b, 999));
+	w1_bench_put(&buf, ",\"max\":");
+	w1_bench_put_milli(&buf, n ? b->lat_ns[n - 1] : 0);
+	w1_bench_put(&buf, "},\"syscalls_per_op\":");
+	w1_bench_put_per_op(&buf, b->syscalls, b->ops);
+	w1_bench_put(&buf, ",\"irqs_per_op\":");
+	w1_bench_put_per_op(&buf, b->irqs, b->ops);
+	w1_bench_put(&buf, ",\"cpu_us_per_op\":");
+	if (b->cpu_ns == W1_BENCH_NA || b->ops == 0)
+		w1_bench_put(&buf, "null");
+	else
+		w1_bench_put_milli(&buf, b->cpu_ns / b->ops);
+	w1_bench_put(&buf, "}");
+	return buf.len;
+}
+
+size_t w1_bench_format_skipped(const char *path, const char *workload, const char *reason,
+			       char *line, size_t size)
+{
+	struct w1_bench_buf buf = { line, size, 0 };
+
+	w1_bench_put_names(&buf, path, workload);
+	w1_bench_put(&buf, ",\"skipped\":\"");
+	w1_bench_put(&buf, reason);
+	w1_bench_put(&buf, "\"}");
+	return buf.len;
+}
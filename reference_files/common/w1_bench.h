@@ -0,0 +1,104 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef W1_BENCH_H
+#define W1_BENCH_H
+
+/*
+ * Benchmark results shared by the benchmark suites of every access path: the
+ * baremetal application (application_bench.c, on the target or on the sim
+ * model) and the Linux tool (xlnxw1-bench.c, over the character driver or
+ * the w1 core).
+ *
+ * The suites run the same workloads:
+ *   sample  Convert T and Read Scratchpad of one DS18B20 (Match ROM)
+ *   sweep   Convert T of all DS18B20 at once, then Read Scratchpad of each
+ *   search  Search ROM enumeration of the bus
+ *   eeprom  Read Memory of W1_BENCH_EEPROM_BYTES from an EEPROM device
+ * and print one JSON object per line and workload, so the outputs of the
+ * paths can be compared by a script:
+ *   {"path":"chardev","workload":"sample","ops":100,"errors":0,
+ *    "elapsed_us":75512.345,"ops_per_s":1.324,
+ *    "lat_us":{"p50":755.100,"p99":756.200,"p999":756.200,"max":756.200},
+ *    "syscalls_per_op":26.000,"irqs_per_op":52.000,"cpu_us_per_op":310.000}
+ * A counter a path cannot measure is null, a workload that cannot run is
+ *   {"path":"w1core","workload":"search","skipped":"<reason>"}
+ *
+ * Only integer arithmetic is used and nothing is allocated, the formatting
+ * does not depend on the printf of the platform.
+ */
+
+/****************** Include Files ********************/
+#include <stddef.h>
+#include <stdint.h>
+
+#define W1_BENCH_SAMPLE		"sample"
+#define W1_BENCH_SWEEP		"sweep"
+#define W1_BENCH_SEARCH		"search"
+#define W1_BENCH_EEPROM		"eeprom"
+
+#define W1_BENCH_EEPROM_BYTES	2048
+
+#define W1_BENCH_NA		UINT64_MAX	/* Counter not measured by the path */
+#define W1_BENCH_LINE_SIZE	384
+
+/**************************** Type Definitions *****************************/
+struct w1_bench {
+	const char *path;
+	const char *workload;
+	uint64_t *lat_ns;	/* Latency of each operation, caller storage */
+	unsigned int cap;	/* Size of lat_ns, later operations are not sampled */
+	unsigned int ops;	/* Operations run, failed ones included */
+	unsigned int errors;
+	uint64_t elapsed_ns;
+	/* Totals over the run, W1_BENCH_NA if not measured */
+	uint64_t syscalls;
+	uint64_t irqs;
+	uint64_t cpu_ns;
+};
+
+/************************** Function Prototypes ****************************/
+/**
+ *
+ * Initialize the results of a workload, all counters not measured.
+ *
+ * @param   b is the results.
+ *          path and workload name the run, they must outlive b.
+ *          lat_ns receives the latencies, cap of them.
+ *
+ */
+void w1_bench_init(struct w1_bench *b, const char *path, const char *workload,
+		   uint64_t *lat_ns, unsigned int cap);
+
+/* Account an operation, error non-zero if it failed */
+void w1_bench_add(struct w1_bench *b, uint64_t lat_ns, int error);
+
+/**
+ *
+ * Latency percentile, nearest rank. Sorts the latencies.
+ *
+ * @param   b is the results.
+ *          per_mille is the percentile in 1/1000, e.g. 999 for p99.9.
+ *
+ * @return  The latency in ns, 0 if no operation was sampled
+ *
+ */
+uint64_t w1_bench_percentile(struct w1_bench *b, unsigned int per_mille);
+
+/**
+ *
+ * Format the results as a JSON line, without the newline.
+ *
+ * @param   b is the results, its latencies are sorted.
+ *          line receives the line, W1_BENCH_LINE_SIZE bytes are enough.
+ *          size is the size of line.
+ *
+ * @return  The length of the line, truncated to size - 1
+ *
+ */
+size_t w1_bench_format(struct w1_bench *b, char *line, size_t size);
+size_t w1_bench_format_skipped(const char *path, const char *workload, const char *reason,
+			       char *line, size_t size);
+
+#endif // W1_BENCH_H
@@ -0,0 +1,224 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+/***************************** Include Files *******************************/
+#include "w1_crc.h"
+
+#ifndef W1_CRC_MAKE_TABLES
+#include "w1_crc_tables.h"
+#endif
+
+#if !defined(__KERNEL__) && !defined(W1_CRC_MAKE_TABLES)
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define W1_CRC_BATCH_NEON
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define W1_CRC_BATCH_SSSE3
+#endif
+#endif
+
+/************************** Constant Definitions ***************************/
+#define W1_CRC8_POLY	0x8C	/* X^8 + X^5 + X^4 + 1, reflected */
+#define W1_CRC16_POLY	0xA001	/* X^16 + X^15 + X^2 + 1, reflected */
+
+/************************** Function Definitions ***************************/
+uint8_t w1_crc8_bitwise(uint8_t crc, const uint8_t *data, size_t len)
+{
+	int i;
+
+	while (len--) {
+		crc ^= *data++;
+		for (i = 0; i < 8; i++)
+			crc = (uint8_t)((crc >> 1) ^ (W1_CRC8_POLY & -(crc & 1)));
+	}
+	return crc;
+}
+
+uint16_t w1_crc16_bitwise(uint16_t crc, const uint8_t *data, size_t len)
+{
+	int i;
+
+	while (len--) {
+		crc ^= *data++;
+		for (i = 0; i < 8; i++)
+			crc = (uint16_t)((crc >> 1) ^ (W1_CRC16_POLY & -(crc & 1)));
+	}
+	return crc;
+}
+
+#ifdef W1_CRC_MAKE_TABLES
+/*
+ * Generate w1_crc_tables.h:
+ *   cc -DW1_CRC_MAKE_TABLES -o make_tables w1_crc.c && ./make_tables > w1_crc_tables.h
+ *
+ * Table k gives the CRC of a byte followed by k zero bytes.
+ */
+#include <stdio.h>
+
+int main(void)
+{
+	static uint8_t t8[8][256];
+	static uint16_t t16[8][256];
+	uint8_t b;
+	int k, i;
+
+	for (i = 0; i < 256; i++) {
+		b = (uint8_t)i;
+		t8[0][i] = w1_crc8_bitwise(0, &b, 1);
+		t16[0][i] = w1_crc16_bitwise(0, &b, 1);
+	}
+	for (k = 1; k < 8; k++) {
+		for (i = 0; i < 256; i++) {
+			t8[k][i] = t8[0][t8[k - 1][i]];
+			t16[k][i] = (uint16_t)((t16[k - 1][i] >> 8) ^ t16[0][t16[k - 1][i] & 0xFF]);
+		}
+	}
+
+	printf("/*\nCopyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.\n"
+	       "SPDX-License-Identifier: MIT\n*/\n");
+	printf("/* Generated by w1_crc.c built with -DW1_CRC_MAKE_TABLES, do not edit */\n\n");
+	printf("static const uint8_t w1_crc8_table[8][256] = {\n");
+	for (k = 0; k < 8; k++) {
+		printf("\t{");
+		for (i = 0; i < 256; i++)
+			printf("%s%s%u", i ? "," : "", (i % 16) ? " " : "\n\t\t", t8[k][i]);
+		printf("\n\t},\n");
+	}
+	printf("};\n\nstatic const uint16_t w1_crc16_table[8][256] = {\n");
+	for (k = 0; k < 8; k++) {
+		printf("\t{");
+		for (i = 0; i < 256; i++)
+			printf("%s%s0x%04X", i ? "," : "", (i % 8) ? " " : "\n\t\t", t16[k][i]);
+		printf("\n\t},\n");
+	}
+	printf("};\n");
+	return 0;
+}
+#else
+
+uint8_t w1_crc8(uint8_t crc, const uint8_t *data, size_t len)
+{
+	while (len--)
+		crc = w1_crc8_table[0][crc ^ *data++];
+	return crc;
+}
+
+uint8_t w1_crc8_slice4(uint8_t crc, const uint8_t *data, size_t len)
+{
+	for (; len >= 4; len -= 4, data += 4)
+		crc = w1_crc8_table[3][crc ^ data[0]] ^ w1_crc8_table[2][data[1]] ^
+		      w1_crc8_table[1][data[2]] ^ w1_crc8_table[0][data[3]];
+	return w1_crc8(crc, data, len);
+}
+
+uint8_t w1_crc8_slice8(uint8_t crc, const uint8_t *data, size_t len)
+{
+	for (; len >= 8; len -= 8, data += 8)
+		crc = w1_crc8_table[7][crc ^ data[0]] ^ w1_crc8_table[6][data[1]] ^
+		      w1_crc8_table[5][data[2]] ^ w1_crc8_table[4][data[3]] ^
+		      w1_crc8_table[3][data[4]] ^ w1_crc8_table[2][data[5]] ^
+		      w1_crc8_table[1][data[6]] ^ w1_crc8_table[0][data[7]];
+	return w1_crc8(crc, data, len);
+}
+
+uint16_t w1_crc16(uint16_t crc, const uint8_t *data, size_t len)
+{
+	while (len--)
+		crc = (uint16_t)((crc >> 8) ^ w1_crc16_table[0][(crc ^ *data++) & 0xFF]);
+	return crc;
+}
+
+uint16_t w1_crc16_slice4(uint16_t crc, const uint8_t *data, size_t len)
+{
+	for (; len >= 4; len -= 4, data += 4)
+		crc = w1_crc16_table[3][(crc ^ data[0]) & 0xFF] ^
+		      w1_crc16_table[2][(crc >> 8) ^ data[1]] ^
+		      w1_crc16_table[1][data[2]] ^ w1_crc16_table[0][data[3]];
+	return w1_crc16(crc, data, len);
+}
+
+uint16_t w1_crc16_slice8(uint16_t crc, const uint8_t *data, size_t len)
+{
+	for (; len >= 8; len -= 8, data += 8)
+		crc = w1_crc16_table[7][(crc ^ data[0]) & 0xFF] ^
+		      w1_crc16_table[6][(crc >> 8) ^ data[1]] ^
+		      w1_crc16_table[5][data[2]] ^ w1_crc16_table[4][data[3]] ^
+		      w1_crc16_table[3][data[4]] ^ w1_crc16_table[2][data[5]] ^
+		      w1_crc16_table[1][data[6]] ^ w1_crc16_table[0][data[7]];
+	return w1_crc16(crc, data, len);
+}
+
+#ifndef __KERNEL__
+size_t w1_crc8_check_batch(const uint8_t *records, size_t stride, size_t len,
+			   size_t count, uint8_t *valid)
+{
+	size_t i = 0, nvalid = 0;
+#if defined(W1_CRC_BATCH_NEON) || defined(W1_CRC_BATCH_SSSE3)
+	/*
+	 * One record per byte lane. The CRC-8 being linear, the table lookup of
+	 * a byte is the XOR of the lookups of its two nibbles, which are 16
+	 * entries tables the byte shuffle instructions can index.
+	 */
+	uint8_t lo[16], hi[16], column[16];
+	size_t j, k;
+
+	for (k = 0; k < 16; k++) {
+		lo[k] = w1_crc8_table[0][k];
+		hi[k] = w1_crc8_table[0][k << 4];
+	}
+#if defined(W1_CRC_BATCH_NEON)
+	{
+		uint8x16_t vlo = vld1q_u8(lo), vhi = vld1q_u8(hi);
+		uint8x16_t mask = vdupq_n_u8(0x0F), one = vdupq_n_u8(1);
+		uint8x16_t crc;
+
+		for (; i + 16 <= count; i += 16) {
+			crc = vdupq_n_u8(0);
+			for (j = 0; j < len; j++) {
+				for (k = 0; k < 16; k++)
+					column[k] = records[(i + k) * stride + j];
+				crc = veorq_u8(crc, vld1q_u8(column));
+				crc = veorq_u8(vqtbl1q_u8(vlo, vandq_u8(crc, mask)),
+					       vqtbl1q_u8(vhi, vshrq_n_u8(crc, 4)));
+			}
+			vst1q_u8(&valid[i], vandq_u8(vceqq_u8(crc, vdupq_n_u8(0)), one));
+		}
+	}
+#else
+	{
+		__m128i vlo = _mm_loadu_si128((const __m128i *)lo);
+		__m128i vhi = _mm_loadu_si128((const __m128i *)hi);
+		__m128i mask = _mm_set1_epi8(0x0F), one = _mm_set1_epi8(1);
+		__m128i crc;
+
+		for (; i + 16 <= count; i += 16) {
+			crc = _mm_setzero_si128();
+			for (j = 0; j < len; j++) {
+				for (k = 0; k < 16; k++)
+					column[k] = records[(i + k) * stride + j];
+				crc = _mm_xor_si128(crc, _mm_loadu_si128((const __m128i *)column));
+				crc = _mm_xor_si128(_mm_shuffle_epi8(vlo, _mm_and_si128(crc, mask)),
+						    _mm_shuffle_epi8(vhi, _mm_and_si128(_mm_srli_epi16(crc, 4), mask)));
+			}
+			_mm_storeu_si128((__m128i *)&valid[i],
+					 _mm_and_si128(_mm_cmpeq_epi8(crc, _mm_setzero_si128()), one));
+		}
+	}
+#endif
+	for (k = 0; k < i; k++)
+		nvalid += valid[k];
+#endif
+	for (; i < count; i++) {
+		if (len == W1_ROM_ID_SIZE)
+			valid[i] = (w1_crc8_slice8(0, &records[i * stride], len) == 0);
+		else
+			valid[i] = (w1_crc8(0, &records[i * stride], len) == 0);
+		nvalid += valid[i];
+	}
+	return nvalid;
+}
+#endif /* __KERNEL__ */
+
+#endif /* W1_CRC_MAKE_TABLES */
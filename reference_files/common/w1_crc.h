@@ -0,0 +1,94 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef W1_CRC_H
+#define W1_CRC_H
+
+/*
+ * Dallas/Maxim 1-Wire CRCs, shared between the baremetal application and the
+ * Linux user space tools.
+ *
+ * CRC-8 (X^8 + X^5 + X^4 + 1) protects the ROM IDs and the scratchpads, the
+ * CRC byte being the last byte of the record. CRC-16 (X^16 + X^15 + X^2 + 1)
+ * protects the memory pages of the DS2431/DS28EC20, the device sending the
+ * inverted CRC LSB first.
+ *
+ * Both CRCs are reflected and start from 0. Running the CRC-8 over a record
+ * including its CRC byte gives 0, running the CRC-16 over data followed by
+ * its inverted CRC gives W1_CRC16_RESIDUE.
+ *
+ * The bitwise variants have no table and only use the kernel/libc common
+ * subset, they are the ones to use from a kernel driver.
+ */
+
+/****************** Include Files ********************/
+#ifdef __KERNEL__
+#include <linux/types.h>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+#define W1_CRC16_RESIDUE	0xB001
+
+#define W1_ROM_ID_SIZE		8
+
+/************************** Function Prototypes ****************************/
+/**
+ *
+ * Compute the CRC-8 of a buffer.
+ *
+ * @param   crc is the initial CRC, 0 or the CRC of the previous buffer.
+ *          data is the buffer.
+ *          len is the number of bytes in the buffer.
+ *
+ * @return  The CRC-8
+ *
+ * @note    w1_crc8() uses a 256 bytes table, w1_crc8_slice4/8() process 4/8
+ *          bytes per step with 4/8 tables and suit long buffers.
+ *
+ */
+uint8_t w1_crc8_bitwise(uint8_t crc, const uint8_t *data, size_t len);
+uint8_t w1_crc8(uint8_t crc, const uint8_t *data, size_t len);
+uint8_t w1_crc8_slice4(uint8_t crc, const uint8_t *data, size_t len);
+uint8_t w1_crc8_slice8(uint8_t crc, const uint8_t *data, size_t len);
+
+/**
+ *
+ * Compute the CRC-16 of a buffer.
+ *
+ * @param   crc is the initial CRC, 0 or the CRC of the previous buffer.
+ *          data is the buffer.
+ *          len is the number of bytes in the buffer.
+ *
+ * @return  The CRC-16, to be inverted before comparing it with the one sent
+ *          by the device
+ *
+ */
+uint16_t w1_crc16_bitwise(uint16_t crc, const uint8_t *data, size_t len);
+uint16_t w1_crc16(uint16_t crc, const uint8_t *data, size_t len);
+uint16_t w1_crc16_slice4(uint16_t crc, const uint8_t *data, size_t len);
+uint16_t w1_crc16_slice8(uint16_t crc, const uint8_t *data, size_t len);
+
+#ifndef __KERNEL__
+/**
+ *
+ * Verify the CRC-8 of an array of records ending with their CRC byte, such as
+ * ROM IDs (8 bytes) or scratchpads (9 bytes). When built with NEON (AArch64)
+ * or SSSE3, 16 records are verified per step.
+ *
+ * @param   records is the first record.
+ *          stride is the distance in bytes between two records.
+ *          len is the length of a record, CRC byte included.
+ *          count is the number of records.
+ *          valid receives 1 for each record with a valid CRC, 0 otherwise.
+ *
+ * @return  The number of records with a valid CRC
+ *
+ */
+size_t w1_crc8_check_batch(const uint8_t *records, size_t stride, size_t len,
+			   size_t count, uint8_t *valid);
+#endif
+
+#endif // W1_CRC_H
@@ -0,0 +1,60 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+/***************************** Include Files *******************************/
+#include <string.h>
+#include "w1_crc.h"
+#include "w1_mem.h"
+
+/************************** Constant Definitions ***************************/
+static const struct w1_mem_type w1_mem_types[] = {
+	{ W1_FAMILY_DS2431, "DS2431", 128, 8, 10 },
+	{ W1_FAMILY_DS28EC20, "DS28EC20", 2560, 32, 10 },
+};
+
+/************************** Function Definitions ***************************/
+const struct w1_mem_type *w1_mem_type(uint8_t family)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(w1_mem_types) / sizeof(w1_mem_types[0]); i++)
+		if (w1_mem_types[i].family == family)
+			return &w1_mem_types[i];
+	return NULL;
+}
+
+size_t w1_mem_write_frame(const struct w1_mem_type *type, uint8_t *frame, uint16_t addr,
+			  const uint8_t *page)
+{
+	frame[0] = W1_MEM_WRITE_SCRATCHPAD;
+	frame[1] = (uint8_t)addr;
+	frame[2] = (uint8_t)(addr >> 8);
+	memcpy(&frame[3], page, type->page);
+	return 3 + type->page;
+}
+
+int w1_mem_check_write(const uint8_t *frame, size_t len, const uint8_t *crc)
+{
+	return w1_crc16(w1_crc16(0, frame, len), crc, 2) == W1_CRC16_RESIDUE;
+}
+
+int w1_mem_check_scratchpad(const struct w1_mem_type *type, const uint8_t *rsp, uint16_t addr,
+			    const uint8_t *page)
+{
+	static const uint8_t cmd = W1_MEM_READ_SCRATCHPAD;
+
+	if (w1_crc16(w1_crc16(0, &cmd, 1), rsp, w1_mem_read_sp_len(type)) != W1_CRC16_RESIDUE)
+		return 0;
+	/* The whole page, not copied yet: E/S holds the last offset only */
+	return rsp[0] == (uint8_t)addr && rsp[1] == (uint8_t)(addr >> 8) &&
+	       rsp[2] == type->page - 1 && memcmp(&rsp[3], page, type->page) == 0;
+}
+
+void w1_mem_copy_frame(const struct w1_mem_type *type, uint8_t *frame, uint16_t addr)
+{
+	frame[0] = W1_MEM_COPY_SCRATCHPAD;
+	frame[1] = (uint8_t)addr;
+	frame[2] = (uint8_t)(addr >> 8);
+	frame[3] = type->page - 1;
+}
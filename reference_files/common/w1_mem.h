@@ -0,0 +1,120 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef W1_MEM_H
+#define W1_MEM_H
+
+/*
+ * Memory function commands of the 1-Wire EEPROMs with a CRC-16 protected
+ * scratchpad, the DS2431 and the DS28EC20. Shared between the baremetal
+ * application and the Linux user space library, it only depends on the C
+ * standard headers and w1_crc.
+ *
+ * A page (the scratchpad) is written in three steps, each one after a reset
+ * and the ROM selection, Resume selecting again the device of the last Match
+ * ROM with one byte instead of nine:
+ *   Write Scratchpad  0x0F, TA1, TA2, the page; the device sends the
+ *                     inverted CRC-16 of the command, address and data
+ *   Read Scratchpad   0xAA; the device sends TA1, TA2, E/S, the page and the
+ *                     inverted CRC-16 of the command and of all that
+ *   Copy Scratchpad   0x55, TA1, TA2, E/S as read back; the device programs
+ *                     the page for tPROG, then sends 0xAA
+ * The device draws its programming current from the bus, which must stay
+ * idle for tPROG: on a bus, the pages are written one after another.
+ * Read Memory (0xF0, TA1, TA2) streams the memory from TA up to its end.
+ */
+
+/****************** Include Files ********************/
+#include <stddef.h>
+#include <stdint.h>
+
+/* Family codes, first byte of the ROM ID */
+#define W1_FAMILY_DS2431	0x2D
+#define W1_FAMILY_DS28EC20	0x43
+
+/* ROM command of these devices */
+#define W1_MEM_RESUME		0xA5
+
+/* Memory function commands */
+#define W1_MEM_WRITE_SCRATCHPAD	0x0F
+#define W1_MEM_READ_SCRATCHPAD	0xAA
+#define W1_MEM_COPY_SCRATCHPAD	0x55
+#define W1_MEM_READ_MEMORY	0xF0
+
+#define W1_MEM_COPY_DONE	0xAA	/* Read after tPROG once the page is programmed */
+#define W1_MEM_ES_PF		0x20	/* E/S: partial page in the scratchpad */
+#define W1_MEM_ES_AA		0x80	/* E/S: scratchpad copied */
+
+#define W1_MEM_PAGE_MAX		32
+
+/* Frames of a page: command and address, the page, the CRC-16 */
+#define W1_MEM_WRITE_FRAME_MAX	(3 + W1_MEM_PAGE_MAX)
+#define W1_MEM_READ_SP_MAX	(3 + W1_MEM_PAGE_MAX + 2)
+#define W1_MEM_COPY_FRAME_SIZE	4
+
+/**************************** Type Definitions *****************************/
+struct w1_mem_type {
+	uint8_t family;
+	const char *name;
+	uint16_t size;		/* Bytes of the data memory, the registers excluded */
+	uint8_t page;		/* Bytes of the scratchpad, copied at once (a row of the DS2431) */
+	uint8_t tprog_ms;	/* Copy Scratchpad programming time, rounded up */
+};
+
+/************************** Function Prototypes ****************************/
+/* Memory device of a family code, NULL if it is not one */
+const struct w1_mem_type *w1_mem_type(uint8_t family);
+
+/**
+ *
+ * Build the Write Scratchpad frame of a page.
+ *
+ * @param   type is the memory device.
+ *          frame receives the frame, W1_MEM_WRITE_FRAME_MAX bytes at most.
+ *          addr is the start of the page.
+ *          page is the data of the page, type->page bytes.
+ *
+ * @return  The length of the frame
+ *
+ */
+size_t w1_mem_write_frame(const struct w1_mem_type *type, uint8_t *frame, uint16_t addr,
+			  const uint8_t *page);
+
+/* 1 if crc, the 2 bytes read after a Write Scratchpad frame, matches it */
+int w1_mem_check_write(const uint8_t *frame, size_t len, const uint8_t *crc);
+
+/* Bytes read after the Read Scratchpad command, the CRC-16 included */
+static inline size_t w1_mem_read_sp_len(const struct w1_mem_type *type)
+{
+	return 3 + type->page + 2;
+}
+
+/**
+ *
+ * Check a Read Scratchpad answer against the page written.
+ *
+ * @param   type is the memory device.
+ *          rsp is the answer, w1_mem_read_sp_len() bytes.
+ *          addr is the start of the page.
+ *          page is the data written.
+ *
+ * @return  1 if the CRC-16 is good and the device holds the whole page at
+ *          addr, ready to be copied; 0 otherwise
+ *
+ */
+int w1_mem_check_scratchpad(const struct w1_mem_type *type, const uint8_t *rsp, uint16_t addr,
+			    const uint8_t *page);
+
+/* The Copy Scratchpad frame of the page at addr, W1_MEM_COPY_FRAME_SIZE bytes */
+void w1_mem_copy_frame(const struct w1_mem_type *type, uint8_t *frame, uint16_t addr);
+
+/* The Read Memory frame from addr, 3 bytes */
+static inline void w1_mem_read_frame(uint8_t *frame, uint16_t addr)
+{
+	frame[0] = W1_MEM_READ_MEMORY;
+	frame[1] = (uint8_t)addr;
+	frame[2] = (uint8_t)(addr >> 8);
+}
+
+#endif // W1_MEM_H
@@ -0,0 +1,133 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+/***************************** Include Files *******************************/
+#include "w1_temp.h"
+
+/************************** Function Definitions ***************************/
+/*
+ * DS18B20/DS1822: 12 bits two's complement in 1/16 degree. At lower
+ * resolutions the (3 - r) LSBs are undefined and cleared here, r being the
+ * resolution setting 0 (9 bits) to 3 (12 bits).
+ */
+static inline int16_t decode_ds18b20(int r, const uint8_t *scratchpad)
+{
+	int16_t raw = (int16_t)((scratchpad[1] << 8) | scratchpad[0]);
+
+	return (int16_t)(raw & ~((1 << (3 - r)) - 1));
+}
+
+/*
+ * DS18S20: 9 bits two's complement in 1/2 degree. The extended resolution
+ * drops the 1/2 degree bit and adds (COUNT_PER_C - COUNT_REMAIN) / COUNT_PER_C
+ * - 0.25, COUNT_PER_C being hardwired to 16.
+ */
+static inline int16_t decode_ds18s20(int extended, const uint8_t *scratchpad)
+{
+	int16_t raw = (int16_t)((scratchpad[1] << 8) | scratchpad[0]);
+
+	if (!extended)
+		return (int16_t)(raw * 8);
+	return (int16_t)((raw & ~1) * 8 - 4 + 16 - scratchpad[6]);
+}
+
+/*
+ * MAX31850: 14 bits two's complement in 1/4 degree in bits 15:2. Bit 0 is the
+ * fault flag and bit 1 is reserved.
+ */
+static inline int16_t decode_max31850(const uint8_t *scratchpad)
+{
+	int16_t raw = (int16_t)((scratchpad[1] << 8) | scratchpad[0]);
+
+	return (int16_t)(raw & ~3);
+}
+
+int16_t w1_temp_decode(uint8_t family, int resolution, const uint8_t *scratchpad)
+{
+	int r;
+
+	switch (family) {
+	case W1_FAMILY_DS18S20:
+		return decode_ds18s20(resolution == 0, scratchpad);
+	case W1_FAMILY_MAX31850:
+		return decode_max31850(scratchpad);
+	default:
+		if (resolution == 0)
+			r = (scratchpad[4] >> 5) & 0x3;
+		else if (resolution < 9 || resolution > 12)
+			r = 0;
+		else
+			r = resolution - 9;
+		return decode_ds18b20(r, scratchpad);
+	}
+}
+
+unsigned int w1_temp_conv_time_ms(uint8_t family, int resolution)
+{
+	switch (family) {
+	case W1_FAMILY_DS18S20:
+		return 750;
+	case W1_FAMILY_MAX31850:
+		return 100;
+	default:
+		/* 93.75 ms at 9 bits, doubling with every bit */
+		if (resolution < 9 || resolution > 12)
+			resolution = 12;
+		return (750 >> (12 - resolution)) + (resolution < 11);
+	}
+}
+
+void w1_temp_decode_batch(uint8_t family, const uint8_t (*scratchpads)[W1_SCRATCHPAD_SIZE],
+			  int32_t *millideg, size_t count)
+{
+	size_t i;
+
+	/* Keep the family test out of the loops so their bodies are branch free */
+	switch (family) {
+	case W1_FAMILY_DS18S20:
+		for (i = 0; i < count; i++)
+			millideg[i] = w1_temp_to_millideg(decode_ds18s20(1, scratchpads[i]));
+		break;
+	case W1_FAMILY_MAX31850:
+		for (i = 0; i < count; i++)
+			millideg[i] = w1_temp_to_millideg(decode_max31850(scratchpads[i]));
+		break;
+	default:
+		for (i = 0; i < count; i++)
+			millideg[i] = w1_temp_to_millideg(decode_ds18b20((scratchpads[i][4] >> 5) & 0x3,
+									 scratchpads[i]));
+		break;
+	}
+}
+
+int w1_temp_format(int16_t q4, char *buf)
+{
+	char digits[4];
+	uint32_t mag = (q4 < 0) ? (uint32_t)(-(int32_t)q4) : (uint32_t)q4;
+	uint32_t int_p = mag >> 4;
+	uint32_t dec_p = (mag & 0xF) * 625;	/* 1/16 = 0.0625 */
+	int len = 0;
+	int n = 0;
+
+	if (q4 < 0)
+		buf[len++] = '-';
+
+	/* Integer part, at most 4 digits */
+	do {
+		digits[n++] = (char)('0' + int_p % 10);
+		int_p /= 10;
+	} while (int_p != 0);
+	while (n > 0)
+		buf[len++] = digits[--n];
+
+	/* Decimal part, always 4 digits */
+	buf[len++] = '.';
+	buf[len++] = (char)('0' + dec_p / 1000);
+	buf[len++] = (char)('0' + (dec_p / 100) % 10);
+	buf[len++] = (char)('0' + (dec_p / 10) % 10);
+	buf[len++] = (char)('0' + dec_p % 10);
+	buf[len] = '\0';
+
+	return len;
+}
@@ -0,0 +1,109 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef W1_TEMP_H
+#define W1_TEMP_H
+
+/*
+ * Temperature decode for the DS18B20 family of 1-Wire temperature sensors.
+ * Shared between the baremetal application and the Linux user space tools,
+ * it only depends on the C standard headers.
+ *
+ * Every device of the family is decoded to a signed 1/16 degree Celsius
+ * fixed point value (Q4), which is exact for all of them.
+ */
+
+/****************** Include Files ********************/
+#include <stddef.h>
+#include <stdint.h>
+
+/* Family codes, first byte of the ROM ID */
+#define W1_FAMILY_DS18S20	0x10
+#define W1_FAMILY_DS1822	0x22
+#define W1_FAMILY_DS18B20	0x28
+#define W1_FAMILY_MAX31850	0x3B
+
+#define W1_SCRATCHPAD_SIZE	9
+#define W1_SCRATCHPAD_TEMP_SIZE	2
+
+/* Copy Scratchpad (0x48) to the EEPROM, tWR of the datasheets, in ms */
+#define W1_TEMP_COPY_TIME_MS	10
+
+/* Longest string written by w1_temp_format(), "-2048.0000" and the terminating 0 */
+#define W1_TEMP_STR_SIZE	11
+
+/************************** Function Prototypes ****************************/
+/**
+ *
+ * Decode the temperature of a scratchpad.
+ *
+ * @param   family is the device family code. Unknown family codes are decoded
+ *          as a DS18B20.
+ *          resolution is the DS18B20/DS1822 conversion resolution (9 to 12 bits),
+ *          or 0 to take it from the configuration byte of the scratchpad. For a
+ *          DS18S20, 0 selects the extended resolution computed from COUNT_REMAIN.
+ *          Ignored for the MAX31850.
+ *          scratchpad holds the 2 temperature bytes, and the full scratchpad
+ *          when resolution is 0.
+ *
+ * @return  The temperature in 1/16 degree Celsius
+ *
+ */
+int16_t w1_temp_decode(uint8_t family, int resolution, const uint8_t *scratchpad);
+
+/**
+ *
+ * Maximum temperature conversion time (tCONV) of a device.
+ *
+ * @param   family is the device family code. Unknown family codes are taken
+ *          as a DS18B20.
+ *          resolution is the DS18B20/DS1822 conversion resolution (9 to 12
+ *          bits), or 0 for the longest conversion time (12 bits). Ignored for
+ *          the DS18S20 and the MAX31850.
+ *
+ * @return  The conversion time in ms, rounded up
+ *
+ */
+unsigned int w1_temp_conv_time_ms(uint8_t family, int resolution);
+
+/**
+ *
+ * Convert a 1/16 degree Celsius temperature to millidegree Celsius. The
+ * result is rounded toward 0.
+ *
+ */
+static inline int32_t w1_temp_to_millideg(int16_t q4)
+{
+	return (int32_t)q4 * 125 / 2;
+}
+
+/**
+ *
+ * Decode an array of full scratchpads to millidegree Celsius. The resolution
+ * of each DS18B20/DS1822 is taken from its configuration byte and the extended
+ * resolution is used for the DS18S20.
+ *
+ * @param   family is the family code shared by all the devices.
+ *          scratchpads is the array of count scratchpads.
+ *          millideg receives the count temperatures.
+ *          count is the number of scratchpads to decode.
+ *
+ */
+void w1_temp_decode_batch(uint8_t family, const uint8_t (*scratchpads)[W1_SCRATCHPAD_SIZE],
+			  int32_t *millideg, size_t count);
+
+/**
+ *
+ * Format a 1/16 degree Celsius temperature with 4 decimals, without going
+ * through printf.
+ *
+ * @param   q4 is the temperature in 1/16 degree Celsius.
+ *          buf receives the string, at least W1_TEMP_STR_SIZE bytes long.
+ *
+ * @return  The length of the string
+ *
+ */
+int w1_temp_format(int16_t q4, char *buf);
+
+#endif // W1_TEMP_H
@@ -0,0 +1,184 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef W1_TRACE_H
+#define W1_TRACE_H
+
+/*
+ * Binary trace of the bus primitives, recorded by the drivers into a ring in
+ * memory and analysed offline by tools/w1_trace_analyze.c:
+ *   Linux drivers  bus_trace=<records> module parameter, the ring is read
+ *                  from /sys/kernel/debug/xlnxw1-<device>/bus_trace
+ *   baremetal      AXI_1WIRE_HOST_TRACE build flag and
+ *                  AXI_1WIRE_HOST_TraceStart(), the ring is dumped from the
+ *                  memory of the target (xsdb mrd -bin)
+ *
+ * A ring is a header followed by size records, size being a power of two.
+ * The driver owning the bus is its only writer: it fills the record at index
+ * head % size, then increments head, so neither side takes a lock. A dump
+ * has the same layout, little endian as the targets, and its valid records
+ * are the ones with a sequence number in [head - size, head), in any order.
+ *
+ * The file is shared by the Linux drivers, the baremetal driver and the host
+ * tools, it only has inline functions.
+ */
+
+/****************** Include Files ********************/
+#ifdef __KERNEL__
+#include <linux/string.h>
+#include <linux/types.h>
+#include <asm/barrier.h>
+#define w1_trace_wmb()	smp_wmb()
+#define w1_trace_rmb()	smp_rmb()
+#else
+#include <stdint.h>
+#include <string.h>
+#define w1_trace_wmb()	__atomic_thread_fence(__ATOMIC_RELEASE)
+#define w1_trace_rmb()	__atomic_thread_fence(__ATOMIC_ACQUIRE)
+#endif
+
+#define W1_TRACE_MAGIC		0x52543157	/* "W1TR" */
+#define W1_TRACE_VERSION	1
+#define W1_TRACE_SEQ_NONE	0xFFFFFFFF	/* Record never written */
+
+/* Record flags */
+#define W1_TRACE_IRQ		0x01	/* DONE waited for with the interrupt, else polled */
+#define W1_TRACE_CHAINED	0x02	/* Issued from the interrupt handler */
+#define W1_TRACE_ERROR		0x04	/* Wait timed out or interrupted */
+
+/* Bytes of a ring of n records */
+#define W1_TRACE_RING_BYTES(n)	(sizeof(struct w1_trace_ring) + (n) * sizeof(struct w1_trace_rec))
+
+/**************************** Type Definitions *****************************/
+/* One primitive, the times in ticks of the clock of the ring */
+struct w1_trace_rec {
+	uint64_t t;		/* Start, before the READY wait */
+	uint32_t ready;		/* READY wait, up to the instruction write */
+	uint32_t done;		/* Instruction write to the end of the DONE wait */
+	uint32_t seq;		/* Sequence number */
+	uint16_t instr;		/* Instruction register: opcode, SPU flag, TX data */
+	uint8_t rx;		/* Data read, 1 if no presence pulse for INITPRES or timeout for POLLBIT */
+	uint8_t flags;		/* W1_TRACE_* */
+};
+
+struct w1_trace_ring {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t rec_size;
+	uint32_t clock_hz;	/* Ticks per second of the times */
+	uint32_t size;		/* Records */
+	uint32_t head;		/* Records written */
+	uint32_t reserved;
+	struct w1_trace_rec rec[];
+};
+
+/************************** Function Definitions ***************************/
+/**
+ *
+ * Initialize a ring.
+ *
+ * @param   ring is the ring, of W1_TRACE_RING_BYTES(size) bytes.
+ *          size is the number of records, a power of two.
+ *          clock_hz is the rate of the clock of the times.
+ *
+ */
+static inline void w1_trace_init(struct w1_trace_ring *ring, uint32_t size, uint32_t clock_hz)
+{
+	uint32_t i;
+
+	ring->magic = W1_TRACE_MAGIC;
+	ring->version = W1_TRACE_VERSION;
+	ring->rec_size = sizeof(struct w1_trace_rec);
+	ring->clock_hz = clock_hz;
+	ring->size = size;
+	ring->head = 0;
+	ring->reserved = 0;
+	for (i = 0; i < size; i++)
+		ring->rec[i].seq = W1_TRACE_SEQ_NONE;
+}
+
+/* Records of the ring, the largest power of two fitting in bytes */
+static inline uint32_t w1_trace_fit(uint32_t bytes)
+{
+	uint32_t size = 1;
+
+	if (bytes < W1_TRACE_RING_BYTES(1))
+		return 0;
+	while (W1_TRACE_RING_BYTES(size * 2) <= bytes)
+		size *= 2;
+	return size;
+}
+
+/* Append a record, overwriting the oldest one. Only the bus owner calls it */
+static inline void w1_trace_put(struct w1_trace_ring *ring, const struct w1_trace_rec *rec)
+{
+	uint32_t head = ring->head;
+	struct w1_trace_rec *dst = &ring->rec[head & (ring->size - 1)];
+
+	dst->t = rec->t;
+	dst->ready = rec->ready;
+	dst->done = rec->done;
+	dst->instr = rec->instr;
+	dst->rx = rec->rx;
+	dst->flags = rec->flags;
+	w1_trace_wmb();
+	dst->seq = head;
+	w1_trace_wmb();
+	*(volatile uint32_t *)&ring->head = head + 1;
+}
+
+/* Whether a record of a ring or of a snapshot is valid */
+static inline int w1_trace_valid(const struct w1_trace_ring *ring, const struct w1_trace_rec *rec)
+{
+	return rec->seq != W1_TRACE_SEQ_NONE && ring->head - 1 - rec->seq < ring->size;
+}
+
+/**
+ *
+ * Copy the valid records of a ring being written, oldest first. A record
+ * overwritten during the copy is dropped.
+ *
+ * @param   ring is the ring.
+ *          dst receives the snapshot, of W1_TRACE_RING_BYTES(ring->size)
+ *          bytes. Its size is the number of records copied.
+ *
+ * @return  The number of records copied
+ *
+ */
+static inline uint32_t w1_trace_snapshot(const struct w1_trace_ring *ring,
+					 struct w1_trace_ring *dst)
+{
+	uint32_t size = ring->size;
+	uint32_t h0, h1, n, drop, i;
+
+	h0 = *(volatile const uint32_t *)&ring->head;
+	w1_trace_rmb();
+	n = h0 < size ? h0 : size;
+	for (i = 0; i < n; i++)
+		dst->rec[i] = ring->rec[(h0 - n + i) & (size - 1)];
+	w1_trace_rmb();
+	h1 = *(volatile const uint32_t *)&ring->head;
+
+	/*
+	 * The writer overwrote the records up to h1 - size, and may be writing
+	 * the next one: they are the oldest of the copy.
+	 */
+	drop = h1 - h0 + n + 1;
+	drop = drop > size ? drop - size : 0;
+	if (drop > n)
+		drop = n;
+	memmove(dst->rec, dst->rec + drop, (n - drop) * sizeof(struct w1_trace_rec));
+	n -= drop;
+
+	dst->magic = W1_TRACE_MAGIC;
+	dst->version = W1_TRACE_VERSION;
+	dst->rec_size = sizeof(struct w1_trace_rec);
+	dst->clock_hz = ring->clock_hz;
+	dst->size = n;
+	dst->head = h0;
+	dst->reserved = 0;
+	return n;
+}
+
+#endif // W1_TRACE_H
@@ -8,6 +8,8 @@ SPDX-License-Identifier: MIT
 	(
 		// Users to add parameters here
 		parameter integer CLK_DIV_VAL_TO_1MHz = 100,
+		parameter integer BULK_STREAM = 0,
+		parameter integer ROM_TABLE = 0,
 
 		// User parameters ends
 		// Do not modify the parameters beyond this line
@@ -15,12 +17,19 @@ SPDX-License-Identifier: MIT
 
 		// Parameters of Axi Slave Bus Interface S00_AXI
 		parameter integer C_S00_AXI_DATA_WIDTH	= 32,
-		parameter integer C_S00_AXI_ADDR_WIDTH	= 5
+		parameter integer C_S00_AXI_ADDR_WIDTH	= 7
 	)
 	(
 		// Users to add ports here
 		inout w1_bus,
 		output wire w1_irq,
+		output wire [7:0] m_axis_rx_tdata,
+		output wire m_axis_rx_tvalid,
+		input wire m_axis_rx_tready,
+		output wire m_axis_rx_tlast,
+		input wire [7:0] s_axis_tx_tdata,
+		input wire s_axis_tx_tvalid,
+		output wire s_axis_tx_tready,
 		// User ports ends
 		// Do not modify the ports beyond this line
 
@@ -52,7 +61,9 @@ SPDX-License-Identifier: MIT
 	axi_1wire_host_slave_lite_v1_2_S00_AXI # ( 
 		.C_S_AXI_DATA_WIDTH(C_S00_AXI_DATA_WIDTH),
 		.C_S_AXI_ADDR_WIDTH(C_S00_AXI_ADDR_WIDTH),
-		.CLK_DIV_VAL_TO_1MHz(CLK_DIV_VAL_TO_1MHz)
+		.CLK_DIV_VAL_TO_1MHz(CLK_DIV_VAL_TO_1MHz),
+		.BULK_STREAM(BULK_STREAM),
+		.ROM_TABLE(ROM_TABLE)
 	) axi_1wire_host_slave_lite_v1_2_S00_AXI_inst (
 		.S_AXI_ACLK(s00_axi_aclk),
 		.S_AXI_ARESETN(s00_axi_aresetn),
@@ -76,7 +87,14 @@ SPDX-License-Identifier: MIT
 		.S_AXI_RVALID(s00_axi_rvalid),
 		.S_AXI_RREADY(s00_axi_rready),
 		.w1_bus(w1_bus),
-		.w1_irq(w1_irq)
+		.w1_irq(w1_irq),
+		.m_axis_rx_tdata(m_axis_rx_tdata),
+		.m_axis_rx_tvalid(m_axis_rx_tvalid),
+		.m_axis_rx_tready(m_axis_rx_tready),
+		.m_axis_rx_tlast(m_axis_rx_tlast),
+		.s_axis_tx_tdata(s_axis_tx_tdata),
+		.s_axis_tx_tvalid(s_axis_tx_tvalid),
+		.s_axis_tx_tready(s_axis_tx_tready)
 	);
 
 	// Add user logic here
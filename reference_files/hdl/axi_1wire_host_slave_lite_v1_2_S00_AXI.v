@@ -8,18 +8,29 @@ SPDX-License-Identifier: MIT
 	(
 		// Users to add parameters here
 		parameter integer CLK_DIV_VAL_TO_1MHz = 100,
+		parameter integer BULK_STREAM = 0,	// 1 for the block instructions and their AXI4-Stream ports
+		parameter integer ROM_TABLE = 0,	// ROM IDs of the table for SELECT_ROM and PING_ALL, 0 to 64
 		// User parameters ends
 		// Do not modify the parameters beyond this line
 
 		// Width of S_AXI data bus
 		parameter integer C_S_AXI_DATA_WIDTH	= 32,
 		// Width of S_AXI address bus
-		parameter integer C_S_AXI_ADDR_WIDTH	= 5
+		parameter integer C_S_AXI_ADDR_WIDTH	= 7
 	)
 	(
 		// Users to add ports here
 		inout w1_bus,
 		output reg w1_irq,
+		// Bytes read by RX_BLOCK, on S_AXI_ACLK
+		output wire [7:0] m_axis_rx_tdata,
+		output wire m_axis_rx_tvalid,
+		input wire m_axis_rx_tready,
+		output wire m_axis_rx_tlast,
+		// Bytes written by TX_BLOCK, on S_AXI_ACLK
+		input wire [7:0] s_axis_tx_tdata,
+		input wire s_axis_tx_tvalid,
+		output wire s_axis_tx_tready,
 		// User ports ends
 		// Do not modify the ports beyond this line
 
@@ -85,19 +96,58 @@ SPDX-License-Identifier: MIT
 		input wire  S_AXI_RREADY
 	);
 	// User signals
-	wire 		clk_1MHz;
 	wire 		ctrl_reset;
 	wire 		go;
 	wire        ready_irq_en;
 	wire        done_irq_en;
 	wire [3:0] 	command;
 	wire [7:0]	tx_data;
+	wire		spu;			// strong pull-up after TX_BIT/TX_BYTE
+	wire [23:0]	spu_duration;	// strong pull-up duration in us
+	wire [19:0]	t_rstl;			// slot timing in S_AXI_ACLK cycles
+	wire [19:0]	t_msp;
+	wire [19:0]	t_w0l;
+	wire [19:0]	t_rec;
+	wire [19:0]	t_rdv;
+	wire [19:0]	t_w1l;
+	wire [19:0]	t_slot;
 	
 	wire		done;
 	wire        ready;
 	wire		reg_wr;
 	wire		failure;
 	wire [7:0]	rx_data;
+	wire [15:0]	blen;			// bytes of a block instruction
+	wire [15:0]	bcnt;			// bytes transferred by the last block instruction
+	wire [7:0]	rom_entries;	// ROM_TABLE
+	reg			rom_wr;			// ROM ID written in the table entry of register 19
+	wire [63:0]	ping;			// entries found by the last PING_ALL
+	wire [15:0]	poll_slots;		// POLL_BIT read slots at most
+	wire [15:0]	poll_interval;	// POLL_BIT us between two slots
+	wire [15:0]	poll_cnt;		// read slots issued by the last POLL_BIT
+	wire [31:0]	caps;			// optional features, read only register 26
+
+	// W1_BULK side of W1_ROMSEL
+	wire		r_go;
+	wire [3:0]	r_command;
+	wire [7:0]	r_tx_data;
+	wire		r_spu;
+	wire		r_done;
+	wire		r_ready;
+	wire		r_reg_wr;
+	wire		r_failure;
+	wire [7:0]	r_rx_data;
+
+	// W1_MASTER side of W1_BULK
+	wire		m_go;
+	wire [3:0]	m_command;
+	wire [7:0]	m_tx_data;
+	wire		m_spu;
+	wire		m_done;
+	wire		m_ready;
+	wire		m_reg_wr;
+	wire		m_failure;
+	wire [7:0]	m_rx_data;
 
 	wire		from_dq;
 	wire        dq_ctrl_master;	// 1 to read, 0 to write to the 1 wire bus
@@ -123,11 +173,11 @@ SPDX-License-Identifier: MIT
 	// ADDR_LSB = 2 for 32 bits (n downto 2)
 	// ADDR_LSB = 3 for 64 bits (n downto 3)
 	localparam integer ADDR_LSB = (C_S_AXI_DATA_WIDTH/32) + 1;
-	localparam integer OPT_MEM_ADDR_BITS = 2;
+	localparam integer OPT_MEM_ADDR_BITS = 4;
 	//----------------------------------------------
 	//-- Signals for user logic register space example
 	//------------------------------------------------
-	//-- Number of Slave Registers 8
+	//-- Number of Slave Registers 24, in a 32 registers space
 	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg0;
 	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg1;
 	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg2;
@@ -136,6 +186,24 @@ SPDX-License-Identifier: MIT
 	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg5;
 	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg6;
 	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg7;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg8;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg9;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg10;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg11;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg12;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg13;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg14;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg15;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg16;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg17;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg18;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg19;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg20;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg21;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg22;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg23;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg24;
+	reg [C_S_AXI_DATA_WIDTH-1:0]	slv_reg25;
 	integer	 byte_index;
 
 	// I/O Connections assignments
@@ -239,69 +307,185 @@ SPDX-License-Identifier: MIT
 	      slv_reg3 <= 0;
 	      slv_reg4 <= 0;
 	      slv_reg5 <= 0;
-	      slv_reg6 <= 32'h76000102; //v01.2
+	      slv_reg6 <= 32'h76000108; //v01.8
 	      slv_reg7 <= 32'h10ee4453; //10ee is XILINX subsystem vendor ID. 4453 is "DS" which identify 1-wire devices
+	      slv_reg8 <= 0;
+	      // Slot timing, standard speed, in S_AXI_ACLK cycles
+	      slv_reg9 <= 480 * CLK_DIV_VAL_TO_1MHz;	// reset low
+	      slv_reg10 <= 70 * CLK_DIV_VAL_TO_1MHz;	// presence sample
+	      slv_reg11 <= 60 * CLK_DIV_VAL_TO_1MHz;	// write-0 low
+	      slv_reg12 <= 1 * CLK_DIV_VAL_TO_1MHz;	// recovery
+	      slv_reg13 <= 15 * CLK_DIV_VAL_TO_1MHz;	// read sample
+	      slv_reg14 <= 6 * CLK_DIV_VAL_TO_1MHz;	// write-1 and read low
+	      slv_reg15 <= 80 * CLK_DIV_VAL_TO_1MHz;	// slot
+	      slv_reg16 <= CLK_DIV_VAL_TO_1MHz;		// read only, cycles per us
+	      slv_reg17 <= 0;
+	      slv_reg18 <= 0;
+	      slv_reg19 <= 0;
+	      slv_reg20 <= 0;
+	      slv_reg21 <= 0;
+	      slv_reg22 <= 0;
+	      slv_reg23 <= 0;
+	      slv_reg24 <= 0;
+	      slv_reg25 <= 0;
+	      rom_wr <= 1'b0;
 	    end 
 	  else begin
+	    rom_wr <= 1'b0;
 	    if (S_AXI_WVALID)
 	      begin
 	        case ( (S_AXI_AWVALID) ? S_AXI_AWADDR[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] : axi_awaddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] )
-	          3'h0:
+	          5'h00:
 	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
 	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
 	                // Respective byte enables are asserted as per write strobes 
 	                // Slave register 0
 	                slv_reg0[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
 	              end  
-	          3'h1:
+	          5'h01:
 	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
 	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
 	                // Respective byte enables are asserted as per write strobes 
 	                // Slave register 1
 	                slv_reg1[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
 	              end  
-	          3'h2:
+	          5'h02:
 	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
 	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
 	                // Respective byte enables are asserted as per write strobes 
 	                // Slave register 2
 	                slv_reg2[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
 	              end  
-	          3'h3:
+	          5'h03:
 	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
 	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
 	                // Respective byte enables are asserted as per write strobes 
 	                // Slave register 3
 	                slv_reg3[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
 	              end  
-	          3'h4:
+	          5'h04:
 	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
 	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
 	                // Respective byte enables are asserted as per write strobes 
 	                // Slave register 4
 	                slv_reg4[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
 	              end  
-	          3'h5:
+	          5'h05:
 	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
 	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
 	                // Respective byte enables are asserted as per write strobes 
 	                // Slave register 5
 	                slv_reg5[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
 	              end  
-	          3'h6:
+	          5'h06:
 	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
 	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
 	                // Respective byte enables are asserted as per write strobes 
 	                // Slave register 6
 	                slv_reg6[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
 	              end  
-	          3'h7:
+	          5'h07:
 	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
 	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
 	                // Respective byte enables are asserted as per write strobes 
 	                // Slave register 7
 	                slv_reg7[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
 	              end  
+	          5'h08:
+	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
+	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
+	                // Respective byte enables are asserted as per write strobes 
+	                // Slave register 8
+	                slv_reg8[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
+	              end  
+	          5'h09:
+	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
+	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
+	                // Respective byte enables are asserted as per write strobes 
+	                // Slave register 9
+	                slv_reg9[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
+	              end  
+	          5'h0A:
+	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
+	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
+	                // Respective byte enables are asserted as per write strobes 
+	                // Slave register 10
+	                slv_reg10[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
+	              end  
+	          5'h0B:
+	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
+	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
+	                // Respective byte enables are asserted as per write strobes 
+	                // Slave register 11
+	                slv_reg11[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
+	              end  
+	          5'h0C:
+	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
+	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
+	                // Respective byte enables are asserted as per write strobes 
+	                // Slave register 12
+	                slv_reg12[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
+	              end  
+	          5'h0D:
+	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
+	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
+	                // Respective byte enables are asserted as per write strobes 
+	                // Slave register 13
+	                slv_reg13[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
+	              end  
+	          5'h0E:
+	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
+	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
+	                // Respective byte enables are asserted as per write strobes 
+	                // Slave register 14
+	                slv_reg14[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
+	              end  
+	          5'h0F:
+	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
+	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
+	                // Respective byte enables are asserted as per write strobes 
+	                // Slave register 15
+	                slv_reg15[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
+	              end  
+	          5'h11:
+	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
+	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
+	                // Respective byte enables are asserted as per write strobes 
+	                // Slave register 17
+	                slv_reg17[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
+	              end  
+	          5'h13:
+	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
+	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
+	                // Respective byte enables are asserted as per write strobes 
+	                // Slave register 19
+	                slv_reg19[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
+	              end  
+	          5'h14:
+	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
+	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
+	                // Respective byte enables are asserted as per write strobes 
+	                // Slave register 20
+	                slv_reg20[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
+	              end  
+	          5'h15:
+	            begin
+	              for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
+	                if ( S_AXI_WSTRB[byte_index] == 1 ) begin
+	                  // Respective byte enables are asserted as per write strobes 
+	                  // Slave register 21
+	                  slv_reg21[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
+	                end  
+	              // The entry is written with registers 21 and 20 on the next cycle
+	              rom_wr <= 1'b1;
+	            end
+	          5'h18:
+	            for ( byte_index = 0; byte_index <= (C_S_AXI_DATA_WIDTH/8)-1; byte_index = byte_index+1 )
+	              if ( S_AXI_WSTRB[byte_index] == 1 ) begin
+	                // Respective byte enables are asserted as per write strobes 
+	                // Slave register 24
+	                slv_reg24[(byte_index*8) +: 8] <= S_AXI_WDATA[(byte_index*8) +: 8];
+	              end  
 	          default : begin
 	                      slv_reg0 <= slv_reg0;
 	                      slv_reg1 <= slv_reg1;
@@ -311,6 +495,20 @@ SPDX-License-Identifier: MIT
 	                      slv_reg5 <= slv_reg5;
 	                      slv_reg6 <= slv_reg6;
 	                      slv_reg7 <= slv_reg7;
+	                      slv_reg8 <= slv_reg8;
+	                      slv_reg9 <= slv_reg9;
+	                      slv_reg10 <= slv_reg10;
+	                      slv_reg11 <= slv_reg11;
+	                      slv_reg12 <= slv_reg12;
+	                      slv_reg13 <= slv_reg13;
+	                      slv_reg14 <= slv_reg14;
+	                      slv_reg15 <= slv_reg15;
+	                      slv_reg16 <= slv_reg16;
+	                      slv_reg17 <= slv_reg17;
+	                      slv_reg19 <= slv_reg19;
+	                      slv_reg20 <= slv_reg20;
+	                      slv_reg21 <= slv_reg21;
+	                      slv_reg24 <= slv_reg24;
 	                    end
 	        endcase
 	      end
@@ -322,6 +520,13 @@ SPDX-License-Identifier: MIT
 			slv_reg4[7:0]	<= rx_data;
 			slv_reg5[0]		<= from_dq;
 		  end
+		// Read only, block progress and whether the stream ports are present
+		slv_reg18		<= {BULK_STREAM != 0, 15'b0, bcnt};
+		// Read only, entries found by the last PING_ALL
+		slv_reg22		<= ping[31:0];
+		slv_reg23		<= ping[63:32];
+		// Read only, slots issued by the last POLL_BIT
+		slv_reg25		<= {16'b0, poll_cnt};
 	  end
 	end    
 
@@ -373,7 +578,7 @@ SPDX-License-Identifier: MIT
 	          end                                       
 	        end                                         
 	// Implement memory mapped register select and read logic generation
-	  assign S_AXI_RDATA = (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 3'h0) ? slv_reg0 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 3'h1) ? slv_reg1 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 3'h2) ? slv_reg2 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 3'h3) ? slv_reg3 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 3'h4) ? slv_reg4 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 3'h5) ? slv_reg5 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 3'h6) ? slv_reg6 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 3'h7) ? slv_reg7 : 0; 
+	  assign S_AXI_RDATA = (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h00) ? slv_reg0 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h01) ? slv_reg1 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h02) ? slv_reg2 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h03) ? slv_reg3 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h04) ? slv_reg4 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h05) ? slv_reg5 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h06) ? slv_reg6 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h07) ? slv_reg7 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h08) ? slv_reg8 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h09) ? slv_reg9 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h0A) ? slv_reg10 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h0B) ? slv_reg11 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h0C) ? slv_reg12 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h0D) ? slv_reg13 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h0E) ? slv_reg14 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h0F) ? slv_reg15 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h10) ? slv_reg16 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h11) ? slv_reg17 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h12) ? slv_reg18 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h13) ? {rom_entries, slv_reg19[23:0]} : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h14) ? slv_reg20 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h15) ? slv_reg21 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h16) ? slv_reg22 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h17) ? slv_reg23 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h18) ? slv_reg24 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h19) ? slv_reg25 : (axi_araddr[ADDR_LSB+OPT_MEM_ADDR_BITS:ADDR_LSB] == 5'h1A) ? caps : 0; 
 	// Add user logic here
 	assign ctrl_reset 	= slv_reg1[31];
 	assign go			= slv_reg1[0];
@@ -389,28 +594,148 @@ SPDX-License-Identifier: MIT
 	assign tx_data			= slv_reg0[7:0];
 	assign dq_ctrl_gpio		= slv_reg0[23];
 	assign dq_out_gpio      = slv_reg0[16];
-	
-	CLK_DIVIDER #(.DIVIDER(CLK_DIV_VAL_TO_1MHz)) CLK_DIVIDER(
-		.areset(S_AXI_ARESETN),
-		.clk_in(S_AXI_ACLK),
-		.clk_out(clk_1MHz)
-	);
+	assign spu				= slv_reg0[12];
+	assign spu_duration		= slv_reg8[23:0];
+	assign t_rstl			= slv_reg9[19:0];
+	assign t_msp			= slv_reg10[19:0];
+	assign t_w0l			= slv_reg11[19:0];
+	assign t_rec			= slv_reg12[19:0];
+	assign t_rdv			= slv_reg13[19:0];
+	assign t_w1l			= slv_reg14[19:0];
+	assign t_slot			= slv_reg15[19:0];
+	assign blen				= slv_reg17[15:0];
+	assign rom_entries		= ROM_TABLE;	// read in the MSB of register 19
+	assign poll_slots		= slv_reg24[15:0];
+	assign poll_interval	= slv_reg24[31:16];
+	// SPU, TIMING, BLOCK, ROM_TABLE, POLL_BIT and the ROM ID table entries
+	assign caps				= {16'b0, rom_entries, 3'b0, 1'b1, ROM_TABLE != 0, BULK_STREAM != 0, 2'b11};
+
+	// ROM table instructions, sequenced over W1_BULK
+	generate
+	if (ROM_TABLE != 0) begin : g_rom
+		W1_ROMSEL #(.ROM_TABLE(ROM_TABLE)) W1_ROMSEL(
+			.clk(S_AXI_ACLK),
+			.areset(S_AXI_ARESETN),
+			.ctrl_reset(ctrl_reset),
+			.go(go),
+			.command(command),
+			.tx_data(tx_data),
+			.spu(spu),
+			.rom_wr(rom_wr),
+			.rom_idx(slv_reg19[5:0]),
+			.rom_id({slv_reg21, slv_reg20}),
+			.done(done),
+			.ready(ready),
+			.reg_wr(reg_wr),
+			.failure(failure),
+			.data_out(rx_data),
+			.ping(ping),
+			.m_go(r_go),
+			.m_command(r_command),
+			.m_tx_data(r_tx_data),
+			.m_spu(r_spu),
+			.m_done(r_done),
+			.m_ready(r_ready),
+			.m_reg_wr(r_reg_wr),
+			.m_failure(r_failure),
+			.m_data_out(r_rx_data)
+		);
+	end
+	else begin : g_no_rom
+		assign r_go				= go;
+		assign r_command		= command;
+		assign r_tx_data		= tx_data;
+		assign r_spu			= spu;
+		assign done				= r_done;
+		assign ready			= r_ready;
+		assign reg_wr			= r_reg_wr;
+		assign failure			= r_failure;
+		assign rx_data			= r_rx_data;
+		assign ping				= 0;
+	end
+	endgenerate
+
+	// Block instructions, sequenced over W1_MASTER
+	generate
+	if (BULK_STREAM != 0) begin : g_bulk
+		W1_BULK W1_BULK(
+			.clk(S_AXI_ACLK),
+			.areset(S_AXI_ARESETN),
+			.ctrl_reset(ctrl_reset),
+			.go(r_go),
+			.command(r_command),
+			.tx_data(r_tx_data),
+			.spu(r_spu),
+			.blen(blen),
+			.done(r_done),
+			.ready(r_ready),
+			.reg_wr(r_reg_wr),
+			.failure(r_failure),
+			.data_out(r_rx_data),
+			.bcnt(bcnt),
+			.m_go(m_go),
+			.m_command(m_command),
+			.m_tx_data(m_tx_data),
+			.m_spu(m_spu),
+			.m_done(m_done),
+			.m_ready(m_ready),
+			.m_reg_wr(m_reg_wr),
+			.m_failure(m_failure),
+			.m_data_out(m_rx_data),
+			.m_axis_tdata(m_axis_rx_tdata),
+			.m_axis_tvalid(m_axis_rx_tvalid),
+			.m_axis_tready(m_axis_rx_tready),
+			.m_axis_tlast(m_axis_rx_tlast),
+			.s_axis_tdata(s_axis_tx_tdata),
+			.s_axis_tvalid(s_axis_tx_tvalid),
+			.s_axis_tready(s_axis_tx_tready)
+		);
+	end
+	else begin : g_no_bulk
+		assign m_go				= r_go;
+		assign m_command		= r_command;
+		assign m_tx_data		= r_tx_data;
+		assign m_spu			= r_spu;
+		assign r_done			= m_done;
+		assign r_ready			= m_ready;
+		assign r_reg_wr			= m_reg_wr;
+		assign r_failure		= m_failure;
+		assign r_rx_data		= m_rx_data;
+		assign bcnt				= 0;
+		assign m_axis_rx_tdata	= 0;
+		assign m_axis_rx_tvalid	= 1'b0;
+		assign m_axis_rx_tlast	= 1'b0;
+		assign s_axis_tx_tready	= 1'b0;
+	end
+	endgenerate
 
-	W1_MASTER W1_MASTER(
-		.clk_1MHz(clk_1MHz),
+	W1_MASTER #(.CLK_DIV_VAL_TO_1MHz(CLK_DIV_VAL_TO_1MHz)) W1_MASTER(
+		.clk(S_AXI_ACLK),
 		.areset(S_AXI_ARESETN),
 		.ctrl_reset(ctrl_reset),
-		.go(go),
-		.command(command),
-		.tx_data(tx_data),
+		.go(m_go),
+		.command(m_command),
+		.tx_data(m_tx_data),
+		.spu(m_spu),
+		.spu_duration(spu_duration),
+		.t_rstl(t_rstl),
+		.t_msp(t_msp),
+		.t_w0l(t_w0l),
+		.t_rec(t_rec),
+		.t_rdv(t_rdv),
+		.t_w1l(t_w1l),
+		.t_slot(t_slot),
+		.poll_slots(poll_slots),
+		.poll_interval(poll_interval),
 		.from_dq(from_dq),
 		.dq_ctrl(dq_ctrl_master),
 		.dq_out(dq_out_master),
-		.done(done),
-		.ready(ready),
-		.reg_wr(reg_wr),
-		.failure(failure),
-		.data_out(rx_data)
+		.done(m_done),
+		.ready(m_ready),
+		.reg_wr(m_reg_wr),
+		.failure(m_failure),
+		.data_out(m_rx_data),
+		.poll_cnt(poll_cnt)
 	);
 
 	IOBUF IOBUF1(
@@ -0,0 +1,26 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+/*
+-------------------------------------------------------------------------------
+-- Title      : IOBUF, simulation model
+-- Project    : 1-wire
+-------------------------------------------------------------------------------
+-- File       : iobuf_model.v
+-------------------------------------------------------------------------------
+-- Description: Stand-in of the Xilinx IOBUF primitive: IO is driven with I
+--              while T is 0 and released while T is 1, O is the level of IO.
+-------------------------------------------------------------------------------
+*/
+module IOBUF (
+    output  wire    O,
+    inout   wire    IO,
+    input   wire    I,
+    input   wire    T
+);
+
+assign IO = T ? 1'bz : I;
+assign O  = IO;
+
+endmodule
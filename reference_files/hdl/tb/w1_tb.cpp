@@ -0,0 +1,1131 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+/*
+ * w1_tb: Verilator testbench of the AXI 1-Wire Host IP.
+ *
+ * The harness drives the AXI4-Lite interface of w1_tb_top cycle by cycle at
+ * 100 MHz and runs behavioural DS18B20 devices on the bus, decoding the slots
+ * from the low time of the wire as a device does. Scripts (scripts/) are
+ * sequences of AXI-lite transactions and of 1-Wire instructions executed
+ * with the handshake of the baremetal driver: wait READY, write INSTR, set
+ * GO, poll DONE, read RXDATA, clear GO. Each script starts from the reset
+ * of the IP and of the devices, so they can be run in any order.
+ *
+ * For each script, the harness reports, from the handshake signals of
+ * W1_MASTER:
+ *   - the bus utilization, share of the time W1_MASTER executes an
+ *     instruction (neither in IDLE_M nor DONE_M);
+ *   - the idle time between two instructions caused by the host handshake,
+ *     from DONE raised to the next instruction started;
+ *   - the instructions per second.
+ * It also checks the GO to DONE time of every instruction against the slot
+ * timing of w1_master.v, so a change of the time base or of the handshake
+ * shows up as a failure. The expected times follow the slot timing
+ * registers written by the scripts.
+ *
+ * The AXI4-Stream ports of the block instructions are served like an AXI
+ * DMA: the bytes read are collected, the bytes to write are offered from a
+ * queue filled before the instruction.
+ *
+ * w1_tb_top has a ROM ID table of 8 entries, loaded by the scripts with the
+ * ROM IDs of the devices.
+ *
+ * Usage: w1_tb [-n devices] [-g gap_cycles] [-t trace.vcd] script...
+ *   -n  number of DS18B20 on the bus (1 to W1_TB_MAX_DEVICES, default 1)
+ *   -g  idle AXI cycles after each access, to model the latency of the
+ *       processor and of the interconnect (default 0)
+ *   -t  dump a VCD trace, if built with --trace
+ *
+ * The exit status is the number of failed checks.
+ */
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+#include <string>
+#include "verilated.h"
+#include "Vw1_tb_top.h"
+#if VM_TRACE
+#include "verilated_vcd_c.h"
+#endif
+
+/* Register map, see axi_1wire_host.h */
+#define INSTR_REG	0x00
+#define CTRL_REG	0x04
+#define STAT_REG	0x0C
+#define RXDATA_REG	0x10
+#define SPU_REG		0x20
+#define TRSTL_REG	0x24	/* Slot timing, in AXI clock cycles */
+#define TMSP_REG	0x28
+#define TW0L_REG	0x2C
+#define TREC_REG	0x30
+#define TRDV_REG	0x34
+#define TW1L_REG	0x38
+#define TSLOT_REG	0x3C
+#define TCLK_REG	0x40
+#define BLEN_REG	0x44	/* Bytes of a block instruction */
+#define BCNT_REG	0x48
+#define ROMIDX_REG	0x4C	/* ROM ID table */
+#define ROMLO_REG	0x50
+#define ROMHI_REG	0x54
+#define PING0_REG	0x58
+#define PING1_REG	0x5C
+#define POLL_REG	0x60	/* POLL_BIT interval and slots */
+#define POLLCNT_REG	0x64
+
+#define INITPRES	0x0800
+#define READBIT		0x0C00
+#define WRITEBIT	0x0E00
+#define READBYTE	0x0D00
+#define WRITEBYTE	0x0F00
+#define READBLOCK	0x0900
+#define WRITEBLOCK	0x0B00
+#define SELECTROM	0x0A00
+#define PINGALL		0x0600
+#define POLLBIT		0x0700
+#define SPU		0x1000
+
+#define STAT_DONE	0x00000001
+#define STAT_READY	0x00000010
+#define STAT_NOPRESENCE	0x80000000
+#define CTRL_GO		0x00000001
+
+#define CLK_NS		10	/* 100 MHz AXI clock */
+#define US		1000ULL
+#define MS		1000000ULL
+
+#define CYCLES_PER_US	(US / CLK_NS)	/* CLK_DIV_VAL_TO_1MHz of w1_tb_top */
+#define TIMING_TOL_NS	(2 * US)
+
+#define POLL_TIMEOUT_NS	(100 * MS)
+#define CONV_TIMEOUT_NS	(1000 * MS)
+
+#define W1_TB_MAX_DEVICES	8
+#define W1_TB_ROM_TABLE		8	/* ROM_TABLE of w1_tb_top */
+
+/**************************** Behavioural device ***************************/
+/*
+ * DS18B20 subset: ROM layer (Read, Match, Skip and Search ROM), Convert T
+ * with its busy read slots, Read and Write Scratchpad.
+ */
+#define DEV_PRESENCE_WAIT_NS	(30 * US)
+#define DEV_PRESENCE_NS		(120 * US)
+#define DEV_TX0_NS		(30 * US)	/* Low time of a read-0 slot */
+#define DEV_WRITE0_NS		(15 * US)	/* Longer low time reads as a 0 */
+#define DEV_RESET_NS		(400 * US)	/* Longer low time is a reset */
+
+enum { DEV_ROM_CMD, DEV_MATCH, DEV_SEARCH, DEV_FUNC_CMD, DEV_WRITE_SP, DEV_CONVERT,
+       DEV_TX, DEV_IGNORE };
+
+struct w1_dev {
+	uint8_t rom[8];
+	uint8_t scratchpad[9];
+	uint16_t temp;			/* Latched by Convert T, 1/16 C */
+	int state;
+	uint8_t rx;
+	int nrx;			/* Bits of the byte being received */
+	int count;			/* Bytes or bits of the current command */
+	uint8_t tx[16];
+	int tx_len;			/* In bits */
+	int tx_pos;
+	int search_phase;		/* Bit, complement, direction */
+	int sending;			/* Driving the current slot */
+	int conv_pending;
+	uint64_t busy_until_ns;		/* Conversion in progress */
+	uint64_t drive_until_ns;	/* Pulling the bus low until */
+	uint64_t presence_ns;		/* Presence pulse to start, 0 if none */
+};
+
+/***************************** Measurements ********************************/
+struct tb_stats {
+	uint64_t start_ns;
+	uint64_t busy_ns;
+	uint64_t instructions;
+	uint64_t gaps;
+	uint64_t gap_ns;
+	uint64_t gap_min_ns;
+	uint64_t gap_max_ns;
+	uint64_t axi_reads;
+	uint64_t axi_writes;
+	uint64_t timing_errors;
+};
+
+static VerilatedContext *ctx;
+static Vw1_tb_top *top;
+#if VM_TRACE
+static VerilatedVcdC *tfp;
+#endif
+static uint64_t now_ns;
+static int gap_cycles;
+
+static struct w1_dev devs[W1_TB_MAX_DEVICES];
+static int ndevs = 1;
+static int bus_level = 1;
+static int master_low;
+static uint64_t slot_fall_ns;
+
+static struct tb_stats st;
+static int prev_busy, prev_done;
+static uint64_t done_rise_ns;		/* 0 while no gap is measured */
+static uint64_t go_ns;			/* GO seen by W1_MASTER */
+static uint64_t expected_ns;		/* GO to DONE of the instruction */
+static uint32_t timing[7];		/* TRSTL to TSLOT as written, in cycles */
+static std::vector<uint8_t> rx_stream;	/* Bytes of m_axis_rx, and their tlast */
+static std::vector<int> rx_last;
+static std::deque<uint8_t> tx_stream;	/* Bytes for s_axis_tx */
+static int failures;
+
+static void fail(const char *fmt, ...)
+{
+	va_list args;
+
+	printf("FAIL: ");
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+	printf("\n");
+	failures++;
+}
+
+static uint8_t crc8(const uint8_t *data, int len)
+{
+	uint8_t crc = 0;
+	int i, b;
+
+	for (i = 0; i < len; i++) {
+		crc ^= data[i];
+		for (b = 0; b < 8; b++)
+			crc = (crc & 1) ? (crc >> 1) ^ 0x8C : crc >> 1;
+	}
+	return crc;
+}
+
+/*************************** Device, byte layer ****************************/
+static void dev_queue(struct w1_dev *dev, const uint8_t *buf, int len)
+{
+	memcpy(dev->tx, buf, len);
+	dev->tx_len = len * 8;
+	dev->tx_pos = 0;
+	dev->state = DEV_TX;
+}
+
+static void dev_rx_byte(struct w1_dev *dev, uint8_t byte)
+{
+	int r;
+
+	switch (dev->state) {
+	case DEV_ROM_CMD:
+		dev->count = 0;
+		switch (byte) {
+		case 0x33:	/* Read ROM */
+			dev_queue(dev, dev->rom, 8);
+			break;
+		case 0x55:	/* Match ROM */
+			dev->state = DEV_MATCH;
+			break;
+		case 0xCC:	/* Skip ROM */
+			dev->state = DEV_FUNC_CMD;
+			break;
+		case 0xF0:	/* Search ROM */
+			dev->search_phase = 0;
+			dev->state = DEV_SEARCH;
+			break;
+		default:
+			dev->state = DEV_IGNORE;
+			break;
+		}
+		break;
+	case DEV_MATCH:
+		if (byte != dev->rom[dev->count]) {
+			dev->state = DEV_IGNORE;
+			break;
+		}
+		if (++dev->count == 8)
+			dev->state = DEV_FUNC_CMD;
+		break;
+	case DEV_FUNC_CMD:
+		dev->count = 0;
+		switch (byte) {
+		case 0x44:	/* Convert T */
+			r = (dev->scratchpad[4] >> 5) & 3;
+			dev->busy_until_ns = now_ns + ((93750 * US) << r);
+			dev->conv_pending = 1;
+			dev->state = DEV_CONVERT;
+			break;
+		case 0x4E:	/* Write Scratchpad */
+			dev->state = DEV_WRITE_SP;
+			break;
+		case 0xBE:	/* Read Scratchpad */
+			dev_queue(dev, dev->scratchpad, 9);
+			break;
+		default:
+			dev->state = DEV_IGNORE;
+			break;
+		}
+		break;
+	case DEV_WRITE_SP:
+		/* TH, TL and configuration, only R1:R0 are writable */
+		if (dev->count == 2)
+			byte = (byte & 0x60) | 0x1F;
+		dev->scratchpad[2 + dev->count] = byte;
+		if (++dev->count == 3) {
+			dev->scratchpad[8] = crc8(dev->scratchpad, 8);
+			dev->state = DEV_IGNORE;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/* Latch the conversion result once its time has elapsed */
+static void dev_update(struct w1_dev *dev)
+{
+	if (!dev->conv_pending || now_ns < dev->busy_until_ns)
+		return;
+	dev->conv_pending = 0;
+	dev->scratchpad[0] = (uint8_t)dev->temp;
+	dev->scratchpad[1] = (uint8_t)(dev->temp >> 8);
+	dev->scratchpad[8] = crc8(dev->scratchpad, 8);
+}
+
+/* Level to drive in the slot starting, -1 when receiving */
+static int dev_tx_bit(struct w1_dev *dev)
+{
+	int bit;
+
+	switch (dev->state) {
+	case DEV_TX:
+		return (dev->tx[dev->tx_pos / 8] >> (dev->tx_pos % 8)) & 1;
+	case DEV_SEARCH:
+		if (dev->search_phase == 2)
+			return -1;
+		bit = (dev->rom[dev->count / 8] >> (dev->count % 8)) & 1;
+		return dev->search_phase ? !bit : bit;
+	case DEV_CONVERT:
+		/* 0 while converting, 1 once done */
+		return !dev->conv_pending;
+	case DEV_IGNORE:
+		return 1;
+	default:
+		return -1;
+	}
+}
+
+static void dev_rx_bit(struct w1_dev *dev, int bit)
+{
+	if (dev->state == DEV_SEARCH) {
+		/* Direction chosen by the host, deselected if not ours */
+		if (bit != ((dev->rom[dev->count / 8] >> (dev->count % 8)) & 1)) {
+			dev->state = DEV_IGNORE;
+			return;
+		}
+		dev->search_phase = 0;
+		if (++dev->count == 64) {
+			dev->count = 0;
+			dev->state = DEV_FUNC_CMD;
+		}
+		return;
+	}
+	dev->rx = (uint8_t)((dev->rx >> 1) | (bit << 7));
+	if (++dev->nrx == 8) {
+		dev->nrx = 0;
+		dev_rx_byte(dev, dev->rx);
+	}
+}
+
+static void dev_reset(struct w1_dev *dev)
+{
+	dev_update(dev);
+	dev->state = DEV_ROM_CMD;
+	dev->nrx = 0;
+	dev->count = 0;
+	dev->sending = 0;
+	dev->presence_ns = now_ns + DEV_PRESENCE_WAIT_NS;
+}
+
+/*************************** Device, wire layer ****************************/
+static void dev_slot_start(struct w1_dev *dev)
+{
+	int bit;
+
+	dev_update(dev);
+	bit = dev_tx_bit(dev);
+	dev->sending = bit >= 0;
+	if (bit == 0)
+		dev->drive_until_ns = now_ns + DEV_TX0_NS;
+}
+
+static void dev_slot_end(struct w1_dev *dev, uint64_t low_ns)
+{
+	if (low_ns >= DEV_RESET_NS) {
+		dev_reset(dev);
+		return;
+	}
+	if (!dev->sending) {
+		dev_rx_bit(dev, low_ns < DEV_WRITE0_NS);
+		return;
+	}
+	dev->sending = 0;
+	if (dev->state == DEV_TX) {
+		if (++dev->tx_pos == dev->tx_len)
+			dev->state = DEV_IGNORE;
+	} else if (dev->state == DEV_SEARCH) {
+		dev->search_phase++;
+	}
+}
+
+/*
+ * Called after each rising edge of the AXI clock: a falling edge of the wire
+ * no device caused starts a slot, the next rising edge ends it.
+ */
+static void devices_update(void)
+{
+	int level = top->w1_level;
+	int pull = 0;
+	int i;
+
+	if (level != bus_level) {
+		if (!level && !top->dev_pull_low) {
+			master_low = 1;
+			slot_fall_ns = now_ns;
+			for (i = 0; i < ndevs; i++)
+				dev_slot_start(&devs[i]);
+		} else if (level && master_low) {
+			master_low = 0;
+			for (i = 0; i < ndevs; i++)
+				dev_slot_end(&devs[i], now_ns - slot_fall_ns);
+		}
+		bus_level = level;
+	}
+
+	for (i = 0; i < ndevs; i++) {
+		struct w1_dev *dev = &devs[i];
+
+		if (dev->presence_ns && now_ns >= dev->presence_ns) {
+			dev->presence_ns = 0;
+			dev->drive_until_ns = now_ns + DEV_PRESENCE_NS;
+		}
+		if (now_ns < dev->drive_until_ns)
+			pull = 1;
+	}
+	top->dev_pull_low = pull;
+}
+
+static void dev_init(struct w1_dev *dev, int index)
+{
+	static const uint8_t por[9] = { 0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10, 0 };
+	uint64_t serial = 0x000012345600ULL + index;
+	int i;
+
+	memset(dev, 0, sizeof(*dev));
+	dev->rom[0] = 0x28;
+	for (i = 0; i < 6; i++)
+		dev->rom[1 + i] = (uint8_t)(serial >> (8 * i));
+	dev->rom[7] = crc8(dev->rom, 7);
+	memcpy(dev->scratchpad, por, sizeof(por));
+	dev->scratchpad[8] = crc8(dev->scratchpad, 8);
+	dev->temp = (uint16_t)(0x0190 + 8 * index);	/* 25 C + index * 0.5 C */
+	dev->state = DEV_IGNORE;
+}
+
+/******************************** Clocking *********************************/
+/* Handshake measurements, sampled once per AXI cycle */
+static void monitor(void)
+{
+	int busy = top->busy, done = top->done;
+	uint64_t gap, d;
+
+	if (busy)
+		st.busy_ns += CLK_NS;
+	if (busy && !prev_busy) {
+		go_ns = now_ns;
+		st.instructions++;
+		if (done_rise_ns) {
+			gap = now_ns - done_rise_ns;
+			st.gaps++;
+			st.gap_ns += gap;
+			if (!st.gap_min_ns || gap < st.gap_min_ns)
+				st.gap_min_ns = gap;
+			if (gap > st.gap_max_ns)
+				st.gap_max_ns = gap;
+			done_rise_ns = 0;
+		}
+	}
+	if (done && !prev_done) {
+		done_rise_ns = now_ns;
+		if (expected_ns) {
+			d = now_ns - go_ns;
+			if (d + TIMING_TOL_NS < expected_ns || d > expected_ns + TIMING_TOL_NS) {
+				fail("GO to DONE %llu ns, expected %llu ns", (unsigned long long)d,
+				     (unsigned long long)expected_ns);
+				st.timing_errors++;
+			}
+			expected_ns = 0;
+		}
+	}
+	prev_busy = busy;
+	prev_done = done;
+}
+
+static void tick(void)
+{
+	int rx_fire, tx_fire;
+
+	top->clk = 0;
+	top->rx_tready = 1;
+	top->tx_tvalid = !tx_stream.empty();
+	top->tx_tdata = tx_stream.empty() ? 0 : tx_stream.front();
+	top->eval();
+	rx_fire = top->rx_tvalid && top->rx_tready;
+	tx_fire = top->tx_tvalid && top->tx_tready;
+	if (rx_fire) {
+		rx_stream.push_back(top->rx_tdata);
+		rx_last.push_back(top->rx_tlast);
+	}
+	if (tx_fire)
+		tx_stream.pop_front();
+	ctx->timeInc(CLK_NS / 2);
+#if VM_TRACE
+	if (tfp)
+		tfp->dump(ctx->time());
+#endif
+	top->clk = 1;
+	top->eval();
+	ctx->timeInc(CLK_NS / 2);
+#if VM_TRACE
+	if (tfp)
+		tfp->dump(ctx->time());
+#endif
+	now_ns += CLK_NS;
+	devices_update();
+	monitor();
+}
+
+static void idle(uint64_t ns)
+{
+	uint64_t end = now_ns + ns;
+
+	while (now_ns < end)
+		tick();
+}
+
+/****************************** AXI4-Lite master ***************************/
+static void axi_write(uint32_t offset, uint32_t value)
+{
+	top->awaddr = offset;
+	top->awvalid = 1;
+	top->wdata = value;
+	top->wstrb = 0xF;
+	top->wvalid = 1;
+	top->bready = 1;
+	while (!top->awready)
+		tick();
+	tick();
+	top->awvalid = 0;
+	top->wvalid = 0;
+	while (!top->bvalid)
+		tick();
+	tick();
+	top->bready = 0;
+	st.axi_writes++;
+	idle((uint64_t)gap_cycles * CLK_NS);
+}
+
+static uint32_t axi_read(uint32_t offset)
+{
+	uint32_t value;
+
+	top->araddr = offset;
+	top->arvalid = 1;
+	top->rready = 1;
+	while (!top->arready)
+		tick();
+	tick();
+	top->arvalid = 0;
+	while (!top->rvalid)
+		tick();
+	value = top->rdata;
+	tick();
+	top->rready = 0;
+	st.axi_reads++;
+	idle((uint64_t)gap_cycles * CLK_NS);
+	return value;
+}
+
+/* Read a register until (value & mask) == expected, 0 on timeout */
+static int axi_poll(uint32_t offset, uint32_t mask, uint32_t expected, uint32_t *value,
+		    uint64_t timeout_ns)
+{
+	uint64_t end = now_ns + timeout_ns;
+	uint32_t v;
+
+	do {
+		v = axi_read(offset);
+		if ((v & mask) == expected) {
+			if (value)
+				*value = v;
+			return 1;
+		}
+	} while (now_ns < end);
+	fail("poll of 0x%x timed out", offset);
+	return 0;
+}
+
+/**************************** 1-Wire instructions **************************/
+/* Reset values of TRSTL to TSLOT */
+static void timing_init(void)
+{
+	static const uint32_t us[7] = { 480, 70, 60, 1, 15, 6, 80 };
+	int i;
+
+	for (i = 0; i < 7; i++)
+		timing[i] = us[i] * CYCLES_PER_US;
+}
+
+static uint32_t timing_reg(uint32_t offset)
+{
+	return timing[(offset - TRSTL_REG) / 4];
+}
+
+/*
+ * GO to DONE of w1_master.v, in cycles of the AXI clock: INIT_M, then the
+ * reset pulse and the presence window, or DONE raised at TW0L of the last
+ * slot, a slot lasting TSLOT or TW0L + TREC if longer.
+ */
+static uint64_t init_ns(void)
+{
+	return (1 + 2ULL * timing_reg(TRSTL_REG)) * CLK_NS;
+}
+
+static uint64_t bit_ns(void)
+{
+	return (1 + (uint64_t)timing_reg(TW0L_REG)) * CLK_NS;
+}
+
+static uint64_t byte_ns(void)
+{
+	uint64_t slot = timing_reg(TW0L_REG) + timing_reg(TREC_REG);
+
+	if (slot < timing_reg(TSLOT_REG))
+		slot = timing_reg(TSLOT_REG);
+	return 7 * slot * CLK_NS + bit_ns();
+}
+
+/*
+ * Execute an instruction with the handshake of the baremetal driver.
+ * Returns RXDATA for the reads and STAT otherwise.
+ */
+static uint32_t w1_instr(uint32_t instr, uint64_t expected)
+{
+	uint32_t cmd = instr & 0x0F00, value = 0;
+
+	axi_poll(STAT_REG, STAT_READY, STAT_READY, NULL, POLL_TIMEOUT_NS);
+	axi_write(INSTR_REG, instr);
+	expected_ns = expected;
+	axi_write(CTRL_REG, CTRL_GO);
+	axi_poll(STAT_REG, STAT_DONE, STAT_DONE, &value, POLL_TIMEOUT_NS + expected_ns);
+	if (cmd == READBIT || cmd == READBYTE)
+		value = axi_read(RXDATA_REG);
+	axi_write(CTRL_REG, 0);
+	return value;
+}
+
+/*
+ * Block instruction of len bytes over the streams, DONE raised once after
+ * the last byte. The time of a block depends on the streams, it is not
+ * checked.
+ */
+static void w1_block(uint32_t instr, uint32_t len)
+{
+	uint32_t n;
+
+	axi_poll(STAT_REG, STAT_READY, STAT_READY, NULL, POLL_TIMEOUT_NS);
+	axi_write(BLEN_REG, len);
+	axi_write(INSTR_REG, instr);
+	axi_write(CTRL_REG, CTRL_GO);
+	axi_poll(STAT_REG, STAT_DONE, STAT_DONE, NULL, POLL_TIMEOUT_NS + len * byte_ns());
+	axi_write(CTRL_REG, 0);
+	n = axi_read(BCNT_REG) & 0xFFFF;
+	if (n != len)
+		fail("block of %u bytes, %u transferred", len, n);
+}
+
+static void w1_write_block(const uint8_t *buf, uint32_t len)
+{
+	tx_stream.insert(tx_stream.end(), buf, buf + len);
+	w1_block(WRITEBLOCK, len);
+	if (!tx_stream.empty())
+		fail("%zu bytes of the block not written", tx_stream.size());
+	tx_stream.clear();
+}
+
+static void w1_read_block(uint8_t *buf, uint32_t len)
+{
+	uint32_t i;
+
+	rx_stream.clear();
+	rx_last.clear();
+	w1_block(READBLOCK, len);
+	if (rx_stream.size() != len) {
+		fail("block of %u bytes, %zu streamed", len, rx_stream.size());
+		return;
+	}
+	for (i = 0; i < len; i++) {
+		buf[i] = rx_stream[i];
+		if (rx_last[i] != (i == len - 1))
+			fail("tlast on byte %u of %u", i, len);
+	}
+}
+
+/*
+ * ROM table instruction, DONE raised once at the end. Its time depends on
+ * the devices, it is not checked. Returns STAT.
+ */
+static uint32_t w1_rom_instr(uint32_t instr, uint64_t max_ns)
+{
+	uint32_t value = 0;
+
+	axi_poll(STAT_REG, STAT_READY, STAT_READY, NULL, POLL_TIMEOUT_NS);
+	axi_write(INSTR_REG, instr);
+	axi_write(CTRL_REG, CTRL_GO);
+	axi_poll(STAT_REG, STAT_DONE, STAT_DONE, &value, POLL_TIMEOUT_NS + max_ns);
+	axi_write(CTRL_REG, 0);
+	return value;
+}
+
+/* Entries 0 to ndevs - 1 hold the devices, the others a ROM ID on no device */
+static void w1_rom_load(void)
+{
+	static const uint8_t unknown[8] = { 0x28, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00 };
+	const uint8_t *rom;
+	int e, i;
+	uint32_t lo, hi;
+
+	for (e = 0; e < W1_TB_ROM_TABLE; e++) {
+		rom = e < ndevs ? devs[e].rom : unknown;
+		for (i = 3, lo = hi = 0; i >= 0; i--) {
+			lo = lo << 8 | rom[i];
+			hi = hi << 8 | rom[i + 4];
+		}
+		axi_write(ROMIDX_REG, e);
+		axi_write(ROMLO_REG, lo);
+		axi_write(ROMHI_REG, hi);
+	}
+}
+
+/* Reset, Match ROM and the ROM ID of the entry, returns 1 on presence */
+static int w1_select_rom(uint32_t entry)
+{
+	return !(w1_rom_instr(SELECTROM | (entry & 0x3F), init_ns() + 9 * byte_ns()) &
+		 STAT_NOPRESENCE);
+}
+
+/* Ping the entries 0 to n - 1, returns the bitmap of those found */
+static uint64_t w1_ping_all(uint32_t n)
+{
+	w1_rom_instr(PINGALL | (n & 0x7F), n * (init_ns() + byte_ns() + 192 * bit_ns()));
+	return (uint64_t)axi_read(PING1_REG) << 32 | axi_read(PING0_REG);
+}
+
+/*
+ * Read slots every interval_us until a 1, at most slots of them, with a
+ * single POLL_BIT instruction. Returns 1 on the 1, 0 on timeout, and the
+ * slots issued, from POLLCNT, in *count if not NULL.
+ */
+static int w1_poll_bit(uint32_t interval_us, uint32_t slots, uint32_t *count)
+{
+	uint32_t stat, n, max = slots ? slots : 1;
+
+	axi_write(POLL_REG, interval_us << 16 | slots);
+	stat = w1_rom_instr(POLLBIT, max * (interval_us * US + bit_ns()));
+	n = axi_read(POLLCNT_REG) & 0xFFFF;
+	if (n == 0 || n > max)
+		fail("POLL_BIT of %u slots issued %u", slots, n);
+	if (count)
+		*count = n;
+	return !(stat & STAT_NOPRESENCE);
+}
+
+static int w1_reset(void)
+{
+	return !(w1_instr(INITPRES, init_ns()) & STAT_NOPRESENCE);
+}
+
+static void w1_write_byte(uint8_t byte)
+{
+	w1_instr(WRITEBYTE | byte, byte_ns());
+}
+
+static void w1_write_byte_spu(uint8_t byte, uint32_t spu_us)
+{
+	axi_write(SPU_REG, spu_us);
+	w1_instr(WRITEBYTE | SPU | byte, byte_ns() + spu_us * US);
+}
+
+static uint8_t w1_read_byte(void)
+{
+	return (uint8_t)w1_instr(READBYTE, byte_ns());
+}
+
+static void w1_write_bit(int bit)
+{
+	w1_instr(WRITEBIT | (bit & 1), bit_ns());
+}
+
+static int w1_read_bit(void)
+{
+	return w1_instr(READBIT, bit_ns()) & 1;
+}
+
+/* Search ROM, returns the number of ROM IDs found that belong to a device */
+static int w1_search(void)
+{
+	uint8_t rom[8] = { 0 };
+	int last_discrepancy = -1, discrepancy, found = 0, known;
+	int i, b, bit, cmp, dir;
+
+	do {
+		if (!w1_reset())
+			return found;
+		w1_write_byte(0xF0);
+		discrepancy = -1;
+		for (i = 0; i < 64; i++) {
+			bit = w1_read_bit();
+			cmp = w1_read_bit();
+			if (bit && cmp)
+				return found;
+			if (bit != cmp) {
+				dir = bit;
+			} else {
+				if (i < last_discrepancy)
+					dir = (rom[i / 8] >> (i % 8)) & 1;
+				else
+					dir = i == last_discrepancy;
+				if (!dir)
+					discrepancy = i;
+			}
+			if (dir)
+				rom[i / 8] |= (uint8_t)(1 << (i % 8));
+			else
+				rom[i / 8] &= (uint8_t)~(1 << (i % 8));
+			w1_write_bit(dir);
+		}
+		known = 0;
+		for (b = 0; b < ndevs; b++)
+			known |= !memcmp(rom, devs[b].rom, 8);
+		if (!known)
+			fail("search found an unknown ROM ID");
+		found += known;
+		last_discrepancy = discrepancy;
+	} while (last_discrepancy >= 0);
+	return found;
+}
+
+/********************************* Scripts *********************************/
+/*
+ * One command per line, # starts a comment, numbers in C notation:
+ *   w <offset> <value>           AXI write, slot timing registers followed
+ *   r <offset> [<value> [<mask>]] AXI read, checked if a value is given
+ *   poll <offset> <mask> <value> AXI read until (read & mask) == value
+ *   delay <us>                   Bus idle
+ *   reset [absent]               Reset/presence, checked
+ *   wbit <bit>, rbit [<bit>]     Write/read a bit
+ *   wbyte <byte> [<spu_us>]      Write a byte, with a strong pull-up
+ *   rbyte [<byte>]               Read a byte
+ *   skip, match <dev>            Reset, then Skip/Match ROM
+ *   readrom                      Reset, Read ROM, checked against device 0
+ *   search                       Search ROM, all devices must be found
+ *   convert [<spu_us>]           Convert T, polled or with a strong pull-up
+ *   pollbit <us> <slots> [<bit> [<count>]]
+ *                                POLL_BIT, bit read and POLLCNT checked
+ *   wsp <th> <tl> <config>       Write Scratchpad
+ *   readsp [<dev>]               Read Scratchpad, checked against the device
+ *   wblock <byte>...             Write bytes with a block instruction
+ *   rblock <n> [<byte>...]       Read n bytes with a block instruction
+ *   readspb [<dev>]              readsp with the block instructions
+ *   romload                      Load the ROM ID table, see w1_rom_load()
+ *   select <entry> [absent]      SELECT_ROM, presence checked
+ *   ping <n>                     PING_ALL of n entries, the devices must be found
+ *   repeat <n> ... end           Repeat a block
+ */
+static unsigned long arg(const std::vector<std::string> &t, size_t i, unsigned long def)
+{
+	return i < t.size() ? strtoul(t[i].c_str(), NULL, 0) : def;
+}
+
+static void check_byte(const char *what, uint8_t got, uint8_t expected)
+{
+	if (got != expected)
+		fail("%s read 0x%02x, expected 0x%02x", what, got, expected);
+}
+
+static void run_command(const std::vector<std::string> &t)
+{
+	const std::string &c = t[0];
+	unsigned long dev, v;
+	uint64_t deadline;
+	uint8_t buf[256];
+	int i, n;
+
+	if (c == "w") {
+		axi_write(arg(t, 1, 0), arg(t, 2, 0));
+		if (arg(t, 1, 0) >= TRSTL_REG && arg(t, 1, 0) <= TSLOT_REG)
+			timing[(arg(t, 1, 0) - TRSTL_REG) / 4] = arg(t, 2, 0) & 0xFFFFF;
+	} else if (c == "r") {
+		v = axi_read(arg(t, 1, 0));
+		if (t.size() > 2 && (v & arg(t, 3, 0xFFFFFFFF)) != arg(t, 2, 0))
+			fail("register 0x%lx read 0x%lx", arg(t, 1, 0), v);
+	} else if (c == "poll") {
+		axi_poll(arg(t, 1, 0), arg(t, 2, 0), arg(t, 3, 0), NULL, POLL_TIMEOUT_NS);
+	} else if (c == "delay") {
+		idle(arg(t, 1, 0) * US);
+		done_rise_ns = 0;
+	} else if (c == "reset") {
+		if (w1_reset() != (t.size() < 2 || t[1] != "absent"))
+			fail("unexpected presence pulse state");
+	} else if (c == "wbit") {
+		w1_write_bit(arg(t, 1, 1));
+	} else if (c == "rbit") {
+		v = w1_read_bit();
+		if (t.size() > 1 && v != arg(t, 1, 0))
+			fail("bit read %lu", v);
+	} else if (c == "wbyte") {
+		if (t.size() > 2)
+			w1_write_byte_spu(arg(t, 1, 0), arg(t, 2, 0));
+		else
+			w1_write_byte(arg(t, 1, 0));
+	} else if (c == "rbyte") {
+		v = w1_read_byte();
+		if (t.size() > 1)
+			check_byte("byte", v, arg(t, 1, 0));
+	} else if (c == "skip" || c == "match") {
+		if (!w1_reset())
+			fail("no presence pulse");
+		if (c == "skip") {
+			w1_write_byte(0xCC);
+		} else {
+			dev = arg(t, 1, 0) % ndevs;
+			w1_write_byte(0x55);
+			for (i = 0; i < 8; i++)
+				w1_write_byte(devs[dev].rom[i]);
+		}
+	} else if (c == "readrom") {
+		if (!w1_reset())
+			fail("no presence pulse");
+		w1_write_byte(0x33);
+		for (i = 0; i < 8; i++)
+			check_byte("ROM ID", w1_read_byte(), devs[0].rom[i]);
+	} else if (c == "search") {
+		n = w1_search();
+		if (n != ndevs)
+			fail("search found %d of %d devices", n, ndevs);
+	} else if (c == "convert") {
+		if (t.size() > 1) {
+			w1_write_byte_spu(0x44, arg(t, 1, 0));
+		} else {
+			w1_write_byte(0x44);
+			deadline = now_ns + CONV_TIMEOUT_NS;
+			while (!w1_read_bit() && now_ns < deadline)
+				;
+			if (now_ns >= deadline)
+				fail("conversion timed out");
+		}
+	} else if (c == "convertp") {
+		w1_write_byte(0x44);
+		if (!w1_poll_bit(1000, CONV_TIMEOUT_NS / MS, NULL))
+			fail("conversion timed out");
+	} else if (c == "pollbit") {
+		uint32_t count;
+
+		v = w1_poll_bit(arg(t, 1, 0), arg(t, 2, 0), &count);
+		if (t.size() > 3 && v != arg(t, 3, 0))
+			fail("POLL_BIT read %lu", v);
+		if (t.size() > 4 && count != arg(t, 4, 0))
+			fail("POLL_BIT issued %u slots, expected %lu", count, arg(t, 4, 0));
+	} else if (c == "wsp") {
+		w1_write_byte(0x4E);
+		for (i = 1; i <= 3; i++)
+			w1_write_byte(arg(t, i, 0));
+	} else if (c == "wblock") {
+		n = (int)t.size() - 1;
+		for (i = 0; i < n && i < (int)sizeof(buf); i++)
+			buf[i] = (uint8_t)arg(t, i + 1, 0);
+		w1_write_block(buf, i);
+	} else if (c == "rblock") {
+		n = (int)arg(t, 1, 0);
+		if (n > (int)sizeof(buf))
+			n = sizeof(buf);
+		w1_read_block(buf, n);
+		for (i = 0; i < n && i + 2 < (int)t.size(); i++)
+			check_byte("block", buf[i], arg(t, i + 2, 0));
+	} else if (c == "readsp" || c == "readspb") {
+		dev = arg(t, 1, 0) % ndevs;
+		if (c == "readsp") {
+			w1_write_byte(0xBE);
+			for (i = 0; i < 9; i++)
+				buf[i] = w1_read_byte();
+		} else {
+			buf[0] = 0xBE;
+			w1_write_block(buf, 1);
+			w1_read_block(buf, 9);
+		}
+		if (crc8(buf, 9))
+			fail("scratchpad CRC of device %lu", dev);
+		for (i = 0; i < 9; i++)
+			check_byte("scratchpad", buf[i], devs[dev].scratchpad[i]);
+	} else if (c == "romload") {
+		w1_rom_load();
+	} else if (c == "select") {
+		if (w1_select_rom(arg(t, 1, 0)) != (t.size() < 3 || t[2] != "absent"))
+			fail("unexpected presence pulse state");
+	} else if (c == "ping") {
+		n = (int)arg(t, 1, 0);
+		v = w1_ping_all(n);
+		if (v != ((1UL << (n < ndevs ? n : ndevs)) - 1))
+			fail("ping of %d entries found 0x%lx", n, v);
+	} else {
+		fail("unknown command %s", c.c_str());
+	}
+}
+
+static void run_block(const std::vector<std::vector<std::string> > &lines, size_t begin,
+		      size_t end)
+{
+	size_t i, j;
+	unsigned long n, k;
+	int depth;
+
+	for (i = begin; i < end; i++) {
+		if (lines[i][0] != "repeat") {
+			run_command(lines[i]);
+			continue;
+		}
+		for (j = i + 1, depth = 1; j < end; j++) {
+			if (lines[j][0] == "repeat")
+				depth++;
+			else if (lines[j][0] == "end" && !--depth)
+				break;
+		}
+		n = arg(lines[i], 1, 1);
+		for (k = 0; k < n; k++)
+			run_block(lines, i + 1, j);
+		i = j;
+	}
+}
+
+static int load_script(const char *path, std::vector<std::vector<std::string> > &lines)
+{
+	char line[256], *tok, *hash;
+	FILE *f = fopen(path, "r");
+
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), f)) {
+		std::vector<std::string> t;
+
+		hash = strchr(line, '#');
+		if (hash)
+			*hash = '\0';
+		for (tok = strtok(line, " \t\r\n"); tok; tok = strtok(NULL, " \t\r\n"))
+			t.push_back(tok);
+		if (!t.empty())
+			lines.push_back(t);
+	}
+	fclose(f);
+	return 0;
+}
+
+static void report(const char *name)
+{
+	uint64_t elapsed = now_ns - st.start_ns;
+
+	printf("%-24s %9llu us, busy %9llu us (%3llu%%), %6llu instr, %7.0f instr/s, "
+	       "gap %6.2f us (min %6.2f, max %7.2f), %6llu AXI rd, %5llu AXI wr\n",
+	       name, (unsigned long long)(elapsed / US), (unsigned long long)(st.busy_ns / US),
+	       (unsigned long long)(elapsed ? st.busy_ns * 100 / elapsed : 0),
+	       (unsigned long long)st.instructions,
+	       elapsed ? st.instructions * 1e9 / elapsed : 0.0,
+	       st.gaps ? (double)st.gap_ns / st.gaps / US : 0.0,
+	       (double)st.gap_min_ns / US, (double)st.gap_max_ns / US,
+	       (unsigned long long)st.axi_reads, (unsigned long long)st.axi_writes);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *trace = NULL;
+	int i, d;
+
+	ctx = new VerilatedContext;
+	ctx->commandArgs(argc, argv);
+
+	for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+		if (i + 1 >= argc)
+			break;
+		if (!strcmp(argv[i], "-n"))
+			ndevs = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-g"))
+			gap_cycles = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-t"))
+			trace = argv[++i];
+		else
+			break;
+	}
+	if (i >= argc || ndevs < 1 || ndevs > W1_TB_MAX_DEVICES || gap_cycles < 0) {
+		fprintf(stderr, "Usage: %s [-n devices] [-g gap_cycles] [-t trace.vcd] script...\n",
+			argv[0]);
+		return 1;
+	}
+
+	top = new Vw1_tb_top(ctx);
+#if VM_TRACE
+	if (trace) {
+		ctx->traceEverOn(true);
+		tfp = new VerilatedVcdC;
+		top->trace(tfp, 99);
+		tfp->open(trace);
+	}
+#else
+	if (trace)
+		fprintf(stderr, "%s: built without --trace, -t ignored\n", argv[0]);
+#endif
+	for (; i < argc; i++) {
+		std::vector<std::vector<std::string> > lines;
+		const char *name = strrchr(argv[i], '/');
+
+		if (load_script(argv[i], lines)) {
+			failures++;
+			continue;
+		}
+		/* Each script starts from the reset of the IP and of the devices */
+		for (d = 0; d < ndevs; d++)
+			dev_init(&devs[d], d);
+		timing_init();
+		top->aresetn = 0;
+		idle(20 * CLK_NS);
+		top->aresetn = 1;
+		idle(2 * US);
+		memset(&st, 0, sizeof(st));
+		st.start_ns = now_ns;
+		done_rise_ns = 0;
+		run_block(lines, 0, lines.size());
+		report(name ? name + 1 : argv[i]);
+	}
+
+#if VM_TRACE
+	if (tfp)
+		tfp->close();
+#endif
+	top->final();
+	delete top;
+	delete ctx;
+	printf("%d failure(s)\n", failures);
+	return failures;
+}
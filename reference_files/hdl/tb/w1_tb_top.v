@@ -0,0 +1,121 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+/*
+-------------------------------------------------------------------------------
+-- Title      : Testbench top level
+-- Project    : 1-wire
+-------------------------------------------------------------------------------
+-- File       : w1_tb_top.v
+-------------------------------------------------------------------------------
+-- Uses       : axi_1wire_host.v, axi_1wire_host_slave_lite_v1_2_S00_AXI.v,
+--              w1_master.v, w1_bulk.v, w1_romsel.v, iobuf_model.v
+-------------------------------------------------------------------------------
+-- Description: Top level of the Verilator testbench (w1_tb.cpp). The AXI4-Lite
+--              interface of the IP is driven by the C++ harness, which also
+--              runs the behavioural 1-Wire device:
+--                dev_pull_low : 1 while the device pulls the bus low;
+--                w1_level     : resolved level of the bus, the pull-up
+--                               resistor giving 1 while nobody drives it.
+--              done and ready are the handshake signals of W1_MASTER, busy
+--              its state outside of IDLE_M and DONE_M, brought out for the
+--              throughput measurements. The IP is built with BULK_STREAM,
+--              its AXI4-Stream ports are driven by the harness as well, and
+--              with a ROM ID table of 8 entries.
+-------------------------------------------------------------------------------
+*/
+`timescale 1 ns / 1 ps
+
+module w1_tb_top #(
+    parameter integer CLK_DIV_VAL_TO_1MHz = 100
+)(
+    input   wire        clk,
+    input   wire        aresetn,
+
+    input   wire [6:0]  awaddr,
+    input   wire        awvalid,
+    output  wire        awready,
+    input   wire [31:0] wdata,
+    input   wire [3:0]  wstrb,
+    input   wire        wvalid,
+    output  wire        wready,
+    output  wire [1:0]  bresp,
+    output  wire        bvalid,
+    input   wire        bready,
+    input   wire [6:0]  araddr,
+    input   wire        arvalid,
+    output  wire        arready,
+    output  wire [31:0] rdata,
+    output  wire [1:0]  rresp,
+    output  wire        rvalid,
+    input   wire        rready,
+    output  wire        irq,
+
+    output  wire [7:0]  rx_tdata,
+    output  wire        rx_tvalid,
+    input   wire        rx_tready,
+    output  wire        rx_tlast,
+    input   wire [7:0]  tx_tdata,
+    input   wire        tx_tvalid,
+    output  wire        tx_tready,
+
+    input   wire        dev_pull_low,
+    output  wire        w1_level,
+    output  wire        done,
+    output  wire        ready,
+    output  wire        busy
+);
+
+wire w1_bus;
+
+pullup (w1_bus);
+assign w1_bus   = dev_pull_low ? 1'b0 : 1'bz;
+assign w1_level = w1_bus;
+
+axi_1wire_host #(
+    .CLK_DIV_VAL_TO_1MHz(CLK_DIV_VAL_TO_1MHz),
+    .BULK_STREAM(1),
+    .ROM_TABLE(8)
+) dut (
+    .w1_bus(w1_bus),
+    .w1_irq(irq),
+    .m_axis_rx_tdata(rx_tdata),
+    .m_axis_rx_tvalid(rx_tvalid),
+    .m_axis_rx_tready(rx_tready),
+    .m_axis_rx_tlast(rx_tlast),
+    .s_axis_tx_tdata(tx_tdata),
+    .s_axis_tx_tvalid(tx_tvalid),
+    .s_axis_tx_tready(tx_tready),
+    .s00_axi_aclk(clk),
+    .s00_axi_aresetn(aresetn),
+    .s00_axi_awaddr(awaddr),
+    .s00_axi_awprot(3'b000),
+    .s00_axi_awvalid(awvalid),
+    .s00_axi_awready(awready),
+    .s00_axi_wdata(wdata),
+    .s00_axi_wstrb(wstrb),
+    .s00_axi_wvalid(wvalid),
+    .s00_axi_wready(wready),
+    .s00_axi_bresp(bresp),
+    .s00_axi_bvalid(bvalid),
+    .s00_axi_bready(bready),
+    .s00_axi_araddr(araddr),
+    .s00_axi_arprot(3'b000),
+    .s00_axi_arvalid(arvalid),
+    .s00_axi_arready(arready),
+    .s00_axi_rdata(rdata),
+    .s00_axi_rresp(rresp),
+    .s00_axi_rvalid(rvalid),
+    .s00_axi_rready(rready)
+);
+
+// W1_MASTER is between two instructions in IDLE_M and DONE_M, ready being
+// held low in IDLE_M until the recovery of the last slot is over
+wire [3:0] state = dut.axi_1wire_host_slave_lite_v1_2_S00_AXI_inst.W1_MASTER.PRESENT_STATE;
+
+assign done  = dut.axi_1wire_host_slave_lite_v1_2_S00_AXI_inst.done;
+assign ready = dut.axi_1wire_host_slave_lite_v1_2_S00_AXI_inst.ready;
+assign busy  = state != 4'b0001 && state != 4'b0100;
+
+endmodule
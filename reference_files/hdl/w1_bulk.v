@@ -0,0 +1,190 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+/*
+-------------------------------------------------------------------------------
+-- Title      : 1-Wire block transfer sequencer
+-- Project    : 1-wire
+-------------------------------------------------------------------------------
+-- File       : w1_bulk.v
+-- Author     : agent
+-- Company    : Advanced Micro Devices, Inc.
+-------------------------------------------------------------------------------
+-- Uses       : none
+-------------------------------------------------------------------------------
+-- Description: Sits between the AXI registers and W1_MASTER to run the
+--              block instructions, moving blen bytes between the 1-Wire bus
+--              and two AXI4-Stream ports, for an AXI DMA:
+--                RX_BLOCK (1001): reads blen bytes from the bus, each one is
+--                                 sent on m_axis, the last one with tlast.
+--                TX_BLOCK (1011): writes blen bytes received on s_axis to
+--                                 the bus, the strong pull-up bit applies
+--                                 to the last one.
+--
+--              A block instruction uses the GO/DONE/READY handshake of the
+--              other instructions, DONE is raised once after the last byte.
+--              The sequencer issues one RX_BYTE/TX_BYTE to W1_MASTER per
+--              byte, waiting for the stream when the DMA is late: the bus
+--              stays idle between two slots. The other instructions go
+--              through unchanged.
+--
+-- Inputs/Outpus
+--              clk         : AXI clock;
+--              areset      : asynchronous reset from AXI register;
+--              ctrl_reset  : reset control, aborts a block instruction;
+--              go, command, tx_data, spu : from the AXI registers;
+--              blen        : 16 LSB in register 17, bytes of the block;
+--
+--              done, ready, reg_wr, failure, data_out : to the AXI
+--                            registers, from W1_MASTER or the sequencer;
+--              bcnt        : 16 LSB in register 18, bytes transferred by
+--                            the last block instruction;
+--
+--              m_*         : instruction and handshake of W1_MASTER;
+--              m_axis_*    : AXI4-Stream of the bytes read;
+--              s_axis_*    : AXI4-Stream of the bytes to write;
+-------------------------------------------------------------------------------
+-- Revisions  :
+-- Date        Version  Author  	Description
+-- 2026/10/19  0.1      agent       Initial Version
+-------------------------------------------------------------------------------
+*/
+
+module W1_BULK (
+    input   wire        clk,        // AXI clock
+    input   wire        areset,
+    input   wire        ctrl_reset,
+    // From the AXI registers
+    input   wire        go,
+    input   wire [3:0]  command,
+    input   wire [7:0]  tx_data,
+    input   wire        spu,
+    input   wire [15:0] blen,       // Bytes of the block
+    // To the AXI registers
+    output  wire        done,
+    output  wire        ready,
+    output  wire        reg_wr,
+    output  wire        failure,
+    output  wire [7:0]  data_out,
+    output  reg  [15:0] bcnt,       // Bytes transferred
+    // W1_MASTER
+    output  wire        m_go,
+    output  wire [3:0]  m_command,
+    output  wire [7:0]  m_tx_data,
+    output  wire        m_spu,
+    input   wire        m_done,
+    input   wire        m_ready,
+    input   wire        m_reg_wr,
+    input   wire        m_failure,
+    input   wire [7:0]  m_data_out,
+    // Bytes read
+    output  wire [7:0]  m_axis_tdata,
+    output  wire        m_axis_tvalid,
+    input   wire        m_axis_tready,
+    output  wire        m_axis_tlast,
+    // Bytes to write
+    input   wire [7:0]  s_axis_tdata,
+    input   wire        s_axis_tvalid,
+    output  wire        s_axis_tready
+);
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Invert reset signal
+wire reset = !areset | ctrl_reset;          // active high reset signal
+
+parameter [3:0]
+RX_BLOCK    = 4'b1001,   // Receive blen bytes to m_axis
+TX_BLOCK    = 4'b1011,   // Transmit blen bytes from s_axis
+RX_BYTE     = 4'b1101,   // W1_MASTER commands issued for each byte
+TX_BYTE     = 4'b1111;
+
+parameter [2:0]
+B_IDLE      = 3'd0,      // Instructions go through to W1_MASTER
+B_FETCH     = 3'd1,      // Wait for W1_MASTER ready, and the byte to write
+B_GO        = 3'd2,      // Byte on the bus, wait for W1_MASTER done
+B_PUSH      = 3'd3,      // Byte read sent on m_axis
+B_DONE      = 3'd4;      // Block done, wait for PS to clear go
+
+reg [2:0]   state;
+reg         dir_tx;         // TX_BLOCK in progress
+reg [15:0]  left;           // Bytes not transferred yet
+reg [7:0]   byte_q;         // Byte to write, or byte read
+
+wire        block  = (command == RX_BLOCK) | (command == TX_BLOCK);
+wire        active = state != B_IDLE;
+wire        m_end  = m_done & m_reg_wr;     // Byte done, m_data_out valid
+
+always @ (posedge clk or posedge reset) begin
+    if (reset) begin
+        state   <= B_IDLE;
+        dir_tx  <= 1'b0;
+        left    <= 0;
+        bcnt    <= 0;
+        byte_q  <= 8'hFF;
+    end
+    else begin
+        case (state)
+            B_IDLE: begin
+                if (go & block & m_ready) begin
+                    dir_tx  <= command == TX_BLOCK;
+                    left    <= blen;
+                    bcnt    <= 0;
+                    state   <= (blen == 0) ? B_DONE : B_FETCH;
+                end
+            end
+            B_FETCH: begin
+                if (m_ready & (!dir_tx | s_axis_tvalid)) begin
+                    if (dir_tx)
+                        byte_q <= s_axis_tdata;
+                    state <= B_GO;
+                end
+            end
+            B_GO: begin
+                if (m_end) begin
+                    if (!dir_tx)
+                        byte_q <= m_data_out;
+                    left    <= left - 1;
+                    bcnt    <= bcnt + 1;
+                    if (!dir_tx)
+                        state <= B_PUSH;
+                    else if (left == 1)
+                        state <= B_DONE;
+                    else
+                        state <= B_FETCH;
+                end
+            end
+            B_PUSH: begin
+                if (m_axis_tready)
+                    state <= (left == 0) ? B_DONE : B_FETCH;
+            end
+            B_DONE: begin
+                // If PS has not cleared go, stay here to let PS fetch data
+                if (!go)
+                    state <= B_IDLE;
+            end
+            default: begin
+                state <= B_IDLE;
+            end
+        endcase
+    end
+end
+
+// W1_MASTER runs the byte of the sequencer, or the instruction of the PS
+assign m_go          = active ? (state == B_GO) : (go & !block);
+assign m_command     = active ? (dir_tx ? TX_BYTE : RX_BYTE) : command;
+assign m_tx_data     = active ? byte_q : tx_data;
+assign m_spu         = active ? (spu & dir_tx & (left == 1)) : spu;
+
+// The AXI registers see a single instruction
+assign done          = active ? (state == B_DONE) : m_done;
+assign ready         = active ? 1'b0 : m_ready;
+assign reg_wr        = active ? 1'b1 : m_reg_wr;
+assign failure       = active ? 1'b0 : m_failure;
+assign data_out      = active ? byte_q : m_data_out;
+
+assign m_axis_tdata  = byte_q;
+assign m_axis_tvalid = state == B_PUSH;
+assign m_axis_tlast  = left == 0;
+assign s_axis_tready = (state == B_FETCH) & dir_tx & m_ready;
+
+endmodule
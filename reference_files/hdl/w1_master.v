@@ -11,10 +11,10 @@ SPDX-License-Identifier: MIT
 -- Author     : Thomas Delev
 -- Company    : Advanced Micro Devices, Inc.
 -- Created    : 2023/06/05
--- Last update: 2023/06/05
+-- Last update: 2026/10/19
 -- Copyright  : (c) Advanced Micro Devices, Inc. 2023
 -------------------------------------------------------------------------------
--- Uses       : jcnt.v, sr.v
+-- Uses       : none
 -------------------------------------------------------------------------------
 -- Description: The master sub-module to drive initialization, bit and byte
 --              transmission and receiving with one or more 1-wire devices.
@@ -38,13 +38,37 @@ SPDX-License-Identifier: MIT
 --              at: 
 --          analog.com/media/en/technical-documentation/data-sheets/ds18b20.pdf
 --
+--              The slots are timed in cycles of the AXI clock by a counter
+--              compared against the timing inputs, programmed from the AXI
+--              registers 9 to 15 (reset values for standard speed, see
+--              axi_1wire_host_slave_lite_v1_2_S00_AXI.v):
+--                t_rstl : reset pulse low, and presence window after it
+--                t_msp  : presence sampled, from the release of the reset
+--                t_w0l  : write-0 low, end of the data phase of a slot
+--                t_rec  : recovery, bus released between two slots
+--                t_rdv  : read sampled, from the start of the slot
+--                t_w1l  : write-1 and read low
+--                t_slot : slot length, at least t_w0l + t_rec
+--              The recovery of the last slot of an instruction is enforced
+--              before ready is raised again.
+--
+--              POLL_BIT repeats read slots, poll_interval us apart, until one
+--              reads 1 or poll_slots slots have been issued, so that a
+--              conversion or an EEPROM copy is waited for in hardware, with a
+--              single DONE (and interrupt) at the end.
+--
 -- Inputs/Outpus
---              clk_1MHz    : 1 MHz (1us period) input clock;
+--              clk         : AXI clock, time base of the slots;
 --              areset      : asynchronous reset from AXI register;
 --              ctrl_reset  : reset control issue by PS in one of the AXI register, MSB in register 1
 --              go          : PS signal to initiate the command execution, LSB in register 1;
 --              command     : 4 MSB in register 0 issued by PS;
 --              tx_data     : 8 LSB in register 0 to be send to device (tx_bit is LSB);
+--              spu         : bit 12 in register 0, strong pull-up after TX_BIT/TX_BYTE;
+--              spu_duration: 24 LSB in register 8, strong pull-up duration in us;
+--              t_*         : 20 LSB in registers 9 to 15, slot timing in clk cycles;
+--              poll_slots  : 16 LSB in register 24, read slots of POLL_BIT at most;
+--              poll_interval: 16 MSB in register 24, us between two slots of POLL_BIT;
 --              
 --              dq          : 1-Wire Bus;
 --              
@@ -52,6 +76,7 @@ SPDX-License-Identifier: MIT
 --              reg_wr      : Master signal to control write in AXI registers;
 --              failure     : MSB Bit in register 2, set to 1 if no device detected;
 --              data_out    : 8 LSB in register 3 received from device (rx_bit is LSB);
+--              poll_cnt    : 16 LSB in register 25, read slots issued by the last POLL_BIT;
 -------------------------------------------------------------------------------
 -- Revisions  :
 -- Date        Version  Author  	Description
@@ -60,6 +85,11 @@ SPDX-License-Identifier: MIT
 -- 2023/08/14  0.3      thomasd     Removal of unused functions
 -- 2023/08/23  0.4      thomasd     Fix bug releated to DONE
 -- 2024/02/07  0.5      thomasd     Fix 50KHz clock
+-- 2026/10/19  0.6      agent       Strong pull-up after TX_BIT/TX_BYTE
+-- 2026/10/19  0.7      agent       Slot timing programmed from the AXI
+--                                  registers, one slot counter instead of
+--                                  the 1 us tick (jcnt/sr)
+-- 2026/10/19  0.8      agent       POLL_BIT instruction
 -------------------------------------------------------------------------------
 */
 /*
@@ -83,6 +113,16 @@ TX_BIT_M    1110            Transmit bit state: master send 1 bit to 1-wire. Onc
 TX_BYTE_M   1111            Transmit byte state: master send 8 bits to 1-wire. Once
                                 done, set done to 1 and move to DONE_M state.
                                 tx_data are transmitted.
+SPU_M       0101            Strong pull-up state: master drives the 1-wire bus high
+                                for spu_duration us to power parasite powered devices,
+                                then set done to 1 and move to DONE_M state. Entered
+                                at the end of the last bit slot of TX_BIT_M/TX_BYTE_M
+                                when spu is set, or issued as a command on its own.
+POLL_BIT_M  0111            Poll bit state: master repeats read slots, poll_interval us
+                                apart, until one reads 1 or poll_slots slots are issued
+                                (0 or 1 for a single slot). Then the last bit read is
+                                in the lsb of data_out, failure is set to 1 if it is 0
+                                (timeout), done is set to 1 and move to DONE_M state.
 */
 /*
     HANDSHAKE SEQUENCE
@@ -93,13 +133,26 @@ TX_BYTE_M   1111            Transmit byte state: master send 8 bits to 1-wire. O
     1. PS signal go (1) to initiate next command execution
 */
 
-module W1_MASTER (
-    input   wire        clk_1MHz,
+module W1_MASTER #(
+    parameter integer CLK_DIV_VAL_TO_1MHz = 100   // clk cycles per us, for spu_duration
+)(
+    input   wire        clk,        // AXI clock
     input   wire        areset,
     input   wire        ctrl_reset,
     input   wire        go,
     input   wire [3:0]  command,    // 4 MSB in register 0 issued by PS
     input   wire [7:0]  tx_data,    // 8 LSB in register 0 to be send to device (tx_bit is LSB)
+    input   wire        spu,        // Strong pull-up after TX_BIT/TX_BYTE
+    input   wire [23:0] spu_duration, // Strong pull-up duration in us
+    input   wire [19:0] t_rstl,     // Reset low, and presence window, in clk cycles
+    input   wire [19:0] t_msp,      // Presence sample, from the reset release
+    input   wire [19:0] t_w0l,      // Write-0 low
+    input   wire [19:0] t_rec,      // Recovery between slots
+    input   wire [19:0] t_rdv,      // Read sample, from the slot start
+    input   wire [19:0] t_w1l,      // Write-1 and read low
+    input   wire [19:0] t_slot,     // Slot length
+    input   wire [15:0] poll_slots, // POLL_BIT read slots at most
+    input   wire [15:0] poll_interval, // POLL_BIT us between two slots
     
     input   wire        from_dq,    // data from one-wire bus
     // inout               dq,         // 1-Wire Bus
@@ -111,7 +164,8 @@ module W1_MASTER (
     output  reg         ready,      // Ready for next instruction
     output  reg         reg_wr,     // Initialization failed, no devices found on 1-wire
     output  reg         failure,    // 1 bit received, can be read in data_out[0]
-    output  reg [7:0]   data_out   // data received from 1-wire
+    output  reg [7:0]   data_out,  // data received from 1-wire
+    output  reg [15:0]  poll_cnt   // read slots issued by the last POLL_BIT
 );
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Invert reset signal
@@ -120,28 +174,34 @@ wire reset = !areset | ctrl_reset;          // active high reset signal
 reg         to_dq;          // data to one-wire bus
 reg         read_write_dq;  // if 0 then dq <= to_dq (write) if 1 then from_dq <= dq (read)
 reg         from_dq_pp;     // data of presence pulse 0 if presence pulse is detected.
+reg [1:0]   from_dq_sync;   // from_dq synchronized to clk
+wire        dq_in = from_dq_sync[1];
 
+reg [19:0]  tcnt;           // clk cycles since the start of the slot or pulse
+reg         tcnt_reset;
+wire [20:0] tcnt_next = tcnt + 1;
+wire [20:0] slot_len;
 
-wire [9:0]  jc1_q;
-reg         jc1_reset;
-wire        clk_50KHz;
-
-reg         jc2_reset;
-wire [1:0]  jc2_q;
-
-wire        ts_60_to_80us;
-wire        ts_0_to_10us;
-wire        ts_0_to_1us;
-wire        ts_14_to_15us;
+wire        ts_low;
+wire        ts_sample;
+wire        ts_rec;
+wire        ts_rec_start;
+wire        ts_end;
+wire        ts_rst_end;
+wire        ts_msp;
 
 reg [7:0]   data_RX; // Store the data comming from one-wire
 
-reg         sr1_reset;
-reg         sr1_en;
-wire [7:0]  sr1_q;
-reg         sr2_reset;
-reg         sr2_en;
-wire [6:0]  sr2_q;
+reg         bit_reset;
+reg         bit_next;
+reg [7:0]   bit_sel;        // One-hot bit of the byte in the slot
+reg [19:0]  rec_cnt;        // Recovery of the last slot remaining, in clk cycles
+reg [23:0]  spu_cnt;        // Strong pull-up remaining time in us
+reg [15:0]  us_cnt;         // clk cycles of the current us of the strong pull-up
+reg         poll_wait;      // POLL_BIT_M between two slots
+reg [15:0]  poll_us;        // POLL_BIT_M interval remaining in us
+reg [15:0]  poll_clk;       // clk cycles of the current us of the interval
+wire        poll_last;      // Slot of POLL_BIT_M is the last one allowed
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // define the state machine state
@@ -155,6 +215,8 @@ TX_BIT_M    = 4'b1110,   // Transmit bit to device
 TX_BYTE_M   = 4'b1111,   // Transmit byte to device
 RX_BIT_M    = 4'b1100,   // Receive bit from device
 RX_BYTE_M   = 4'b1101,   // Receive byte from device
+SPU_M       = 4'b0101,   // Strong pull-up, after TX_BIT_M/TX_BYTE_M or on its own
+POLL_BIT_M  = 4'b0111,   // Read slots until a 1 is read
 // Should not be found it the MEM, used for the FSM
 DONE_M      = 4'b0100,   // Done state, after every state, wait for PS to clear Go.
 IDLE_M      = 4'b0001,   // Idle state, increment memory address value, reset signal, transition between every state
@@ -166,7 +228,7 @@ initial begin
     PRESENT_STATE <= IDLE_M;
 end
 
-always @ (posedge clk_1MHz or posedge reset) begin
+always @ (posedge clk or posedge reset) begin
     if (reset) begin
         PRESENT_STATE <= IDLE_M;
     end
@@ -187,99 +249,164 @@ end
 //     .I(dq_out), 
 //     .T(dq_ctrl)
 // ); 
-always @ (negedge clk_1MHz) begin
+always @ (posedge clk) begin
     dq_ctrl <= read_write_dq;
     dq_out <= to_dq;
+    from_dq_sync <= {from_dq_sync[0], from_dq};
 end
-always @ (posedge clk_50KHz or posedge reset) begin
+always @ (posedge clk or posedge reset) begin
     if (reset) begin
-        from_dq_pp = 1'b1;                                  // default to NOT present
+        from_dq_pp <= 1'b1;                                 // default to NOT present
     end
-    else if (PRESENT_STATE == RX_PRE_PLS & sr2_q[6] & ts_60_to_80us) begin  // second 60us slot in RX_PRE_PLS
-        from_dq_pp = from_dq;                               // capture the presence bit
+    else if (PRESENT_STATE == RX_PRE_PLS & ts_msp) begin    // t_msp after the reset release
+        from_dq_pp <= dq_in;                                // capture the presence bit
     end
 end
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// ------------------------ Clock generation ------------------------ //
+// --------------------------- Slot timer --------------------------- //
 /*
   -------------------------------------------------------------------
-  -- Johnson Counter 1
-  -- (1) Use this counter to generate 20 us slow clock (jc2_q[9]).
-  -- (2) It is also used to divide a period of time into time slots.
-  --     It counts for small time slot which
-  --     is 1 us wide, add up to total 20 slots. 
-  -- It should be synchronized with JCount1.
+  -- Slot timer
+  -- Counts the clk cycles since the start of the current slot, reset
+  -- pulse or presence window. The FSM resets it at the start of each
+  -- of them.
   -------------------------------------------------------------------
 */
-JCNT #(.COUNTER_WIDTH(10)) jc_1us_20us (
-    .clk(clk_1MHz),
-    .reset(reset | jc1_reset),
-    .en(1'b1),
-    .q(jc1_q)
-);
-/*
+always @ (posedge clk or posedge reset) begin
+    if (reset | tcnt_reset) begin
+        tcnt <= 0;
+    end
+    else if (tcnt != 20'hFFFFF) begin
+        tcnt <= tcnt + 1;
+    end
+end
+/*                               
   -------------------------------------------------------------------
-  -- 50 KHz slow clock based on JC1 msb
-  -- use "not" here to generate rising
-  -- edge at proper position
+  -- Several time slot identification signals
   -------------------------------------------------------------------
+  -- Suppose the beginning of each slot is time 0. A slot lasts
+  -- t_slot, or t_w0l + t_rec if longer, so that the recovery is
+  -- never shorter than t_rec.
 */
-assign  clk_50KHz = !jc1_q[9];
+assign  slot_len    = ({1'b0, t_slot} > {1'b0, t_w0l} + t_rec) ? t_slot : {1'b0, t_w0l} + t_rec;
+assign  ts_low      = tcnt < t_w1l;                 // write-1/read low
+assign  ts_sample   = tcnt == t_rdv;                // read sample
+assign  ts_rec      = tcnt >= t_w0l;                // released until the end of the slot
+assign  ts_rec_start = tcnt == t_w0l;               // first cycle of the recovery
+assign  ts_end      = tcnt_next >= slot_len;        // last cycle of the slot
+assign  ts_rst_end  = tcnt_next >= t_rstl;          // last cycle of the reset pulse or window
+assign  ts_msp      = tcnt == t_msp;                // presence sample
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /*
   -------------------------------------------------------------------
-  -- Johnson Counter 1 2
-  -- This Johnson counter is used to deal with the time slots.
-  -- It chops one state into small time slots. Each is 20 us long,
-  -- total 4 slots.
-  -- It's driven by the slow clock (20us) in this system.
-  -- Counter transitions 00 -> 01 -> 11 -> 10 -> 00
+  -- Bit select
+  -- One-hot bit of the byte in the current slot, shifted at the end
+  -- of each slot of RX_BYTE_M/TX_BYTE_M.
   -------------------------------------------------------------------
 */
-JCNT #(.COUNTER_WIDTH(2)) jc_20us_80us (
-    .clk(clk_50KHz),
-    .reset(reset | jc1_reset | jc2_reset),  // As jc2 is synchronised with jc1, a reset of jc1 should reset jc2
-    .en(1'b1),
-    .q(jc2_q)
-);
-/*                               
+always @ (posedge clk or posedge reset) begin
+    if (reset | bit_reset) begin
+        bit_sel <= 8'h01;
+    end
+    else if (bit_next) begin
+        bit_sel <= {bit_sel[6:0], bit_sel[7]};
+    end
+end
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
   -------------------------------------------------------------------
-  -- Several time slot identification signals
+  -- Recovery counter
+  -- Reloaded with t_rec while a slot is in its recovery, counts
+  -- down after the last slot so that the next instruction does not
+  -- start before the bus has recovered.
   -------------------------------------------------------------------
-  -- Suppose the beginning of each state is time 0.
-  -- Use combination of JC1 and JC2, we can id any time slot during
-  -- each state as small as 1 us.
 */
-
-assign  ts_0_to_1us    = (!jc2_q[1] & !jc2_q[0] & !jc1_q[9] & !jc1_q[0]);
-assign  ts_0_to_10us   = (!jc2_q[1] & !jc2_q[0] & !jc1_q[9]);
-assign  ts_14_to_15us  = (!jc2_q[1] & !jc2_q[0] &  jc1_q[4] & !jc1_q[3]);  
-assign  ts_60_to_80us  = ( jc2_q[1] & !jc2_q[0]);
-//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+always @ (posedge clk or posedge reset) begin
+    if (reset) begin
+        rec_cnt <= 0;
+    end
+    else if ((PRESENT_STATE == RX_BIT_M | PRESENT_STATE == RX_BYTE_M |
+              PRESENT_STATE == TX_BIT_M | PRESENT_STATE == TX_BYTE_M |
+              PRESENT_STATE == POLL_BIT_M) & ts_rec) begin
+        rec_cnt <= t_rec;
+    end
+    else if (rec_cnt != 0) begin
+        rec_cnt <= rec_cnt - 1;
+    end
+end
 /*
   -------------------------------------------------------------------
-  -- Shift Register 1 
-  -- Used to count 8 bits in a byte of data
+  -- Strong pull-up counter
+  -- Loaded with the duration outside of SPU_M, counts down the us
+  -- in SPU_M, a us being CLK_DIV_VAL_TO_1MHz clk cycles.
   -------------------------------------------------------------------
 */
-SR #(.REGISTER_WIDTH(8)) SR1 (
-    .clk(clk_50KHz),
-    .reset(sr1_reset),
-    .en(sr1_en),
-    .q(sr1_q)
-);
-/*              
+always @ (posedge clk or posedge reset) begin
+    if (reset) begin
+        spu_cnt <= 0;
+        us_cnt  <= 0;
+    end
+    else if (PRESENT_STATE != SPU_M) begin
+        spu_cnt <= spu_duration;
+        us_cnt  <= 0;
+    end
+    else if (us_cnt != CLK_DIV_VAL_TO_1MHz - 1) begin
+        us_cnt  <= us_cnt + 1;
+    end
+    else begin
+        us_cnt  <= 0;
+        if (spu_cnt != 0) begin
+            spu_cnt <= spu_cnt - 1;
+        end
+    end
+end
+/*
   -------------------------------------------------------------------
-  -- Shift Register 2  
-  -- Used to count 480 us
+  -- Poll counters
+  -- Slots issued by POLL_BIT_M, cleared when it starts, and the us
+  -- of the interval after each slot reading 0, a us being
+  -- CLK_DIV_VAL_TO_1MHz clk cycles.
   -------------------------------------------------------------------
 */
-SR #(.REGISTER_WIDTH(7)) SR2 (
-    .clk(clk_50KHz),
-    .reset(sr2_reset),
-    .en(sr2_en),
-    .q(sr2_q)
-);
-//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+assign  poll_last   = {1'b0, poll_cnt} + 1 >= poll_slots;
+
+always @ (posedge clk or posedge reset) begin
+    if (reset) begin
+        poll_cnt    <= 0;
+        poll_wait   <= 1'b0;
+        poll_us     <= 0;
+        poll_clk    <= 0;
+    end
+    else if (PRESENT_STATE != POLL_BIT_M) begin
+        poll_wait   <= 1'b0;
+        poll_us     <= poll_interval;
+        poll_clk    <= 0;
+        if (PRESENT_STATE == IDLE_M & NEXT_STATE == POLL_BIT_M) begin
+            poll_cnt <= 0;
+        end
+    end
+    else if (!poll_wait) begin
+        if (ts_rec_start) begin             // slot done, in its recovery
+            poll_cnt <= poll_cnt + 1;
+        end
+        if (ts_rec & ts_end) begin          // the FSM stays: 0 read
+            poll_wait <= 1'b1;
+            poll_us   <= poll_interval;
+            poll_clk  <= 0;
+        end
+    end
+    else if (poll_us == 0) begin
+        poll_wait <= 1'b0;                  // next slot
+    end
+    else if (poll_clk != CLK_DIV_VAL_TO_1MHz - 1) begin
+        poll_clk <= poll_clk + 1;
+    end
+    else begin
+        poll_clk <= 0;
+        poll_us  <= poll_us - 1;
+    end
+end
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /*              
   -------------------------------------------------------------------
   -- data received logic
@@ -291,14 +418,14 @@ initial begin
     data_RX <= 0;
 end
 
-always @ (posedge clk_1MHz or posedge reset) begin
+always @ (posedge clk or posedge reset) begin
     if (reset) begin
         data_RX <= 0;
     end
     else begin
-        if (PRESENT_STATE == RX_BIT_M) begin
+        if (PRESENT_STATE == RX_BIT_M | PRESENT_STATE == POLL_BIT_M) begin
             if (data_RX_wr) begin
-                data_RX[0] = from_dq;
+                data_RX[0] = dq_in;
                 data_RX[7:1] = 0;
             end
             else begin
@@ -309,8 +436,8 @@ always @ (posedge clk_1MHz or posedge reset) begin
         else if (PRESENT_STATE == RX_BYTE_M) begin
             if (data_RX_wr) begin
                 for (j = 0; j < 8; j = j+1) begin
-                    if (sr1_q[j]) begin
-                        data_RX[j] = from_dq;
+                    if (bit_sel[j]) begin
+                        data_RX[j] = dq_in;
                     end
                     else begin
                         data_RX[j] = data_RX[j];
@@ -333,8 +460,7 @@ integer i;
    -- State Mux 
    -- Combinational Logic for the state machine.
    --
-   -- Any action in this state mux is synchronized with the 20 us clock
-   -- and a few of them are synchronized with the 1us clock.
+   -- Any action in this state mux is synchronized with the slot timer.
    --
    -- The transition of the state will take effect on next
    -- rising edge of the clock. 
@@ -353,12 +479,9 @@ always @ (*) begin
         DONE_M:begin
             read_write_dq   = 1'b1;
             to_dq           = 1'b1;
-            jc1_reset       = 1'b1;     // Reset clock counters
-            jc2_reset       = 1'b1;
-            sr1_reset       = 1'b1;
-            sr1_en          = 1'b0;
-            sr2_reset       = 1'b1;
-            sr2_en          = 1'b0;
+            tcnt_reset      = 1'b1;     // Reset slot timer
+            bit_reset       = 1'b1;
+            bit_next        = 1'b0;
             reg_wr          = 1'b0;
             done = 1'b1;
             ready           = 1'b0;
@@ -378,18 +501,16 @@ always @ (*) begin
                                     -- IDLE state
                                     ---------------------------------------
                                     -- Master waiting for go Command to
-                                    -- execute next instruction.
+                                    -- execute next instruction, once the
+                                    -- bus has recovered from the last slot.
                                     ---------------------------------------
         */
         IDLE_M:begin
             read_write_dq   = 1'b1;
             to_dq           = 1'b1;
-            jc1_reset       = 1'b1;     // Reset clock counters
-            jc2_reset       = 1'b1;
-            sr1_reset       = 1'b1;
-            sr1_en          = 1'b0;
-            sr2_reset       = 1'b1;
-            sr2_en          = 1'b0;
+            tcnt_reset      = 1'b1;     // Reset slot timer
+            bit_reset       = 1'b1;
+            bit_next        = 1'b0;
             done            = 1'b0;
             failure = 1'b0;
             ready           = 1'b1;
@@ -401,6 +522,12 @@ always @ (*) begin
                 NEXT_STATE = IDLE_M;
                 reg_wr  = 1'b1;
             end
+            else if (rec_cnt != 0) begin
+                // Recovery of the last slot not over
+                NEXT_STATE = IDLE_M;
+                reg_wr     = 1'b1;
+                ready      = 1'b0;
+            end
             else begin
                 // Check if go signal is issued by PS
                 if (go) begin
@@ -428,12 +555,9 @@ always @ (*) begin
         INIT_M:begin
             read_write_dq   = 1'b0;     // drive the one-wire bus high
             to_dq           = 1'b1;
-            jc1_reset       = 1'b1;     // Reset clock counters
-            jc2_reset       = 1'b1;
-            sr1_en          = 1'b0;
-            sr1_reset       = 1'b1;
-            sr2_reset       = 1'b1;
-            sr2_en          = 1'b0;
+            tcnt_reset      = 1'b1;     // Reset slot timer
+            bit_reset       = 1'b1;
+            bit_next        = 1'b0;
             reg_wr          = 1'b0;
             failure = 1'b0;
             ready           = 1'b0;
@@ -444,47 +568,37 @@ always @ (*) begin
             NEXT_STATE      = TX_RST_PLS;
         end
         /*
-                                        ---------------------------------------
+                                    ---------------------------------------
                                     -- Transmit Reset Pulse state     
                                     ---------------------------------------
                                     -- In this state, the one-wire bus will
                                     -- be pulled down (Tx "Reset Pulse") for
-                                    -- 480 us to reset the one-wire
+                                    -- t_rstl (480 us) to reset the one-wire
                                     -- device connected to the bus.
                                     --
-                                    -- It enables FSM to move to next state
-                                    -- at 480 us. The transition of the state
-                                    -- will happend at 500 us.
-                                    --
-                                    -- Use JC1 and SR2 here to count for
-                                    -- longer time duration (0 ~ 480 us):
+                                    -- On the last cycle of the pulse, it
+                                    -- resets the slot timer and moves to
+                                    -- next state, which releases the bus.
                                     -----------------------------------------
         */
         TX_RST_PLS:begin
-            
-            jc2_reset   = 1'b0;
-            sr2_reset   = 1'b0;
-            sr2_en      = ts_60_to_80us;    // enable sr2 to count every 80us
-            sr1_en          = 1'b0;
-            sr1_reset       = 1'b1;
+            bit_reset       = 1'b1;
+            bit_next        = 1'b0;
             reg_wr      = 1'b0;
             data_RX_wr = 1'b0;
             done = 1'b0;
             failure = 1'b0;
             ready           = 1'b0;
             data_out = 0;
+            read_write_dq   = 1'b0;     // write the one-wire bus with "0"
+            to_dq           = 1'b0;     // for t_rstl (one-wire RESET)
 
-            if (sr2_q[6]) begin             // 480 us has passed.
-                read_write_dq   = 1'b1;
-                to_dq           = 1'b1;
-                jc1_reset       = 1'b1;     // reset the 20 us counter
-
+            if (ts_rst_end) begin           // t_rstl has passed.
+                tcnt_reset      = 1'b1;     // time the presence window
                 NEXT_STATE = RX_PRE_PLS; 
             end
-            else begin                      // 0 ~ 480 us
-                read_write_dq   = 1'b0;     // write the one-wire bus with "0"
-                to_dq           = 1'b0;     // for 480 us (one-wire RESET)
-                jc1_reset   = 1'b0;
+            else begin                      // 0 ~ t_rstl
+                tcnt_reset      = 1'b0;
                 NEXT_STATE      = TX_RST_PLS;
             end
         end
@@ -494,24 +608,17 @@ always @ (*) begin
                                     ---------------------------------------
                                     -- In this state, data on the one-wire
                                     -- bus is sampled for the presence of a slave.
-                                    -- The data will be latched at 0~80 us.
-                                    -- Then it waits till total 500us has
-                                    -- has passed, and moves to next state
-                                    -- or goes back to INIT state according 
-                                    -- to the presence of the "Presence
-                                    -- Pulse"
-                                    --
-                                    -- Use JC1 and SR2 here to count for
-                                    -- longer time duration (0 ~ 480 us)
+                                    -- The data will be latched at t_msp
+                                    -- (70 us). Then it waits till t_rstl
+                                    -- (480 us) has passed, and moves to
+                                    -- next state with the presence of the
+                                    -- "Presence Pulse" in failure.
                                     ----------------------------------------
         */
         RX_PRE_PLS:begin
-            jc1_reset       = 1'b0;
-            jc2_reset       = 1'b0;
-            sr2_reset       = 1'b0;             // use sr2 to create a 480 us counter
-            sr2_en          = ts_60_to_80us;    // enable sr2 to count every 80us
-            sr1_en          = 1'b0;
-            sr1_reset       = 1'b1;
+            tcnt_reset      = 1'b0;
+            bit_reset       = 1'b1;
+            bit_next        = 1'b0;
             reg_wr          = 1'b0;
             data_RX_wr = 1'b0;
             ready           = 1'b0;
@@ -520,9 +627,9 @@ always @ (*) begin
             to_dq           = 1'b0;
             data_out = 0;
 
-            if (sr2_q[5]) begin                                 // wait for 480us to pass
+            if (ts_rst_end) begin                               // wait for t_rstl to pass
                 reg_wr  = 1'b1;
-                if (from_dq_pp == 1'b0 & from_dq == 1'b1) begin // slave is present and pull-up is present
+                if (from_dq_pp == 1'b0 & dq_in == 1'b1) begin   // slave is present and pull-up is present
                     done        = 1'b1;
                     failure     = 1'b0;
                     NEXT_STATE  = DONE_M;  // Move to next state
@@ -533,7 +640,7 @@ always @ (*) begin
                     NEXT_STATE = DONE_M;
                 end
             end
-            else begin                                          // 0 ~ 480 us
+            else begin                                          // 0 ~ t_rstl
                 NEXT_STATE = RX_PRE_PLS;
                 done = 1'b0;
                 failure = 1'b0;
@@ -545,44 +652,31 @@ always @ (*) begin
                                     -- Receive Bit from Device
                                     ---------------------------------------
                                     -- In this state, the onewire bus is
-                                    -- pulled down during first 1 us, this
+                                    -- pulled down during first t_w1l, this
                                     -- is the initialization of the Rx of one
                                     -- bit . Then it release the bus by changing
                                     -- back to read mode.
                                     --
-                                    -- From 13us to 15 us, it samples the 
-                                    -- data on the one-wire bus, and assert
+                                    -- At t_rdv, it samples the data on the
+                                    -- one-wire bus, and assert
                                     -- databit_valid signal. 
                                     --
-                                    -- After 15us, it releases the bus allowing
-                                    -- the one-wire bus to be pulled back to
-                                    -- high.
-                                    --
-                                    -- After 80us, one bit has been read.
+                                    -- At t_w0l, one bit has been read, the
+                                    -- recovery of the slot is timed by
+                                    -- rec_cnt.
                                     -----------------------------------------
         */
         RX_BIT_M:begin
-            jc1_reset       = 1'b0;
-            jc2_reset       = 1'b0;
-            sr1_en          = 1'b0;
-            sr1_reset       = 1'b1;
-            sr2_en          = 1'b0;
-            sr2_reset       = 1'b1;
+            tcnt_reset      = 1'b0;
+            bit_reset       = 1'b1;
+            bit_next        = 1'b0;
             ready           = 1'b0;
             read_write_dq   = 1'b1;
             reg_wr          = 1'b0;
             failure = 1'b0;
+            data_RX_wr      = ts_sample;    // bit from 1-wire stored to data_RX lsb
 
-            if (ts_0_to_1us) begin      // pull down one_wire bus
-                read_write_dq   = 1'b0;
-                to_dq           = 1'b0;
-                NEXT_STATE      = RX_BIT_M;
-                data_RX_wr = 1'b0;
-                done = 1'b0;
-                data_out = 0;
-            end
-
-            else if (ts_60_to_80us) begin
+            if (ts_rec) begin
                 read_write_dq   = 1'b1;
                 to_dq           = 1'b1;
                 done            = 1'b1;
@@ -594,18 +688,19 @@ always @ (*) begin
                 NEXT_STATE      = DONE_M;
             end
 
-            else begin                      // 1-60us
+            else if (ts_low) begin      // pull down one_wire bus
+                read_write_dq   = 1'b0;
+                to_dq           = 1'b0;
+                NEXT_STATE      = RX_BIT_M;
+                done = 1'b0;
+                data_out = 0;
+            end
+
+            else begin                      // t_w1l ~ t_w0l
                 read_write_dq   = 1'b1;     // release the bus
                 to_dq           = 1'b1;
                 done = 1'b0;
                 data_out = 0;
-                if (ts_14_to_15us) begin    // Read time slot
-                    data_RX_wr = 1'b1;  // bit from 1-wire stored to data_RX lsb
-                end
-                else begin
-                    data_RX_wr = 1'b0;
-                end
-
                 NEXT_STATE      = RX_BIT_M;
             end
         end
@@ -614,55 +709,38 @@ always @ (*) begin
                                     -- Receive Byte from Device
                                     ---------------------------------------
                                     -- In this state, the onewire bus is
-                                    -- pulled down during first 1 us, this
+                                    -- pulled down during first t_w1l, this
                                     -- is the initialization of the Rx of one
                                     -- bit . Then it release the bus by changing
                                     -- back to read mode.
                                     --
-                                    -- From 13us to 15 us, it samples the 
-                                    -- data on the one-wire bus, and assert
+                                    -- At t_rdv, it samples the data on the
+                                    -- one-wire bus, and assert
                                     -- databit_valid signal. 
                                     --
-                                    -- After 15us, it releases the bus allowing
-                                    -- the one-wire bus to be pulled back to
-                                    -- high.
-                                    --
-                                    -- At 60us, it enables SR1 to shift to
-                                    -- next bit. After 80us, one bit has
-                                    -- been read. Then it repeats
-                                    -- the process to receive other 7
-                                    -- bits in one byte.
+                                    -- From t_w0l, the bus recovers. At the
+                                    -- end of the slot, bit_sel shifts to
+                                    -- next bit and the timer restarts.
+                                    -- Then it repeats the process to
+                                    -- receive other 7 bits in one byte.
                                     -----------------------------------------
         */
         RX_BYTE_M:begin
-            jc1_reset       = 1'b0;
-            jc2_reset       = 1'b0;
-            sr1_en          = 1'b0;
-            sr1_reset       = 1'b0; // start to use sr1 to count 8 bits.
-            sr2_en          = 1'b0;
-            sr2_reset       = 1'b1;
+            tcnt_reset      = 1'b0;
+            bit_reset       = 1'b0; // start to use bit_sel to count 8 bits.
+            bit_next        = 1'b0;
             ready           = 1'b0;
             read_write_dq   = 1'b1;
             reg_wr          = 1'b0;
             failure = 1'b0;
+            data_RX_wr      = ts_sample;
 
-            if (ts_0_to_1us) begin      // pull down one_wire bus
-                read_write_dq   = 1'b0;
-                to_dq           = 1'b0;
-                sr1_en          = 1'b0;
-                NEXT_STATE      = RX_BYTE_M;
-                data_RX_wr = 1'b0;
-                done = 1'b0;
-                data_out = 0;
-            end
-
-            else if (ts_60_to_80us) begin
+            if (ts_rec) begin
                 read_write_dq   = 1'b1;
                 to_dq           = 1'b1;
-                sr1_en          = 1'b1;
                 data_RX_wr = 1'b0;
 
-                if (sr1_q[7]) begin
+                if (bit_sel[7]) begin
                     data_out        = data_RX;
                     done            = 1'b1;
                     reg_wr          = 1'b1;
@@ -671,24 +749,27 @@ always @ (*) begin
                     NEXT_STATE = DONE_M;  // Move to next state
                 end
                 else begin
+                    tcnt_reset = ts_end;    // next bit at the end of the slot
+                    bit_next   = ts_end;
                     NEXT_STATE = RX_BYTE_M;
                     done = 1'b0;
                     data_out = 0;
                 end
             end
 
-            else begin                              // 1-60us
+            else if (ts_low) begin      // pull down one_wire bus
+                read_write_dq   = 1'b0;
+                to_dq           = 1'b0;
+                NEXT_STATE      = RX_BYTE_M;
+                done = 1'b0;
+                data_out = 0;
+            end
+
+            else begin                      // t_w1l ~ t_w0l
                 read_write_dq   = 1'b1;     // release the bus
                 to_dq           = 1'b1;
-                sr1_en          = 1'b0;
                 done = 1'b0;
                 data_out = 0;
-                if (ts_14_to_15us) begin    // Read time slot
-                    data_RX_wr = 1'b1;
-                end
-                else begin
-                    data_RX_wr = 1'b0;
-                end
                 NEXT_STATE = RX_BYTE_M;       // continue to assemble the data bytes
             end
         end
@@ -697,7 +778,7 @@ always @ (*) begin
                                     -- Transmit Bit to device
                                     ---------------------------------------
                                     -- In this state, the one-wire bus is
-                                    -- pulled down during first 10 us.
+                                    -- pulled down during first t_w1l.
                                     --
                                     -- Then according to each bit of data
                                     -- in the tx_data register, we write data 
@@ -710,27 +791,39 @@ always @ (*) begin
                                     -- (2) if we need to write '0' to
                                     -- the device, we output '0' directly
                                     -- to the bus. This process happens from
-                                    -- 10 us to 60 us.
+                                    -- t_w1l to t_w0l.
                                     -- 
-                                    -- After 60us, it releases the bus allowing
+                                    -- At t_w0l, it releases the bus allowing
                                     -- the one-wire bus to be pulled back to
-                                    -- high, and enable SR1 to shift to 
-                                    -- next bit.
+                                    -- high, the recovery of the slot is
+                                    -- timed by rec_cnt.
                                     -----------------------------------------
         */
         TX_BIT_M:begin
-            jc1_reset       = 1'b0;
-            jc2_reset       = 1'b0;
-            sr1_en          = 1'b0;
-            sr1_reset       = 1'b1;
-            sr2_en          = 1'b0;
-            sr2_reset       = 1'b1;
+            tcnt_reset      = 1'b0;
+            bit_reset       = 1'b1;
+            bit_next        = 1'b0;
             reg_wr          = 1'b0;
             data_RX_wr = 1'b0;
             failure = 1'b0;
             ready           = 1'b0;
             data_out = 0;
-            if (ts_0_to_10us) begin         // pull down one_wire bus
+            if (ts_rec) begin               // release the bus
+                read_write_dq   = 1'b1;
+                to_dq           = 1'b1;
+                if (spu) begin
+                    done        = 1'b0;
+                    reg_wr      = 1'b0;
+                    NEXT_STATE  = SPU_M;   // Power the devices before done
+                end
+                else begin
+                    done        = 1'b1;
+                    reg_wr      = 1'b1;
+                    NEXT_STATE  = DONE_M;  // Move to next state
+                end
+            end
+
+            else if (ts_low) begin          // pull down one_wire bus
                 read_write_dq   = 1'b0;
                 to_dq           = 1'b0;
                 done = 1'b0;
@@ -738,15 +831,7 @@ always @ (*) begin
                 NEXT_STATE      = TX_BIT_M;
             end
 
-            else if (ts_60_to_80us) begin   // release the bus
-                read_write_dq   = 1'b1;
-                to_dq           = 1'b1;
-                done            = 1'b1;
-                reg_wr          = 1'b1;
-                NEXT_STATE      = DONE_M;  // Move to next state
-            end
-
-            else begin  // write the command bit from 10 us to 60 us
+            else begin  // write the command bit from t_w1l to t_w0l
                 read_write_dq   = tx_data[0];
                 to_dq           = tx_data[0];
                 done = 1'b0;
@@ -759,7 +844,7 @@ always @ (*) begin
                                     -- Transmit Byte to device
                                     ---------------------------------------
                                     -- In this state, the one-wire bus is
-                                    -- pulled down during first 10 us.
+                                    -- pulled down during first t_w1l.
                                     --
                                     -- Then according to each bit of data
                                     -- in the tx_data register, we write data 
@@ -772,91 +857,191 @@ always @ (*) begin
                                     -- (2) if we need to write '0' to
                                     -- the device, we output '0' directly
                                     -- to the bus. This process happens from
-                                    -- 10 us to 60 us.
+                                    -- t_w1l to t_w0l.
                                     -- 
-                                    -- After 60us, it releases the bus allowing
+                                    -- At t_w0l, it releases the bus allowing
                                     -- the one-wire bus to be pulled back to
-                                    -- high, and enable SR1 to shift to 
-                                    -- next bit.
+                                    -- high.
                                     --  
-                                    -- After another 20us, the transition of SR1
-                                    -- will take place. The process will repeat
-                                    -- to transmit another bit in the MEM Command,
-                                    -- till all 8 bits in the MEM Command have
-                                    -- been sent out. 
+                                    -- At the end of the slot, bit_sel shifts
+                                    -- to next bit and the timer restarts. The
+                                    -- process will repeat to transmit another
+                                    -- bit in the MEM Command, till all 8 bits
+                                    -- in the MEM Command have been sent out. 
                                     -----------------------------------------
         */
         TX_BYTE_M:begin
-            jc1_reset       = 1'b0;
-            jc2_reset       = 1'b0;
-            sr1_reset       = 1'b0; // use sr1 to count the 8 bits
-            sr1_en          = 1'b0;
-            sr2_en          = 1'b0;
-            sr2_reset       = 1'b1;
+            tcnt_reset      = 1'b0;
+            bit_reset       = 1'b0; // use bit_sel to count the 8 bits
+            bit_next        = 1'b0;
             reg_wr          = 1'b0;
             data_RX_wr = 1'b0;
             failure = 1'b0;
             ready           = 1'b0;
             data_out = 0;
-            if (ts_0_to_10us) begin         // pull down one_wire bus
-                read_write_dq   = 1'b0;
-                to_dq           = 1'b0;
-                sr1_en          = 1'b0;
-                done = 1'b0;
-                NEXT_STATE      = TX_BYTE_M;
-                reg_wr          = 1'b0;
-            end
-
-            else if (ts_60_to_80us) begin   // release the bus
+            if (ts_rec) begin               // release the bus
                 read_write_dq   = 1'b1;
                 to_dq           = 1'b1;
-                sr1_en          = 1'b1;
-                if (sr1_q[7]) begin
+                if (bit_sel[7] & spu) begin
+                    done        = 1'b0;
+                    reg_wr      = 1'b0;
+                    // Byte has sent, power the devices before done
+                    NEXT_STATE  = SPU_M;
+                end
+                else if (bit_sel[7]) begin
                     done        = 1'b1;
                     reg_wr      = 1'b1;
                     // Byte has sent
                     NEXT_STATE  = DONE_M;  // Move to next state
                 end
                 else begin
+                    tcnt_reset  = ts_end;   // next bit at the end of the slot
+                    bit_next    = ts_end;
                     NEXT_STATE = TX_BYTE_M;
                     done = 1'b0;
                     reg_wr          = 1'b0;
                 end
             end
 
-            else begin  // write the command bit from 10 us to 60 us
+            else if (ts_low) begin          // pull down one_wire bus
+                read_write_dq   = 1'b0;
+                to_dq           = 1'b0;
+                done = 1'b0;
+                NEXT_STATE      = TX_BYTE_M;
+                reg_wr          = 1'b0;
+            end
+
+            else begin  // write the command bit from t_w1l to t_w0l
                 read_write_dq = 1'b1;
                 to_dq = 1'b1;
                 for (i = 0; i < 8; i = i+1) begin
-                    if (sr1_q[i]) begin
+                    if (bit_sel[i]) begin
                         read_write_dq   = tx_data[i];
                         to_dq           = tx_data[i];
                     end
                 end
-                sr1_en      = 1'b0;
                 reg_wr          = 1'b0;
                 NEXT_STATE  = TX_BYTE_M;
                 done = 1'b0;
             end
         end
+        /*
+                                    ---------------------------------------
+                                    -- Strong pull-up
+                                    ---------------------------------------
+                                    -- The one-wire bus is actively driven
+                                    -- high, instead of through the pull-up
+                                    -- resistor, to supply the current of
+                                    -- parasite powered devices during a
+                                    -- temperature conversion or an EEPROM
+                                    -- write.
+                                    --
+                                    -- After spu_duration us, it releases
+                                    -- the bus and signals done.
+                                    -----------------------------------------
+        */
+        SPU_M:begin
+            tcnt_reset      = 1'b1;
+            bit_reset       = 1'b1;
+            bit_next        = 1'b0;
+            data_RX_wr = 1'b0;
+            failure = 1'b0;
+            ready           = 1'b0;
+            data_out = 0;
+            if (spu_cnt == 0) begin
+                read_write_dq   = 1'b1;     // release the bus
+                to_dq           = 1'b1;
+                done            = 1'b1;
+                reg_wr          = 1'b1;
+                NEXT_STATE      = DONE_M;
+            end
+            else begin
+                read_write_dq   = 1'b0;     // drive the one-wire bus high
+                to_dq           = 1'b1;
+                done            = 1'b0;
+                reg_wr          = 1'b0;
+                NEXT_STATE      = SPU_M;
+            end
+        end
+        /*
+                                    ---------------------------------------
+                                    -- Poll Bit from Device
+                                    ---------------------------------------
+                                    -- Each slot is the one of RX_BIT_M. In
+                                    -- its recovery, if a 1 is read or the
+                                    -- slot is the last one allowed, done is
+                                    -- set, with failure if still 0, and it
+                                    -- moves to DONE_M.
+                                    --
+                                    -- Otherwise the slot ends, then the bus
+                                    -- stays released for poll_interval us
+                                    -- (poll_wait) before the next slot.
+                                    -----------------------------------------
+        */
+        POLL_BIT_M:begin
+            bit_reset       = 1'b1;
+            bit_next        = 1'b0;
+            ready           = 1'b0;
+            reg_wr          = 1'b0;
+            failure = 1'b0;
+            done = 1'b0;
+            data_out = 0;
+            data_RX_wr      = ts_sample & !poll_wait;   // bit from 1-wire stored to data_RX lsb
+
+            if (poll_wait) begin        // interval, slot timer held
+                read_write_dq   = 1'b1;
+                to_dq           = 1'b1;
+                tcnt_reset      = 1'b1;
+                NEXT_STATE      = POLL_BIT_M;
+            end
+
+            else if (ts_rec) begin
+                read_write_dq   = 1'b1;
+                to_dq           = 1'b1;
+                tcnt_reset      = 1'b0;
+                data_RX_wr = 1'b0;
+                // Decided once, poll_cnt not counting this slot yet
+                if (ts_rec_start & (data_RX[0] | poll_last)) begin
+                    done        = 1'b1;
+                    reg_wr      = 1'b1;
+                    failure     = !data_RX[0];  // timeout
+                    data_out    = data_RX;
+                    NEXT_STATE  = DONE_M;
+                end
+                else begin
+                    NEXT_STATE  = POLL_BIT_M;   // 0 read, until the end of the slot
+                end
+            end
+
+            else if (ts_low) begin      // pull down one_wire bus
+                read_write_dq   = 1'b0;
+                to_dq           = 1'b0;
+                tcnt_reset      = 1'b0;
+                NEXT_STATE      = POLL_BIT_M;
+            end
+
+            else begin                      // t_w1l ~ t_w0l
+                read_write_dq   = 1'b1;     // release the bus
+                to_dq           = 1'b1;
+                tcnt_reset      = 1'b0;
+                NEXT_STATE      = POLL_BIT_M;
+            end
+        end
         default:begin
             NEXT_STATE = IDLE_M;
             data_RX_wr = 1'b0;
             done = 1'b0;
             failure = 1'b0;
-            jc1_reset   = 1'b0;
-            jc2_reset = 1'b0;
+            tcnt_reset      = 1'b1;
             read_write_dq   = 1'b1;
             ready           = 1'b0;
             reg_wr          = 1'b0;
-            sr1_en          = 1'b0;
-            sr1_reset       = 1'b1;
-            sr2_en          = 1'b0;
-            sr2_reset       = 1'b1;
+            bit_next        = 1'b0;
+            bit_reset       = 1'b1;
             to_dq           = 1'b1;
             data_out = 0;
         end
     endcase
 end
 
-endmodule
\ No newline at end of file
+endmodule
@@ -0,0 +1,297 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+/*
+-------------------------------------------------------------------------------
+-- Title      : 1-Wire ROM ID table and device select sequencer
+-- Project    : 1-wire
+-------------------------------------------------------------------------------
+-- File       : w1_romsel.v
+-- Author     : agent
+-- Company    : Advanced Micro Devices, Inc.
+-------------------------------------------------------------------------------
+-- Uses       : none
+-------------------------------------------------------------------------------
+-- Description: Holds a table of ROM_TABLE ROM IDs, loaded by the PS after
+--              the enumeration of the bus, and runs the instructions using
+--              it over W1_MASTER:
+--                SELECT_ROM (1010): reset/presence, Match ROM (0x55) and the
+--                                   8 bytes of the entry tx_data[5:0]. The
+--                                   failure bit is set, and nothing sent
+--                                   after the reset, if no presence pulse.
+--                PING_ALL   (0110): for the entries 0 to tx_data[6:0] - 1,
+--                                   a Search ROM (0xF0) pass forced along
+--                                   the ROM ID, which only completes if the
+--                                   device is on the bus. The result is one
+--                                   bit per entry in ping.
+--
+--              Both use the GO/DONE/READY handshake of the other
+--              instructions, DONE is raised once at the end. A select costs
+--              one instruction instead of ten, a ping about 200 slots per
+--              entry. The other instructions go through unchanged.
+--
+-- Inputs/Outpus
+--              clk         : AXI clock;
+--              areset      : asynchronous reset from AXI register;
+--              ctrl_reset  : reset control, aborts a table instruction;
+--              go, command, tx_data, spu : from the AXI registers;
+--              rom_wr      : write rom_id in the entry rom_idx, one cycle;
+--              rom_idx     : 6 LSB in register 19;
+--              rom_id      : registers 21 (MSB) and 20 (LSB), the family
+--                            code in the LSB;
+--
+--              done, ready, reg_wr, failure, data_out : to the AXI
+--                            registers, from W1_MASTER or the sequencer;
+--              ping        : registers 23 (MSB) and 22 (LSB), devices found
+--                            by the last PING_ALL;
+--
+--              m_*         : instruction and handshake of W1_MASTER;
+-------------------------------------------------------------------------------
+-- Revisions  :
+-- Date        Version  Author  	Description
+-- 2026/10/19  0.1      agent       Initial Version
+-------------------------------------------------------------------------------
+*/
+
+module W1_ROMSEL #(
+    parameter integer ROM_TABLE = 64    // Entries of the table, 1 to 64
+)(
+    input   wire        clk,        // AXI clock
+    input   wire        areset,
+    input   wire        ctrl_reset,
+    // From the AXI registers
+    input   wire        go,
+    input   wire [3:0]  command,
+    input   wire [7:0]  tx_data,
+    input   wire        spu,
+    input   wire        rom_wr,
+    input   wire [5:0]  rom_idx,
+    input   wire [63:0] rom_id,
+    // To the AXI registers
+    output  wire        done,
+    output  wire        ready,
+    output  wire        reg_wr,
+    output  wire        failure,
+    output  wire [7:0]  data_out,
+    output  reg  [63:0] ping,       // Entries found by PING_ALL
+    // W1_MASTER
+    output  wire        m_go,
+    output  wire [3:0]  m_command,
+    output  wire [7:0]  m_tx_data,
+    output  wire        m_spu,
+    input   wire        m_done,
+    input   wire        m_ready,
+    input   wire        m_reg_wr,
+    input   wire        m_failure,
+    input   wire [7:0]  m_data_out
+);
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Invert reset signal
+wire reset = !areset | ctrl_reset;          // active high reset signal
+
+parameter [3:0]
+SELECT_ROM  = 4'b1010,   // Reset, Match ROM and the ROM ID of an entry
+PING_ALL    = 4'b0110,   // Search ROM along the ROM ID of each entry
+INIT        = 4'b1000,   // W1_MASTER commands issued for each step
+RX_BIT      = 4'b1100,
+TX_BIT      = 4'b1110,
+TX_BYTE     = 4'b1111;
+
+parameter [7:0]
+MATCH_ROM   = 8'h55,
+SEARCH_ROM  = 8'hF0;
+
+parameter [2:0]
+R_IDLE      = 3'd0,      // Instructions go through to W1_MASTER
+R_LOAD      = 3'd1,      // Read the entry from the table
+R_FETCH     = 3'd2,      // Wait for W1_MASTER ready
+R_GO        = 3'd3,      // Step on the bus, wait for W1_MASTER done
+R_NEXT      = 3'd4,      // Entry done, store its result
+R_DONE      = 3'd5;      // Instruction done, wait for PS to clear go
+
+parameter [2:0]
+P_RESET     = 3'd0,      // Reset/presence
+P_CMD       = 3'd1,      // ROM command byte
+P_BYTE      = 3'd2,      // SELECT_ROM: ROM ID byte n
+P_ID        = 3'd3,      // PING_ALL: read bit n of the devices
+P_CMP       = 3'd4,      // PING_ALL: read its complement
+P_DIR       = 3'd5;      // PING_ALL: write bit n of the entry
+
+reg [63:0]  rom_table [0:ROM_TABLE-1];
+reg [63:0]  id_q;           // Entry being sent
+reg [5:0]   idx;            // Entry read from the table
+reg [2:0]   state;
+reg [2:0]   phase;
+reg         ping_all;       // PING_ALL in progress
+reg [6:0]   entries;        // Entries to ping
+reg [5:0]   n;              // Byte or bit of the ROM ID
+reg         id_bit;         // First read bit of a search step
+reg         found;          // Presence, or device found by the ping
+reg         fail_q;
+
+wire        rom_cmd = (command == SELECT_ROM) | (command == PING_ALL);
+wire        active  = state != R_IDLE;
+wire        m_end   = m_done & m_reg_wr;    // Step done, m_failure and m_data_out valid
+wire        id_b    = id_q[n];              // Bit n of the entry, LSB first on the bus
+
+// Table: written from the AXI registers, read by the sequencer
+always @ (posedge clk) begin
+    if (rom_wr && rom_idx < ROM_TABLE)
+        rom_table[rom_idx] <= rom_id;
+    id_q <= rom_table[idx];
+end
+
+always @ (posedge clk or posedge reset) begin
+    if (reset) begin
+        state       <= R_IDLE;
+        phase       <= P_RESET;
+        idx         <= 0;
+        ping_all    <= 1'b0;
+        entries     <= 0;
+        n           <= 0;
+        id_bit      <= 1'b0;
+        found       <= 1'b0;
+        fail_q      <= 1'b0;
+        ping        <= 0;
+    end
+    else begin
+        case (state)
+            R_IDLE: begin
+                if (go & rom_cmd & m_ready) begin
+                    ping_all    <= command == PING_ALL;
+                    phase       <= P_RESET;
+                    fail_q      <= 1'b0;
+                    if (command == PING_ALL) begin
+                        idx     <= 0;
+                        entries <= (tx_data[6:0] > ROM_TABLE) ? ROM_TABLE : tx_data[6:0];
+                        ping    <= 0;
+                        state   <= (tx_data[6:0] == 0) ? R_DONE : R_LOAD;
+                    end
+                    else begin
+                        idx     <= tx_data[5:0];
+                        state   <= R_LOAD;
+                    end
+                end
+            end
+            R_LOAD: begin
+                // id_q holds the entry from the next cycle
+                state <= R_FETCH;
+            end
+            R_FETCH: begin
+                if (m_ready)
+                    state <= R_GO;
+            end
+            R_GO: begin
+                if (m_end) begin
+                    state <= R_FETCH;
+                    case (phase)
+                        P_RESET: begin
+                            found <= !m_failure;
+                            phase <= P_CMD;
+                            if (m_failure)
+                                state <= R_NEXT;
+                        end
+                        P_CMD: begin
+                            n     <= 0;
+                            phase <= ping_all ? P_ID : P_BYTE;
+                        end
+                        P_BYTE: begin
+                            n <= n + 1;
+                            if (n == 7)
+                                state <= R_NEXT;
+                        end
+                        P_ID: begin
+                            id_bit <= m_data_out[0];
+                            phase  <= P_CMP;
+                        end
+                        P_CMP: begin
+                            // Nobody answers with the bit of the entry
+                            phase <= P_DIR;
+                            if (id_b ? m_data_out[0] : id_bit) begin
+                                found <= 1'b0;
+                                state <= R_NEXT;
+                            end
+                        end
+                        P_DIR: begin
+                            n     <= n + 1;
+                            phase <= P_ID;
+                            if (n == 63)
+                                state <= R_NEXT;
+                        end
+                        default: begin
+                            state <= R_NEXT;
+                        end
+                    endcase
+                end
+            end
+            R_NEXT: begin
+                if (ping_all) begin
+                    ping[idx] <= found;
+                    if (idx + 1 == entries)
+                        state <= R_DONE;
+                    else begin
+                        idx   <= idx + 1;
+                        phase <= P_RESET;
+                        state <= R_LOAD;
+                    end
+                end
+                else begin
+                    fail_q <= !found;
+                    state  <= R_DONE;
+                end
+            end
+            R_DONE: begin
+                // If PS has not cleared go, stay here to let PS fetch status
+                if (!go)
+                    state <= R_IDLE;
+            end
+            default: begin
+                state <= R_IDLE;
+            end
+        endcase
+    end
+end
+
+// W1_MASTER runs the step of the sequencer, or the instruction of the PS
+reg [3:0]   step_cmd;
+reg [7:0]   step_tx;
+
+always @ (*) begin
+    case (phase)
+        P_RESET: begin
+            step_cmd = INIT;
+            step_tx  = 8'h00;
+        end
+        P_CMD: begin
+            step_cmd = TX_BYTE;
+            step_tx  = ping_all ? SEARCH_ROM : MATCH_ROM;
+        end
+        P_BYTE: begin
+            step_cmd = TX_BYTE;
+            step_tx  = id_q[{n[2:0], 3'b000} +: 8];
+        end
+        P_DIR: begin
+            step_cmd = TX_BIT;
+            step_tx  = {7'b0, id_b};
+        end
+        default: begin          // P_ID, P_CMP
+            step_cmd = RX_BIT;
+            step_tx  = 8'h00;
+        end
+    endcase
+end
+
+assign m_go          = active ? (state == R_GO) : (go & !rom_cmd);
+assign m_command     = active ? step_cmd : command;
+assign m_tx_data     = active ? step_tx : tx_data;
+assign m_spu         = active ? 1'b0 : spu;
+
+// The AXI registers see a single instruction
+assign done          = active ? (state == R_DONE) : m_done;
+assign ready         = active ? 1'b0 : m_ready;
+assign reg_wr        = active ? 1'b1 : m_reg_wr;
+assign failure       = active ? fail_q : m_failure;
+assign data_out      = active ? 8'h00 : m_data_out;
+
+endmodule
@@ -3,20 +3,28 @@ Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
 SPDX-License-Identifier: MIT
 */
 
-#include <linux/atomic.h>
 #include <linux/bitfield.h>
 #include <linux/clk.h>
+#include <linux/completion.h>
+#include <linux/delay.h>
+#include <linux/dma-mapping.h>
+#include <linux/dmaengine.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/jiffies.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/of_platform.h>
 #include <linux/types.h>
-#include <linux/wait.h>
 
 #include <linux/w1.h>
 
+#define CREATE_TRACE_POINTS
+#include "xlnxw1_trace.h"
+#include "xlnxw1_stats.h"
+#include "w1_caps.h"
+
 /* 1-wire AMD IP definition */
 #define AXIW1_IPID	0x10ee4453
 /* Registers offset */
@@ -27,16 +35,30 @@ SPDX-License-Identifier: MIT
 #define AXIW1_DATA_REG	0x10
 #define AXIW1_IPVER_REG	0x18
 #define AXIW1_IPID_REG	0x1C
+#define AXIW1_SPU_REG	0x20
+#define AXIW1_TRSTL_REG	0x24		/* Slot timing in AXI clock cycles, since v1.4 */
+#define AXIW1_TCLK_REG	0x40		/* AXI clock cycles per microsecond */
+#define AXIW1_TIMING_REGS	7		/* TRSTL, TMSP, TW0L, TREC, TRDV, TW1L, TSLOT */
+#define AXIW1_BLEN_REG	0x44		/* Bytes of a block instruction, since v1.5 */
+#define AXIW1_BCNT_REG	0x48		/* Bytes transferred by the last block instruction */
 /* Instructions */
 #define AXIW1_INITPRES	0x0800
 #define AXIW1_READBIT	0x0C00
 #define AXIW1_WRITEBIT	0x0E00
 #define AXIW1_READBYTE	0x0D00
 #define AXIW1_WRITEBYTE	0x0F00
+#define AXIW1_READBLOCK	0x0900		/* BLEN bytes to the AXI4-Stream, since v1.5 */
+#define AXIW1_WRITEBLOCK	0x0B00		/* BLEN bytes from the AXI4-Stream */
+#define AXIW1_SPU	BIT(12)		/* Strong pull-up after the byte, since v1.3 */
+#define AXIW1_SPU_MAX_US	GENMASK(23, 0)
+#define AXIW1_TIMING_MAX	GENMASK(19, 0)
+#define AXIW1_BLOCK_MAX	GENMASK(15, 0)
+#define AXIW1_IS_READ(instr)	(((instr) & 0x0E00) == 0x0C00)
 /* Status flag masks */
 #define AXIW1_DONE	BIT(0)
 #define AXIW1_READY	BIT(4)
 #define AXIW1_PRESENCE	BIT(31)
+#define AXIW1_BCNT_MASK	GENMASK(15, 0)
 #define AXIW1_MAJORVER_MASK	GENMASK(23, 8)
 #define AXIW1_MINORVER_MASK	GENMASK(7, 0)
 /* Control flag */
@@ -50,47 +72,133 @@ SPDX-License-Identifier: MIT
 
 #define AXIW1_TIMEOUT	msecs_to_jiffies(100)
 
+static bool threaded_irq;
+module_param(threaded_irq, bool, 0444);
+MODULE_PARM_DESC(threaded_irq, "Chain the block transfers from an IRQ thread instead of the hard IRQ");
+
+static unsigned int bus_trace;
+module_param(bus_trace, uint, 0444);
+MODULE_PARM_DESC(bus_trace, "Records of the bus trace in debugfs, 0 for none");
+
+static unsigned int timing_ns[AXIW1_TIMING_REGS];
+module_param_array(timing_ns, uint, NULL, 0444);
+MODULE_PARM_DESC(timing_ns, "Reset low, presence sample, write-0 low, recovery, read sample, write-1 low and slot in ns, 0 keeps the IP default (v1.4+)");
+
+static unsigned int dma_min_bytes = 16;
+module_param(dma_min_bytes, uint, 0644);
+MODULE_PARM_DESC(dma_min_bytes, "Shortest block transferred by the DMA, with the rx/tx channels of the IP (v1.5+)");
+
 #define DRIVER_NAME	"xlnxw1"
 
 struct xlnxw1_local {
 	struct device *dev;
 	void __iomem *base_addr;
 	int irq;
-	atomic_t flag;			/* Set on IRQ, cleared once serviced */
-	wait_queue_head_t wait_queue;
+	struct completion done;		/* Completed by the IRQ handler */
+	u32 irqe;			/* IRQs armed, IRQE is cleared by the handler */
+	u32 irq_stat;			/* STAT and RXDATA read by the handler */
+	u32 irq_data;
+	const u8 *tx;			/* Block transfer chained by the handler */
+	u8 *rx;
+	int len;
+	int pos;
+	struct dma_chan *dma_rx;	/* Optional, block instructions of the IP */
+	struct dma_chan *dma_tx;
+	struct completion dma_done;	/* Completed by the DMA callback */
 	struct w1_bus_master bus_host;
+	u32 caps;			/* W1_CAP_* of the IP, read at probe */
+	unsigned int pullup_ms;		/* Strong pull-up armed for the next write_byte */
+	u32 instr;			/* Primitive in progress, for the traces */
+	u64 start_ns;
+	u64 issue_ns;
+	u8 trace_flags;
+	struct xlnxw1_stats stats;
 };
 
+/* Start of a primitive, before its READY wait */
+static void xlnxw1_op_begin(struct xlnxw1_local *xlnxw1_local, u32 instr)
+{
+	xlnxw1_local->instr = instr;
+	xlnxw1_local->start_ns = ktime_get_ns();
+	xlnxw1_local->issue_ns = 0;
+	xlnxw1_local->trace_flags = W1_TRACE_IRQ;
+}
+
+/* End of a primitive, rc is 0 or the error of its IRQ wait */
+static void xlnxw1_op_end(struct xlnxw1_local *xlnxw1_local, u32 val, int rc)
+{
+	u64 end_ns = ktime_get_ns();
+	u64 lat_ns = end_ns - xlnxw1_local->start_ns;
+
+	xlnxw1_stats_add(&xlnxw1_local->stats, xlnxw1_local->instr, lat_ns);
+	xlnxw1_stats_trace(&xlnxw1_local->stats, xlnxw1_local->start_ns, xlnxw1_local->issue_ns,
+			   end_ns, xlnxw1_local->instr, val,
+			   xlnxw1_local->trace_flags | (rc < 0 ? W1_TRACE_ERROR : 0));
+	trace_xlnxw1_complete(xlnxw1_local->dev, xlnxw1_local->instr, val, rc, lat_ns);
+}
+
 /**
  * xlnxw1_wait_irq_interruptible_timeout() - Wait for IRQ with timeout.
  *
  * @xlnxw1_local:	Pointer to device structure
  * @IRQ:		IRQ channel to wait on
  *
+ * The handler completes the wait with the STAT and RXDATA registers read at
+ * the IRQ in irq_stat and irq_data, the caller does not read them again.
+ *
  * Return:		%0 - OK, %-EINTR - Interrupted, %-EBUSY - Timed out
  */
 static int xlnxw1_wait_irq_interruptible_timeout(struct xlnxw1_local *xlnxw1_local,
 						     u32 IRQ)
 {
-	int ret;
+	long ret;
+
+	if (IRQ == AXIW1_READY_IRQ_EN)
+		trace_xlnxw1_ready_wait(xlnxw1_local->dev, xlnxw1_local->instr);
+	else
+		trace_xlnxw1_done_wait(xlnxw1_local->dev, xlnxw1_local->instr);
 
-	/* Enable the IRQ requested and wait for flag to indicate it's been triggered */
+	/* Enable the IRQ requested and wait for the handler to complete */
+	reinit_completion(&xlnxw1_local->done);
+	xlnxw1_local->irqe = IRQ;
 	iowrite32(IRQ, xlnxw1_local->base_addr + AXIW1_IRQE_REG);
-	ret = wait_event_interruptible_timeout(xlnxw1_local->wait_queue,
-					       atomic_read(&xlnxw1_local->flag) != 0,
-					       AXIW1_TIMEOUT);
+	ret = wait_for_completion_interruptible_timeout(&xlnxw1_local->done, AXIW1_TIMEOUT);
+	if (ret > 0)
+		return 0;
+
+	/* Disarm the IRQ so that a late one does not complete the next wait */
+	iowrite32(AXI_CLEAR, xlnxw1_local->base_addr + AXIW1_IRQE_REG);
+	synchronize_irq(xlnxw1_local->irq);
+	xlnxw1_local->irqe = 0;
+
 	if (ret < 0) {
 		dev_err(xlnxw1_local->dev, "Wait IRQ Interrupted\n");
 		return -EINTR;
 	}
 
-	if (!ret) {
-		dev_err(xlnxw1_local->dev, "Wait IRQ Timeout\n");
-		return -EBUSY;
-	}
+	xlnxw1_local->stats.timeouts++;
+	dev_err(xlnxw1_local->dev, "Wait IRQ Timeout\n");
+	return -EBUSY;
+}
 
-	atomic_set(&xlnxw1_local->flag, 0);
-	return 0;
+/* Wait for READY signal to be 1 to ensure 1-wire IP is ready */
+static int xlnxw1_wait_ready(struct xlnxw1_local *xlnxw1_local)
+{
+	if (ioread32(xlnxw1_local->base_addr + AXIW1_STAT_REG) & AXIW1_READY)
+		return 0;
+
+	/* The handler only completes once the enabled status is set */
+	return xlnxw1_wait_irq_interruptible_timeout(xlnxw1_local, AXIW1_READY_IRQ_EN);
+}
+
+/* Write the instruction and the Go signal, clearing the control reset signal */
+static void xlnxw1_issue(struct xlnxw1_local *xlnxw1_local, u32 instr)
+{
+	iowrite32(instr, xlnxw1_local->base_addr + AXIW1_INST_REG);
+	iowrite32(AXIW1_GO, xlnxw1_local->base_addr + AXIW1_CTRL_REG);
+	if (xlnxw1_local->stats.ring)
+		xlnxw1_local->issue_ns = ktime_get_ns();
+	trace_xlnxw1_issue(xlnxw1_local->dev, instr);
 }
 
 /**
@@ -104,43 +212,40 @@ static int xlnxw1_wait_irq_interruptible_timeout(struct xlnxw1_local *xlnxw1_loc
 static u8 xlnxw1_touch_bit(void *data, u8 bit)
 {
 	struct xlnxw1_local *xlnxw1_local = data;
+	u32 instr = bit ? AXIW1_READBIT : AXIW1_WRITEBIT;
 	u8 val = 0;
 	int rc;
 
-	/* Wait for READY signal to be 1 to ensure 1-wire IP is ready */
-	while ((ioread32(xlnxw1_local->base_addr + AXIW1_STAT_REG) & AXIW1_READY) == 0) {
-		rc = xlnxw1_wait_irq_interruptible_timeout(xlnxw1_local,
-							       AXIW1_READY_IRQ_EN);
-		if (rc < 0)
-			return 1; /* Callee doesn't test for error. Return inactive bus state */
-	}
+	xlnxw1_op_begin(xlnxw1_local, instr);
 
-	if (bit)
-		/* Read. Write read Bit command in register 0 */
-		iowrite32(AXIW1_READBIT, xlnxw1_local->base_addr + AXIW1_INST_REG);
-	else
-		/* Write. Write tx Bit command in instruction register with bit to transmit */
-		iowrite32(AXIW1_WRITEBIT + (bit & 0x01),
-			  xlnxw1_local->base_addr + AXIW1_INST_REG);
+	rc = xlnxw1_wait_ready(xlnxw1_local);
+	if (rc < 0)
+		goto err; /* Callee doesn't test for error. Return inactive bus state */
 
-	/* Write Go signal and clear control reset signal in control register */
-	iowrite32(AXIW1_GO, xlnxw1_local->base_addr + AXIW1_CTRL_REG);
+	/*
+	 * Read: write read Bit command in register 0. Write: write tx Bit command
+	 * in instruction register with bit to transmit (0, as a 1 is a read slot)
+	 */
+	xlnxw1_issue(xlnxw1_local, instr);
 
 	/* Wait for done signal to be 1 */
-	while ((ioread32(xlnxw1_local->base_addr + AXIW1_STAT_REG) & AXIW1_DONE) != 1) {
-		rc = xlnxw1_wait_irq_interruptible_timeout(xlnxw1_local, AXIW1_DONE_IRQ_EN);
-		if (rc < 0)
-			return 1; /* Callee doesn't test for error. Return inactive bus state */
-	}
+	rc = xlnxw1_wait_irq_interruptible_timeout(xlnxw1_local, AXIW1_DONE_IRQ_EN);
+	if (rc < 0)
+		goto err; /* Callee doesn't test for error. Return inactive bus state */
 
-	/* If read, Retrieve data from register */
+	/* If read, the handler retrieved the data register */
 	if (bit)
-		val = (u8)(ioread32(xlnxw1_local->base_addr + AXIW1_DATA_REG) & AXIW1_READDATA);
+		val = (u8)(xlnxw1_local->irq_data & AXIW1_READDATA);
 
 	/* Clear Go signal in register 1 */
 	iowrite32(AXI_CLEAR, xlnxw1_local->base_addr + AXIW1_CTRL_REG);
 
+	xlnxw1_op_end(xlnxw1_local, val, 0);
 	return val;
+
+err:
+	xlnxw1_op_end(xlnxw1_local, 1, rc);
+	return 1;
 }
 
 /**
@@ -155,34 +260,32 @@ static u8 xlnxw1_read_byte(void *data)
 	u8 val = 0;
 	int rc;
 
-	/* Wait for READY signal to be 1 to ensure 1-wire IP is ready */
-	while ((ioread32(xlnxw1_local->base_addr + AXIW1_STAT_REG) & AXIW1_READY) == 0) {
-		rc = xlnxw1_wait_irq_interruptible_timeout(xlnxw1_local,
-							       AXIW1_READY_IRQ_EN);
-		if (rc < 0)
-			return 0xFF; /* Return inactive bus state */
-	}
+	xlnxw1_op_begin(xlnxw1_local, AXIW1_READBYTE);
 
-	/* Write read Byte command in instruction register*/
-	iowrite32(AXIW1_READBYTE, xlnxw1_local->base_addr + AXIW1_INST_REG);
+	rc = xlnxw1_wait_ready(xlnxw1_local);
+	if (rc < 0)
+		goto err; /* Return inactive bus state */
 
-	/* Write Go signal and clear control reset signal in control register */
-	iowrite32(AXIW1_GO, xlnxw1_local->base_addr + AXIW1_CTRL_REG);
+	/* Write read Byte command in instruction register */
+	xlnxw1_issue(xlnxw1_local, AXIW1_READBYTE);
 
 	/* Wait for done signal to be 1 */
-	while ((ioread32(xlnxw1_local->base_addr + AXIW1_STAT_REG) & AXIW1_DONE) != 1) {
-		rc = xlnxw1_wait_irq_interruptible_timeout(xlnxw1_local, AXIW1_DONE_IRQ_EN);
-		if (rc < 0)
-			return 0xFF; /* Return inactive bus state */
-	}
+	rc = xlnxw1_wait_irq_interruptible_timeout(xlnxw1_local, AXIW1_DONE_IRQ_EN);
+	if (rc < 0)
+		goto err; /* Return inactive bus state */
 
-	/* Retrieve LSB bit in data register to get RX byte */
-	val = (u8)(ioread32(xlnxw1_local->base_addr + AXIW1_DATA_REG) & 0x000000FF);
+	/* LSB of the data register read by the handler is the RX byte */
+	val = (u8)(xlnxw1_local->irq_data & 0x000000FF);
 
 	/* Clear Go signal in control register */
 	iowrite32(AXI_CLEAR, xlnxw1_local->base_addr + AXIW1_CTRL_REG);
 
+	xlnxw1_op_end(xlnxw1_local, val, 0);
 	return val;
+
+err:
+	xlnxw1_op_end(xlnxw1_local, 0xFF, rc);
+	return 0xFF;
 }
 
 /**
@@ -194,32 +297,288 @@ static u8 xlnxw1_read_byte(void *data)
 static void xlnxw1_write_byte(void *data, u8 val)
 {
 	struct xlnxw1_local *xlnxw1_local = data;
+	unsigned int pullup_ms = xlnxw1_local->pullup_ms;
+	u32 instr = AXIW1_WRITEBYTE + (pullup_ms ? AXIW1_SPU : 0) + val;
 	int rc;
 
-	/* Wait for READY signal to be 1 to ensure 1-wire IP is ready */
-	while ((ioread32(xlnxw1_local->base_addr + AXIW1_STAT_REG) & AXIW1_READY) == 0) {
-		rc = xlnxw1_wait_irq_interruptible_timeout(xlnxw1_local,
-							       AXIW1_READY_IRQ_EN);
-		if (rc < 0)
-			return;
-	}
+	/* The strong pull-up only applies to the write following set_pullup */
+	xlnxw1_local->pullup_ms = 0;
+
+	xlnxw1_op_begin(xlnxw1_local, instr);
+
+	rc = xlnxw1_wait_ready(xlnxw1_local);
+	if (rc < 0)
+		goto err;
 
 	/* Write tx Byte command in instruction register with bit to transmit */
-	iowrite32(AXIW1_WRITEBYTE + val, xlnxw1_local->base_addr + AXIW1_INST_REG);
+	if (pullup_ms)
+		iowrite32(min_t(u32, pullup_ms * USEC_PER_MSEC, AXIW1_SPU_MAX_US),
+			  xlnxw1_local->base_addr + AXIW1_SPU_REG);
+	xlnxw1_issue(xlnxw1_local, instr);
 
-	/* Write Go signal and clear control reset signal in register 1 */
-	iowrite32(AXIW1_GO, xlnxw1_local->base_addr + AXIW1_CTRL_REG);
+	/*
+	 * The IP drives the bus high for the pull-up duration before raising
+	 * done, which is longer than the IRQ wait timeout: sleep it first.
+	 */
+	if (pullup_ms)
+		msleep(pullup_ms);
 
 	/* Wait for done signal to be 1 */
-	while ((ioread32(xlnxw1_local->base_addr + AXIW1_STAT_REG) & AXIW1_DONE) != 1) {
-		rc = xlnxw1_wait_irq_interruptible_timeout(xlnxw1_local,
-							       AXIW1_DONE_IRQ_EN);
-		if (rc < 0)
-			return;
-	}
+	rc = xlnxw1_wait_irq_interruptible_timeout(xlnxw1_local, AXIW1_DONE_IRQ_EN);
+	if (rc < 0)
+		goto err;
 
 	/* Clear Go signal in control register */
 	iowrite32(AXI_CLEAR, xlnxw1_local->base_addr + AXIW1_CTRL_REG);
+
+err:
+	xlnxw1_op_end(xlnxw1_local, val, rc);
+}
+
+/* Instruction of the byte pos of the block transfer */
+static u32 xlnxw1_block_instr(struct xlnxw1_local *xlnxw1_local)
+{
+	if (xlnxw1_local->rx)
+		return AXIW1_READBYTE;
+	return AXIW1_WRITEBYTE + xlnxw1_local->tx[xlnxw1_local->pos];
+}
+
+/*
+ * Next step of the block transfer from the IRQ handler, armed is the IRQ that
+ * fired. Issue the byte on READY, store it and wait for READY again on DONE.
+ * Return: true while the transfer goes on, false once the last byte is done.
+ */
+static bool xlnxw1_block_step(struct xlnxw1_local *xlnxw1_local, u32 armed)
+{
+	u32 irq;
+
+	/* Nothing left to issue, never store past the buffer */
+	if (xlnxw1_local->pos >= xlnxw1_local->len)
+		return false;
+
+	if (armed == AXIW1_READY_IRQ_EN) {
+		xlnxw1_issue(xlnxw1_local, xlnxw1_local->instr);
+		irq = AXIW1_DONE_IRQ_EN;
+	} else {
+		u8 val = xlnxw1_local->irq_data & 0x000000FF;
+
+		if (xlnxw1_local->rx)
+			xlnxw1_local->rx[xlnxw1_local->pos] = val;
+		iowrite32(AXI_CLEAR, xlnxw1_local->base_addr + AXIW1_CTRL_REG);
+		xlnxw1_op_end(xlnxw1_local, val, 0);
+
+		if (++xlnxw1_local->pos == xlnxw1_local->len)
+			return false;
+		xlnxw1_op_begin(xlnxw1_local, xlnxw1_block_instr(xlnxw1_local));
+		xlnxw1_local->trace_flags |= W1_TRACE_CHAINED;
+		irq = AXIW1_READY_IRQ_EN;
+	}
+
+	xlnxw1_local->irqe = irq;
+	iowrite32(irq, xlnxw1_local->base_addr + AXIW1_IRQE_REG);
+	return true;
+}
+
+/*
+ * Transfer a block of bytes with one wait, the IRQ handler issuing each byte
+ * once the previous one is done. Return: the number of bytes transferred.
+ */
+static int xlnxw1_block(struct xlnxw1_local *xlnxw1_local, const u8 *tx, u8 *rx, int len)
+{
+	int rc;
+
+	if (len <= 0)
+		return 0;
+
+	xlnxw1_local->tx = tx;
+	xlnxw1_local->rx = rx;
+	xlnxw1_local->pos = 0;
+	xlnxw1_op_begin(xlnxw1_local, xlnxw1_block_instr(xlnxw1_local));
+
+	/* len is still 0: the READY IRQ only completes the wait */
+	rc = xlnxw1_wait_ready(xlnxw1_local);
+	if (rc == 0) {
+		reinit_completion(&xlnxw1_local->done);
+		/* Arm the chain with the DONE IRQ of the first byte */
+		xlnxw1_local->len = len;
+		xlnxw1_local->irqe = AXIW1_DONE_IRQ_EN;
+		xlnxw1_issue(xlnxw1_local, xlnxw1_local->instr);
+		iowrite32(AXIW1_DONE_IRQ_EN, xlnxw1_local->base_addr + AXIW1_IRQE_REG);
+		/* A byte slot takes less than 1 ms */
+		if (wait_for_completion_timeout(&xlnxw1_local->done,
+						AXIW1_TIMEOUT + msecs_to_jiffies(len)) == 0) {
+			xlnxw1_local->stats.timeouts++;
+			dev_err(xlnxw1_local->dev, "Block transfer Timeout\n");
+			rc = -EBUSY;
+		}
+	}
+
+	/* Stop the chain and wait for the handler before clearing len */
+	if (rc < 0) {
+		iowrite32(AXI_CLEAR, xlnxw1_local->base_addr + AXIW1_IRQE_REG);
+		synchronize_irq(xlnxw1_local->irq);
+		xlnxw1_local->irqe = 0;
+		iowrite32(AXI_CLEAR, xlnxw1_local->base_addr + AXIW1_CTRL_REG);
+		xlnxw1_op_end(xlnxw1_local, 0xFF, rc);
+		if (rx)
+			memset(rx + xlnxw1_local->pos, 0xFF, len - xlnxw1_local->pos);
+	}
+	xlnxw1_local->len = 0;
+
+	return xlnxw1_local->pos;
+}
+
+static void xlnxw1_dma_callback(void *lp)
+{
+	struct xlnxw1_local *xlnxw1_local = lp;
+
+	complete(&xlnxw1_local->dma_done);
+}
+
+/*
+ * Transfer a block of bytes with one block instruction, the DMA moving the
+ * bytes between the buffer and the stream ports of the IP, the CPU only
+ * waits for DONE. Return: the number of bytes transferred, or -EOPNOTSUPP
+ * if the block is not for the DMA and goes through xlnxw1_block().
+ */
+static int xlnxw1_block_dma(struct xlnxw1_local *xlnxw1_local, const u8 *tx, u8 *rx, int len)
+{
+	struct dma_chan *chan = rx ? xlnxw1_local->dma_rx : xlnxw1_local->dma_tx;
+	enum dma_data_direction dir = rx ? DMA_FROM_DEVICE : DMA_TO_DEVICE;
+	void *buf = rx ? rx : (void *)tx;
+	struct dma_async_tx_descriptor *desc;
+	struct device *dma_dev;
+	dma_addr_t addr;
+	u32 instr = rx ? AXIW1_READBLOCK : AXIW1_WRITEBLOCK;
+	u64 start_ns;
+	int rc, n = 0;
+
+	/* The w1 slaves may pass a buffer on their stack, not mappable */
+	if (!chan || (unsigned int)len < dma_min_bytes || (unsigned int)len > AXIW1_BLOCK_MAX ||
+	    object_is_on_stack(buf) || !virt_addr_valid(buf))
+		return -EOPNOTSUPP;
+
+	dma_dev = chan->device->dev;
+	addr = dma_map_single(dma_dev, buf, len, dir);
+	if (dma_mapping_error(dma_dev, addr))
+		return -EOPNOTSUPP;
+
+	desc = dmaengine_prep_slave_single(chan, addr, len,
+					   rx ? DMA_DEV_TO_MEM : DMA_MEM_TO_DEV,
+					   DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!desc) {
+		dma_unmap_single(dma_dev, addr, len, dir);
+		return -EOPNOTSUPP;
+	}
+	reinit_completion(&xlnxw1_local->dma_done);
+	desc->callback = xlnxw1_dma_callback;
+	desc->callback_param = xlnxw1_local;
+	if (dma_submit_error(dmaengine_submit(desc))) {
+		dma_unmap_single(dma_dev, addr, len, dir);
+		return -EOPNOTSUPP;
+	}
+	dma_async_issue_pending(chan);
+
+	start_ns = ktime_get_ns();
+	xlnxw1_local->instr = instr;
+	rc = xlnxw1_wait_ready(xlnxw1_local);
+	if (rc == 0) {
+		reinit_completion(&xlnxw1_local->done);
+		xlnxw1_local->irqe = AXIW1_DONE_IRQ_EN;
+		iowrite32(len, xlnxw1_local->base_addr + AXIW1_BLEN_REG);
+		xlnxw1_issue(xlnxw1_local, instr);
+		iowrite32(AXIW1_DONE_IRQ_EN, xlnxw1_local->base_addr + AXIW1_IRQE_REG);
+		/* DONE follows the last byte, the DMA may still be writing it */
+		if (wait_for_completion_timeout(&xlnxw1_local->done,
+						AXIW1_TIMEOUT + msecs_to_jiffies(len)) == 0 ||
+		    wait_for_completion_timeout(&xlnxw1_local->dma_done, AXIW1_TIMEOUT) == 0) {
+			xlnxw1_local->stats.timeouts++;
+			dev_err(xlnxw1_local->dev, "DMA block transfer Timeout\n");
+			rc = -EBUSY;
+		}
+	}
+
+	if (rc < 0) {
+		/* A block waiting for the stream only stops with a reset */
+		iowrite32(AXI_CLEAR, xlnxw1_local->base_addr + AXIW1_IRQE_REG);
+		synchronize_irq(xlnxw1_local->irq);
+		xlnxw1_local->irqe = 0;
+		dmaengine_terminate_sync(chan);
+		n = ioread32(xlnxw1_local->base_addr + AXIW1_BCNT_REG) & AXIW1_BCNT_MASK;
+		iowrite32(AXI_RESET, xlnxw1_local->base_addr + AXIW1_CTRL_REG);
+		iowrite32(AXI_CLEAR, xlnxw1_local->base_addr + AXIW1_CTRL_REG);
+	} else {
+		n = ioread32(xlnxw1_local->base_addr + AXIW1_BCNT_REG) & AXIW1_BCNT_MASK;
+		iowrite32(AXI_CLEAR, xlnxw1_local->base_addr + AXIW1_CTRL_REG);
+	}
+	dma_unmap_single(dma_dev, addr, len, dir);
+
+	if (rx && n < len)
+		memset(rx + n, 0xFF, len - n);
+	trace_xlnxw1_complete(xlnxw1_local->dev, instr, n & 0xFF, rc,
+			      ktime_get_ns() - start_ns);
+
+	return n;
+}
+
+/* Transfer a block by DMA if possible, else with the chained IRQs */
+static int xlnxw1_block_any(struct xlnxw1_local *xlnxw1_local, const u8 *tx, u8 *rx, int len)
+{
+	int n = xlnxw1_block_dma(xlnxw1_local, tx, rx, len);
+
+	if (n == -EOPNOTSUPP)
+		n = xlnxw1_block(xlnxw1_local, tx, rx, len);
+	return n;
+}
+
+/**
+ * xlnxw1_read_block() - Reads a block of bytes.
+ *
+ * @data:	the bus host data struct
+ * @buf:	buffer of the bytes read
+ * @len:	number of bytes to read
+ * Return:	the number of bytes read
+ */
+static u8 xlnxw1_read_block(void *data, u8 *buf, int len)
+{
+	return xlnxw1_block_any(data, NULL, buf, len);
+}
+
+/**
+ * xlnxw1_write_block() - Writes a block of bytes.
+ *
+ * @data:	the bus host data struct
+ * @buf:	the bytes to write
+ * @len:	number of bytes to write
+ */
+static void xlnxw1_write_block(void *data, const u8 *buf, int len)
+{
+	struct xlnxw1_local *xlnxw1_local = data;
+
+	/* The strong pull-up armed by the w1 core applies to the last byte */
+	if (xlnxw1_local->pullup_ms && len > 0) {
+		xlnxw1_block_any(xlnxw1_local, buf, NULL, len - 1);
+		xlnxw1_write_byte(xlnxw1_local, buf[len - 1]);
+		return;
+	}
+
+	xlnxw1_block_any(xlnxw1_local, buf, NULL, len);
+}
+
+/**
+ * xlnxw1_set_pullup() - Arms the strong pull-up for the next write byte.
+ *
+ * @data:	the bus host data struct
+ * @delay:	pull-up duration in ms, 0 to disarm
+ * Return:	0
+ */
+static u8 xlnxw1_set_pullup(void *data, int delay)
+{
+	struct xlnxw1_local *xlnxw1_local = data;
+
+	xlnxw1_local->pullup_ms = delay > 0 ? delay : 0;
+
+	return 0;
 }
 
 /**
@@ -234,36 +593,38 @@ static u8 xlnxw1_reset_bus(void *data)
 	u8 val = 0;
 	int rc;
 
+	xlnxw1_op_begin(xlnxw1_local, AXIW1_INITPRES);
+
 	/* Reset 1-wire Axi IP */
 	iowrite32(AXI_RESET, xlnxw1_local->base_addr + AXIW1_CTRL_REG);
 
-	/* Wait for READY signal to be 1 to ensure 1-wire IP is ready */
-	while ((ioread32(xlnxw1_local->base_addr + AXIW1_STAT_REG) & AXIW1_READY) == 0) {
-		rc = xlnxw1_wait_irq_interruptible_timeout(xlnxw1_local,
-							       AXIW1_READY_IRQ_EN);
-		if (rc < 0)
-			return 1; /* Something went wrong with the hardware */
-	}
-	/* Write Initialization command in instruction register */
-	iowrite32(AXIW1_INITPRES, xlnxw1_local->base_addr + AXIW1_INST_REG);
+	rc = xlnxw1_wait_ready(xlnxw1_local);
+	if (rc < 0)
+		goto err; /* Something went wrong with the hardware */
 
-	/* Write Go signal and clear control reset signal in register 1 */
-	iowrite32(AXIW1_GO, xlnxw1_local->base_addr + AXIW1_CTRL_REG);
+	/* Write Initialization command in instruction register */
+	xlnxw1_issue(xlnxw1_local, AXIW1_INITPRES);
 
 	/* Wait for done signal to be 1 */
-	while ((ioread32(xlnxw1_local->base_addr + AXIW1_STAT_REG) & AXIW1_DONE) != 1) {
-		rc = xlnxw1_wait_irq_interruptible_timeout(xlnxw1_local, AXIW1_DONE_IRQ_EN);
-		if (rc < 0)
-			return 1; /* Something went wrong with the hardware */
-	}
-	/* Retrieve MSB bit in status register to get failure bit */
-	if ((ioread32(xlnxw1_local->base_addr + AXIW1_STAT_REG) & AXIW1_PRESENCE) != 0)
+	rc = xlnxw1_wait_irq_interruptible_timeout(xlnxw1_local, AXIW1_DONE_IRQ_EN);
+	if (rc < 0)
+		goto err; /* Something went wrong with the hardware */
+
+	/* MSB bit of the status register read by the handler is the failure bit */
+	if ((xlnxw1_local->irq_stat & AXIW1_PRESENCE) != 0) {
+		xlnxw1_local->stats.presence_failures++;
 		val = 1;
+	}
 
 	/* Clear Go signal in control register */
 	iowrite32(AXI_CLEAR, xlnxw1_local->base_addr + AXIW1_CTRL_REG);
 
+	xlnxw1_op_end(xlnxw1_local, val, 0);
 	return val;
+
+err:
+	xlnxw1_op_end(xlnxw1_local, 1, rc);
+	return 1;
 }
 
 /* Reset the 1-wire AXI IP. Put the IP in reset state and clear registers */
@@ -276,17 +637,115 @@ static void xlnxw1_reset(struct xlnxw1_local *xlnxw1_local)
 	iowrite32(AXI_CLEAR, xlnxw1_local->base_addr + AXIW1_DATA_REG);
 }
 
+/* Release the DMA channels requested by xlnxw1_request_dma() */
+static void xlnxw1_release_dma(struct xlnxw1_local *xlnxw1_local)
+{
+	if (xlnxw1_local->dma_rx)
+		dma_release_channel(xlnxw1_local->dma_rx);
+	if (xlnxw1_local->dma_tx)
+		dma_release_channel(xlnxw1_local->dma_tx);
+}
+
+/*
+ * Request the "rx" and "tx" DMA channels connected to the stream ports, each
+ * one is optional: without it the blocks go through the IRQ handler.
+ */
+static int xlnxw1_request_dma(struct xlnxw1_local *xlnxw1_local)
+{
+	static const char * const names[] = { "rx", "tx" };
+	struct dma_chan **chans[] = { &xlnxw1_local->dma_rx, &xlnxw1_local->dma_tx };
+	struct dma_chan *chan;
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		chan = dma_request_chan(xlnxw1_local->dev, names[i]);
+		if (IS_ERR(chan)) {
+			if (PTR_ERR(chan) == -EPROBE_DEFER) {
+				xlnxw1_release_dma(xlnxw1_local);
+				return -EPROBE_DEFER;
+			}
+			continue;
+		}
+		*chans[i] = chan;
+		dev_info(xlnxw1_local->dev, "Block transfers by DMA on %s\n", dma_chan_name(chan));
+	}
+
+	return 0;
+}
+
+/*
+ * Program the slot timing of the timing_ns parameter, converted to AXI clock
+ * cycles rounding up. Nothing is written if one of the values does not fit.
+ */
+static int xlnxw1_set_timing(struct xlnxw1_local *xlnxw1_local)
+{
+	u32 cycles[AXIW1_TIMING_REGS];
+	u32 tclk;
+	int i;
+
+	tclk = ioread32(xlnxw1_local->base_addr + AXIW1_TCLK_REG);
+	if (!tclk)
+		return -ENODEV;
+
+	for (i = 0; i < AXIW1_TIMING_REGS; i++) {
+		cycles[i] = DIV_ROUND_UP_ULL((u64)timing_ns[i] * tclk, 1000);
+		if (cycles[i] > AXIW1_TIMING_MAX)
+			return -ERANGE;
+	}
+
+	for (i = 0; i < AXIW1_TIMING_REGS; i++)
+		if (cycles[i])
+			iowrite32(cycles[i], xlnxw1_local->base_addr + AXIW1_TRSTL_REG + 4 * i);
+
+	return 0;
+}
+
+/* Issue the next byte of a block transfer or complete the wait */
+static irqreturn_t xlnxw1_irq_thread(int irq, void *lp)
+{
+	struct xlnxw1_local *xlnxw1_local = lp;
+	u32 armed = xlnxw1_local->irqe;
+
+	xlnxw1_local->irqe = 0;
+	if (!xlnxw1_local->len || !xlnxw1_block_step(xlnxw1_local, armed))
+		complete(&xlnxw1_local->done);
+
+	return IRQ_HANDLED;
+}
+
 static irqreturn_t xlnxw1_irq(int irq, void *lp)
 {
 	struct xlnxw1_local *xlnxw1_local = lp;
+	u32 irqe = xlnxw1_local->irqe;
+	u32 stat = ioread32(xlnxw1_local->base_addr + AXIW1_STAT_REG);
+
+	/* The IP raises its line for an enabled status only */
+	if ((irqe & stat & (AXIW1_DONE | AXIW1_READY)) == 0) {
+		xlnxw1_local->stats.spurious_irqs++;
+		return IRQ_NONE;
+	}
 
 	/* Reset interrupt trigger */
 	iowrite32(AXI_CLEAR, xlnxw1_local->base_addr + AXIW1_IRQE_REG);
+	trace_xlnxw1_irq(xlnxw1_local->dev, xlnxw1_local->instr, irqe, stat);
 
-	atomic_set(&xlnxw1_local->flag, 1);
-	wake_up_interruptible(&xlnxw1_local->wait_queue);
+	/* Snapshot for the waiter, the data register only holds a read result */
+	xlnxw1_local->irq_stat = stat;
+	if ((stat & AXIW1_DONE) && AXIW1_IS_READ(xlnxw1_local->instr))
+		xlnxw1_local->irq_data = ioread32(xlnxw1_local->base_addr + AXIW1_DATA_REG);
 
-	return IRQ_HANDLED;
+	if (threaded_irq)
+		return IRQ_WAKE_THREAD;
+
+	return xlnxw1_irq_thread(irq, lp);
+}
+
+/* Register reader of w1_caps_detect() */
+static u32 xlnxw1_caps_read(void *data, u32 offset)
+{
+	struct xlnxw1_local *xlnxw1_local = data;
+
+	return ioread32(xlnxw1_local->base_addr + offset);
 }
 
 static int xlnxw1_probe(struct platform_device *pdev)
@@ -310,13 +769,20 @@ static int xlnxw1_probe(struct platform_device *pdev)
 	if (lp->irq < 0)
 		return lp->irq;
 
-	rc = devm_request_irq(dev, lp->irq, &xlnxw1_irq, IRQF_TRIGGER_HIGH, DRIVER_NAME, lp);
+	/* Initialize the completion before the handler can run */
+	init_completion(&lp->done);
+
+	/*
+	 * The hard IRQ handler reads the status and clears IRQE, the next byte
+	 * of a block transfer is issued from it or from the IRQ thread.
+	 */
+	rc = devm_request_threaded_irq(dev, lp->irq, &xlnxw1_irq,
+				       threaded_irq ? &xlnxw1_irq_thread : NULL,
+				       IRQF_TRIGGER_HIGH | (threaded_irq ? IRQF_ONESHOT : 0),
+				       DRIVER_NAME, lp);
 	if (rc)
 		return rc;
 
-	/* Initialize wait queue and flag */
-	init_waitqueue_head(&lp->wait_queue);
-
 	clk = devm_clk_get_enabled(dev, NULL);
 	if (IS_ERR(clk))
 		return PTR_ERR(clk);
@@ -333,32 +799,64 @@ static int xlnxw1_probe(struct platform_device *pdev)
 	 * to detect if a potentially incompatible future version is used
 	 * by reading major version ID. It is highly undesirable for new IP versions
 	 * to break the API, but this code will at least allow for graceful failure
-	 * should that happen. Future new features can be enabled by hardware
-	 * incrementing the minor version and augmenting the driver to detect capability
-	 * using the minor version number
+	 * should that happen. New features are reported by the CAPS register
+	 * from v1.8, and derived from the minor version before: the primitives
+	 * of the bus master are chosen once here from them.
 	 */
 	val = ioread32(lp->base_addr + AXIW1_IPVER_REG);
 	ver_major = FIELD_GET(AXIW1_MAJORVER_MASK, val);
 	ver_minor = FIELD_GET(AXIW1_MINORVER_MASK, val);
 
-	if (ver_major != 0) {
+	if (ver_major != 1) {
 		dev_err(dev, "AMD AXI W1 host version %u.%u is not supported by this driver",
 			ver_major, ver_minor);
 		return -ENODEV;
 	}
 
+	lp->caps = w1_caps_detect(xlnxw1_caps_read, lp);
+	dev_dbg(dev, "IP version %u.%u, capabilities 0x%08x\n", ver_major, ver_minor, lp->caps);
+
 	lp->bus_host.data = lp;
 	lp->bus_host.touch_bit = xlnxw1_touch_bit;
 	lp->bus_host.read_byte = xlnxw1_read_byte;
 	lp->bus_host.write_byte = xlnxw1_write_byte;
 	lp->bus_host.reset_bus = xlnxw1_reset_bus;
+	lp->bus_host.read_block = xlnxw1_read_block;
+	lp->bus_host.write_block = xlnxw1_write_block;
+	if (lp->caps & W1_CAP_SPU)
+		lp->bus_host.set_pullup = xlnxw1_set_pullup;
 
 	xlnxw1_reset(lp);
 
+	/* The DMA channels of the stream ports are optional */
+	init_completion(&lp->dma_done);
+	if (lp->caps & W1_CAP_BLOCK) {
+		rc = xlnxw1_request_dma(lp);
+		if (rc)
+			return rc;
+	}
+
+	if (memchr_inv(timing_ns, 0, sizeof(timing_ns))) {
+		if (!(lp->caps & W1_CAP_TIMING)) {
+			dev_warn(dev, "IP version %u.%u has a fixed slot timing, timing_ns ignored\n",
+				 ver_major, ver_minor);
+		} else {
+			rc = xlnxw1_set_timing(lp);
+			if (rc) {
+				dev_err(dev, "Invalid timing_ns\n");
+				xlnxw1_release_dma(lp);
+				return rc;
+			}
+		}
+	}
+
 	platform_set_drvdata(pdev, lp);
+	xlnxw1_stats_init(&lp->stats, dev, bus_trace);
 	rc = w1_add_master_device(&lp->bus_host);
 	if (rc) {
 		dev_err(dev, "Could not add host device\n");
+		xlnxw1_stats_remove(&lp->stats);
+		xlnxw1_release_dma(lp);
 		return rc;
 	}
 
@@ -370,6 +868,8 @@ static void xlnxw1_remove(struct platform_device *pdev)
 	struct xlnxw1_local *lp = platform_get_drvdata(pdev);
 
 	w1_remove_master_device(&lp->bus_host);
+	xlnxw1_stats_remove(&lp->stats);
+	xlnxw1_release_dma(lp);
 }
 
 static const struct of_device_id xlnxw1_of_match[] = {
@@ -0,0 +1,931 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "libxlnxw1.h"
+#include "w1_crc.h"
+#include "w1_mem.h"
+#include "w1_temp.h"
+
+#define XLNXW1_OP_MAX_LEN	255	/* Longest READ/WRITE operation, larger ones are split */
+#define XLNXW1_MEM_VERIFY_LEN	256	/* Bytes compared per Read Memory at the end of a job */
+
+int xlnxw1_open(struct xlnxw1 *w1, const char *path)
+{
+	w1->fd = open(path ? path : XLNX_W1_DEVICE_NAME, O_RDWR | O_CLOEXEC);
+	w1->has_conv_wait = 1;
+	w1->has_wait_one = 1;
+	w1->has_pio_write = 0;
+	w1->rom_table_size = -1;
+	w1->rom_count = 0;
+	w1->syscalls = 0;
+	if (w1->fd < 0)
+		return -errno;
+	/* No argument: EFAULT from a driver with the priority lane, the bus untouched */
+	w1->has_pio_write = ioctl(w1->fd, XLNX_IOCTL_PIO_WRITE, NULL) < 0 && errno == EFAULT;
+	return 0;
+}
+
+void xlnxw1_close(struct xlnxw1 *w1)
+{
+	if (w1->fd >= 0)
+		close(w1->fd);
+	w1->fd = -1;
+}
+
+/* The primitive ioctls all copy a single byte */
+static int xlnxw1_ioctl_u8(struct xlnxw1 *w1, unsigned long cmd, uint8_t *val)
+{
+	w1->syscalls++;
+	if (ioctl(w1->fd, cmd, val) < 0)
+		return -errno;
+	return 0;
+}
+
+/* Without the priority lane, there is nothing to end */
+int xlnxw1_end(struct xlnxw1 *w1)
+{
+	if (!w1->has_pio_write)
+		return 0;
+	w1->syscalls++;
+	if (ioctl(w1->fd, XLNX_IOCTL_TXN_END) < 0)
+		return -errno;
+	return 0;
+}
+
+int xlnxw1_reset_bus(struct xlnxw1 *w1)
+{
+	uint8_t presence;
+	int ret;
+
+	ret = xlnxw1_ioctl_u8(w1, XLNX_IOCTL_RESET_BUS, &presence);
+	if (ret == 0 && presence != 0)
+		ret = -ENODEV;
+	return ret;
+}
+
+int xlnxw1_read_bit(struct xlnxw1 *w1, uint8_t *bit)
+{
+	return xlnxw1_ioctl_u8(w1, XLNX_IOCTL_READ_BIT, bit);
+}
+
+int xlnxw1_write_bit(struct xlnxw1 *w1, uint8_t bit)
+{
+	return xlnxw1_ioctl_u8(w1, XLNX_IOCTL_WRITE_BIT, &bit);
+}
+
+int xlnxw1_read_byte(struct xlnxw1 *w1, uint8_t *byte)
+{
+	return xlnxw1_ioctl_u8(w1, XLNX_IOCTL_READ_BYTE, byte);
+}
+
+int xlnxw1_write_byte(struct xlnxw1 *w1, uint8_t byte)
+{
+	return xlnxw1_ioctl_u8(w1, XLNX_IOCTL_WRITE_BYTE, &byte);
+}
+
+/****************************** Transactions *******************************/
+void xlnxw1_txn_init(struct xlnxw1_txn *txn)
+{
+	txn->nops = 0;
+	txn->ntx = 0;
+	txn->error = 0;
+}
+
+static struct xlnxw1_op *xlnxw1_txn_add(struct xlnxw1_txn *txn, uint8_t type)
+{
+	struct xlnxw1_op *op;
+
+	if (txn->nops == XLNXW1_TXN_MAX_OPS) {
+		if (txn->error == 0)
+			txn->error = -E2BIG;
+		return NULL;
+	}
+	op = &txn->ops[txn->nops++];
+	memset(op, 0, sizeof(*op));
+	op->type = type;
+	return op;
+}
+
+void xlnxw1_txn_reset(struct xlnxw1_txn *txn)
+{
+	xlnxw1_txn_add(txn, XLNXW1_OP_RESET);
+}
+
+void xlnxw1_txn_select(struct xlnxw1_txn *txn, const uint8_t *rom)
+{
+	if (rom == NULL) {
+		xlnxw1_txn_write_byte(txn, W1_SKIP_ROM);
+	} else {
+		xlnxw1_txn_write_byte(txn, W1_MATCH_ROM);
+		xlnxw1_txn_write(txn, rom, W1_ROM_ID_SIZE);
+	}
+}
+
+void xlnxw1_txn_write(struct xlnxw1_txn *txn, const void *buf, size_t len)
+{
+	struct xlnxw1_op *op;
+
+	if (len > XLNXW1_TXN_MAX_TX - txn->ntx) {
+		if (txn->error == 0)
+			txn->error = -E2BIG;
+		return;
+	}
+	if (len == 0)
+		return;
+
+	/* Consecutive writes are merged into one operation */
+	op = txn->nops ? &txn->ops[txn->nops - 1] : NULL;
+	if (op == NULL || op->type != XLNXW1_OP_WRITE || op->len + len > XLNXW1_OP_MAX_LEN) {
+		op = xlnxw1_txn_add(txn, XLNXW1_OP_WRITE);
+		if (op == NULL)
+			return;
+		op->offset = (uint16_t)txn->ntx;
+	}
+	memcpy(&txn->tx[txn->ntx], buf, len);
+	txn->ntx += len;
+	op->len += len;
+}
+
+void xlnxw1_txn_write_byte(struct xlnxw1_txn *txn, uint8_t byte)
+{
+	xlnxw1_txn_write(txn, &byte, 1);
+}
+
+void xlnxw1_txn_read(struct xlnxw1_txn *txn, void *buf, size_t len)
+{
+	uint8_t *rx = buf;
+	struct xlnxw1_op *op;
+	size_t n;
+
+	while (len) {
+		n = len < XLNXW1_OP_MAX_LEN ? len : XLNXW1_OP_MAX_LEN;
+		op = xlnxw1_txn_add(txn, XLNXW1_OP_READ);
+		if (op == NULL)
+			return;
+		op->len = (uint8_t)n;
+		op->rx = rx;
+		rx += n;
+		len -= n;
+	}
+}
+
+void xlnxw1_txn_wait_one(struct xlnxw1_txn *txn, unsigned int timeout_ms)
+{
+	struct xlnxw1_op *op = xlnxw1_txn_add(txn, XLNXW1_OP_WAIT_ONE);
+
+	if (op != NULL)
+		op->arg = timeout_ms;
+}
+
+void xlnxw1_txn_delay(struct xlnxw1_txn *txn, unsigned int ms)
+{
+	struct xlnxw1_op *op = xlnxw1_txn_add(txn, XLNXW1_OP_DELAY);
+
+	if (op != NULL)
+		op->arg = ms;
+}
+
+void xlnxw1_txn_wait_conversion(struct xlnxw1_txn *txn, unsigned int tconv_ms)
+{
+	struct xlnxw1_op *op = xlnxw1_txn_add(txn, XLNXW1_OP_WAIT_CONV);
+
+	if (op != NULL)
+		op->arg = tconv_ms;
+}
+
+static uint64_t xlnxw1_now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static int xlnxw1_wait_one(struct xlnxw1 *w1, unsigned int timeout_ms)
+{
+	uint64_t deadline;
+	__u32 arg = timeout_ms;
+	uint8_t bit;
+	int ret;
+
+	if (w1->has_wait_one) {
+		w1->syscalls++;
+		if (ioctl(w1->fd, XLNX_IOCTL_WAIT_ONE, &arg) == 0)
+			return 0;
+		if (errno != EOPNOTSUPP && errno != EINVAL && errno != ENOTTY)
+			return -errno;
+		/* IP without POLL_BIT or older driver, read slots from here */
+		w1->has_wait_one = 0;
+	}
+
+	deadline = xlnxw1_now_ms() + timeout_ms;
+	for (;;) {
+		ret = xlnxw1_read_bit(w1, &bit);
+		if (ret != 0 || bit != 0)
+			return ret;
+		if (xlnxw1_now_ms() > deadline)
+			return -ETIMEDOUT;
+	}
+}
+
+static void xlnxw1_delay(struct xlnxw1 *w1, unsigned int ms)
+{
+	struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000 };
+
+	w1->syscalls++;
+	while (nanosleep(&ts, &ts) < 0 && errno == EINTR)
+		w1->syscalls++;
+}
+
+static int xlnxw1_wait_conversion(struct xlnxw1 *w1, unsigned int tconv_ms)
+{
+	__u32 arg = tconv_ms;
+	uint64_t deadline;
+	uint8_t bit;
+	int ret;
+
+	if (w1->has_conv_wait) {
+		w1->syscalls++;
+		if (ioctl(w1->fd, XLNX_IOCTL_WAIT_CONVERSION, &arg) == 0)
+			return 0;
+		if (errno != EINVAL && errno != ENOTTY)
+			return -errno;
+		/* Driver without the ioctl, the same in user space */
+		w1->has_conv_wait = 0;
+	}
+
+	xlnxw1_delay(w1, tconv_ms);
+	deadline = xlnxw1_now_ms() + tconv_ms;
+	for (;;) {
+		ret = xlnxw1_read_bit(w1, &bit);
+		if (ret != 0 || bit != 0)
+			return ret;
+		if (xlnxw1_now_ms() > deadline)
+			return -ETIMEDOUT;
+		xlnxw1_delay(w1, XLNX_W1_CONV_POLL_MS);
+	}
+}
+
+/* Table entry of the ROM ID matched by a write, -1 if none */
+static int xlnxw1_rom_entry(const struct xlnxw1 *w1, const struct xlnxw1_txn *txn,
+			    const struct xlnxw1_op *op)
+{
+	int i;
+
+	if (op->type != XLNXW1_OP_WRITE || op->len < 1 + W1_ROM_ID_SIZE ||
+	    txn->tx[op->offset] != W1_MATCH_ROM)
+		return -1;
+	for (i = 0; i < w1->rom_count; i++)
+		if (memcmp(&txn->tx[op->offset + 1], w1->rom_table[i], W1_ROM_ID_SIZE) == 0)
+			return i;
+	return -1;
+}
+
+/* Reset and Match ROM of a table entry, one ioctl */
+static int xlnxw1_select_entry(struct xlnxw1 *w1, int entry)
+{
+	uint8_t val = (uint8_t)entry;
+	int ret;
+
+	ret = xlnxw1_ioctl_u8(w1, XLNX_IOCTL_SELECT_ROM, &val);
+	if (ret == 0 && val != 0)
+		ret = -ENODEV;
+	return ret;
+}
+
+/*
+ * One ioctl per bus primitive, the only path of the current driver, but a
+ * reset followed by the Match ROM of a device of the ROM ID table
+ */
+static int xlnxw1_submit_ioctl(struct xlnxw1 *w1, const struct xlnxw1_txn *txn)
+{
+	const struct xlnxw1_op *op;
+	unsigned int i, j, skip = 0;
+	int ret = 0, entry;
+
+	for (i = 0; i < txn->nops && ret == 0; i++) {
+		op = &txn->ops[i];
+		switch (op->type) {
+		case XLNXW1_OP_RESET:
+			entry = i + 1 < txn->nops ? xlnxw1_rom_entry(w1, txn, &txn->ops[i + 1]) : -1;
+			if (entry >= 0) {
+				ret = xlnxw1_select_entry(w1, entry);
+				skip = 1 + W1_ROM_ID_SIZE;
+				break;
+			}
+			ret = xlnxw1_reset_bus(w1);
+			break;
+		case XLNXW1_OP_WRITE:
+			/* Bytes already sent by SELECT_ROM */
+			for (j = skip, skip = 0; j < op->len && ret == 0; j++)
+				ret = xlnxw1_write_byte(w1, txn->tx[op->offset + j]);
+			break;
+		case XLNXW1_OP_READ:
+			for (j = 0; j < op->len && ret == 0; j++)
+				ret = xlnxw1_read_byte(w1, &op->rx[j]);
+			break;
+		case XLNXW1_OP_WAIT_ONE:
+			ret = xlnxw1_wait_one(w1, op->arg);
+			break;
+		case XLNXW1_OP_DELAY:
+			xlnxw1_delay(w1, op->arg);
+			break;
+		case XLNXW1_OP_WAIT_CONV:
+			ret = xlnxw1_wait_conversion(w1, op->arg);
+			break;
+		default:
+			ret = -EINVAL;
+		}
+	}
+	return ret;
+}
+
+/* Run a transaction left open, followed by another one of the same device */
+static int xlnxw1_submit_open(struct xlnxw1 *w1, const struct xlnxw1_txn *txn)
+{
+	if (txn->error != 0)
+		return txn->error;
+	return xlnxw1_submit_ioctl(w1, txn);
+}
+
+int xlnxw1_submit(struct xlnxw1 *w1, const struct xlnxw1_txn *txn)
+{
+	int ret;
+
+	ret = xlnxw1_submit_open(w1, txn);
+	xlnxw1_end(w1);
+	return ret;
+}
+
+/******************************** Search ROM *******************************/
+void xlnxw1_search_init(struct xlnxw1_search *search)
+{
+	memset(search->rom, 0, sizeof(search->rom));
+	search->last_discrepancy = -1;
+	search->done = 0;
+}
+
+static int xlnxw1_search_pass(struct xlnxw1 *w1, uint8_t cmd, struct xlnxw1_search *search)
+{
+	uint8_t *rom = search->rom;
+	uint8_t id_bit, cmp_bit, dir;
+	int discrepancy = -1, bit, ret;
+
+	if (search->done) {
+		xlnxw1_search_init(search);
+		return 0;
+	}
+	ret = xlnxw1_reset_bus(w1);
+	if (ret == -ENODEV) {
+		xlnxw1_search_init(search);
+		return 0;
+	}
+	if (ret != 0)
+		return ret;
+	ret = xlnxw1_write_byte(w1, cmd);
+	if (ret != 0)
+		return ret;
+
+	for (bit = 0; bit < W1_ROM_ID_SIZE * 8; bit++) {
+		if ((ret = xlnxw1_read_bit(w1, &id_bit)) != 0 ||
+		    (ret = xlnxw1_read_bit(w1, &cmp_bit)) != 0)
+			return ret;
+		if (id_bit && cmp_bit) {
+			/* Nobody left on the bus */
+			xlnxw1_search_init(search);
+			return 0;
+		}
+
+		if (id_bit != cmp_bit)
+			dir = id_bit;
+		else if (bit < search->last_discrepancy)
+			dir = (rom[bit / 8] >> (bit % 8)) & 1;
+		else
+			dir = (bit == search->last_discrepancy);
+		if (id_bit == cmp_bit && dir == 0)
+			discrepancy = bit;
+
+		if (dir)
+			rom[bit / 8] |= (uint8_t)(1 << (bit % 8));
+		else
+			rom[bit / 8] &= (uint8_t)~(1 << (bit % 8));
+		ret = xlnxw1_write_bit(w1, dir);
+		if (ret != 0)
+			return ret;
+	}
+
+	search->last_discrepancy = discrepancy;
+	search->done = (discrepancy < 0);
+	if (w1_crc8(0, rom, W1_ROM_ID_SIZE) != 0 || rom[0] == 0)
+		return -EIO;
+	return 1;
+}
+
+int xlnxw1_search_next(struct xlnxw1 *w1, uint8_t cmd, struct xlnxw1_search *search)
+{
+	int ret;
+
+	ret = xlnxw1_search_pass(w1, cmd, search);
+	xlnxw1_end(w1);
+	return ret;
+}
+
+int xlnxw1_search(struct xlnxw1 *w1, uint8_t cmd, uint8_t (*roms)[8], int max)
+{
+	struct xlnxw1_search search;
+	int found = 0, ret;
+
+	xlnxw1_search_init(&search);
+	while (found < max) {
+		ret = xlnxw1_search_next(w1, cmd, &search);
+		if (ret == 0)
+			break;
+		if (ret == -EIO)
+			continue;	/* Corrupted pass, go on with the next branch */
+		if (ret < 0)
+			return ret;
+		memcpy(roms[found++], search.rom, W1_ROM_ID_SIZE);
+	}
+	/* Best effort, the transactions fall back to Match ROM without it */
+	if (cmd == W1_SEARCH_ROM && found > 0)
+		xlnxw1_rom_table_load(w1, roms, found);
+	return found;
+}
+
+/*
+ * A Search ROM pass forced along the branch of rom: a device answers at each
+ * bit as long as it is on the bus.
+ */
+static int xlnxw1_verify_pass(struct xlnxw1 *w1, const uint8_t rom[8])
+{
+	uint8_t id_bit, cmp_bit, dir;
+	int bit, ret;
+
+	ret = xlnxw1_reset_bus(w1);
+	if (ret == 0)
+		ret = xlnxw1_write_byte(w1, W1_SEARCH_ROM);
+	if (ret != 0)
+		return ret;
+
+	for (bit = 0; bit < W1_ROM_ID_SIZE * 8; bit++) {
+		if ((ret = xlnxw1_read_bit(w1, &id_bit)) != 0 ||
+		    (ret = xlnxw1_read_bit(w1, &cmp_bit)) != 0)
+			return ret;
+		dir = (rom[bit / 8] >> (bit % 8)) & 1;
+		/* Nobody, or only devices with the other bit */
+		if ((id_bit && cmp_bit) || (id_bit != cmp_bit && id_bit != dir))
+			return -ENODEV;
+		ret = xlnxw1_write_bit(w1, dir);
+		if (ret != 0)
+			return ret;
+	}
+	return 0;
+}
+
+int xlnxw1_verify(struct xlnxw1 *w1, const uint8_t rom[8])
+{
+	int ret;
+
+	ret = xlnxw1_verify_pass(w1, rom);
+	xlnxw1_end(w1);
+	return ret;
+}
+
+/******************************* ROM ID table ******************************/
+int xlnxw1_rom_table_load(struct xlnxw1 *w1, uint8_t (*roms)[8], int n)
+{
+	struct xlnx_w1_rom_table table = { 0 };
+
+	if (w1->rom_table_size == 0)
+		return -EOPNOTSUPP;
+	if (n > XLNX_W1_ROM_TABLE_MAX || (w1->rom_table_size > 0 && n > w1->rom_table_size))
+		return -E2BIG;
+
+	/* The table is dropped while it does not match the IP */
+	w1->rom_count = 0;
+	table.count = (uint32_t)n;
+	memcpy(table.rom, roms, (size_t)n * W1_ROM_ID_SIZE);
+	w1->syscalls++;
+	if (ioctl(w1->fd, XLNX_IOCTL_ROM_TABLE_LOAD, &table) < 0) {
+		/* Driver or IP without the table, do not ask again */
+		if (errno == ENOTTY || errno == EOPNOTSUPP) {
+			w1->rom_table_size = 0;
+			return -EOPNOTSUPP;
+		}
+		w1->rom_table_size = (int)table.size;
+		return errno == EINVAL ? -E2BIG : -errno;
+	}
+	w1->rom_table_size = (int)table.size;
+	memcpy(w1->rom_table, roms, (size_t)n * W1_ROM_ID_SIZE);
+	w1->rom_count = n;
+	return 0;
+}
+
+int xlnxw1_ping_all(struct xlnxw1 *w1, uint64_t *found)
+{
+	uint64_t val = (uint64_t)w1->rom_count;
+
+	if (w1->rom_count == 0)
+		return -EOPNOTSUPP;
+	w1->syscalls++;
+	if (ioctl(w1->fd, XLNX_IOCTL_PING_ALL, &val) < 0)
+		return -errno;
+	*found = val;
+	return 0;
+}
+
+/********************************* ROM cache *******************************/
+int xlnxw1_rom_cache_load(const char *path, uint8_t (*roms)[8], int max)
+{
+	char line[64];
+	unsigned int b[W1_ROM_ID_SIZE];
+	int n = 0, i;
+	FILE *f;
+
+	f = fopen(path, "r");
+	if (f == NULL)
+		return -errno;
+	while (n < max && fgets(line, sizeof(line), f) != NULL) {
+		if (sscanf(line, "%02x%02x%02x%02x%02x%02x%02x%02x", &b[0], &b[1], &b[2],
+			   &b[3], &b[4], &b[5], &b[6], &b[7]) != W1_ROM_ID_SIZE)
+			continue;
+		for (i = 0; i < W1_ROM_ID_SIZE; i++)
+			roms[n][i] = (uint8_t)b[i];
+		if (w1_crc8(0, roms[n], W1_ROM_ID_SIZE) == 0)
+			n++;
+	}
+	fclose(f);
+	return n;
+}
+
+int xlnxw1_rom_cache_save(const char *path, uint8_t (*roms)[8], int n)
+{
+	char tmp[PATH_MAX];
+	int i, ret = 0;
+	FILE *f;
+
+	/* Written aside then renamed, a crash leaves the previous file */
+	if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp))
+		return -ENAMETOOLONG;
+	f = fopen(tmp, "w");
+	if (f == NULL)
+		return -errno;
+	for (i = 0; i < n; i++)
+		fprintf(f, "%02x%02x%02x%02x%02x%02x%02x%02x\n", roms[i][0], roms[i][1],
+			roms[i][2], roms[i][3], roms[i][4], roms[i][5], roms[i][6], roms[i][7]);
+	if (fflush(f) != 0 || fsync(fileno(f)) != 0)
+		ret = -errno;
+	if (fclose(f) != 0 && ret == 0)
+		ret = -errno;
+	if (ret == 0 && rename(tmp, path) != 0)
+		ret = -errno;
+	if (ret != 0)
+		unlink(tmp);
+	return ret;
+}
+
+/************************** Device family helpers **************************/
+int xlnxw1_read_rom(struct xlnxw1 *w1, uint8_t rom[8])
+{
+	struct xlnxw1_txn txn;
+	int ret;
+
+	xlnxw1_txn_init(&txn);
+	xlnxw1_txn_reset(&txn);
+	xlnxw1_txn_write_byte(&txn, W1_READ_ROM);
+	xlnxw1_txn_read(&txn, rom, W1_ROM_ID_SIZE);
+	ret = xlnxw1_submit(w1, &txn);
+	if (ret == 0 && w1_crc8(0, rom, W1_ROM_ID_SIZE) != 0)
+		ret = -EIO;
+	return ret;
+}
+
+int xlnxw1_ds18b20_convert(struct xlnxw1 *w1, const uint8_t *rom, int resolution)
+{
+	struct xlnxw1_txn txn;
+
+	xlnxw1_txn_init(&txn);
+	xlnxw1_txn_reset(&txn);
+	xlnxw1_txn_select(&txn, rom);
+	xlnxw1_txn_write_byte(&txn, W1_CONVERT_T);
+	xlnxw1_txn_wait_conversion(&txn, w1_temp_conv_time_ms(rom ? rom[0] : W1_FAMILY_DS18B20,
+							       resolution));
+	return xlnxw1_submit(w1, &txn);
+}
+
+int xlnxw1_ds18b20_read_scratchpad(struct xlnxw1 *w1, const uint8_t *rom,
+				   uint8_t *scratchpad, size_t len)
+{
+	struct xlnxw1_txn txn;
+	int ret;
+
+	if (len > W1_SCRATCHPAD_SIZE)
+		len = W1_SCRATCHPAD_SIZE;
+
+	xlnxw1_txn_init(&txn);
+	xlnxw1_txn_reset(&txn);
+	xlnxw1_txn_select(&txn, rom);
+	xlnxw1_txn_write_byte(&txn, W1_READ_SCRATCHPAD);
+	xlnxw1_txn_read(&txn, scratchpad, len);
+	/* Stop the device from sending the remaining scratchpad bytes */
+	if (len < W1_SCRATCHPAD_SIZE)
+		xlnxw1_txn_reset(&txn);
+	ret = xlnxw1_submit(w1, &txn);
+	if (ret == 0 && len == W1_SCRATCHPAD_SIZE &&
+	    w1_crc8(0, scratchpad, W1_SCRATCHPAD_SIZE) != 0)
+		ret = -EIO;
+	return ret;
+}
+
+int xlnxw1_ds18b20_write_scratchpad(struct xlnxw1 *w1, const uint8_t *rom,
+				    uint8_t th, uint8_t tl, uint8_t config)
+{
+	struct xlnxw1_txn txn;
+	uint8_t data[4] = { W1_WRITE_SCRATCHPAD, th, tl, config };
+
+	xlnxw1_txn_init(&txn);
+	xlnxw1_txn_reset(&txn);
+	xlnxw1_txn_select(&txn, rom);
+	xlnxw1_txn_write(&txn, data, sizeof(data));
+	return xlnxw1_submit(w1, &txn);
+}
+
+/***************************** Memory devices ******************************/
+int xlnxw1_mem_read(struct xlnxw1 *w1, const uint8_t *rom, uint16_t addr, void *buf,
+		    size_t len)
+{
+	struct xlnxw1_txn txn;
+	uint8_t frame[3];
+
+	w1_mem_read_frame(frame, addr);
+	xlnxw1_txn_init(&txn);
+	xlnxw1_txn_reset(&txn);
+	xlnxw1_txn_select(&txn, rom);
+	xlnxw1_txn_write(&txn, frame, sizeof(frame));
+	xlnxw1_txn_read(&txn, buf, len);
+	/* Stop the device from sending the rest of the memory */
+	xlnxw1_txn_reset(&txn);
+	return xlnxw1_submit(w1, &txn);
+}
+
+static const struct w1_mem_type *xlnxw1_mem_job_type(const struct xlnxw1_mem_job *job)
+{
+	if (job->type != NULL)
+		return job->type;
+	return job->rom ? w1_mem_type(job->rom[0]) : NULL;
+}
+
+/* Address again the device of the last Match ROM, rom NULL for Skip ROM */
+static void xlnxw1_txn_resume(struct xlnxw1_txn *txn, const uint8_t *rom)
+{
+	xlnxw1_txn_write_byte(txn, rom ? W1_MEM_RESUME : W1_SKIP_ROM);
+}
+
+/* Page holding the next byte of a job, and the bytes of the job in it */
+static size_t xlnxw1_mem_page(const struct xlnxw1_mem_job *job, const struct w1_mem_type *type,
+			      uint16_t *base)
+{
+	uint16_t addr = (uint16_t)(job->addr + job->done);
+	size_t n;
+
+	*base = addr & ~(type->page - 1);
+	n = type->page - (addr - *base);
+	return n < job->len - job->done ? n : job->len - job->done;
+}
+
+/*
+ * Write the next page to the scratchpad, check it and start its copy. The
+ * transaction goes on up to xlnxw1_mem_confirm(), the bus idle meanwhile.
+ */
+static int xlnxw1_mem_stage(struct xlnxw1_mem_job *job, const struct w1_mem_type *type)
+{
+	uint8_t page[W1_MEM_PAGE_MAX], frame[W1_MEM_WRITE_FRAME_MAX], sp[W1_MEM_READ_SP_MAX];
+	uint8_t crc[2], copy[W1_MEM_COPY_FRAME_SIZE];
+	struct xlnxw1_txn txn;
+	uint16_t base;
+	size_t n, len;
+	int ret;
+
+	n = xlnxw1_mem_page(job, type, &base);
+	if (n < type->page) {
+		ret = xlnxw1_mem_read(job->w1, job->rom, base, page, type->page);
+		if (ret != 0)
+			return ret;
+	}
+	memcpy(&page[job->addr + job->done - base], job->data + job->done, n);
+	len = w1_mem_write_frame(type, frame, base, page);
+
+	xlnxw1_txn_init(&txn);
+	xlnxw1_txn_reset(&txn);
+	xlnxw1_txn_select(&txn, job->rom);
+	xlnxw1_txn_write(&txn, frame, len);
+	xlnxw1_txn_read(&txn, crc, sizeof(crc));
+	xlnxw1_txn_reset(&txn);
+	xlnxw1_txn_resume(&txn, job->rom);
+	xlnxw1_txn_write_byte(&txn, W1_MEM_READ_SCRATCHPAD);
+	xlnxw1_txn_read(&txn, sp, w1_mem_read_sp_len(type));
+	ret = xlnxw1_submit_open(job->w1, &txn);
+	if (ret == 0 &&
+	    (!w1_mem_check_write(frame, len, crc) || !w1_mem_check_scratchpad(type, sp, base, page)))
+		ret = -EIO;
+
+	if (ret == 0) {
+		w1_mem_copy_frame(type, copy, base);
+		xlnxw1_txn_init(&txn);
+		xlnxw1_txn_reset(&txn);
+		xlnxw1_txn_resume(&txn, job->rom);
+		xlnxw1_txn_write(&txn, copy, sizeof(copy));
+		ret = xlnxw1_submit_open(job->w1, &txn);
+	}
+	if (ret != 0) {
+		xlnxw1_end(job->w1);
+		return ret;
+	}
+	/* Rounded up, a partial millisecond is not enough */
+	job->deadline_ms = xlnxw1_now_ms() + type->tprog_ms + 1;
+	return 0;
+}
+
+/* After tPROG, the device sends 0xAA once the page is programmed */
+static int xlnxw1_mem_confirm(struct xlnxw1_mem_job *job)
+{
+	struct xlnxw1_txn txn;
+	uint8_t status;
+	int ret;
+
+	xlnxw1_txn_init(&txn);
+	xlnxw1_txn_read(&txn, &status, 1);
+	xlnxw1_txn_reset(&txn);
+	ret = xlnxw1_submit(job->w1, &txn);
+	if (ret == 0 && status != W1_MEM_COPY_DONE)
+		ret = -EIO;
+	return ret;
+}
+
+static int xlnxw1_mem_verify(struct xlnxw1_mem_job *job)
+{
+	uint8_t buf[XLNXW1_MEM_VERIFY_LEN];
+	size_t off, n;
+	int ret;
+
+	for (off = 0; off < job->len; off += n) {
+		n = job->len - off < sizeof(buf) ? job->len - off : sizeof(buf);
+		ret = xlnxw1_mem_read(job->w1, job->rom, (uint16_t)(job->addr + off), buf, n);
+		if (ret != 0)
+			return ret;
+		if (memcmp(buf, job->data + off, n) != 0)
+			return -EIO;
+	}
+	return 0;
+}
+
+/* Run the next step of a job: stage a page, or confirm its copy once tPROG is over */
+static void xlnxw1_mem_step(struct xlnxw1_mem_job *job, const struct w1_mem_type *type)
+{
+	uint16_t base;
+	int ret;
+
+	if (job->busy) {
+		job->busy = 0;
+		ret = xlnxw1_mem_confirm(job);
+		if (ret == 0) {
+			job->done += xlnxw1_mem_page(job, type, &base);
+			job->retries = 0;
+		}
+	} else {
+		ret = xlnxw1_mem_stage(job, type);
+		if (ret == 0) {
+			job->busy = 1;
+			return;
+		}
+	}
+	/* A corrupted frame or a failed copy, the page is written again */
+	if (ret == -EIO && ++job->retries < XLNXW1_MEM_RETRIES)
+		return;
+	if (ret != 0)
+		job->error = ret;
+	else if (job->done == job->len)
+		job->error = xlnxw1_mem_verify(job);
+}
+
+int xlnxw1_mem_program(struct xlnxw1_mem_job *jobs, int n)
+{
+	const struct w1_mem_type *type;
+	struct xlnxw1_mem_job *job;
+	struct xlnxw1 *sleeper;
+	uint64_t now, next;
+	int i, j, left = 0, ret = 0;
+
+	for (i = 0; i < n; i++) {
+		job = &jobs[i];
+		type = xlnxw1_mem_job_type(job);
+		job->done = 0;
+		job->busy = 0;
+		job->retries = 0;
+		if (type == NULL || job->addr + job->len > type->size) {
+			job->error = -EINVAL;
+		} else if (job->len == 0) {
+			job->error = 0;
+		} else {
+			job->error = -EINPROGRESS;
+			left++;
+		}
+	}
+
+	while (left) {
+		now = xlnxw1_now_ms();
+		next = UINT64_MAX;
+		sleeper = NULL;
+		for (i = 0; i < n; i++) {
+			job = &jobs[i];
+			if (job->error != -EINPROGRESS)
+				continue;
+			/* The bus stays idle while a device programs a page: one job per handle */
+			for (j = 0; j < i; j++)
+				if (jobs[j].w1 == job->w1 && jobs[j].error == -EINPROGRESS)
+					break;
+			if (j < i)
+				continue;
+			if (!job->busy || now >= job->deadline_ms) {
+				xlnxw1_mem_step(job, xlnxw1_mem_job_type(job));
+				if (job->error != -EINPROGRESS) {
+					left--;
+					continue;
+				}
+				if (!job->busy) {
+					next = now;
+					continue;
+				}
+			}
+			if (job->deadline_ms < next) {
+				next = job->deadline_ms;
+				sleeper = job->w1;
+			}
+		}
+		now = xlnxw1_now_ms();
+		if (left && sleeper != NULL && next > now)
+			xlnxw1_delay(sleeper, (unsigned int)(next - now));
+	}
+
+	for (i = 0; i < n && ret == 0; i++)
+		ret = jobs[i].error;
+	return ret;
+}
+
+int xlnxw1_mem_write(struct xlnxw1 *w1, const uint8_t *rom, uint16_t addr, const void *data,
+		     size_t len)
+{
+	struct xlnxw1_mem_job job = {
+		.w1 = w1, .rom = rom, .addr = addr, .data = data, .len = len,
+	};
+
+	return xlnxw1_mem_program(&job, 1);
+}
+
+/******************************** Switches *********************************/
+int xlnxw1_pio_write(struct xlnxw1 *w1, const uint8_t rom[8], uint8_t value, uint8_t *state)
+{
+	/* Match ROM: the table of the handle may be reloaded by another thread */
+	struct xlnx_w1_pio pio = { .entry = XLNX_W1_PIO_NO_ENTRY };
+	struct xlnxw1_txn txn;
+	uint8_t data[3], rsp[2];
+	int ret;
+
+	if (rom[0] == W1_FAMILY_DS2413)
+		value |= 0xFC;
+
+	/* Only the fd is used, beside the thread running the transactions */
+	if (w1->has_pio_write) {
+		memcpy(pio.rom, rom, W1_ROM_ID_SIZE);
+		pio.value = value;
+		ret = ioctl(w1->fd, XLNX_IOCTL_PIO_WRITE, &pio) < 0 ? -errno : 0;
+		if (state && (ret == 0 || ret == -EIO))
+			*state = pio.state;
+		return ret;
+	}
+
+	data[0] = W1_PIO_ACCESS_WRITE;
+	data[1] = value;
+	data[2] = (uint8_t)~value;
+	xlnxw1_txn_init(&txn);
+	xlnxw1_txn_reset(&txn);
+	xlnxw1_txn_select(&txn, rom);
+	xlnxw1_txn_write(&txn, data, sizeof(data));
+	xlnxw1_txn_read(&txn, rsp, sizeof(rsp));
+	/* The switch sends the PIO state until a reset */
+	xlnxw1_txn_reset(&txn);
+	ret = xlnxw1_submit(w1, &txn);
+	if (ret == 0 && state)
+		*state = rsp[1];
+	if (ret == 0 && rsp[0] != W1_PIO_CONFIRM)
+		ret = -EIO;
+	return ret;
+}
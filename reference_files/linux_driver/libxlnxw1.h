@@ -0,0 +1,333 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef LIBXLNXW1_H
+#define LIBXLNXW1_H
+
+/*
+ * libxlnxw1: user space access layer of the /dev/xlnx_w1 character driver.
+ *
+ * A transaction is built with the xlnxw1_txn_*() calls (reset, ROM
+ * selection, writes, reads, wait for a 1 and delays) and run at once by
+ * xlnxw1_submit(), which picks the most efficient path the driver offers.
+ * The transaction lives in the caller's storage, the data written is copied
+ * into it and the data read goes straight into the caller's buffers, so no
+ * call allocates memory. The builder calls never fail: an overflow is
+ * recorded in the transaction and returned by xlnxw1_submit().
+ *
+ * All functions returning an int return 0 on success or a negative errno,
+ * -ENODEV meaning no device answered a reset with a presence pulse.
+ *
+ * With an IP holding a ROM ID table, xlnxw1_search() loads the ROM IDs it
+ * finds in the table, and xlnxw1_submit() runs the reset and the Match ROM
+ * of a device of the table as a single SELECT_ROM instruction.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "xlnxw1_ioctl.h"
+
+#define XLNXW1_TXN_MAX_OPS	32	/* Operations of one transaction */
+#define XLNXW1_TXN_MAX_TX	64	/* Bytes written by one transaction */
+#define XLNXW1_MEM_RETRIES	3	/* Attempts at a page before giving up */
+
+/* ROM commands */
+#define W1_READ_ROM		0x33
+#define W1_MATCH_ROM		0x55
+#define W1_SKIP_ROM		0xCC
+#define W1_SEARCH_ROM		0xF0
+#define W1_ALARM_SEARCH		0xEC
+
+/* DS18B20 family function commands */
+#define W1_CONVERT_T		0x44
+#define W1_WRITE_SCRATCHPAD	0x4E
+#define W1_READ_SCRATCHPAD	0xBE
+#define W1_COPY_SCRATCHPAD	0x48
+#define W1_RECALL_EEPROM	0xB8
+
+/* DS2413 and DS2408 switches */
+#define W1_FAMILY_DS2413	0x3A
+#define W1_FAMILY_DS2408	0x29
+#define W1_PIO_ACCESS_WRITE	0x5A
+#define W1_PIO_CONFIRM		0xAA	/* Read after a PIO Access Write accepted */
+
+/**************************** Type Definitions *****************************/
+struct w1_mem_type;
+
+enum xlnxw1_op_type {
+	XLNXW1_OP_RESET,	/* Reset and presence, fails with -ENODEV if nobody answers */
+	XLNXW1_OP_WRITE,	/* Write len bytes of the transaction tx buffer */
+	XLNXW1_OP_READ,		/* Read len bytes into rx */
+	XLNXW1_OP_WAIT_ONE,	/* Read bits until a 1, fails with -ETIMEDOUT after arg ms */
+	XLNXW1_OP_DELAY,	/* Sleep arg ms, the bus idle */
+	XLNXW1_OP_WAIT_CONV,	/* Sleep the arg ms conversion time, then confirm with a read slot */
+};
+
+struct xlnxw1_op {
+	uint8_t type;		/* enum xlnxw1_op_type */
+	uint8_t len;		/* WRITE, READ: byte count */
+	uint16_t offset;	/* WRITE: offset in the tx buffer */
+	uint32_t arg;		/* WAIT_ONE: timeout, DELAY: duration, WAIT_CONV: tCONV, in ms */
+	uint8_t *rx;		/* READ: destination */
+};
+
+struct xlnxw1_txn {
+	struct xlnxw1_op ops[XLNXW1_TXN_MAX_OPS];
+	uint8_t tx[XLNXW1_TXN_MAX_TX];
+	unsigned int nops;
+	unsigned int ntx;
+	int error;		/* First builder error, returned by xlnxw1_submit() */
+};
+
+struct xlnxw1_search {
+	uint8_t rom[8];			/* ROM ID found by the last pass */
+	int last_discrepancy;		/* -1 to start the search over */
+	int done;			/* The last pass found the last device */
+};
+
+struct xlnxw1 {
+	int fd;
+	int has_conv_wait;	/* The driver has XLNX_IOCTL_WAIT_CONVERSION */
+	int has_wait_one;	/* The driver and the IP have XLNX_IOCTL_WAIT_ONE */
+	int has_pio_write;	/* The driver has XLNX_IOCTL_PIO_WRITE, probed at open */
+	int rom_table_size;	/* Entries of the ROM ID table, 0 without, -1 not known yet */
+	int rom_count;		/* ROM IDs loaded in the table */
+	uint8_t rom_table[XLNX_W1_ROM_TABLE_MAX][8];
+	unsigned long syscalls;	/* ioctl() and nanosleep() calls made, for benchmarks
+				 * (XLNX_IOCTL_PIO_WRITE aside) */
+};
+
+/* A range of an EEPROM to program, see xlnxw1_mem_program() */
+struct xlnxw1_mem_job {
+	struct xlnxw1 *w1;
+	const uint8_t *rom;			/* NULL for the only device of the bus */
+	const struct w1_mem_type *type;		/* NULL to look it up from rom */
+	uint16_t addr;
+	const uint8_t *data;
+	size_t len;
+	int error;				/* Result of the job */
+	/* Private */
+	size_t done;				/* Bytes programmed */
+	int busy;				/* A page is being copied */
+	int retries;
+	uint64_t deadline_ms;			/* End of its tPROG */
+};
+
+/************************** Function Prototypes ****************************/
+/**
+ *
+ * Open the character device.
+ *
+ * @param   w1 is the handle to initialize.
+ *          path is the device node, NULL for XLNX_W1_DEVICE_NAME.
+ *
+ * @return  0 or a negative errno (-EBUSY if the device is already open)
+ *
+ */
+int xlnxw1_open(struct xlnxw1 *w1, const char *path);
+void xlnxw1_close(struct xlnxw1 *w1);
+
+/*
+ * Bus primitives, one ioctl each. They are meant for the algorithms where
+ * every bit depends on the previous ones, as the ROM search; anything else
+ * should be a transaction. xlnxw1_end() ends a transaction made of them, the
+ * priority lane of xlnxw1_pio_write() taking the bus only in between.
+ */
+int xlnxw1_reset_bus(struct xlnxw1 *w1);
+int xlnxw1_read_bit(struct xlnxw1 *w1, uint8_t *bit);
+int xlnxw1_write_bit(struct xlnxw1 *w1, uint8_t bit);
+int xlnxw1_read_byte(struct xlnxw1 *w1, uint8_t *byte);
+int xlnxw1_write_byte(struct xlnxw1 *w1, uint8_t byte);
+int xlnxw1_end(struct xlnxw1 *w1);
+
+/*
+ * Transaction builder. xlnxw1_txn_write() copies buf, xlnxw1_txn_read()
+ * keeps buf, which must stay valid until xlnxw1_submit() returns. rom is
+ * the 8 bytes ROM ID as read from the bus, NULL to address the only device
+ * of the bus (Skip ROM).
+ */
+void xlnxw1_txn_init(struct xlnxw1_txn *txn);
+void xlnxw1_txn_reset(struct xlnxw1_txn *txn);
+void xlnxw1_txn_select(struct xlnxw1_txn *txn, const uint8_t *rom);
+void xlnxw1_txn_write(struct xlnxw1_txn *txn, const void *buf, size_t len);
+void xlnxw1_txn_write_byte(struct xlnxw1_txn *txn, uint8_t byte);
+void xlnxw1_txn_read(struct xlnxw1_txn *txn, void *buf, size_t len);
+void xlnxw1_txn_wait_one(struct xlnxw1_txn *txn, unsigned int timeout_ms);
+void xlnxw1_txn_delay(struct xlnxw1_txn *txn, unsigned int ms);
+/*
+ * Wait for the end of a conversion without spinning on read slots: the
+ * driver sleeps tconv_ms with the bus free for other transactions, then
+ * confirms with a read slot. Fails with -ETIMEDOUT after twice tconv_ms.
+ */
+void xlnxw1_txn_wait_conversion(struct xlnxw1_txn *txn, unsigned int tconv_ms);
+
+/**
+ *
+ * Run a transaction, then end it (xlnxw1_end()). The transaction is left
+ * untouched and can be submitted again, e.g. by a periodic sampling loop.
+ *
+ * @param   w1 is the device handle.
+ *          txn is the transaction to run.
+ *
+ * @return  0, the builder error, or the error of the first failing operation
+ *
+ */
+int xlnxw1_submit(struct xlnxw1 *w1, const struct xlnxw1_txn *txn);
+
+/**
+ *
+ * Enumerate the devices of the bus with the Search ROM algorithm.
+ *
+ * @param   w1 is the device handle.
+ *          cmd is W1_SEARCH_ROM, or W1_ALARM_SEARCH for the devices in alarm only.
+ *          roms receives up to max ROM IDs, 8 bytes each.
+ *          max is the size of roms, in ROM IDs.
+ *
+ * @return  the number of ROM IDs found (CRC checked), or a negative errno
+ *
+ */
+int xlnxw1_search(struct xlnxw1 *w1, uint8_t cmd, uint8_t (*roms)[8], int max);
+
+/*
+ * Search ROM one device at a time. Each call runs one pass from the last
+ * discrepancy of the previous one, so a caller can spread an enumeration over
+ * time to notice the devices plugged in.
+ */
+void xlnxw1_search_init(struct xlnxw1_search *search);
+/**
+ *
+ * Find the next device of a search.
+ *
+ * @param   w1 is the device handle.
+ *          cmd is W1_SEARCH_ROM or W1_ALARM_SEARCH.
+ *          search is the state, initialized by xlnxw1_search_init().
+ *
+ * @return  1 with the ROM ID in search->rom, 0 at the end of the search (the
+ *          state is restarted), -EIO for a corrupted ROM ID (the search can
+ *          go on), or a negative errno
+ *
+ */
+int xlnxw1_search_next(struct xlnxw1 *w1, uint8_t cmd, struct xlnxw1_search *search);
+/* Tell if a device is on the bus with a single Search ROM pass along its ROM ID: 0 or -ENODEV */
+int xlnxw1_verify(struct xlnxw1 *w1, const uint8_t rom[8]);
+
+/**
+ *
+ * Load the ROM ID table of the IP, in the entries 0 to n - 1. xlnxw1_search()
+ * does it for W1_SEARCH_ROM; a caller enumerating otherwise, or from the ROM
+ * cache, loads the table itself.
+ *
+ * @param   w1 is the device handle.
+ *          roms is the ROM IDs.
+ *          n is the number of ROM IDs.
+ *
+ * @return  0, -EOPNOTSUPP without ROM ID table, -E2BIG if n is larger than
+ *          it, or a negative errno
+ *
+ */
+int xlnxw1_rom_table_load(struct xlnxw1 *w1, uint8_t (*roms)[8], int n);
+/**
+ *
+ * Tell which devices of the ROM ID table are on the bus, with a single
+ * PING_ALL instruction: a Search ROM pass along each ROM ID, as
+ * xlnxw1_verify() does with 192 ioctls per device.
+ *
+ * @param   w1 is the device handle.
+ *          found receives a bit per entry loaded, set if the device answered.
+ *
+ * @return  0, -EOPNOTSUPP if no table is loaded, or a negative errno
+ *
+ */
+int xlnxw1_ping_all(struct xlnxw1 *w1, uint64_t *found);
+
+/*
+ * ROM cache: a text file with a ROM ID per line, 16 hex digits from the
+ * family code, so that a restart can skip the enumeration of the bus.
+ */
+/* Returns the number of ROM IDs read (CRC checked), or a negative errno */
+int xlnxw1_rom_cache_load(const char *path, uint8_t (*roms)[8], int max);
+/* Replaces the file atomically. Returns 0 or a negative errno */
+int xlnxw1_rom_cache_save(const char *path, uint8_t (*roms)[8], int n);
+
+/*
+ * Device family helpers.
+ */
+/* ROM ID of the only device of the bus, CRC checked (-EIO) */
+int xlnxw1_read_rom(struct xlnxw1 *w1, uint8_t rom[8]);
+/*
+ * Start a temperature conversion and wait for its end. resolution (9 to 12
+ * bits, 0 if unknown) sets the conversion time to wait, see
+ * w1_temp_conv_time_ms().
+ */
+int xlnxw1_ds18b20_convert(struct xlnxw1 *w1, const uint8_t *rom, int resolution);
+/*
+ * Read the first len bytes of the scratchpad. A full read (9 bytes) is CRC
+ * checked (-EIO), a shorter one ends with a reset.
+ */
+int xlnxw1_ds18b20_read_scratchpad(struct xlnxw1 *w1, const uint8_t *rom,
+				   uint8_t *scratchpad, size_t len);
+/* Write the TH, TL and configuration bytes */
+int xlnxw1_ds18b20_write_scratchpad(struct xlnxw1 *w1, const uint8_t *rom,
+				    uint8_t th, uint8_t tl, uint8_t config);
+
+/*
+ * EEPROMs with a CRC-16 protected scratchpad, the DS2431 and the DS28EC20
+ * (w1_mem.h).
+ */
+/* Read len bytes from addr with one Read Memory transaction */
+int xlnxw1_mem_read(struct xlnxw1 *w1, const uint8_t *rom, uint16_t addr, void *buf,
+		    size_t len);
+/**
+ *
+ * Program several EEPROMs at once. A page is written to the scratchpad in
+ * one transaction with its CRC-16 and read back in the same one, retried if
+ * it does not match, then copied. The bus of a device must stay idle while
+ * it programs the page (tPROG, 10 ms), so the jobs of a handle run one after
+ * the other, but the copies of the devices on other handles go on meanwhile:
+ * n buses are programmed in about the time of the largest image. A job ends
+ * with a Read Memory of its range compared with the data.
+ *
+ * The partial pages at the ends of a range are read first and completed with
+ * the memory contents.
+ *
+ * @param   jobs is the ranges to program, their error field receives the
+ *          result of each one.
+ *          n is the number of jobs.
+ *
+ * @return  0, or the error of the first job failing: -EINVAL for a range
+ *          outside the memory or an unknown device, -EIO for a page whose
+ *          scratchpad or copy could not be verified, or a negative errno
+ *
+ */
+int xlnxw1_mem_program(struct xlnxw1_mem_job *jobs, int n);
+/* Program a single range, a job of its own, the device type given by rom */
+int xlnxw1_mem_write(struct xlnxw1 *w1, const uint8_t *rom, uint16_t addr, const void *data,
+		     size_t len);
+
+/*
+ * DS2413 and DS2408 switches.
+ */
+/**
+ *
+ * Set the PIO output latch of a switch (PIOA bit 0, PIOB bit 1 on the
+ * DS2413, whose other bits are written as 1). The Match ROM, PIO Access
+ * Write and confirmation run as a single XLNX_IOCTL_PIO_WRITE on the
+ * priority lane of the driver, which takes the bus at the end of the
+ * transaction in progress, never within it. It may then be called from a
+ * thread of its own while another thread runs transactions on the handle.
+ * With a driver without the ioctl (w1->has_pio_write is 0) it is a
+ * transaction of its own, without priority, to run from the thread of the
+ * other transactions of the handle.
+ *
+ * @param   rom is the ROM ID of the switch.
+ *          value is the latch byte.
+ *          state receives the PIO status byte read back, NULL if not needed.
+ *
+ * @return  0, -EIO if the switch did not confirm (the latch is unchanged), or
+ *          a negative errno
+ *
+ */
+int xlnxw1_pio_write(struct xlnxw1 *w1, const uint8_t rom[8], uint8_t value, uint8_t *state);
+
+#endif /* LIBXLNXW1_H */
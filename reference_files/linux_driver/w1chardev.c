@@ -10,6 +10,10 @@ SPDX-License-Identifier: MIT
 #include <linux/interrupt.h>
 #include <linux/types.h>
 #include <linux/wait.h>
+#include <linux/mutex.h>
+#include <linux/delay.h>
+#include <linux/jiffies.h>
+#include <linux/ktime.h>
 #include <asm/atomic.h>
 
 #include <linux/of_address.h>
@@ -20,11 +24,13 @@ SPDX-License-Identifier: MIT
 #include <linux/fs.h>
 #include <linux/device.h>
 
-#define XLNX_IOCTL_RESET_BUS 	_IOR('k', 0, int)
-#define XLNX_IOCTL_READ_BIT 	_IOR('k', 1, int)
-#define XLNX_IOCTL_WRITE_BIT 	_IOW('k', 2, int)
-#define XLNX_IOCTL_READ_BYTE 	_IOR('k', 3, int)
-#define XLNX_IOCTL_WRITE_BYTE	_IOW('k', 4, int)
+#include "xlnxw1_ioctl.h"
+
+#define CREATE_TRACE_POINTS
+#define XLNXW1_TRACE_CHARDEV
+#include "xlnxw1_trace.h"
+#include "xlnxw1_stats.h"
+#include "w1_caps.h"
 
 
 /* 1-wire XLNX IP definition */
@@ -34,16 +40,28 @@ SPDX-License-Identifier: MIT
 #define AXIW1_IRQE_REG	0x8
 #define AXIW1_STAT_REG 	0xC
 #define AXIW1_DATA_REG 	0x10
+#define AXIW1_ROMIDX_REG	0x4C
+#define AXIW1_ROMLO_REG	0x50
+#define AXIW1_ROMHI_REG	0x54
+#define AXIW1_PING0_REG	0x58
+#define AXIW1_PING1_REG	0x5C
+#define AXIW1_POLL_REG	0x60
 // Instructions
 #define AXIW1_READBIT 	0x00000C00
 #define AXIW1_WRITEBIT 	0x00000E00
 #define AXIW1_READBYTE 	0x00000D00
 #define AXIW1_WRITEBYTE	0x00000F00
 #define AXIW1_INITPRES 	0x00000800
+#define AXIW1_SELECTROM	0x00000A00
+#define AXIW1_PINGALL	0x00000600
+#define AXIW1_POLLBIT	0x00000700
 // Status flag masks
 #define AXIW1_DONE 		0x00000001
 #define AXIW1_READY		0x00000010
 #define AXI_PRESENCE	0x80000000
+// POLL register fields
+#define AXIW1_POLL_MAX	0xFFFF
+#define AXIW1_POLL_INTERVAL_SHIFT	16
 // Control flag
 #define AXIW1_GO 		0x00000001
 #define AXI_CLEAR 		0x00000000
@@ -52,6 +70,11 @@ SPDX-License-Identifier: MIT
 #define AXIW1_READY_IRQ_EN 	0x00000010
 #define AXIW1_DONE_IRQ_EN 	0x00000001
 
+/* 1-Wire commands of the PIO Access Write sequence (DS2413, DS2408) */
+#define W1_MATCH_ROM		0x55
+#define W1_PIO_ACCESS_WRITE	0x5A
+#define W1_PIO_CONFIRM		0xAA
+
 #define DEVICE_NAME "xlnx_w1"
 #define CLASS_NAME "xlnx_w1_class"
 static int major_num;
@@ -62,6 +85,33 @@ static void __iomem *xlnxw1_base_register;
 static int device_in_use = 0;
 static wait_queue_head_t wait_queue;
 static atomic_t flag;
+/* Serializes the bus operations of the threads sharing the device */
+static DEFINE_MUTEX(bus_lock);
+/* Platform device naming the traces, and the primitive in progress */
+static struct device *xlnxw1_dev;
+static struct xlnxw1_stats stats;
+static u32 op_instr;
+static u64 op_start_ns;
+static u64 op_issue_ns;
+static u8 op_flags;
+/* W1_CAP_* of the IP, read at probe */
+static u32 caps;
+/* Entries of the ROM ID table of the IP, 0 without */
+static u32 rom_table_size;
+/*
+ * Priority lane of XLNX_IOCTL_PIO_WRITE: the calls waiting for the bus, the
+ * transactions starting after them. txn_open is set from the reset of a
+ * transaction up to its end, see XLNX_IOCTL_TXN_END. txn_end_seen once the
+ * user ends its transactions so, its resets no more ending them.
+ */
+static atomic_t prio_pending = ATOMIC_INIT(0);
+static DECLARE_WAIT_QUEUE_HEAD(prio_wq);
+static bool txn_open;
+static bool txn_end_seen;
+
+static unsigned int bus_trace;
+module_param(bus_trace, uint, 0444);
+MODULE_PARM_DESC(bus_trace, "Records of the bus trace in debugfs, 0 for none");
 
 #define DRIVER_NAME "xlnxw1"
 
@@ -86,44 +136,364 @@ static inline u32 xlnxw1_read_register(u8 reg_offset)
 	return val;
 };
 
-static long xlnxw1_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+/* Start of a primitive, before its READY wait */
+static void xlnxw1_op_begin(u32 instr)
 {
-	u8 val = 0;
-	switch (cmd)
+	op_instr = instr;
+	op_start_ns = ktime_get_ns();
+	op_flags = 0;
+}
+
+/* Instruction written with GO, the bus time starts */
+static void xlnxw1_op_issue(void)
+{
+	xlnxw1_write_register(AXIW1_INST_REG, op_instr);
+	xlnxw1_write_register(AXIW1_CTRL_REG, AXIW1_GO);
+	op_issue_ns = ktime_get_ns();
+	trace_xlnxw1_issue(xlnxw1_dev, op_instr);
+}
+
+static void xlnxw1_op_end(u32 val)
+{
+	u64 end_ns = ktime_get_ns();
+	u64 lat_ns = end_ns - op_start_ns;
+
+	xlnxw1_stats_add(&stats, op_instr, lat_ns);
+	xlnxw1_stats_trace(&stats, op_start_ns, op_issue_ns, end_ns, op_instr, val, op_flags);
+	trace_xlnxw1_complete(xlnxw1_dev, op_instr, val, 0, lat_ns);
+}
+
+// Wait for READY signal to be 1 to ensure 1-wire IP is ready
+static void xlnxw1_wait_ready(void)
+{
+	while((xlnxw1_read_register(AXIW1_STAT_REG) & AXIW1_READY) == 0)
 	{
-	case XLNX_IOCTL_RESET_BUS:
-		// Reset 1-wire Axi IP
-		xlnxw1_write_register(AXIW1_CTRL_REG, AXI_RESET);
-		// Wait for READY signal to be 1 to ensure 1-wire IP is ready
-		while((xlnxw1_read_register(AXIW1_STAT_REG) & AXIW1_READY) == 0)
-		{
-			// Enable the ready signal interrupt
-			xlnxw1_write_register(AXIW1_IRQE_REG, AXIW1_READY_IRQ_EN);
-			wait_event_interruptible(wait_queue, atomic_read(&flag) != 0);
-			atomic_set(&flag, 0);
+		trace_xlnxw1_ready_wait(xlnxw1_dev, op_instr);
+		// Enable the ready signal interrupt
+		xlnxw1_write_register(AXIW1_IRQE_REG, AXIW1_READY_IRQ_EN);
+		wait_event_interruptible(wait_queue, atomic_read(&flag) != 0);
+		atomic_set(&flag, 0);
+	}
+}
+
+// Wait for Done signal to be 1
+static void xlnxw1_wait_done(void)
+{
+	while((xlnxw1_read_register(AXIW1_STAT_REG) & AXIW1_DONE) != 1)
+	{
+		trace_xlnxw1_done_wait(xlnxw1_dev, op_instr);
+		op_flags |= W1_TRACE_IRQ;
+		// Enable the done signal interrupt
+		xlnxw1_write_register(AXIW1_IRQE_REG, AXIW1_DONE_IRQ_EN);
+		wait_event_interruptible(wait_queue, atomic_read(&flag) != 0);
+		atomic_set(&flag, 0);
+	}
+}
+
+static u8 xlnxw1_read_bit(void)
+{
+	u8 val;
+
+	xlnxw1_op_begin(AXIW1_READBIT);
+	xlnxw1_wait_ready();
+	
+	// Write read Bit command in register 0, and Go signal in register 1
+	xlnxw1_op_issue();
+	
+	xlnxw1_wait_done();
+	
+	// Retrieve LSB bit in register 3 to get RX byte
+	val = (u8) (xlnxw1_read_register(AXIW1_DATA_REG) & 0x00000001);
+	
+	// Clear Go signal in register 1
+	xlnxw1_write_register(AXIW1_CTRL_REG, AXI_CLEAR);
+	xlnxw1_op_end(val);
+	return val;
+}
+
+/* Reset and presence pulse. Returns 0 if a device answered, 1 otherwise */
+static u8 xlnxw1_reset(void)
+{
+	u8 val = 0;
+
+	xlnxw1_op_begin(AXIW1_INITPRES);
+	// Reset 1-wire Axi IP
+	xlnxw1_write_register(AXIW1_CTRL_REG, AXI_RESET);
+	xlnxw1_wait_ready();
+	
+	// Write Initialization command in register 0, and Go signal in register 1
+	xlnxw1_op_issue();
+	
+	xlnxw1_wait_done();
+	
+	// Retrieve MSB bit in register 2 to get failure bit
+	if ((xlnxw1_read_register(AXIW1_STAT_REG) & AXI_PRESENCE) != 0) {
+		stats.presence_failures++;
+		val = 1;
+	}
+	// Clear Go signal in register 1
+	xlnxw1_write_register(AXIW1_CTRL_REG, AXI_CLEAR);
+	xlnxw1_op_end(val);
+	return val;
+}
+
+static u8 xlnxw1_read_byte(void)
+{
+	u8 val;
+
+	xlnxw1_op_begin(AXIW1_READBYTE);
+	xlnxw1_wait_ready();
+	
+	// Write read Byte command in register 0, and Go signal in register 1
+	xlnxw1_op_issue();
+	
+	xlnxw1_wait_done();
+	
+	// Retrieve LSB bit in register 3 to get RX byte
+	val = (u8) (xlnxw1_read_register(AXIW1_DATA_REG) & 0x000000FF);
+	
+	// Clear Go signal in register 1
+	xlnxw1_write_register(AXIW1_CTRL_REG, AXI_CLEAR);
+	xlnxw1_op_end(val);
+	return val;
+}
+
+static void xlnxw1_write_byte(u8 val)
+{
+	xlnxw1_op_begin(AXIW1_WRITEBYTE + val);
+	xlnxw1_wait_ready();
+	
+	// Write tx Byte command in register 0 with byte to transmit, and Go signal in register 1
+	xlnxw1_op_issue();
+	
+	xlnxw1_wait_done();
+	
+	// Clear Go signal in register 1
+	xlnxw1_write_register(AXIW1_CTRL_REG, AXI_CLEAR);
+	xlnxw1_op_end(val);
+}
+
+/*
+ * Sequenced instruction (ROM ID table, POLL_BIT), DONE raised once at the
+ * end. Returns the status. Like the DMA blocks of amd_axi_w1, it is not in
+ * the latency statistics nor in the bus trace.
+ */
+static u32 xlnxw1_seq_instr(u32 instr)
+{
+	u32 stat;
+
+	op_instr = instr;
+	xlnxw1_wait_ready();
+	xlnxw1_write_register(AXIW1_INST_REG, instr);
+	xlnxw1_write_register(AXIW1_CTRL_REG, AXIW1_GO);
+	xlnxw1_wait_done();
+	stat = xlnxw1_read_register(AXIW1_STAT_REG);
+	xlnxw1_write_register(AXIW1_CTRL_REG, AXI_CLEAR);
+	return stat;
+}
+
+/*
+ * Read slots interval_us apart until one reads 1, slots at most, in the IP:
+ * the caller sleeps until the DONE interrupt. Returns 0 or -ETIMEDOUT.
+ */
+static long xlnxw1_poll_bit(u32 interval_us, u32 slots)
+{
+	u32 stat;
+
+	slots = clamp_t(u32, slots, 1, AXIW1_POLL_MAX);
+	xlnxw1_write_register(AXIW1_POLL_REG,
+			      min_t(u32, interval_us, AXIW1_POLL_MAX) << AXIW1_POLL_INTERVAL_SHIFT |
+			      slots);
+	// The failure bit is set if the last slot still read 0
+	stat = xlnxw1_seq_instr(AXIW1_POLLBIT);
+	if (stat & AXI_PRESENCE) {
+		stats.timeouts++;
+		return -ETIMEDOUT;
+	}
+	return 0;
+}
+
+/* End of the transaction of the caller, wakes the priority lane */
+static void xlnxw1_txn_end(void)
+{
+	WRITE_ONCE(txn_open, false);
+	wake_up_all(&prio_wq);
+}
+
+/*
+ * Take the bus for the priority lane, between two transactions only: the
+ * ones starting meanwhile wait in xlnxw1_txn_start(), the one on the bus
+ * goes on up to its end. Returns 0 with bus_lock held, or -EINTR.
+ */
+static long xlnxw1_prio_lock(void)
+{
+	atomic_inc(&prio_pending);
+	while (1) {
+		mutex_lock(&bus_lock);
+		if (!txn_open)
+			return 0;
+		mutex_unlock(&bus_lock);
+		if (wait_event_interruptible(prio_wq, !READ_ONCE(txn_open))) {
+			if (atomic_dec_and_test(&prio_pending))
+				wake_up_all(&prio_wq);
+			return -EINTR;
 		}
-		
-		// Write Initialization command in register 0
-		xlnxw1_write_register(AXIW1_INST_REG, AXIW1_INITPRES);
-		// Write Go signal and clear control reset signal in register 1
-		xlnxw1_write_register(AXIW1_CTRL_REG, AXIW1_GO);
-		
-		// Wait for Done signal to be 1
-		while((xlnxw1_read_register(AXIW1_STAT_REG) & AXIW1_DONE) != 1)
-		{
-			// Enable the done signal interrupt
-			xlnxw1_write_register(AXIW1_IRQE_REG, AXIW1_DONE_IRQ_EN);
-			wait_event_interruptible(wait_queue, atomic_read(&flag) != 0);
-			atomic_set(&flag, 0);
+	}
+}
+
+static void xlnxw1_prio_unlock(void)
+{
+	xlnxw1_txn_end();
+	mutex_unlock(&bus_lock);
+	if (atomic_dec_and_test(&prio_pending))
+		wake_up_all(&prio_wq);
+}
+
+/* A primitive starting a transaction gives way to the pending actuations */
+static long xlnxw1_txn_start(void)
+{
+	// A reset within a transaction, e.g. before a Resume
+	if (READ_ONCE(txn_open) && READ_ONCE(txn_end_seen))
+		return 0;
+	xlnxw1_txn_end();
+	if (wait_event_interruptible(prio_wq, atomic_read(&prio_pending) == 0))
+		return -EINTR;
+	return 0;
+}
+
+/* PIO Access Write of a DS2413/DS2408, see XLNX_IOCTL_PIO_WRITE */
+static long xlnxw1_pio_write(unsigned long arg)
+{
+	struct xlnx_w1_pio pio;
+	u64 start_ns = ktime_get_ns();
+	long ret = 0;
+	u8 val;
+	int i;
+
+	if(copy_from_user(&pio, (struct xlnx_w1_pio *) arg, sizeof(pio)))
+	{
+		return -EFAULT;
+	}
+	if (pio.entry != XLNX_W1_PIO_NO_ENTRY && pio.entry >= rom_table_size)
+		return -EINVAL;
+	if (xlnxw1_prio_lock())
+		return -EINTR;
+	pio.wait_us = (u32)div_u64(ktime_get_ns() - start_ns, NSEC_PER_USEC);
+
+	if (pio.entry != XLNX_W1_PIO_NO_ENTRY) {
+		val = (xlnxw1_seq_instr(AXIW1_SELECTROM + pio.entry) & AXI_PRESENCE) != 0;
+		if (val)
+			stats.presence_failures++;
+	} else {
+		val = xlnxw1_reset();
+		if (!val) {
+			xlnxw1_write_byte(W1_MATCH_ROM);
+			for (i = 0; i < 8; i++)
+				xlnxw1_write_byte(pio.rom[i]);
 		}
-		
-		// Retrieve MSB bit in register 2 to get failure bit
-		if ((xlnxw1_read_register(AXIW1_STAT_REG) & AXI_PRESENCE) != 0) {
-			val = 1;
+	}
+	if (val) {
+		ret = -ENODEV;
+	} else {
+		// The latch changes once the complement is received
+		xlnxw1_write_byte(W1_PIO_ACCESS_WRITE);
+		xlnxw1_write_byte(pio.value);
+		xlnxw1_write_byte((u8)~pio.value);
+		pio.confirm = xlnxw1_read_byte();
+		pio.state = xlnxw1_read_byte();
+		// The device sends the PIO state until a reset
+		xlnxw1_reset();
+		if (pio.confirm != W1_PIO_CONFIRM)
+			ret = -EIO;
+	}
+	xlnxw1_prio_unlock();
+
+	if(copy_to_user((struct xlnx_w1_pio *) arg, &pio, sizeof(pio)))
+	{
+		return -EFAULT;
+	}
+	return ret;
+}
+
+/*
+ * Sleep for the conversion time without holding the bus, then read slots
+ * until the device releases the bus (reads 1).
+ */
+static long xlnxw1_wait_conversion(unsigned long arg)
+{
+	unsigned long deadline;
+	u32 tconv;
+	long ret;
+	u8 val;
+
+	if(copy_from_user(&tconv, (u32 *) arg, sizeof(u32)))
+	{
+		return -EFAULT;
+	}
+	// The conversion ends the transaction, an actuation may take the bus
+	xlnxw1_txn_end();
+	if (msleep_interruptible(tconv))
+		return -EINTR;
+
+	if (caps & W1_CAP_POLL_BIT) {
+		mutex_lock(&bus_lock);
+		ret = xlnxw1_poll_bit(XLNX_W1_CONV_POLL_MS * 1000, tconv / XLNX_W1_CONV_POLL_MS + 1);
+		mutex_unlock(&bus_lock);
+		return ret;
+	}
+
+	deadline = jiffies + msecs_to_jiffies(tconv);
+	while (1)
+	{
+		mutex_lock(&bus_lock);
+		val = xlnxw1_read_bit();
+		mutex_unlock(&bus_lock);
+		if (val)
+			return 0;
+		if (time_after(jiffies, deadline)) {
+			stats.timeouts++;
+			return -ETIMEDOUT;
 		}
-		// Clear Go signal in register 1
-		xlnxw1_write_register(AXIW1_CTRL_REG, AXI_CLEAR);
+		if (msleep_interruptible(XLNX_W1_CONV_POLL_MS))
+			return -EINTR;
+	}
+}
+
+static long xlnxw1_rom_table_load(unsigned long arg)
+{
+	struct xlnx_w1_rom_table __user *table = (struct xlnx_w1_rom_table __user *) arg;
+	u8 rom[8];
+	u32 count, i;
+
+	if (get_user(count, &table->count) || put_user(rom_table_size, &table->size))
+		return -EFAULT;
+	if (!rom_table_size)
+		return -EOPNOTSUPP;
+	if (count > rom_table_size)
+		return -EINVAL;
 
+	for (i = 0; i < count; i++) {
+		if (copy_from_user(rom, table->rom[i], sizeof(rom)))
+			return -EFAULT;
+		xlnxw1_write_register(AXIW1_ROMIDX_REG, i);
+		xlnxw1_write_register(AXIW1_ROMLO_REG, rom[0] | rom[1] << 8 | rom[2] << 16 |
+				      (u32)rom[3] << 24);
+		// Writing ROMHI stores the entry
+		xlnxw1_write_register(AXIW1_ROMHI_REG, rom[4] | rom[5] << 8 | rom[6] << 16 |
+				      (u32)rom[7] << 24);
+	}
+	return 0;
+}
+
+static long xlnxw1_bus_ioctl(unsigned int cmd, unsigned long arg)
+{
+	u64 found;
+	u32 timeout;
+	u8 val = 0;
+	switch (cmd)
+	{
+	case XLNX_IOCTL_RESET_BUS:
+		val = xlnxw1_reset();
 		if(copy_to_user((u8 *) arg, &val, sizeof(u8)))
 		{
 			return -EFAULT;
@@ -131,34 +501,7 @@ static long xlnxw1_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 		break;
 	
 	case XLNX_IOCTL_READ_BIT:
-		// Wait for READY signal to be 1 to ensure 1-wire IP is ready
-		while((xlnxw1_read_register(AXIW1_STAT_REG) & AXIW1_READY) == 0)
-		{
-			// Enable the ready signal interrupt
-			xlnxw1_write_register(AXIW1_IRQE_REG, AXIW1_READY_IRQ_EN);
-			wait_event_interruptible(wait_queue, atomic_read(&flag) != 0);
-			atomic_set(&flag, 0);
-		}
-		
-		// Write read Bit command in register 0
-		xlnxw1_write_register(AXIW1_INST_REG, AXIW1_READBIT);
-		// Write Go signal and clear control reset signal in register 1
-		xlnxw1_write_register(AXIW1_CTRL_REG, AXIW1_GO);
-		
-		// Wait for Done signal to be 1
-		while((xlnxw1_read_register(AXIW1_STAT_REG) & AXIW1_DONE) != 1)
-		{
-			// Enable the done signal interrupt
-			xlnxw1_write_register(AXIW1_IRQE_REG, AXIW1_DONE_IRQ_EN);
-			wait_event_interruptible(wait_queue, atomic_read(&flag) != 0);
-			atomic_set(&flag, 0);
-		}
-		
-		// Retrieve LSB bit in register 3 to get RX byte
-		val = (u8) (xlnxw1_read_register(AXIW1_DATA_REG) & 0x00000001);
-		
-		// Clear Go signal in register 1
-		xlnxw1_write_register(AXIW1_CTRL_REG, AXI_CLEAR);
+		val = xlnxw1_read_bit();
 		
 		if(copy_to_user((u8 *) arg, &val, sizeof(u8)))
 		{
@@ -171,62 +514,21 @@ static long xlnxw1_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 		{
 			return -EFAULT;
 		}
-		// Wait for READY signal to be 1 to ensure 1-wire IP is ready
-		while((xlnxw1_read_register(AXIW1_STAT_REG) & AXIW1_READY) == 0)
-		{
-			// Enable the ready signal interrupt
-			xlnxw1_write_register(AXIW1_IRQE_REG, AXIW1_READY_IRQ_EN);
-			wait_event_interruptible(wait_queue, atomic_read(&flag) != 0);
-			atomic_set(&flag, 0);
-		}
+		xlnxw1_op_begin(AXIW1_WRITEBIT + (val & 0x01));
+		xlnxw1_wait_ready();
 		
-		// Write tx Byte command in register 0 with bit to transmit
-		xlnxw1_write_register(AXIW1_INST_REG, (AXIW1_WRITEBIT + (val & 0x01)));
-		// Write Go signal and clear control reset signal in register 1
-		xlnxw1_write_register(AXIW1_CTRL_REG, AXIW1_GO);
+		// Write tx Bit command in register 0 with bit to transmit, and Go signal in register 1
+		xlnxw1_op_issue();
 		
-		// Wait for Done signal to be 1
-		while((xlnxw1_read_register(AXIW1_STAT_REG) & AXIW1_DONE) != 1)
-		{
-			// Enable the done signal interrupt
-			xlnxw1_write_register(AXIW1_IRQE_REG, AXIW1_DONE_IRQ_EN);
-			wait_event_interruptible(wait_queue, atomic_read(&flag) != 0);
-			atomic_set(&flag, 0);
-		}
+		xlnxw1_wait_done();
 		
 		// Clear Go signal in register 1
 		xlnxw1_write_register(AXIW1_CTRL_REG, AXI_CLEAR);
+		xlnxw1_op_end(val);
 		break;
 
 	case XLNX_IOCTL_READ_BYTE:
-		// Wait for READY signal to be 1 to ensure 1-wire IP is ready
-		while((xlnxw1_read_register(AXIW1_STAT_REG) & AXIW1_READY) == 0)
-		{
-			// Enable the ready signal interrupt
-			xlnxw1_write_register(AXIW1_IRQE_REG, AXIW1_READY_IRQ_EN);
-			wait_event_interruptible(wait_queue, atomic_read(&flag) != 0);
-			atomic_set(&flag, 0);
-		}
-		
-		// Write read Byte command in register 0
-		xlnxw1_write_register(AXIW1_INST_REG, AXIW1_READBYTE);
-		// Write Go signal and clear control reset signal in register 1
-		xlnxw1_write_register(AXIW1_CTRL_REG, AXIW1_GO);
-		
-		// Wait for Done signal to be 1
-		while((xlnxw1_read_register(AXIW1_STAT_REG) & AXIW1_DONE) != 1)
-		{
-			// Enable the done signal interrupt
-			xlnxw1_write_register(AXIW1_IRQE_REG, AXIW1_DONE_IRQ_EN);
-			wait_event_interruptible(wait_queue, atomic_read(&flag) != 0);
-			atomic_set(&flag, 0);
-		}
-		
-		// Retrieve LSB bit in register 3 to get RX byte
-		val = (u8) (xlnxw1_read_register(AXIW1_DATA_REG) & 0x000000FF);
-		
-		// Clear Go signal in register 1
-		xlnxw1_write_register(AXIW1_CTRL_REG, AXI_CLEAR);
+		val = xlnxw1_read_byte();
 		
 		if(copy_to_user((u8 *) arg, &val, sizeof(u8)))
 		{
@@ -240,32 +542,57 @@ static long xlnxw1_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 		{
 			return -EFAULT;
 		}
-		// Wait for READY signal to be 1 to ensure 1-wire IP is ready
-		while((xlnxw1_read_register(AXIW1_STAT_REG) & AXIW1_READY) == 0)
+		xlnxw1_write_byte(val);
+		break;
+
+	case XLNX_IOCTL_ROM_TABLE_LOAD:
+		return xlnxw1_rom_table_load(arg);
+
+	case XLNX_IOCTL_SELECT_ROM:
+		if (!rom_table_size)
+			return -EOPNOTSUPP;
+		if(copy_from_user(&val, (u8 *) arg, sizeof(u8)))
 		{
-			// Enable the ready signal interrupt
-			xlnxw1_write_register(AXIW1_IRQE_REG, AXIW1_READY_IRQ_EN);
-			wait_event_interruptible(wait_queue, atomic_read(&flag) != 0);
-			atomic_set(&flag, 0);
+			return -EFAULT;
 		}
-		
-		// Write tx Byte command in register 0 with bit to transmit
-		xlnxw1_write_register(AXIW1_INST_REG, (AXIW1_WRITEBYTE + (val & 0xFF)));
-		// Write Go signal and clear control reset signal in register 1
-		xlnxw1_write_register(AXIW1_CTRL_REG, AXIW1_GO);
-		
-		// Wait for Done signal to be 1
-		while((xlnxw1_read_register(AXIW1_STAT_REG) & AXIW1_DONE) != 1)
+		if (val >= rom_table_size)
+			return -EINVAL;
+		// Failure bit set, and nothing sent after the reset, if no presence
+		val = (xlnxw1_seq_instr(AXIW1_SELECTROM + val) & AXI_PRESENCE) != 0;
+		if (val)
+			stats.presence_failures++;
+		if(copy_to_user((u8 *) arg, &val, sizeof(u8)))
 		{
-			// Enable the done signal interrupt
-			xlnxw1_write_register(AXIW1_IRQE_REG, AXIW1_DONE_IRQ_EN);
-			wait_event_interruptible(wait_queue, atomic_read(&flag) != 0);
-			atomic_set(&flag, 0);
+			return -EFAULT;
 		}
-		
-		// Clear Go signal in register 1
-		xlnxw1_write_register(AXIW1_CTRL_REG, AXI_CLEAR);
 		break;
+
+	case XLNX_IOCTL_PING_ALL:
+		if (!rom_table_size)
+			return -EOPNOTSUPP;
+		if(copy_from_user(&found, (u64 *) arg, sizeof(u64)))
+		{
+			return -EFAULT;
+		}
+		xlnxw1_seq_instr(AXIW1_PINGALL + (u32)min_t(u64, found, rom_table_size));
+		found = (u64)xlnxw1_read_register(AXIW1_PING1_REG) << 32 |
+			xlnxw1_read_register(AXIW1_PING0_REG);
+		if(copy_to_user((u64 *) arg, &found, sizeof(u64)))
+		{
+			return -EFAULT;
+		}
+		break;
+
+	case XLNX_IOCTL_WAIT_ONE:
+		if (!(caps & W1_CAP_POLL_BIT))
+			return -EOPNOTSUPP;
+		if(copy_from_user(&timeout, (u32 *) arg, sizeof(u32)))
+		{
+			return -EFAULT;
+		}
+		return xlnxw1_poll_bit(XLNX_W1_WAIT_ONE_POLL_US,
+				       min_t(u32, timeout, AXIW1_POLL_MAX) * 1000 /
+				       XLNX_W1_WAIT_ONE_POLL_US + 1);
 		
 	default:
 		return -EINVAL;
@@ -273,18 +600,50 @@ static long xlnxw1_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 	return 0;
 }
 
+static long xlnxw1_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+{
+	long ret;
+
+	if (cmd == XLNX_IOCTL_WAIT_CONVERSION)
+		return xlnxw1_wait_conversion(arg);
+	if (cmd == XLNX_IOCTL_PIO_WRITE)
+		return xlnxw1_pio_write(arg);
+	if (cmd == XLNX_IOCTL_TXN_END) {
+		WRITE_ONCE(txn_end_seen, true);
+		xlnxw1_txn_end();
+		return 0;
+	}
+
+	if (cmd == XLNX_IOCTL_RESET_BUS || cmd == XLNX_IOCTL_SELECT_ROM ||
+	    cmd == XLNX_IOCTL_PING_ALL) {
+		ret = xlnxw1_txn_start();
+		if (ret)
+			return ret;
+	}
+	mutex_lock(&bus_lock);
+	ret = xlnxw1_bus_ioctl(cmd, arg);
+	// PING_ALL leaves no device selected
+	if (cmd == XLNX_IOCTL_RESET_BUS || cmd == XLNX_IOCTL_SELECT_ROM)
+		txn_open = true;
+	mutex_unlock(&bus_lock);
+	return ret;
+}
+
 static int xlnxw1_open(struct inode *inode, struct file *file)
 {	
 	if (device_in_use) {
 		return -EBUSY;
 	}
 	device_in_use++;
+	txn_end_seen = false;
 	try_module_get(THIS_MODULE);
 	return 0;
 }
 
 static int xlnxw1_release(struct inode *inode, struct file *file)
 {
+	// A transaction left open by the user would hold the priority lane
+	xlnxw1_txn_end();
 	device_in_use--;
 	module_put(THIS_MODULE);
 	return 0;
@@ -299,8 +658,17 @@ struct file_operations Fops = {
 
 static irqreturn_t xlnxw1_irq(int irq, void *lp)
 {
+	u32 irqe = xlnxw1_read_register(AXIW1_IRQE_REG);
+	u32 stat = xlnxw1_read_register(AXIW1_STAT_REG);
+
+	// The IP raises its line for an enabled status only
+	if ((irqe & stat & (AXIW1_DONE | AXIW1_READY)) == 0) {
+		stats.spurious_irqs++;
+		return IRQ_NONE;
+	}
 	// Clear enables in IRQ enable register
 	xlnxw1_write_register(AXIW1_IRQE_REG, AXI_CLEAR);
+	trace_xlnxw1_irq(xlnxw1_dev, op_instr, irqe, stat);
 	// Wake up the waiting queue
 	atomic_set(&flag, 1);
 	wake_up_interruptible(&wait_queue);
@@ -308,6 +676,14 @@ static irqreturn_t xlnxw1_irq(int irq, void *lp)
 	return IRQ_HANDLED;
 }
 
+/* Register reader of w1_caps_detect(), before xlnxw1_base_register is set */
+static u32 xlnxw1_caps_read(void *data, u32 offset)
+{
+	struct xlnxw1_local *lp = data;
+
+	return ioread32(lp->base_addr + offset);
+}
+
 static int xlnxw1_probe(struct platform_device *pdev)
 {
 	struct device *dev = &pdev->dev;
@@ -362,8 +738,16 @@ static int xlnxw1_probe(struct platform_device *pdev)
 		return -ENODEV; 
 	}
 
+	// Optional features, from the CAPS register or the IP version
+	caps = w1_caps_detect(xlnxw1_caps_read, lp);
+	rom_table_size = W1_CAPS_ROM_ENTRIES(caps);
+	if (rom_table_size)
+		dev_info(dev, "xlnxw1 ROM ID table of %u entries\n", rom_table_size);
+
 	platform_set_drvdata(pdev, lp); 
 	xlnxw1_base_register = lp->base_addr; 
+	xlnxw1_dev = dev;
+	xlnxw1_stats_init(&stats, dev, bus_trace);
 	return 0; 
 }
 
@@ -371,6 +755,7 @@ static int xlnxw1_remove(struct platform_device *pdev)
 {
 	struct device *dev = &pdev->dev;
 	struct xlnxw1_local *lp = dev_get_drvdata(dev);
+	xlnxw1_stats_remove(&stats);
 	iounmap(lp->base_addr);
 	dev_set_drvdata(dev, NULL);
 	return 0;
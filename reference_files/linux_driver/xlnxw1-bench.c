@@ -0,0 +1,471 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+
+/*
+ * xlnxw1-bench: runs the workloads of w1_bench.h through one Linux access
+ * path and prints a JSON line per workload.
+ *
+ *   chardev  the character driver (w1chardev.c) through libxlnxw1, the
+ *            syscalls being the ioctl() and nanosleep() calls of the library
+ *   w1core   the 1-Wire subsystem driver (amd_axi_w1.c) through the sysfs
+ *            files of w1_therm and of the EEPROM slave drivers, the syscalls
+ *            being the open/read/write/close calls of this tool
+ *
+ * The IRQs are the ones of the "xlnxw1" lines of /proc/interrupts, the CPU
+ * time is the user and system time of the process. The w1 core has no
+ * synchronous search from user space (w1_master_search runs in its kernel
+ * thread), the w1core search workload is reported skipped.
+ *
+ * Usage: xlnxw1-bench [-p chardev|w1core] [-n iterations] [-w workload,...] [-d path]
+ *   -d  the device node (chardev), or the bus master sysfs directory (w1core)
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "libxlnxw1.h"
+#include "w1_bench.h"
+#include "w1_temp.h"
+
+#define BENCH_MAX_DEVICES	16
+#define BENCH_W1_DEVICES	"/sys/bus/w1/devices"
+#define BENCH_W1_MASTER		BENCH_W1_DEVICES "/w1_bus_master1"
+#define BENCH_PATH_SIZE		256
+
+#define W1_FAMILY_DS2431	0x2D
+#define W1_FAMILY_DS2433	0x23
+#define W1_FAMILY_DS28EC20	0x43
+#define W1_READ_MEMORY		0xF0
+
+struct bench_ctx {
+	int w1core;
+	const char *path;
+	struct xlnxw1 w1;		/* chardev */
+	unsigned long syscalls;		/* w1core */
+	int ndevices;
+	uint8_t roms[BENCH_MAX_DEVICES][8];
+	char names[BENCH_MAX_DEVICES][20];	/* w1core slave names, ff-xxxxxxxxxxxx */
+};
+
+static uint8_t eeprom[W1_BENCH_EEPROM_BYTES];
+
+static int is_temp_family(uint8_t family)
+{
+	return family == W1_FAMILY_DS18S20 || family == W1_FAMILY_DS1822 ||
+	       family == W1_FAMILY_DS18B20 || family == W1_FAMILY_MAX31850;
+}
+
+static int is_eeprom_family(uint8_t family)
+{
+	return family == W1_FAMILY_DS2431 || family == W1_FAMILY_DS2433 ||
+	       family == W1_FAMILY_DS28EC20;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t cpu_ns(void)
+{
+	struct rusage ru;
+
+	getrusage(RUSAGE_SELF, &ru);
+	return ((uint64_t)ru.ru_utime.tv_sec + (uint64_t)ru.ru_stime.tv_sec) * 1000000000 +
+	       ((uint64_t)ru.ru_utime.tv_usec + (uint64_t)ru.ru_stime.tv_usec) * 1000;
+}
+
+/* Sum of the "xlnxw1" lines of /proc/interrupts, W1_BENCH_NA if there is none */
+static uint64_t irq_count(void)
+{
+	char line[512], *p, *end;
+	uint64_t total = 0;
+	unsigned long n;
+	int found = 0;
+	FILE *f;
+
+	f = fopen("/proc/interrupts", "r");
+	if (f == NULL)
+		return W1_BENCH_NA;
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (strstr(line, "xlnxw1") == NULL)
+			continue;
+		p = strchr(line, ':');
+		if (p == NULL)
+			continue;
+		found = 1;
+		/* The per CPU counts follow the IRQ number */
+		for (p++;; p = end) {
+			n = strtoul(p, &end, 10);
+			if (end == p)
+				break;
+			total += n;
+		}
+	}
+	fclose(f);
+	return found ? total : W1_BENCH_NA;
+}
+
+/****************************** sysfs helpers ******************************/
+/* Read a sysfs file from its start, returns the length or a negative errno */
+static ssize_t sysfs_read(struct bench_ctx *ctx, const char *path, void *buf, size_t size)
+{
+	ssize_t len = 0, n;
+	int fd;
+
+	ctx->syscalls++;
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -errno;
+	while ((size_t)len < size) {
+		ctx->syscalls++;
+		n = read(fd, (char *)buf + len, size - len);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0) {
+			len = -errno;
+			break;
+		}
+		if (n == 0)
+			break;
+		len += n;
+	}
+	ctx->syscalls++;
+	close(fd);
+	return len;
+}
+
+static int sysfs_write(struct bench_ctx *ctx, const char *path, const char *val)
+{
+	int fd, ret = 0;
+
+	ctx->syscalls++;
+	fd = open(path, O_WRONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -errno;
+	ctx->syscalls++;
+	if (write(fd, val, strlen(val)) < 0)
+		ret = -errno;
+	ctx->syscalls++;
+	close(fd);
+	return ret;
+}
+
+/* w1_slave of w1_therm converts and reads, "crc=xx YES" if the CRC matched */
+static int w1core_read_sensor(struct bench_ctx *ctx, int dev, const char *file)
+{
+	char path[BENCH_PATH_SIZE], buf[128];
+	ssize_t len;
+
+	snprintf(path, sizeof(path), BENCH_W1_DEVICES "/%s/%s", ctx->names[dev], file);
+	len = sysfs_read(ctx, path, buf, sizeof(buf) - 1);
+	if (len < 0)
+		return (int)len;
+	buf[len] = '\0';
+	if (strcmp(file, "w1_slave") == 0 && strstr(buf, "YES") == NULL)
+		return -EIO;
+	return 0;
+}
+
+/* The EEPROM file of the slave from its start, wrapping around a smaller memory */
+static int w1core_read_eeprom(struct bench_ctx *ctx, int dev)
+{
+	char path[BENCH_PATH_SIZE];
+	size_t done = 0;
+	ssize_t n;
+	int fd, ret = 0;
+
+	snprintf(path, sizeof(path), BENCH_W1_DEVICES "/%s/eeprom", ctx->names[dev]);
+	ctx->syscalls++;
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -errno;
+	while (done < sizeof(eeprom)) {
+		ctx->syscalls++;
+		n = read(fd, &eeprom[done], sizeof(eeprom) - done);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0) {
+			ret = -errno;
+			break;
+		}
+		if (n == 0) {
+			if (done == 0) {
+				ret = -EIO;
+				break;
+			}
+			ctx->syscalls++;
+			lseek(fd, 0, SEEK_SET);
+		}
+		done += n;
+	}
+	ctx->syscalls++;
+	close(fd);
+	return ret;
+}
+
+/* The slaves the w1 core found, from w1_master_slaves */
+static int w1core_enumerate(struct bench_ctx *ctx)
+{
+	char path[BENCH_PATH_SIZE], buf[1024], *line, *save;
+	unsigned int family;
+	ssize_t len;
+	int i;
+
+	snprintf(path, sizeof(path), "%s/w1_master_slaves", ctx->path);
+	len = sysfs_read(ctx, path, buf, sizeof(buf) - 1);
+	if (len < 0)
+		return (int)len;
+	buf[len] = '\0';
+	ctx->ndevices = 0;
+	for (line = strtok_r(buf, "\n", &save); line != NULL && ctx->ndevices < BENCH_MAX_DEVICES;
+	     line = strtok_r(NULL, "\n", &save)) {
+		if (sscanf(line, "%2x-", &family) != 1)
+			continue;
+		/* The sysfs paths address the slaves, only the family of the ROM ID is used */
+		i = ctx->ndevices++;
+		snprintf(ctx->names[i], sizeof(ctx->names[i]), "%s", line);
+		ctx->roms[i][0] = (uint8_t)family;
+	}
+	return ctx->ndevices;
+}
+
+/******************************** Workloads ********************************/
+static int bench_sample(struct bench_ctx *ctx, int dev)
+{
+	uint8_t scratchpad[W1_SCRATCHPAD_SIZE];
+	int ret;
+
+	if (ctx->w1core)
+		return w1core_read_sensor(ctx, dev, "w1_slave");
+	ret = xlnxw1_ds18b20_convert(&ctx->w1, ctx->roms[dev], 0);
+	if (ret == 0)
+		ret = xlnxw1_ds18b20_read_scratchpad(&ctx->w1, ctx->roms[dev], scratchpad,
+						     sizeof(scratchpad));
+	return ret;
+}
+
+static int bench_sweep(struct bench_ctx *ctx)
+{
+	uint8_t scratchpad[W1_SCRATCHPAD_SIZE];
+	char path[BENCH_PATH_SIZE];
+	int i, ret, bulk = 0, errors = 0;
+
+	if (ctx->w1core) {
+		/* w1_therm converts all the sensors at once with therm_bulk_read */
+		snprintf(path, sizeof(path), "%s/therm_bulk_read", ctx->path);
+		bulk = sysfs_write(ctx, path, "trigger\n") == 0;
+	} else {
+		ret = xlnxw1_ds18b20_convert(&ctx->w1, NULL, 0);
+		if (ret != 0)
+			return ret;
+	}
+	for (i = 0; i < ctx->ndevices; i++) {
+		if (!is_temp_family(ctx->roms[i][0]))
+			continue;
+		if (ctx->w1core)
+			ret = w1core_read_sensor(ctx, i, bulk ? "temperature" : "w1_slave");
+		else
+			ret = xlnxw1_ds18b20_read_scratchpad(&ctx->w1, ctx->roms[i], scratchpad,
+							     sizeof(scratchpad));
+		errors |= ret != 0;
+	}
+	return errors ? -EIO : 0;
+}
+
+static int bench_search(struct bench_ctx *ctx)
+{
+	uint8_t roms[BENCH_MAX_DEVICES][8];
+	int n;
+
+	n = xlnxw1_search(&ctx->w1, W1_SEARCH_ROM, roms, BENCH_MAX_DEVICES);
+	if (n < 0)
+		return n;
+	return n == ctx->ndevices ? 0 : -EIO;
+}
+
+static int bench_eeprom(struct bench_ctx *ctx, int dev)
+{
+	struct xlnxw1_txn txn;
+	static const uint8_t cmd[3] = { W1_READ_MEMORY, 0x00, 0x00 };
+
+	if (ctx->w1core)
+		return w1core_read_eeprom(ctx, dev);
+	xlnxw1_txn_init(&txn);
+	xlnxw1_txn_reset(&txn);
+	xlnxw1_txn_select(&txn, ctx->roms[dev]);
+	xlnxw1_txn_write(&txn, cmd, sizeof(cmd));
+	xlnxw1_txn_read(&txn, eeprom, sizeof(eeprom));
+	return xlnxw1_submit(&ctx->w1, &txn);
+}
+
+static uint64_t bench_syscalls(struct bench_ctx *ctx)
+{
+	return ctx->w1core ? ctx->syscalls : ctx->w1.syscalls;
+}
+
+static void print_skipped(struct bench_ctx *ctx, const char *workload, const char *reason)
+{
+	char line[W1_BENCH_LINE_SIZE];
+
+	w1_bench_format_skipped(ctx->w1core ? "w1core" : "chardev", workload, reason,
+				line, sizeof(line));
+	printf("%s\n", line);
+}
+
+/* Run a workload, dev is the device it addresses or -1 */
+static int run(struct bench_ctx *ctx, const char *workload, int dev, unsigned int iterations,
+	       uint64_t *lat_ns)
+{
+	char line[W1_BENCH_LINE_SIZE];
+	struct w1_bench b;
+	uint64_t start, t0, t1, irqs, cpu, syscalls;
+	unsigned int i;
+	int ret;
+
+	w1_bench_init(&b, ctx->w1core ? "w1core" : "chardev", workload, lat_ns, iterations);
+	irqs = irq_count();
+	cpu = cpu_ns();
+	syscalls = bench_syscalls(ctx);
+	start = now_ns();
+	t1 = start;
+	for (i = 0; i < iterations; i++) {
+		t0 = now_ns();
+		if (strcmp(workload, W1_BENCH_SAMPLE) == 0)
+			ret = bench_sample(ctx, dev);
+		else if (strcmp(workload, W1_BENCH_SWEEP) == 0)
+			ret = bench_sweep(ctx);
+		else if (strcmp(workload, W1_BENCH_SEARCH) == 0)
+			ret = bench_search(ctx);
+		else
+			ret = bench_eeprom(ctx, dev);
+		t1 = now_ns();
+		w1_bench_add(&b, t1 - t0, ret != 0);
+	}
+	b.elapsed_ns = t1 - start;
+	b.syscalls = bench_syscalls(ctx) - syscalls;
+	b.cpu_ns = cpu_ns() - cpu;
+	if (irqs != W1_BENCH_NA)
+		b.irqs = irq_count() - irqs;
+	w1_bench_format(&b, line, sizeof(line));
+	printf("%s\n", line);
+	fflush(stdout);
+	return b.errors;
+}
+
+static int selected(const char *list, const char *workload)
+{
+	size_t len = strlen(workload);
+	const char *p;
+
+	for (p = list; (p = strstr(p, workload)) != NULL; p += len)
+		if ((p == list || p[-1] == ',') && (p[len] == '\0' || p[len] == ','))
+			return 1;
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct bench_ctx ctx;
+	const char *workloads = "sample,sweep,search,eeprom";
+	unsigned int iterations = 10;
+	int opt, ret, i, sensor = -1, mem = -1, errors = 0;
+	uint64_t *lat_ns;
+
+	memset(&ctx, 0, sizeof(ctx));
+	while ((opt = getopt(argc, argv, "p:n:w:d:")) != -1) {
+		switch (opt) {
+		case 'p':
+			if (strcmp(optarg, "w1core") == 0) {
+				ctx.w1core = 1;
+			} else if (strcmp(optarg, "chardev") != 0) {
+				fprintf(stderr, "Unknown path %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'n':
+			iterations = strtoul(optarg, NULL, 0);
+			break;
+		case 'w':
+			workloads = optarg;
+			break;
+		case 'd':
+			ctx.path = optarg;
+			break;
+		default:
+			printf("Usage: %s [-p chardev|w1core] [-n iterations] [-w workload,...] [-d path]\n",
+			       argv[0]);
+			return 1;
+		}
+	}
+	if (iterations == 0)
+		iterations = 1;
+	lat_ns = calloc(iterations, sizeof(*lat_ns));
+	if (lat_ns == NULL)
+		return 1;
+
+	if (ctx.w1core) {
+		if (ctx.path == NULL)
+			ctx.path = BENCH_W1_MASTER;
+		ret = w1core_enumerate(&ctx);
+	} else {
+		ret = xlnxw1_open(&ctx.w1, ctx.path);
+		if (ret == 0)
+			ret = ctx.ndevices = xlnxw1_search(&ctx.w1, W1_SEARCH_ROM, ctx.roms,
+							   BENCH_MAX_DEVICES);
+	}
+	if (ret < 0) {
+		fprintf(stderr, "Cannot access the bus: %s\n", strerror(-ret));
+		return 1;
+	}
+	if (ctx.ndevices == 0) {
+		fprintf(stderr, "No device detected\n");
+		return 1;
+	}
+	for (i = 0; i < ctx.ndevices; i++) {
+		if (is_temp_family(ctx.roms[i][0]) && sensor < 0)
+			sensor = i;
+		else if (is_eeprom_family(ctx.roms[i][0]) && mem < 0)
+			mem = i;
+	}
+
+	if (selected(workloads, W1_BENCH_SAMPLE)) {
+		if (sensor >= 0)
+			errors += run(&ctx, W1_BENCH_SAMPLE, sensor, iterations, lat_ns);
+		else
+			print_skipped(&ctx, W1_BENCH_SAMPLE, "no temperature sensor");
+	}
+	if (selected(workloads, W1_BENCH_SWEEP)) {
+		if (sensor >= 0)
+			errors += run(&ctx, W1_BENCH_SWEEP, -1, iterations, lat_ns);
+		else
+			print_skipped(&ctx, W1_BENCH_SWEEP, "no temperature sensor");
+	}
+	if (selected(workloads, W1_BENCH_SEARCH)) {
+		if (!ctx.w1core)
+			errors += run(&ctx, W1_BENCH_SEARCH, -1, iterations, lat_ns);
+		else
+			print_skipped(&ctx, W1_BENCH_SEARCH, "no synchronous search in the w1 core");
+	}
+	if (selected(workloads, W1_BENCH_EEPROM)) {
+		if (mem >= 0)
+			errors += run(&ctx, W1_BENCH_EEPROM, mem, iterations, lat_ns);
+		else
+			print_skipped(&ctx, W1_BENCH_EEPROM, "no EEPROM device");
+	}
+
+	if (!ctx.w1core)
+		xlnxw1_close(&ctx.w1);
+	free(lat_ns);
+	return errors != 0;
+}
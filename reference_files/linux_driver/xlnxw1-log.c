@@ -0,0 +1,195 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+
+/*
+ * xlnxw1-log: prints the samples of a log written by xlnxw1d -l, one line
+ * per sample in the format of the xlnxw1d socket:
+ *     <seconds.ms> <rom id, 16 hex digits> <millidegrees|err:errno>
+ *
+ * With -i, prints instead a line per sensor built from the chunk indexes
+ * (samples, failed samples, min and max), then the size per sample and the
+ * decoding rate of a full scan.
+ *
+ * Usage: xlnxw1-log [-r rom] [-f from_s] [-t to_s] [-i] log
+ *   -r  only the sensor of this ROM ID
+ *   -f  -t  only the samples from/to these CLOCK_REALTIME seconds
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "xlnxw1_log.h"
+
+struct sensor_info {
+	uint64_t samples, failed;
+	int32_t min, max;
+	int good;
+};
+
+static int parse_rom(const char *s, uint8_t *rom)
+{
+	unsigned int b[8];
+	int i;
+
+	if (strlen(s) != 16 || sscanf(s, "%02x%02x%02x%02x%02x%02x%02x%02x", &b[0], &b[1], &b[2],
+				      &b[3], &b[4], &b[5], &b[6], &b[7]) != 8)
+		return -EINVAL;
+	for (i = 0; i < 8; i++)
+		rom[i] = (uint8_t)b[i];
+	return 0;
+}
+
+static void print_rom(const uint8_t *rom)
+{
+	static const uint8_t unknown[8];
+
+	if (rom == NULL)
+		rom = unknown;
+	printf("%02x%02x%02x%02x%02x%02x%02x%02x", rom[0], rom[1], rom[2], rom[3], rom[4],
+	       rom[5], rom[6], rom[7]);
+}
+
+static double now_s(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Per sensor summary from the indexes, without decoding the streams */
+static int info(const struct xlnxw1_log *log, int64_t sensor, uint64_t from_ns, uint64_t to_ns)
+{
+	const struct xlnxw1_log_chunk *c;
+	const struct xlnxw1_log_series *sr;
+	struct xlnxw1_log_query q;
+	struct xlnxw1_log_sample s;
+	struct sensor_info *si;
+	uint64_t tick_ns = log->tick_us * 1000ULL, total = 0, n = 0;
+	uint32_t i, j;
+	double t;
+	int ret;
+
+	si = calloc(log->nsensors ? log->nsensors : 1, sizeof(*si));
+	if (si == NULL)
+		return -ENOMEM;
+	for (i = 0; i < log->nchunks; i++) {
+		c = log->chunks[i];
+		if (c->t_last < from_ns / tick_ns || c->t_first > to_ns / tick_ns)
+			continue;
+		sr = xlnxw1_log_series(c);
+		for (j = 0; j < c->nseries; j++, sr++) {
+			if (sr->sensor >= log->nsensors || (sensor >= 0 && sr->sensor != sensor))
+				continue;
+			si[sr->sensor].samples += sr->samples;
+			si[sr->sensor].failed += sr->failed;
+			if (sr->samples == sr->failed)
+				continue;
+			if (!si[sr->sensor].good || sr->min < si[sr->sensor].min)
+				si[sr->sensor].min = sr->min;
+			if (!si[sr->sensor].good || sr->max > si[sr->sensor].max)
+				si[sr->sensor].max = sr->max;
+			si[sr->sensor].good = 1;
+		}
+	}
+	for (i = 0; i < log->nsensors; i++) {
+		if (si[i].samples == 0)
+			continue;
+		print_rom(log->roms[i]);
+		printf(" samples %llu failed %llu min %d max %d\n",
+		       (unsigned long long)si[i].samples, (unsigned long long)si[i].failed,
+		       si[i].min, si[i].max);
+		total += si[i].samples;
+	}
+	free(si);
+
+	t = now_s();
+	xlnxw1_log_query(&q, log, sensor, from_ns, to_ns);
+	while ((ret = xlnxw1_log_next(&q, &s)) == 1)
+		n++;
+	t = now_s() - t;
+	printf("%zu bytes, %u chunks (%u bad), %u sensors, tick %u us\n", log->size, log->nchunks,
+	       log->bad_chunks, log->nsensors, log->tick_us);
+	if (total)
+		printf("%.3f bytes per sample, %llu samples decoded at %.1f Msamples/s\n",
+		       (double)log->size / total, (unsigned long long)n, t > 0 ? n / t / 1e6 : 0.0);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	struct xlnxw1_log log;
+	struct xlnxw1_log_query q;
+	struct xlnxw1_log_sample s;
+	uint64_t from_ns = 0, to_ns = UINT64_MAX;
+	int64_t sensor = -1;
+	const char *rom_arg = NULL;
+	uint8_t rom[8];
+	int opt, summary = 0, ret;
+
+	while ((opt = getopt(argc, argv, "r:f:t:i")) != -1) {
+		switch (opt) {
+		case 'r':
+			rom_arg = optarg;
+			break;
+		case 'f':
+			from_ns = strtoull(optarg, NULL, 0) * 1000000000ULL;
+			break;
+		case 't':
+			to_ns = strtoull(optarg, NULL, 0) * 1000000000ULL + 999999999;
+			break;
+		case 'i':
+			summary = 1;
+			break;
+		default:
+			optind = argc;
+			break;
+		}
+	}
+	if (optind != argc - 1) {
+		printf("Usage: %s [-r rom] [-f from_s] [-t to_s] [-i] log\n", argv[0]);
+		return 1;
+	}
+
+	ret = xlnxw1_log_open(&log, argv[optind]);
+	if (ret < 0) {
+		printf("Cannot open %s: %s\n", argv[optind], strerror(-ret));
+		return 1;
+	}
+	if (rom_arg) {
+		if (parse_rom(rom_arg, rom) < 0) {
+			printf("Bad ROM ID %s\n", rom_arg);
+			return 1;
+		}
+		ret = xlnxw1_log_find(&log, rom);
+		if (ret < 0) {
+			printf("%s is not in the log\n", rom_arg);
+			return 1;
+		}
+		sensor = ret;
+	}
+
+	if (summary) {
+		ret = info(&log, sensor, from_ns, to_ns);
+	} else {
+		xlnxw1_log_query(&q, &log, sensor, from_ns, to_ns);
+		while ((ret = xlnxw1_log_next(&q, &s)) == 1) {
+			printf("%llu.%03llu ", (unsigned long long)(s.time_ns / 1000000000),
+			       (unsigned long long)(s.time_ns / 1000000 % 1000));
+			print_rom(s.sensor < log.nsensors ? log.roms[s.sensor] : NULL);
+			if (s.status)
+				printf(" err:%d\n", -s.status);
+			else
+				printf(" %d\n", s.millideg);
+		}
+	}
+	if (ret < 0)
+		printf("%s: %s\n", argv[optind], strerror(-ret));
+	xlnxw1_log_close(&log);
+	return ret < 0;
+}
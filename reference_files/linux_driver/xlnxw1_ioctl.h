@@ -0,0 +1,106 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef XLNXW1_IOCTL_H
+#define XLNXW1_IOCTL_H
+
+/*
+ * ioctl interface of the /dev/xlnx_w1 character driver (w1chardev.c), shared
+ * by the driver and the user space tools.
+ *
+ * The argument of the primitive ioctls points to a single byte, the int in
+ * their definition only sets the ioctl number.
+ */
+
+#ifdef __KERNEL__
+#include <linux/ioctl.h>
+#include <linux/types.h>
+#else
+#include <linux/types.h>
+#include <sys/ioctl.h>
+#endif
+
+#define XLNX_W1_DEVICE_NAME	"/dev/xlnx_w1"
+
+#define XLNX_IOCTL_RESET_BUS 	_IOR('k', 0, int)	/* u8 out: 0=Device present, 1=No device */
+#define XLNX_IOCTL_READ_BIT 	_IOR('k', 1, int)	/* u8 out: bit read */
+#define XLNX_IOCTL_WRITE_BIT 	_IOW('k', 2, int)	/* u8 in: bit to write */
+#define XLNX_IOCTL_READ_BYTE 	_IOR('k', 3, int)	/* u8 out: byte read */
+#define XLNX_IOCTL_WRITE_BYTE	_IOW('k', 4, int)	/* u8 in: byte to write */
+
+/*
+ * __u32 in: conversion time (tCONV) in ms. Sleeps tCONV, the bus being free
+ * for other transactions meanwhile, then confirms the end of the conversion
+ * with read slots every XLNX_W1_CONV_POLL_MS. Fails with ETIMEDOUT if the
+ * device is still busy after another tCONV. From IP v1.7 the read slots are
+ * a single POLL_BIT instruction, the bus being held until its interrupt.
+ */
+#define XLNX_IOCTL_WAIT_CONVERSION	_IOW('k', 5, __u32)
+
+#define XLNX_W1_CONV_POLL_MS	10
+
+/*
+ * ROM ID table of the IP (v1.6 or later, built with ROM_TABLE entries). The
+ * table ioctls fail with EOPNOTSUPP without it.
+ */
+#define XLNX_W1_ROM_TABLE_MAX	64
+
+struct xlnx_w1_rom_table {
+	__u32 count;		/* in: ROM IDs to load in the entries 0 to count - 1 */
+	__u32 size;		/* out: entries of the IP */
+	__u8 rom[XLNX_W1_ROM_TABLE_MAX][8];	/* in: ROM IDs, family code first */
+};
+
+/* Fails with EINVAL if count is larger than the table, count 0 only reads size */
+#define XLNX_IOCTL_ROM_TABLE_LOAD	_IOWR('k', 6, struct xlnx_w1_rom_table)
+/* u8 in: table entry, out: 0=Device present, 1=No device. Reset and Match ROM */
+#define XLNX_IOCTL_SELECT_ROM	_IOWR('k', 7, int)
+/* __u64 in: entries 0 to n - 1 to ping, out: one bit per device found */
+#define XLNX_IOCTL_PING_ALL	_IOWR('k', 8, __u64)
+
+/*
+ * __u32 in: timeout in ms. Read slots every XLNX_W1_WAIT_ONE_POLL_US until
+ * one reads 1, e.g. at the end of an EEPROM copy, as a single POLL_BIT
+ * instruction of the IP (v1.7 or later), which fails with EOPNOTSUPP
+ * without it. Fails with ETIMEDOUT if the device is still busy.
+ */
+#define XLNX_IOCTL_WAIT_ONE	_IOW('k', 9, __u32)
+
+#define XLNX_W1_WAIT_ONE_POLL_US	1000
+
+/*
+ * PIO Access Write of a DS2413 or DS2408 switch as one call, on the priority
+ * lane of the driver: reset and Match ROM (SELECT_ROM of entry if it is a
+ * table entry), 0x5A, value, ~value, then the confirmation byte (0xAA) and
+ * the PIO state are read and a reset ends the access. The transactions of
+ * other threads starting meanwhile wait for it. It takes the bus between
+ * two transactions only: it waits for the one on the bus to end, at its
+ * XLNX_IOCTL_TXN_END or conversion wait (or at its next reset, for a user not
+ * calling XLNX_IOCTL_TXN_END). Fails with ENODEV if no
+ * device answered the reset, EIO if the confirmation byte is not 0xAA (the
+ * latch is unchanged).
+ */
+#define XLNX_W1_PIO_NO_ENTRY	0xFF
+
+struct xlnx_w1_pio {
+	__u8 rom[8];		/* in: ROM ID of the switch, family code first */
+	__u8 entry;		/* in: ROM ID table entry of rom, XLNX_W1_PIO_NO_ENTRY if none */
+	__u8 value;		/* in: PIO output latch byte */
+	__u8 confirm;		/* out: byte read after ~value, 0xAA on success */
+	__u8 state;		/* out: PIO status byte read after it */
+	__u32 wait_us;		/* out: time spent waiting for the bus */
+};
+
+#define XLNX_IOCTL_PIO_WRITE	_IOWR('k', 10, struct xlnx_w1_pio)
+
+/*
+ * No argument. Ends the transaction of the caller, started by its first
+ * RESET_BUS or SELECT_ROM, so XLNX_IOCTL_PIO_WRITE takes the bus at once.
+ * From its first call on the open device, the resets no more end the
+ * transactions: one may hold several resets, e.g. before a Resume, or leave
+ * the bus idle while an EEPROM programs a page.
+ */
+#define XLNX_IOCTL_TXN_END	_IO('k', 11)
+
+#endif /* XLNXW1_IOCTL_H */
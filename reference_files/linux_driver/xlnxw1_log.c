@@ -0,0 +1,632 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "w1_crc.h"
+#include "xlnxw1_log.h"
+
+/* Token, step change and value change or errno of a sample */
+#define XLNXW1_LOG_SAMPLE_MAX	(1 + 10 + 5)
+
+/* Largest chunk of the writer buffer, the dictionary entries included */
+#define XLNXW1_LOG_CHUNK_MAX \
+	(sizeof(struct xlnxw1_log_chunk) + 0xFFFF * W1_ROM_ID_SIZE + \
+	 XLNXW1_LOG_CHUNK_SAMPLES * (sizeof(struct xlnxw1_log_series) + XLNXW1_LOG_SAMPLE_MAX) + 8)
+
+#define XLNXW1_LOG_CRC_OFFSET	offsetof(struct xlnxw1_log_chunk, ndict)
+
+static uint64_t zigzag(int64_t v)
+{
+	return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v)
+{
+	return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static uint8_t *put_varint(uint8_t *p, uint64_t v)
+{
+	while (v >= 0x80) {
+		*p++ = (uint8_t)v | 0x80;
+		v >>= 7;
+	}
+	*p++ = (uint8_t)v;
+	return p;
+}
+
+static int get_varint(const uint8_t **p, const uint8_t *end, uint64_t *v)
+{
+	unsigned int shift;
+
+	*v = 0;
+	for (shift = 0; shift < 64 && *p < end; shift += 7) {
+		*v |= (uint64_t)(**p & 0x7F) << shift;
+		if ((*(*p)++ & 0x80) == 0)
+			return 0;
+	}
+	return -1;
+}
+
+static int write_all(int fd, const void *buf, size_t len)
+{
+	const uint8_t *p = buf;
+	ssize_t n;
+
+	while (len) {
+		n = write(fd, p, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -errno;
+		}
+		p += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/*************************** Writer ****************************/
+int xlnxw1_log_writer_open(struct xlnxw1_log_writer *w, const char *path, uint32_t tick_us)
+{
+	struct xlnxw1_log_header h;
+	struct xlnxw1_log log;
+	struct timespec ts;
+	struct stat st;
+	uint32_t i;
+	int ret;
+
+	memset(w, 0, sizeof(*w));
+	w->fd = -1;
+	w->tick_us = tick_us;
+	w->max_age_s = XLNXW1_LOG_MAX_AGE_S;
+	if (tick_us == 0)
+		return -EINVAL;
+	w->buf = malloc(XLNXW1_LOG_CHUNK_SAMPLES * sizeof(*w->buf));
+	w->order = malloc(XLNXW1_LOG_CHUNK_SAMPLES * sizeof(*w->order));
+	w->chunk = malloc(XLNXW1_LOG_CHUNK_MAX);
+	if (w->buf == NULL || w->order == NULL || w->chunk == NULL) {
+		ret = -ENOMEM;
+		goto fail;
+	}
+
+	w->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (w->fd < 0 || fstat(w->fd, &st) < 0) {
+		ret = -errno;
+		goto fail;
+	}
+	/* A second writer would interleave its chunks */
+	if (flock(w->fd, LOCK_EX | LOCK_NB) < 0) {
+		ret = errno == EWOULDBLOCK ? -EBUSY : -errno;
+		goto fail;
+	}
+
+	if (st.st_size == 0) {
+		clock_gettime(CLOCK_REALTIME, &ts);
+		memset(&h, 0, sizeof(h));
+		h.magic = XLNXW1_LOG_MAGIC;
+		h.version = XLNXW1_LOG_VERSION;
+		h.header_size = sizeof(h);
+		h.tick_us = tick_us;
+		h.created_ns = (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+		ret = write_all(w->fd, &h, sizeof(h));
+		if (ret < 0)
+			goto fail;
+		return 0;
+	}
+
+	/* Carry on with the dictionary of the file, after its last good chunk */
+	ret = xlnxw1_log_open(&log, path);
+	if (ret < 0)
+		goto fail;
+	w->tick_us = log.tick_us;
+	w->cap = log.nsensors;
+	w->roms = w->cap ? malloc(w->cap * sizeof(*w->roms)) : NULL;
+	if (w->cap && w->roms == NULL) {
+		xlnxw1_log_close(&log);
+		ret = -ENOMEM;
+		goto fail;
+	}
+	for (i = 0; i < log.nsensors; i++) {
+		if (log.roms[i])
+			memcpy(w->roms[i], log.roms[i], W1_ROM_ID_SIZE);
+		else
+			memset(w->roms[i], 0, W1_ROM_ID_SIZE);
+	}
+	w->nsensors = w->ndict_written = log.nsensors;
+	if ((off_t)log.size < st.st_size && ftruncate(w->fd, log.size) < 0)
+		ret = -errno;
+	xlnxw1_log_close(&log);
+	if (ret == 0 && lseek(w->fd, 0, SEEK_END) < 0)
+		ret = -errno;
+	if (ret < 0)
+		goto fail;
+	return 0;
+
+fail:
+	xlnxw1_log_writer_close(w);
+	return ret;
+}
+
+static int xlnxw1_log_sensor(struct xlnxw1_log_writer *w, const uint8_t *rom)
+{
+	uint8_t (*roms)[8];
+	uint32_t i;
+
+	for (i = 0; i < w->nsensors; i++)
+		if (memcmp(w->roms[i], rom, W1_ROM_ID_SIZE) == 0)
+			return i;
+	if (w->nsensors == w->cap) {
+		roms = realloc(w->roms, (w->cap ? w->cap * 2 : 64) * sizeof(*roms));
+		if (roms == NULL)
+			return -ENOMEM;
+		w->roms = roms;
+		w->cap = w->cap ? w->cap * 2 : 64;
+	}
+	memcpy(w->roms[w->nsensors], rom, W1_ROM_ID_SIZE);
+	return w->nsensors++;
+}
+
+int xlnxw1_log_append(struct xlnxw1_log_writer *w, const uint8_t *rom, uint64_t time_ns,
+		      int status, int32_t millideg)
+{
+	struct xlnxw1_log_pending *s;
+	uint64_t tick = time_ns / (w->tick_us * 1000ULL);
+	int sensor, ret;
+
+	/* The oldest sample is the first one buffered */
+	if (w->nbuf && w->max_age_s &&
+	    tick - w->buf[0].tick >= (uint64_t)w->max_age_s * 1000000 / w->tick_us) {
+		ret = xlnxw1_log_flush(w);
+		if (ret < 0)
+			return ret;
+	}
+	/* ndict is 16 bits */
+	if (w->nsensors - w->ndict_written == 0xFFFF) {
+		ret = xlnxw1_log_flush(w);
+		if (ret < 0)
+			return ret;
+	}
+
+	sensor = xlnxw1_log_sensor(w, rom);
+	if (sensor < 0)
+		return sensor;
+	s = &w->buf[w->nbuf++];
+	s->tick = tick;
+	s->sensor = sensor;
+	s->millideg = status ? 0 : millideg;
+	s->status = status;
+
+	if (w->nbuf == XLNXW1_LOG_CHUNK_SAMPLES)
+		return xlnxw1_log_flush(w);
+	return 0;
+}
+
+static unsigned int status_code(int status)
+{
+	switch (status) {
+	case 0:
+		return XLNXW1_LOG_OK;
+	case -EIO:
+		return XLNXW1_LOG_CRC;
+	case -ENODEV:
+		return XLNXW1_LOG_NODEV;
+	default:
+		return XLNXW1_LOG_ERROR;
+	}
+}
+
+/* The samples of a sensor, in the order they were buffered */
+static uint8_t *encode_series(struct xlnxw1_log_writer *w, const uint32_t *idx, uint32_t n,
+			      uint64_t t_first, struct xlnxw1_log_series *sr, uint8_t *p)
+{
+	const struct xlnxw1_log_pending *s;
+	uint64_t tick = t_first;
+	int64_t step = 0, d;
+	int32_t value = 0;
+	unsigned int code;
+	uint32_t i, run;
+	int good = 0;
+
+	sr->samples = n;
+	sr->failed = 0;
+	sr->min = sr->max = 0;
+	for (i = 0; i < n; ) {
+		/* Same step, same value: part of a run */
+		for (run = 0; i + run < n; run++) {
+			s = &w->buf[idx[i + run]];
+			if (s->status || s->millideg != value ||
+			    (int64_t)(s->tick - tick) != step * (run + 1))
+				break;
+		}
+		if (run) {
+			p = put_varint(p, (uint64_t)run << 1);
+			tick += step * run;
+			i += run;
+			continue;
+		}
+
+		s = &w->buf[idx[i++]];
+		code = status_code(s->status);
+		d = (int64_t)(s->tick - tick);
+		p = put_varint(p, 1 | code << 1);
+		p = put_varint(p, zigzag(d - step));
+		step = d;
+		tick = s->tick;
+		if (code == XLNXW1_LOG_OK) {
+			p = put_varint(p, zigzag((int64_t)s->millideg - value));
+			value = s->millideg;
+			if (!good || value < sr->min)
+				sr->min = value;
+			if (!good || value > sr->max)
+				sr->max = value;
+			good = 1;
+		} else {
+			if (code == XLNXW1_LOG_ERROR)
+				p = put_varint(p, s->status < 0 ? -s->status : s->status);
+			sr->failed++;
+		}
+	}
+	return p;
+}
+
+int xlnxw1_log_flush(struct xlnxw1_log_writer *w)
+{
+	struct xlnxw1_log_chunk *c = (struct xlnxw1_log_chunk *)w->chunk;
+	struct xlnxw1_log_series *sr;
+	uint32_t *first, i, s, nseries;
+	uint8_t *p;
+	off_t end;
+	int ret;
+
+	if (w->nbuf == 0)
+		return 0;
+
+	/* Counting sort by sensor, stable so each series stays in time order */
+	first = calloc(w->nsensors + 1, sizeof(*first));
+	if (first == NULL)
+		return -ENOMEM;
+	for (i = 0; i < w->nbuf; i++)
+		first[w->buf[i].sensor + 1]++;
+	for (s = 0, nseries = 0; s < w->nsensors; s++) {
+		nseries += first[s + 1] != 0;
+		first[s + 1] += first[s];
+	}
+	for (i = 0; i < w->nbuf; i++)
+		w->order[first[w->buf[i].sensor]++] = i;
+
+	memset(c, 0, sizeof(*c));
+	c->magic = XLNXW1_LOG_CHUNK_MAGIC;
+	c->ndict = w->nsensors - w->ndict_written;
+	c->dict_base = w->ndict_written;
+	c->nseries = nseries;
+	c->nsamples = w->nbuf;
+	c->t_first = c->t_last = w->buf[0].tick;
+	for (i = 1; i < w->nbuf; i++) {
+		if (w->buf[i].tick < c->t_first)
+			c->t_first = w->buf[i].tick;
+		if (w->buf[i].tick > c->t_last)
+			c->t_last = w->buf[i].tick;
+	}
+
+	p = w->chunk + sizeof(*c);
+	if (c->ndict) {
+		memcpy(p, w->roms[c->dict_base], c->ndict * W1_ROM_ID_SIZE);
+		p += c->ndict * W1_ROM_ID_SIZE;
+	}
+	sr = (struct xlnxw1_log_series *)p;
+	p += nseries * sizeof(*sr);
+
+	/* first[s] is now the end of sensor s in order, the start of s + 1 */
+	for (s = 0, i = 0; s < w->nsensors; i = first[s++]) {
+		if (first[s] == i)
+			continue;
+		sr->sensor = s;
+		sr->offset = p - w->chunk;
+		p = encode_series(w, &w->order[i], first[s] - i, c->t_first, sr, p);
+		sr++;
+	}
+	free(first);
+
+	while ((p - w->chunk) % 8)
+		*p++ = 0;
+	c->bytes = p - w->chunk;
+	c->crc = w1_crc16_slice8(0, w->chunk + XLNXW1_LOG_CRC_OFFSET,
+				 c->bytes - XLNXW1_LOG_CRC_OFFSET);
+
+	/* A chunk written in part is cut off, the samples are dropped */
+	end = lseek(w->fd, 0, SEEK_END);
+	ret = end < 0 ? -errno : write_all(w->fd, w->chunk, c->bytes);
+	if (ret < 0 && end >= 0 && ftruncate(w->fd, end) == 0)
+		lseek(w->fd, end, SEEK_SET);
+	else if (ret == 0)
+		w->ndict_written = w->nsensors;
+	w->nbuf = 0;
+	return ret;
+}
+
+int xlnxw1_log_writer_close(struct xlnxw1_log_writer *w)
+{
+	int ret = 0;
+
+	if (w->fd >= 0) {
+		ret = xlnxw1_log_flush(w);
+		if (close(w->fd) < 0 && ret == 0)
+			ret = -errno;
+	}
+	free(w->buf);
+	free(w->order);
+	free(w->chunk);
+	free(w->roms);
+	memset(w, 0, sizeof(*w));
+	w->fd = -1;
+	return ret;
+}
+
+/*************************** Reader ****************************/
+static int xlnxw1_log_index(struct xlnxw1_log *log, const struct xlnxw1_log_chunk *c,
+			    uint32_t *cap)
+{
+	const struct xlnxw1_log_chunk **chunks;
+	const struct xlnxw1_log_chunk *prev;
+	const uint8_t **roms;
+	uint32_t n, i;
+
+	if (log->nchunks == *cap) {
+		chunks = realloc(log->chunks, (*cap ? *cap * 2 : 256) * sizeof(*chunks));
+		if (chunks == NULL)
+			return -ENOMEM;
+		log->chunks = chunks;
+		*cap = *cap ? *cap * 2 : 256;
+	}
+	if (log->nchunks) {
+		prev = log->chunks[log->nchunks - 1];
+		if (c->t_first < prev->t_first || c->t_last < prev->t_last)
+			log->sorted = 0;
+	}
+	log->chunks[log->nchunks++] = c;
+
+	n = c->dict_base + c->ndict;
+	if (n > log->nsensors) {
+		roms = realloc(log->roms, n * sizeof(*roms));
+		if (roms == NULL)
+			return -ENOMEM;
+		for (i = log->nsensors; i < n; i++)
+			roms[i] = NULL;
+		log->roms = roms;
+		log->nsensors = n;
+	}
+	for (i = 0; i < c->ndict; i++)
+		log->roms[c->dict_base + i] = (const uint8_t *)(c + 1) + i * W1_ROM_ID_SIZE;
+	return 0;
+}
+
+int xlnxw1_log_open(struct xlnxw1_log *log, const char *path)
+{
+	const struct xlnxw1_log_header *h;
+	const struct xlnxw1_log_chunk *c;
+	struct stat st;
+	size_t off;
+	uint32_t cap = 0;
+	void *map;
+	int fd, ret;
+
+	memset(log, 0, sizeof(*log));
+	log->sorted = 1;
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -errno;
+	if (fstat(fd, &st) < 0) {
+		ret = -errno;
+		close(fd);
+		return ret;
+	}
+	if ((size_t)st.st_size < sizeof(*h)) {
+		close(fd);
+		return -EBADMSG;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return -errno;
+	log->map = map;
+	log->map_size = log->size = st.st_size;
+
+	h = map;
+	if (h->magic != XLNXW1_LOG_MAGIC || h->version != XLNXW1_LOG_VERSION ||
+	    h->header_size < sizeof(*h) || h->header_size % 8 || h->tick_us == 0 ||
+	    h->header_size > log->size) {
+		xlnxw1_log_close(log);
+		return -EBADMSG;
+	}
+	log->tick_us = h->tick_us;
+
+	/* Up to the first chunk cut off, a writer crashed or still writing */
+	for (off = h->header_size; log->size - off >= sizeof(*c); off += c->bytes) {
+		c = (const struct xlnxw1_log_chunk *)(log->map + off);
+		if (c->magic != XLNXW1_LOG_CHUNK_MAGIC || c->bytes % 8 ||
+		    c->bytes < sizeof(*c) || c->bytes > log->size - off)
+			break;
+		if (w1_crc16_slice8(0, (const uint8_t *)c + XLNXW1_LOG_CRC_OFFSET,
+				    c->bytes - XLNXW1_LOG_CRC_OFFSET) != c->crc ||
+		    sizeof(*c) + (uint64_t)c->ndict * W1_ROM_ID_SIZE +
+		    (uint64_t)c->nseries * sizeof(struct xlnxw1_log_series) > c->bytes) {
+			log->bad_chunks++;
+			continue;
+		}
+		ret = xlnxw1_log_index(log, c, &cap);
+		if (ret < 0) {
+			xlnxw1_log_close(log);
+			return ret;
+		}
+	}
+	log->size = off;
+	return 0;
+}
+
+void xlnxw1_log_close(struct xlnxw1_log *log)
+{
+	if (log->map)
+		munmap((void *)log->map, log->map_size);
+	free(log->chunks);
+	free(log->roms);
+	memset(log, 0, sizeof(*log));
+}
+
+int xlnxw1_log_find(const struct xlnxw1_log *log, const uint8_t *rom)
+{
+	uint32_t i;
+
+	for (i = 0; i < log->nsensors; i++)
+		if (log->roms[i] && memcmp(log->roms[i], rom, W1_ROM_ID_SIZE) == 0)
+			return i;
+	return -ENOENT;
+}
+
+void xlnxw1_log_query(struct xlnxw1_log_query *q, const struct xlnxw1_log *log, int64_t sensor,
+		      uint64_t from_ns, uint64_t to_ns)
+{
+	uint64_t tick_ns = log->tick_us * 1000ULL;
+	uint32_t lo = 0, hi = log->nchunks, mid;
+
+	memset(q, 0, sizeof(*q));
+	q->log = log;
+	q->sensor = sensor;
+	q->from = from_ns / tick_ns;
+	q->to = to_ns / tick_ns;
+
+	/* First chunk ending after from */
+	while (log->sorted && lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (log->chunks[mid]->t_last < q->from)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	q->chunk = lo;
+}
+
+/* The series of a sensor in the index of a chunk, sorted by sensor */
+static const struct xlnxw1_log_series *find_series(const struct xlnxw1_log_chunk *c,
+						   const struct xlnxw1_log_series *sr,
+						   uint32_t sensor)
+{
+	uint32_t lo = 0, hi = c->nseries, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (sr[mid].sensor < sensor)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo < c->nseries && sr[lo].sensor == sensor ? &sr[lo] : NULL;
+}
+
+static int decode_sample(struct xlnxw1_log_query *q, struct xlnxw1_log_sample *s)
+{
+	uint64_t token, v;
+
+	if (q->run == 0) {
+		if (get_varint(&q->p, q->end, &token))
+			return -EBADMSG;
+		if ((token & 1) == 0) {
+			if ((token >> 1) == 0 || (token >> 1) > q->left)
+				return -EBADMSG;
+			q->run = token >> 1;
+		}
+	}
+	q->left--;
+	s->sensor = q->sensor_cur;
+	s->status = 0;
+	if (q->run) {
+		q->run--;
+		q->tick += q->step;
+		s->millideg = q->value;
+	} else {
+		if (get_varint(&q->p, q->end, &v))
+			return -EBADMSG;
+		q->step += unzigzag(v);
+		q->tick += q->step;
+		switch ((token >> 1) & 3) {
+		case XLNXW1_LOG_OK:
+			if (get_varint(&q->p, q->end, &v))
+				return -EBADMSG;
+			q->value += (int32_t)unzigzag(v);
+			break;
+		case XLNXW1_LOG_CRC:
+			s->status = -EIO;
+			break;
+		case XLNXW1_LOG_NODEV:
+			s->status = -ENODEV;
+			break;
+		default:
+			if (get_varint(&q->p, q->end, &v))
+				return -EBADMSG;
+			s->status = -(int32_t)v;
+			break;
+		}
+		s->millideg = s->status ? 0 : q->value;
+	}
+	s->time_ns = q->tick * q->log->tick_us * 1000ULL;
+	return 0;
+}
+
+int xlnxw1_log_next(struct xlnxw1_log_query *q, struct xlnxw1_log_sample *s)
+{
+	const struct xlnxw1_log *log = q->log;
+	const struct xlnxw1_log_chunk *c;
+	const struct xlnxw1_log_series *sr;
+
+	for (;;) {
+		while (q->left) {
+			if (decode_sample(q, s))
+				return -EBADMSG;
+			if (q->tick >= q->from && q->tick <= q->to)
+				return 1;
+		}
+
+		if (q->chunk >= log->nchunks)
+			return 0;
+		c = log->chunks[q->chunk];
+		sr = xlnxw1_log_series(c);
+		if (q->series == 0 && (c->t_last < q->from || c->t_first > q->to)) {
+			q->chunk = log->sorted && c->t_first > q->to ? log->nchunks : q->chunk + 1;
+			continue;
+		}
+		if (q->series >= c->nseries) {
+			q->chunk++;
+			q->series = 0;
+			continue;
+		}
+		if (q->sensor >= 0) {
+			sr = find_series(c, sr, q->sensor);
+			q->series = c->nseries;
+			if (sr == NULL)
+				continue;
+		} else {
+			sr += q->series++;
+		}
+
+		if (sr->offset < (const uint8_t *)(sr + 1) - (const uint8_t *)c ||
+		    sr->offset >= c->bytes)
+			return -EBADMSG;
+		q->p = (const uint8_t *)c + sr->offset;
+		q->end = (const uint8_t *)c + c->bytes;
+		q->sensor_cur = sr->sensor;
+		q->left = sr->samples;
+		q->run = 0;
+		q->tick = c->t_first;
+		q->step = 0;
+		q->value = 0;
+	}
+}
@@ -0,0 +1,236 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef XLNXW1_LOG_H
+#define XLNXW1_LOG_H
+
+/*
+ * xlnxw1_log: append-only binary log of the temperature samples, written by
+ * xlnxw1d (-l) and read back through mmap() by the historians.
+ *
+ * The file is a header followed by chunks, each one written at once by a
+ * single write(). A chunk holds the samples buffered since the previous one,
+ * grouped by sensor:
+ *   struct xlnxw1_log_chunk
+ *   ndict ROM IDs, the sensors seen for the first time, numbered from
+ *                  dict_base: the dictionary of the file is the
+ *                  concatenation of these entries
+ *   nseries struct xlnxw1_log_series, the index of the chunk, sorted by
+ *                  sensor number
+ *   the sample streams of the series, padded to 8 bytes
+ *
+ * A stream is a sequence of varints (LEB128). The first sample of a series
+ * starts from the t_first of the chunk, a step of 0 and a value of 0:
+ *   token even       run of token >> 1 samples, each one step after the
+ *                    previous one, with its value and a good status
+ *   token odd        one sample, the status in bits 2:1 of the token
+ *                    (XLNXW1_LOG_*), then the zigzag change of the step in
+ *                    ticks, then the zigzag change of the value for a good
+ *                    status, or the errno for XLNXW1_LOG_ERROR
+ * A failed sample keeps the value of the previous one for the next change.
+ * A sensor sampled every period with a steady temperature costs a few bytes
+ * per run, a new temperature about 3 bytes.
+ *
+ * A chunk is checked with the CRC-16 of the 1-Wire memories (w1_crc.h) over
+ * its bytes after the crc field. The reader skips a chunk with a wrong CRC,
+ * its dictionary entries being unknown, and stops at a truncated one; the
+ * writer truncates the file after the last good chunk before appending.
+ * The file is little endian, as the targets.
+ *
+ * All functions returning an int return 0 on success or a negative errno.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define XLNXW1_LOG_MAGIC	0x474C3157	/* "W1LG" */
+#define XLNXW1_LOG_CHUNK_MAGIC	0x434C3157	/* "W1LC" */
+#define XLNXW1_LOG_VERSION	1
+
+#define XLNXW1_LOG_CHUNK_SAMPLES	65536	/* Samples buffered by the writer */
+#define XLNXW1_LOG_MAX_AGE_S		300	/* Default writer max_age_s */
+
+/* Sample status, bits 2:1 of an odd token */
+#define XLNXW1_LOG_OK		0
+#define XLNXW1_LOG_CRC		1	/* Scratchpad CRC error, -EIO */
+#define XLNXW1_LOG_NODEV	2	/* No presence pulse or sensor gone, -ENODEV */
+#define XLNXW1_LOG_ERROR	3	/* Other error, the errno follows */
+
+/**************************** Type Definitions *****************************/
+struct xlnxw1_log_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t header_size;	/* Offset of the first chunk */
+	uint32_t tick_us;	/* Time unit of the samples */
+	uint32_t reserved;
+	uint64_t created_ns;	/* CLOCK_REALTIME at the creation of the file */
+};
+
+struct xlnxw1_log_chunk {
+	uint32_t magic;
+	uint32_t bytes;		/* Whole chunk, a multiple of 8 */
+	uint16_t crc;		/* CRC-16 of the chunk after this field */
+	uint16_t ndict;		/* Dictionary entries of the chunk */
+	uint32_t dict_base;	/* Sensor number of the first one */
+	uint32_t nseries;
+	uint32_t nsamples;
+	uint64_t t_first;	/* First and last sample times, in ticks */
+	uint64_t t_last;
+};
+
+struct xlnxw1_log_series {
+	uint32_t sensor;	/* Number in the dictionary */
+	uint32_t offset;	/* Stream, from the start of the chunk */
+	uint32_t samples;
+	uint32_t failed;	/* Samples with a status other than XLNXW1_LOG_OK */
+	int32_t min;		/* Values of the good samples, 0 if none */
+	int32_t max;
+};
+
+/* A decoded sample */
+struct xlnxw1_log_sample {
+	uint64_t time_ns;	/* CLOCK_REALTIME, rounded down to the tick */
+	uint32_t sensor;
+	int32_t millideg;	/* Valid if status is 0 */
+	int32_t status;		/* 0 or a negative errno */
+};
+
+/* Read side, the file mapped at open */
+struct xlnxw1_log {
+	const uint8_t *map;
+	size_t map_size;
+	size_t size;		/* Up to the end of the last complete chunk */
+	uint32_t tick_us;
+	uint32_t nchunks;	/* Good chunks */
+	uint32_t bad_chunks;	/* Chunks skipped for their CRC */
+	const struct xlnxw1_log_chunk **chunks;
+	uint32_t nsensors;
+	const uint8_t **roms;	/* ROM ID of each sensor, NULL if unknown */
+	int sorted;		/* The chunks follow each other in time */
+};
+
+/* A range query, read with xlnxw1_log_next() */
+struct xlnxw1_log_query {
+	const struct xlnxw1_log *log;
+	int64_t sensor;		/* -1 for all */
+	uint64_t from, to;	/* Ticks */
+	uint32_t chunk;
+	uint32_t series;	/* Next series of the chunk */
+	const uint8_t *p, *end;	/* Stream being decoded */
+	uint32_t sensor_cur;
+	uint32_t left;		/* Samples left in the series */
+	uint32_t run;		/* Samples left in the current run */
+	uint64_t tick;
+	int64_t step;
+	int32_t value;
+};
+
+/* Write side, one per file */
+struct xlnxw1_log_writer {
+	int fd;
+	uint32_t tick_us;
+	uint32_t max_age_s;	/* Flush when the oldest buffered sample is older, 0 never */
+	uint8_t (*roms)[8];	/* Dictionary */
+	uint32_t nsensors;
+	uint32_t cap;
+	uint32_t ndict_written;	/* Entries already in the file */
+	struct xlnxw1_log_pending {
+		uint64_t tick;
+		uint32_t sensor;
+		int32_t millideg;
+		int32_t status;
+	} *buf;
+	uint32_t nbuf;
+	uint8_t *chunk;		/* Encoding buffer */
+	uint32_t *order;	/* Counting sort of the buffer by sensor */
+};
+
+/* Index of a chunk, after its dictionary entries */
+static inline const struct xlnxw1_log_series *xlnxw1_log_series(const struct xlnxw1_log_chunk *c)
+{
+	return (const struct xlnxw1_log_series *)((const uint8_t *)(c + 1) + c->ndict * 8);
+}
+
+/************************** Function Prototypes ****************************/
+/**
+ *
+ * Open a log for appending, creating it if needed.
+ *
+ * @param   w is the writer to initialize.
+ *          path is the log file.
+ *          tick_us is the time unit of a new file, the one of the file is
+ *          kept otherwise.
+ *
+ * @return  0 or a negative errno (-EBADMSG if the file is not a log)
+ *
+ */
+int xlnxw1_log_writer_open(struct xlnxw1_log_writer *w, const char *path, uint32_t tick_us);
+
+/**
+ *
+ * Buffer a sample, flushing the chunk when the buffer is full or its oldest
+ * sample is older than max_age_s.
+ *
+ * @param   w is the writer.
+ *          rom is the ROM ID of the sensor.
+ *          time_ns is the CLOCK_REALTIME of the sample.
+ *          status is 0 or a negative errno.
+ *          millideg is the temperature, ignored if status is not 0.
+ *
+ * @return  0 or the negative errno of the flush
+ *
+ */
+int xlnxw1_log_append(struct xlnxw1_log_writer *w, const uint8_t *rom, uint64_t time_ns,
+		      int status, int32_t millideg);
+
+/* Write the buffered samples as a chunk, nothing if there are none */
+int xlnxw1_log_flush(struct xlnxw1_log_writer *w);
+
+/* Flush and close */
+int xlnxw1_log_writer_close(struct xlnxw1_log_writer *w);
+
+/**
+ *
+ * Map a log and index its chunks and its dictionary.
+ *
+ * @param   log is the handle to initialize.
+ *          path is the log file.
+ *
+ * @return  0 or a negative errno (-EBADMSG if the file is not a log)
+ *
+ */
+int xlnxw1_log_open(struct xlnxw1_log *log, const char *path);
+void xlnxw1_log_close(struct xlnxw1_log *log);
+
+/* Sensor number of a ROM ID, or -ENOENT */
+int xlnxw1_log_find(const struct xlnxw1_log *log, const uint8_t *rom);
+
+/**
+ *
+ * Start a range query. The samples come chunk by chunk and sensor by sensor
+ * within a chunk, in time order for a sensor.
+ *
+ * @param   q is the query to initialize.
+ *          log is the log.
+ *          sensor is the sensor number, -1 for all of them.
+ *          from_ns and to_ns bound the CLOCK_REALTIME of the samples,
+ *          inclusive.
+ *
+ */
+void xlnxw1_log_query(struct xlnxw1_log_query *q, const struct xlnxw1_log *log, int64_t sensor,
+		      uint64_t from_ns, uint64_t to_ns);
+
+/**
+ *
+ * Next sample of a query.
+ *
+ * @param   q is the query.
+ *          s receives the sample.
+ *
+ * @return  1 for a sample, 0 at the end, -EBADMSG for a corrupted stream
+ *
+ */
+int xlnxw1_log_next(struct xlnxw1_log_query *q, struct xlnxw1_log_sample *s);
+
+#endif /* XLNXW1_LOG_H */
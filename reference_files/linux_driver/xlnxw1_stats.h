@@ -0,0 +1,267 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef XLNXW1_STATS_H
+#define XLNXW1_STATS_H
+
+/*
+ * Latency histograms and error counters of the 1-Wire host drivers
+ * (amd_axi_w1.c and w1chardev.c), in debugfs under xlnxw1-<device>/:
+ *   latency            per instruction count, min/avg/max and log2 histogram
+ *                      of the latency in us, from the READY wait to the end
+ *                      of the primitive. Writing to it clears the histograms.
+ *   timeouts           IRQ waits that timed out
+ *   spurious_irqs      IRQs without an enabled status set
+ *   presence_failures  resets no device answered
+ *   bus_trace          binary trace of the last primitives (w1_trace.h), with
+ *                      the bus_trace=<records> module parameter, for
+ *                      tools/w1_trace_analyze.c
+ * The counters can be cleared by writing 0 to them.
+ *
+ * The driver serializes the primitives, the histograms and the trace ring are
+ * only updated by the bus owner. The lock makes a read of the latency file
+ * consistent, a read of bus_trace copies the ring without it.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/device.h>
+#include <linux/fs.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+#include <linux/vmalloc.h>
+
+#include "w1_trace.h"
+
+enum xlnxw1_op_index {
+	XLNXW1_OP_INITPRES,
+	XLNXW1_OP_READBIT,
+	XLNXW1_OP_WRITEBIT,
+	XLNXW1_OP_READBYTE,
+	XLNXW1_OP_WRITEBYTE,
+	XLNXW1_NR_OPS
+};
+
+#define XLNXW1_HIST_BUCKETS	16	/* [2^(n-1), 2^n) us, the last one open ended */
+
+struct xlnxw1_op_stats {
+	u64 count;
+	u64 sum_ns;
+	u64 min_ns;
+	u64 max_ns;
+	u64 hist[XLNXW1_HIST_BUCKETS];
+};
+
+struct xlnxw1_stats {
+	spinlock_t lock;
+	struct xlnxw1_op_stats ops[XLNXW1_NR_OPS];
+	u64 timeouts;
+	u64 spurious_irqs;
+	u64 presence_failures;
+	struct w1_trace_ring *ring;	/* NULL without bus_trace */
+	struct dentry *dir;
+};
+
+static const char * const xlnxw1_op_names[XLNXW1_NR_OPS] = {
+	[XLNXW1_OP_INITPRES] = "INITPRES",
+	[XLNXW1_OP_READBIT] = "READBIT",
+	[XLNXW1_OP_WRITEBIT] = "WRITEBIT",
+	[XLNXW1_OP_READBYTE] = "READBYTE",
+	[XLNXW1_OP_WRITEBYTE] = "WRITEBYTE",
+};
+
+/* Histogram index of an instruction register value */
+static inline int xlnxw1_op_index(u32 instr)
+{
+	switch (instr & 0x0F00) {
+	case 0x0800:
+		return XLNXW1_OP_INITPRES;
+	case 0x0C00:
+		return XLNXW1_OP_READBIT;
+	case 0x0E00:
+		return XLNXW1_OP_WRITEBIT;
+	case 0x0D00:
+		return XLNXW1_OP_READBYTE;
+	default:
+		return XLNXW1_OP_WRITEBYTE;
+	}
+}
+
+static inline void xlnxw1_stats_add(struct xlnxw1_stats *stats, u32 instr, u64 lat_ns)
+{
+	struct xlnxw1_op_stats *op = &stats->ops[xlnxw1_op_index(instr)];
+	u64 us = div_u64(lat_ns, NSEC_PER_USEC);
+	int bucket = us ? min_t(int, ilog2(us) + 1, XLNXW1_HIST_BUCKETS - 1) : 0;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	if (op->count == 0 || lat_ns < op->min_ns)
+		op->min_ns = lat_ns;
+	if (lat_ns > op->max_ns)
+		op->max_ns = lat_ns;
+	op->count++;
+	op->sum_ns += lat_ns;
+	op->hist[bucket]++;
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
+/*
+ * Trace a primitive, issue_ns 0 if it failed before the instruction write.
+ * flags are W1_TRACE_*.
+ */
+static inline void xlnxw1_stats_trace(struct xlnxw1_stats *stats, u64 start_ns, u64 issue_ns,
+				      u64 end_ns, u32 instr, u8 rx, u8 flags)
+{
+	struct w1_trace_rec rec;
+
+	if (!stats->ring)
+		return;
+	if (issue_ns < start_ns)
+		issue_ns = end_ns;
+	rec.t = start_ns;
+	rec.ready = issue_ns - start_ns;
+	rec.done = end_ns - issue_ns;
+	rec.seq = 0;
+	rec.instr = instr;
+	rec.rx = rx;
+	rec.flags = flags;
+	w1_trace_put(stats->ring, &rec);
+}
+
+static int xlnxw1_latency_show(struct seq_file *s, void *unused)
+{
+	struct xlnxw1_stats *stats = s->private;
+	struct xlnxw1_op_stats op;
+	unsigned long flags;
+	int i, b;
+
+	for (i = 0; i < XLNXW1_NR_OPS; i++) {
+		spin_lock_irqsave(&stats->lock, flags);
+		op = stats->ops[i];
+		spin_unlock_irqrestore(&stats->lock, flags);
+
+		seq_printf(s, "%s: count %llu", xlnxw1_op_names[i], op.count);
+		if (op.count)
+			seq_printf(s, " min %llu avg %llu max %llu us",
+				   div_u64(op.min_ns, NSEC_PER_USEC),
+				   div64_u64(op.sum_ns, op.count * NSEC_PER_USEC),
+				   div_u64(op.max_ns, NSEC_PER_USEC));
+		seq_putc(s, '\n');
+		for (b = 0; b < XLNXW1_HIST_BUCKETS; b++) {
+			if (!op.hist[b])
+				continue;
+			if (b == 0)
+				seq_printf(s, "  %7s %-7u us %10llu\n", "<", 1, op.hist[b]);
+			else if (b == XLNXW1_HIST_BUCKETS - 1)
+				seq_printf(s, "  %7s %-7u us %10llu\n", ">=", 1U << (b - 1), op.hist[b]);
+			else
+				seq_printf(s, "  %7u-%-7u us %10llu\n", 1U << (b - 1),
+					   (1U << b) - 1, op.hist[b]);
+		}
+	}
+	return 0;
+}
+
+static int xlnxw1_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, xlnxw1_latency_show, inode->i_private);
+}
+
+static ssize_t xlnxw1_latency_write(struct file *file, const char __user *buf,
+				    size_t len, loff_t *ppos)
+{
+	struct xlnxw1_stats *stats = ((struct seq_file *)file->private_data)->private;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	memset(stats->ops, 0, sizeof(stats->ops));
+	spin_unlock_irqrestore(&stats->lock, flags);
+	return len;
+}
+
+static const struct file_operations xlnxw1_latency_fops = {
+	.owner = THIS_MODULE,
+	.open = xlnxw1_latency_open,
+	.read = seq_read,
+	.write = xlnxw1_latency_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+/* A read of bus_trace returns the snapshot of the ring taken at open */
+static int xlnxw1_bus_trace_open(struct inode *inode, struct file *file)
+{
+	struct xlnxw1_stats *stats = inode->i_private;
+	struct w1_trace_ring *snap;
+
+	snap = vmalloc(W1_TRACE_RING_BYTES(stats->ring->size));
+	if (!snap)
+		return -ENOMEM;
+	w1_trace_snapshot(stats->ring, snap);
+	file->private_data = snap;
+	return 0;
+}
+
+static ssize_t xlnxw1_bus_trace_read(struct file *file, char __user *buf, size_t len,
+				     loff_t *ppos)
+{
+	struct w1_trace_ring *snap = file->private_data;
+
+	return simple_read_from_buffer(buf, len, ppos, snap, W1_TRACE_RING_BYTES(snap->size));
+}
+
+static int xlnxw1_bus_trace_release(struct inode *inode, struct file *file)
+{
+	vfree(file->private_data);
+	return 0;
+}
+
+static const struct file_operations xlnxw1_bus_trace_fops = {
+	.owner = THIS_MODULE,
+	.open = xlnxw1_bus_trace_open,
+	.read = xlnxw1_bus_trace_read,
+	.llseek = default_llseek,
+	.release = xlnxw1_bus_trace_release,
+};
+
+/*
+ * Create the debugfs files of a device, with a trace ring of trace_records
+ * rounded up to a power of two, none for 0.
+ */
+static inline void xlnxw1_stats_init(struct xlnxw1_stats *stats, struct device *dev,
+				     unsigned int trace_records)
+{
+	char name[64];
+
+	spin_lock_init(&stats->lock);
+	stats->ring = NULL;
+	if (trace_records) {
+		trace_records = roundup_pow_of_two(min(trace_records, 1U << 20));
+		stats->ring = vmalloc(W1_TRACE_RING_BYTES(trace_records));
+		if (stats->ring)
+			w1_trace_init(stats->ring, trace_records, NSEC_PER_SEC);
+		else
+			dev_warn(dev, "No memory for a bus trace of %u records\n", trace_records);
+	}
+	snprintf(name, sizeof(name), "xlnxw1-%s", dev_name(dev));
+	stats->dir = debugfs_create_dir(name, NULL);
+	debugfs_create_file("latency", 0644, stats->dir, stats, &xlnxw1_latency_fops);
+	debugfs_create_u64("timeouts", 0644, stats->dir, &stats->timeouts);
+	debugfs_create_u64("spurious_irqs", 0644, stats->dir, &stats->spurious_irqs);
+	debugfs_create_u64("presence_failures", 0644, stats->dir, &stats->presence_failures);
+	if (stats->ring)
+		debugfs_create_file("bus_trace", 0444, stats->dir, stats, &xlnxw1_bus_trace_fops);
+}
+
+static inline void xlnxw1_stats_remove(struct xlnxw1_stats *stats)
+{
+	debugfs_remove_recursive(stats->dir);
+	stats->dir = NULL;
+	vfree(stats->ring);
+	stats->ring = NULL;
+}
+
+#endif /* XLNXW1_STATS_H */
@@ -0,0 +1,120 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+/*
+ * Tracepoints of the 1-Wire host drivers, under events/xlnxw1_core in tracefs
+ * for amd_axi_w1.c and events/xlnxw1_chardev for w1chardev.c (defining
+ * XLNXW1_TRACE_CHARDEV), so the events of the two modules loaded together
+ * keep distinct names. Every bus primitive traces:
+ *   xlnxw1_ready_wait  blocking on the READY IRQ before the instruction
+ *   xlnxw1_issue       instruction written with GO, the bus time starts
+ *   xlnxw1_done_wait   blocking on the DONE IRQ
+ *   xlnxw1_irq         IRQ handler, with the enables it cleared
+ *   xlnxw1_complete    end of the primitive with its latency
+ * The waits are only traced when the status is not already set, so the
+ * time between issue and complete is the bus time and the rest of a
+ * transaction is host overhead.
+ *
+ * The driver including this file first defines CREATE_TRACE_POINTS, and is
+ * built with its directory in the include path (ccflags-y += -I$(src)).
+ */
+#undef TRACE_SYSTEM
+#ifdef XLNXW1_TRACE_CHARDEV
+#define TRACE_SYSTEM xlnxw1_chardev
+#else
+#define TRACE_SYSTEM xlnxw1_core
+#endif
+
+#if !defined(_XLNXW1_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _XLNXW1_TRACE_H
+
+#include <linux/device.h>
+#include <linux/tracepoint.h>
+
+#define xlnxw1_show_instr(instr)					\
+	__print_symbolic((instr) & 0x0F00,				\
+			 { 0x0800, "INITPRES" },			\
+			 { 0x0C00, "READBIT" },				\
+			 { 0x0E00, "WRITEBIT" },			\
+			 { 0x0D00, "READBYTE" },			\
+			 { 0x0F00, "WRITEBYTE" })
+
+DECLARE_EVENT_CLASS(xlnxw1_op,
+	TP_PROTO(struct device *dev, u32 instr),
+	TP_ARGS(dev, instr),
+	TP_STRUCT__entry(
+		__string(name, dev_name(dev))
+		__field(u32, instr)
+	),
+	TP_fast_assign(
+		__assign_str(name, dev_name(dev));
+		__entry->instr = instr;
+	),
+	TP_printk("%s %s instr=0x%04x", __get_str(name),
+		  xlnxw1_show_instr(__entry->instr), __entry->instr)
+);
+
+DEFINE_EVENT(xlnxw1_op, xlnxw1_ready_wait,
+	TP_PROTO(struct device *dev, u32 instr),
+	TP_ARGS(dev, instr)
+);
+
+DEFINE_EVENT(xlnxw1_op, xlnxw1_issue,
+	TP_PROTO(struct device *dev, u32 instr),
+	TP_ARGS(dev, instr)
+);
+
+DEFINE_EVENT(xlnxw1_op, xlnxw1_done_wait,
+	TP_PROTO(struct device *dev, u32 instr),
+	TP_ARGS(dev, instr)
+);
+
+TRACE_EVENT(xlnxw1_irq,
+	TP_PROTO(struct device *dev, u32 instr, u32 irqe, u32 stat),
+	TP_ARGS(dev, instr, irqe, stat),
+	TP_STRUCT__entry(
+		__string(name, dev_name(dev))
+		__field(u32, instr)
+		__field(u32, irqe)
+		__field(u32, stat)
+	),
+	TP_fast_assign(
+		__assign_str(name, dev_name(dev));
+		__entry->instr = instr;
+		__entry->irqe = irqe;
+		__entry->stat = stat;
+	),
+	TP_printk("%s %s irqe=0x%x stat=0x%08x", __get_str(name),
+		  xlnxw1_show_instr(__entry->instr), __entry->irqe, __entry->stat)
+);
+
+TRACE_EVENT(xlnxw1_complete,
+	TP_PROTO(struct device *dev, u32 instr, u32 val, int ret, u64 lat_ns),
+	TP_ARGS(dev, instr, val, ret, lat_ns),
+	TP_STRUCT__entry(
+		__string(name, dev_name(dev))
+		__field(u32, instr)
+		__field(u32, val)
+		__field(int, ret)
+		__field(u64, lat_ns)
+	),
+	TP_fast_assign(
+		__assign_str(name, dev_name(dev));
+		__entry->instr = instr;
+		__entry->val = val;
+		__entry->ret = ret;
+		__entry->lat_ns = lat_ns;
+	),
+	TP_printk("%s %s val=0x%02x ret=%d lat_ns=%llu", __get_str(name),
+		  xlnxw1_show_instr(__entry->instr), __entry->val, __entry->ret,
+		  __entry->lat_ns)
+);
+
+#endif /* _XLNXW1_TRACE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE xlnxw1_trace
+#include <trace/define_trace.h>
@@ -0,0 +1,594 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+
+/*
+ * xlnxw1d: samples the temperature sensors of all the 1-Wire buses from a
+ * single process and publishes the values through a Unix socket and a shared
+ * memory table (see xlnxw1d.h).
+ *
+ * The character driver ioctls block for the whole bus operation, so every
+ * bus gets a worker thread, the buses running concurrently. The main thread
+ * serves the socket clients from an epoll loop and is woken up through an
+ * eventfd when new samples are available. Bus sampling is staggered over the
+ * period and a counting semaphore bounds the number of conversions running
+ * at the same time, the sensors drawing their conversion current from the
+ * bus supply.
+ *
+ * The sensors of each bus are saved to a ROM cache file, so that a restart
+ * samples them at once instead of searching the bus first. A cached sensor
+ * whose reading fails is checked with a Search ROM pass along its ROM ID and
+ * a full search runs if it is gone. The sensors plugged in are found by one
+ * Search ROM pass per period, the search resuming from the last discrepancy.
+ *
+ * In monitoring mode (-a), only the sensors out of their TH/TL limits are
+ * read: the conversion is followed by an Alarm Search and the other sensors
+ * keep their last sample. All the sensors are read every full_sweep_interval
+ * periods, which also publishes the sensors back within their limits.
+ *
+ * The clients may also send "pio" lines to set the latch of a DS2413/DS2408
+ * switch (xlnxw1d.h). The main thread runs them at once with
+ * xlnxw1_pio_write() on the handle of the bus, on the priority lane of the
+ * driver, which takes the bus from the worker at the end of its transaction
+ * in progress. A driver without the lane would run them as transactions on
+ * the handle of the worker: they fail with EOPNOTSUPP then.
+ *
+ * With -l, the samples are also appended to a binary log (xlnxw1_log.h),
+ * timed at the start of the conversion of their bus to the log tick, so the
+ * samples of a sensor are a period apart and compress into runs.
+ *
+ * Usage: xlnxw1d [-p period_ms] [-c max_conversions] [-s socket] [-m shm_name]
+ *                [-r cache_dir] [-a full_sweep_interval] [-l log] [device...]
+ *   -r  directory of the ROM cache files, "" for none
+ *   -l  sample log file, appended to
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "libxlnxw1.h"
+#include "w1_crc.h"
+#include "w1_temp.h"
+#include "xlnxw1_log.h"
+#include "xlnxw1d.h"
+
+#define XLNXW1D_MAX_CLIENTS	16
+#define XLNXW1D_LINE_SIZE	64
+#define XLNXW1D_CACHE_DIR	"/var/lib/xlnxw1d"
+#define XLNXW1D_LOG_TICK_US	10000
+
+struct w1_bus {
+	int index;
+	const char *path;
+	struct xlnxw1 w1;
+	int nsensors;
+	uint8_t roms[XLNXW1D_BUS_SENSORS][8];
+	struct xlnxw1_search search;	/* Hotplug search, a pass per period */
+	char cache[PATH_MAX];		/* ROM cache file, empty for none */
+	unsigned int sweeps;		/* Periods since the last enumeration */
+	pthread_t thread;
+};
+
+static struct w1_bus buses[XLNXW1D_MAX_BUSES];
+static int nbuses;
+static unsigned int period_ms = 1000;
+static const char *cache_dir = XLNXW1D_CACHE_DIR;
+static unsigned int full_sweep_interval;	/* Monitoring mode if not 0 */
+static sem_t power_budget;
+static struct xlnxw1d_table *table;
+static int event_fd = -1;
+static int running = 1;
+
+static struct xlnxw1_log_writer sample_log;	/* fd -1 without -l */
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int clients[XLNXW1D_MAX_CLIENTS];
+static int nclients;
+static uint32_t broadcast_samples[XLNXW1D_MAX_SENSORS];
+
+static int is_temp_family(uint8_t family)
+{
+	return family == W1_FAMILY_DS18S20 || family == W1_FAMILY_DS1822 ||
+	       family == W1_FAMILY_DS18B20 || family == W1_FAMILY_MAX31850;
+}
+
+static void timespec_add_ms(struct timespec *ts, unsigned int ms)
+{
+	ts->tv_sec += ms / 1000;
+	ts->tv_nsec += (long)(ms % 1000) * 1000000;
+	if (ts->tv_nsec >= 1000000000) {
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000;
+	}
+}
+
+/* Update a slot of the shared table, readers retry while seq is odd */
+static void publish(struct xlnxw1d_sensor *slot, const uint8_t *rom, int status, int32_t millideg)
+{
+	uint32_t seq = slot->seq;
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+
+	__atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(slot->rom, rom, sizeof(slot->rom));
+	slot->status = status;
+	if (status == 0)
+		slot->millideg = millideg;
+	slot->samples++;
+	slot->timestamp_ns = (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+	__atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/* The workers share the writer, the first error is reported */
+static void log_sample(const uint8_t *rom, uint64_t time_ns, int status, int32_t millideg)
+{
+	static int failed;
+	int ret;
+
+	if (sample_log.fd < 0)
+		return;
+	pthread_mutex_lock(&log_lock);
+	ret = xlnxw1_log_append(&sample_log, rom, time_ns, status, millideg);
+	if (ret < 0 && !failed++)
+		printf("Cannot write the sample log: %s\n", strerror(-ret));
+	pthread_mutex_unlock(&log_lock);
+}
+
+static void enumerate(struct w1_bus *bus)
+{
+	uint8_t roms[XLNXW1D_BUS_SENSORS][8];
+	int i, n, ret;
+
+	n = xlnxw1_search(&bus->w1, W1_SEARCH_ROM, roms, XLNXW1D_BUS_SENSORS);
+	bus->nsensors = 0;
+	for (i = 0; i < n; i++)
+		if (is_temp_family(roms[i][0]))
+			memcpy(bus->roms[bus->nsensors++], roms[i], 8);
+	printf("%s: %d temperature sensor(s)\n", bus->path, bus->nsensors);
+
+	if (bus->cache[0] != '\0' && n >= 0) {
+		ret = xlnxw1_rom_cache_save(bus->cache, bus->roms, bus->nsensors);
+		if (ret < 0)
+			printf("%s: cannot save %s: %s\n", bus->path, bus->cache, strerror(-ret));
+	}
+}
+
+/* The sensors of the last run, checked by their first readings */
+static void load_cache(struct w1_bus *bus)
+{
+	char path[PATH_MAX];
+	int n;
+
+	if (cache_dir[0] == '\0')
+		return;
+	snprintf(path, sizeof(path), "%s", bus->path);
+	snprintf(bus->cache, sizeof(bus->cache), "%s/%s.roms", cache_dir, basename(path));
+	n = xlnxw1_rom_cache_load(bus->cache, bus->roms, XLNXW1D_BUS_SENSORS);
+	if (n > 0) {
+		bus->nsensors = n;
+		printf("%s: %d temperature sensor(s) from %s\n", bus->path, n, bus->cache);
+		/* As xlnxw1_search() does, so the reads select them from the table */
+		xlnxw1_rom_table_load(&bus->w1, bus->roms, n);
+	}
+}
+
+static int rom_in(uint8_t (*roms)[8], int n, const uint8_t *rom)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		if (memcmp(roms[i], rom, 8) == 0)
+			return 1;
+	return 0;
+}
+
+static void *bus_worker(void *arg)
+{
+	struct w1_bus *bus = arg;
+	struct xlnxw1d_sensor *slots = &table->sensors[bus->index * XLNXW1D_BUS_SENSORS];
+	uint8_t alarms[XLNXW1D_BUS_SENSORS][8];
+	uint8_t scratchpad[W1_SCRATCHPAD_SIZE];
+	struct timespec next, now;
+	uint64_t one = 1, conv_ns;
+	int32_t millideg;
+	int i, conv, ret, lost, nalarms;
+
+	load_cache(bus);
+	xlnxw1_search_init(&bus->search);
+
+	/* Spread the buses over the period */
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	timespec_add_ms(&next, bus->index * period_ms / nbuses);
+
+	while (__atomic_load_n(&running, __ATOMIC_RELAXED)) {
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR)
+			;
+		timespec_add_ms(&next, period_ms);
+
+		if (bus->nsensors == 0) {
+			enumerate(bus);
+			if (bus->nsensors == 0)
+				continue;
+		}
+
+		/*
+		 * Convert on all the sensors of the bus at once (Skip ROM), waiting
+		 * for the longest conversion time as their resolutions are unknown
+		 */
+		while (sem_wait(&power_budget) < 0 && errno == EINTR)
+			;
+		clock_gettime(CLOCK_REALTIME, &now);
+		conv_ns = (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+		conv = xlnxw1_ds18b20_convert(&bus->w1, NULL, 0);
+		sem_post(&power_budget);
+
+		/*
+		 * Monitoring mode: the sensors in alarm answer the Alarm Search, a
+		 * failed search reads all of them
+		 */
+		nalarms = -1;
+		if (full_sweep_interval && conv == 0 && bus->sweeps++ % full_sweep_interval != 0)
+			nalarms = xlnxw1_search(&bus->w1, W1_ALARM_SEARCH, alarms,
+						XLNXW1D_BUS_SENSORS);
+
+		lost = (conv == -ENODEV);
+		for (i = 0; i < bus->nsensors; i++) {
+			if (nalarms >= 0 && !rom_in(alarms, nalarms, bus->roms[i]))
+				continue;
+			ret = conv;
+			if (ret == 0)
+				ret = xlnxw1_ds18b20_read_scratchpad(&bus->w1, bus->roms[i], scratchpad,
+								     W1_SCRATCHPAD_SIZE);
+			/* A sensor gone reads as all ones, tell it from a corrupted read */
+			if (ret == -EIO && xlnxw1_verify(&bus->w1, bus->roms[i]) == -ENODEV)
+				ret = -ENODEV;
+			lost |= (ret == -ENODEV);
+			millideg = ret ? 0 :
+				   w1_temp_to_millideg(w1_temp_decode(bus->roms[i][0], 0, scratchpad));
+			publish(&slots[i], bus->roms[i], ret, millideg);
+			log_sample(bus->roms[i], conv_ns, ret, millideg);
+		}
+		/* One more device of the hotplug search, a new sensor means a new enumeration */
+		if (!lost && xlnxw1_search_next(&bus->w1, W1_SEARCH_ROM, &bus->search) == 1 &&
+		    is_temp_family(bus->search.rom[0]) &&
+		    !rom_in(bus->roms, bus->nsensors, bus->search.rom))
+			lost = 1;
+
+		/* Sensors lost or added are found back by a new search */
+		if (lost) {
+			bus->nsensors = 0;
+			bus->sweeps = 0;
+			xlnxw1_search_init(&bus->search);
+		}
+
+		if (write(event_fd, &one, sizeof(one)) < 0)
+			perror("eventfd");
+	}
+	return NULL;
+}
+
+/*************************** Socket publication ****************************/
+static int format_sensor(int slot, char *line)
+{
+	struct xlnxw1d_sensor s;
+	char value[16];
+
+	xlnxw1d_read_sensor(&table->sensors[slot], &s);
+	if (s.rom[0] == 0)
+		return 0;
+	if (s.status)
+		snprintf(value, sizeof(value), "err:%d", -s.status);
+	else
+		snprintf(value, sizeof(value), "%d", s.millideg);
+	broadcast_samples[slot] = s.samples;
+	return snprintf(line, XLNXW1D_LINE_SIZE,
+			"%d %02x%02x%02x%02x%02x%02x%02x%02x %s %u\n",
+			slot / XLNXW1D_BUS_SENSORS, s.rom[0], s.rom[1], s.rom[2], s.rom[3],
+			s.rom[4], s.rom[5], s.rom[6], s.rom[7], value, s.samples);
+}
+
+static void drop_client(int i)
+{
+	close(clients[i]);
+	clients[i] = clients[--nclients];
+}
+
+/* A client which cannot take a line at once is too slow and dropped */
+static int send_line(int fd, const char *line, int len)
+{
+	return send(fd, line, len, MSG_DONTWAIT | MSG_NOSIGNAL) == len ? 0 : -1;
+}
+
+static int epoll_add(int epfd, int fd)
+{
+	struct epoll_event ev = { .events = EPOLLIN, .data.fd = fd };
+
+	return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+/* Run the pio lines of a client, answered to it only. -1 once it hung up */
+static int client_command(int fd)
+{
+	char buf[XLNXW1D_LINE_SIZE * 4], reply[XLNXW1D_LINE_SIZE], *line, *save;
+	unsigned int b[8], value;
+	uint8_t rom[8], state = 0;
+	ssize_t n;
+	int bus, i, ret, len;
+
+	n = recv(fd, buf, sizeof(buf) - 1, 0);
+	if (n <= 0)
+		return n < 0 && errno == EAGAIN ? 0 : -1;
+	buf[n] = '\0';
+	for (line = strtok_r(buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+		if (sscanf(line, "pio %d %02x%02x%02x%02x%02x%02x%02x%02x %x", &bus, &b[0], &b[1],
+			   &b[2], &b[3], &b[4], &b[5], &b[6], &b[7], &value) != 10 ||
+		    bus < 0 || bus >= nbuses || value > 0xFF) {
+			ret = -EINVAL;
+			bus = -1;
+			memset(rom, 0, sizeof(rom));
+		} else {
+			for (i = 0; i < 8; i++)
+				rom[i] = (uint8_t)b[i];
+			ret = buses[bus].w1.has_pio_write ?
+			      xlnxw1_pio_write(&buses[bus].w1, rom, (uint8_t)value, &state) :
+			      -EOPNOTSUPP;
+		}
+		len = snprintf(reply, sizeof(reply), "pio %d %02x%02x%02x%02x%02x%02x%02x%02x ",
+			       bus, rom[0], rom[1], rom[2], rom[3], rom[4], rom[5], rom[6], rom[7]);
+		len += ret ? snprintf(reply + len, sizeof(reply) - len, "err:%d\n", -ret) :
+			     snprintf(reply + len, sizeof(reply) - len, "%02x\n", state);
+		if (send_line(fd, reply, len) < 0)
+			return -1;
+	}
+	return 0;
+}
+
+static void accept_client(int epfd, int listen_fd)
+{
+	char line[XLNXW1D_LINE_SIZE];
+	int fd, slot, len;
+
+	fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (fd < 0)
+		return;
+	if (nclients == XLNXW1D_MAX_CLIENTS) {
+		close(fd);
+		return;
+	}
+	for (slot = 0; slot < XLNXW1D_MAX_SENSORS; slot++) {
+		len = format_sensor(slot, line);
+		if (len > 0 && send_line(fd, line, len) < 0) {
+			close(fd);
+			return;
+		}
+	}
+	if (epoll_add(epfd, fd) < 0) {
+		close(fd);
+		return;
+	}
+	clients[nclients++] = fd;
+}
+
+static void broadcast(void)
+{
+	char line[XLNXW1D_LINE_SIZE];
+	int slot, len, i;
+
+	for (slot = 0; slot < XLNXW1D_MAX_SENSORS; slot++) {
+		if (__atomic_load_n(&table->sensors[slot].samples, __ATOMIC_RELAXED) ==
+		    broadcast_samples[slot])
+			continue;
+		len = format_sensor(slot, line);
+		if (len <= 0)
+			continue;
+		for (i = nclients - 1; i >= 0; i--)
+			if (send_line(clients[i], line, len) < 0)
+				drop_client(i);
+	}
+}
+
+static int open_socket(const char *path)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	int fd;
+
+	if (strlen(path) >= sizeof(addr.sun_path))
+		return -1;
+	strcpy(addr.sun_path, path);
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -1;
+	unlink(path);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 8) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static struct xlnxw1d_table *open_table(const char *name)
+{
+	struct xlnxw1d_table *t;
+	int fd;
+
+	fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+	if (fd < 0)
+		return NULL;
+	if (ftruncate(fd, sizeof(*t)) < 0) {
+		close(fd);
+		return NULL;
+	}
+	t = mmap(NULL, sizeof(*t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (t == MAP_FAILED)
+		return NULL;
+	memset(t, 0, sizeof(*t));
+	t->version = XLNXW1D_VERSION;
+	t->nbuses = nbuses;
+	__atomic_store_n(&t->magic, XLNXW1D_MAGIC, __ATOMIC_RELEASE);
+	return t;
+}
+
+int main(int argc, char **argv)
+{
+	const char *socket_path = XLNXW1D_SOCKET_PATH;
+	const char *shm_name = XLNXW1D_SHM_NAME;
+	const char *log_path = NULL;
+	unsigned int max_conversions = 1;
+	struct epoll_event ev;
+	struct signalfd_siginfo si;
+	uint64_t count;
+	sigset_t sigs;
+	int listen_fd, signal_fd, epfd, opt, i, ret;
+
+	sample_log.fd = -1;
+	while ((opt = getopt(argc, argv, "p:c:s:m:r:a:l:")) != -1) {
+		switch (opt) {
+		case 'p':
+			period_ms = strtoul(optarg, NULL, 0);
+			break;
+		case 'c':
+			max_conversions = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			socket_path = optarg;
+			break;
+		case 'm':
+			shm_name = optarg;
+			break;
+		case 'r':
+			cache_dir = optarg;
+			break;
+		case 'a':
+			full_sweep_interval = strtoul(optarg, NULL, 0);
+			break;
+		case 'l':
+			log_path = optarg;
+			break;
+		default:
+			printf("Usage: %s [-p period_ms] [-c max_conversions] [-s socket] [-m shm_name] "
+			       "[-r cache_dir] [-a full_sweep_interval] [-l log] [device...]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (period_ms == 0 || max_conversions == 0) {
+		printf("The period and the number of conversions must not be 0\n");
+		return 1;
+	}
+
+	for (i = optind; i < argc || (i == optind && argc == optind); i++) {
+		if (nbuses == XLNXW1D_MAX_BUSES) {
+			printf("Too many buses, %d at most\n", XLNXW1D_MAX_BUSES);
+			return 1;
+		}
+		buses[nbuses].index = nbuses;
+		buses[nbuses].path = i < argc ? argv[i] : XLNX_W1_DEVICE_NAME;
+		ret = xlnxw1_open(&buses[nbuses].w1, buses[nbuses].path);
+		if (ret < 0) {
+			printf("Cannot open %s: %s\n", buses[nbuses].path, strerror(-ret));
+			return 1;
+		}
+		nbuses++;
+	}
+
+	if (log_path) {
+		ret = xlnxw1_log_writer_open(&sample_log, log_path, XLNXW1D_LOG_TICK_US);
+		if (ret < 0) {
+			printf("Cannot open %s: %s\n", log_path, strerror(-ret));
+			return 1;
+		}
+	}
+
+	table = open_table(shm_name);
+	if (table == NULL) {
+		perror("shared memory");
+		return 1;
+	}
+	listen_fd = open_socket(socket_path);
+	if (listen_fd < 0) {
+		perror("socket");
+		return 1;
+	}
+	event_fd = eventfd(0, EFD_CLOEXEC);
+	sem_init(&power_budget, 0, max_conversions);
+
+	/* Block the termination signals in all the threads, the main loop takes them */
+	sigemptyset(&sigs);
+	sigaddset(&sigs, SIGINT);
+	sigaddset(&sigs, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+	signal_fd = signalfd(-1, &sigs, SFD_CLOEXEC);
+
+	epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (event_fd < 0 || signal_fd < 0 || epfd < 0 ||
+	    epoll_add(epfd, listen_fd) < 0 || epoll_add(epfd, event_fd) < 0 ||
+	    epoll_add(epfd, signal_fd) < 0) {
+		perror("epoll");
+		return 1;
+	}
+
+	for (i = 0; i < nbuses; i++) {
+		ret = pthread_create(&buses[i].thread, NULL, bus_worker, &buses[i]);
+		if (ret != 0) {
+			printf("Cannot start the %s worker: %s\n", buses[i].path, strerror(ret));
+			return 1;
+		}
+	}
+
+	while (__atomic_load_n(&running, __ATOMIC_RELAXED)) {
+		if (epoll_wait(epfd, &ev, 1, -1) < 1)
+			continue;
+		if (ev.data.fd == listen_fd) {
+			accept_client(epfd, listen_fd);
+		} else if (ev.data.fd == event_fd) {
+			if (read(event_fd, &count, sizeof(count)) == sizeof(count))
+				broadcast();
+		} else if (ev.data.fd == signal_fd) {
+			if (read(signal_fd, &si, sizeof(si)) == sizeof(si))
+				__atomic_store_n(&running, 0, __ATOMIC_RELAXED);
+		} else {
+			/* Closing its fd removes a client from the epoll set */
+			for (i = 0; i < nclients; i++)
+				if (clients[i] == ev.data.fd && client_command(clients[i]) < 0)
+					drop_client(i);
+		}
+	}
+
+	/* The workers stop at their next period */
+	for (i = 0; i < nbuses; i++) {
+		pthread_join(buses[i].thread, NULL);
+		xlnxw1_close(&buses[i].w1);
+	}
+	/* The samples buffered since the last chunk */
+	if (sample_log.fd >= 0) {
+		ret = xlnxw1_log_writer_close(&sample_log);
+		if (ret < 0)
+			printf("Cannot write the sample log: %s\n", strerror(-ret));
+	}
+	while (nclients)
+		drop_client(0);
+	close(listen_fd);
+	unlink(socket_path);
+	shm_unlink(shm_name);
+
+	return 0;
+}
@@ -0,0 +1,74 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef XLNXW1D_H
+#define XLNXW1D_H
+
+/*
+ * Interfaces of xlnxw1d, the daemon sampling the temperature sensors of all
+ * the 1-Wire buses.
+ *
+ * Unix socket: every client connected to XLNXW1D_SOCKET_PATH first receives
+ * one line per known sensor, then one line per new sample:
+ *     <bus> <rom id, 16 hex digits> <millidegrees|error> <sample count>
+ * where error is "err:<errno>". A client sets the latch of a DS2413/DS2408
+ * switch with the line
+ *     pio <bus> <rom id, 16 hex digits> <latch byte, hex>
+ * answered to it only, among the sample lines, by
+ *     pio <bus> <rom id> <PIO status byte, 2 hex digits|error>
+ * the error being err:95 (EOPNOTSUPP) with a driver without
+ * XLNX_IOCTL_PIO_WRITE.
+ *
+ * Shared memory: XLNXW1D_SHM_NAME (shm_open()) holds a struct xlnxw1d_table.
+ * Slot bus * XLNXW1D_BUS_SENSORS + n is the n-th sensor of the bus, unused
+ * slots have a null ROM ID. The daemon updates a slot under a sequence
+ * counter, read it with xlnxw1d_read_sensor().
+ */
+
+#include <stdint.h>
+
+#define XLNXW1D_SOCKET_PATH	"/run/xlnxw1d.sock"
+#define XLNXW1D_SHM_NAME	"/xlnxw1d"
+
+#define XLNXW1D_MAGIC		0x44315758	/* "XW1D" */
+#define XLNXW1D_VERSION		1
+
+#define XLNXW1D_MAX_BUSES	4
+#define XLNXW1D_BUS_SENSORS	16
+#define XLNXW1D_MAX_SENSORS	(XLNXW1D_MAX_BUSES * XLNXW1D_BUS_SENSORS)
+
+struct xlnxw1d_sensor {
+	uint32_t seq;		/* Odd while the slot is being written */
+	uint32_t samples;	/* Samples taken since the daemon start */
+	uint8_t rom[8];		/* ROM ID, null if the slot is unused */
+	int32_t millideg;	/* Last temperature, valid if status is 0 */
+	int32_t status;		/* 0 or the negative errno of the last sample */
+	uint64_t timestamp_ns;	/* CLOCK_REALTIME of the last sample */
+};
+
+struct xlnxw1d_table {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t nbuses;
+	uint32_t reserved;
+	struct xlnxw1d_sensor sensors[XLNXW1D_MAX_SENSORS];
+};
+
+/*
+ * Copy a slot of the shared table, retrying while the daemon updates it.
+ */
+static inline void xlnxw1d_read_sensor(const struct xlnxw1d_sensor *slot,
+				       struct xlnxw1d_sensor *out)
+{
+	uint32_t seq;
+
+	do {
+		while ((seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE)) & 1)
+			;
+		__builtin_memcpy(out, (const void *)slot, sizeof(*out));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq);
+}
+
+#endif /* XLNXW1D_H */
@@ -0,0 +1,33 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+/*
+ * Simulation shim of FreeRTOS.h, for the port layer built with
+ * AXI_1WIRE_HOST_RTOS (w1_sim_rtos.c): a tick is a ms of the virtual time.
+ */
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define configTICK_RATE_HZ		1000
+#define configUSE_RECURSIVE_MUTEXES	1
+
+#define pdFALSE		0
+#define pdTRUE		1
+#define pdPASS		pdTRUE
+#define pdFAIL		pdFALSE
+
+#define pdMS_TO_TICKS(ms)	((TickType_t)(ms) * configTICK_RATE_HZ / 1000)
+#define portMAX_DELAY		((TickType_t)0xFFFFFFFF)
+
+/* The handler runs in the scheduler, which picks the next task anyway */
+#define portYIELD_FROM_ISR(x)	((void)(x))
+
+#endif /* FREERTOS_H */
@@ -0,0 +1,15 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef SLEEP_H
+#define SLEEP_H
+
+/* Simulation shim of the BSP sleep.h, sleeping in virtual time */
+
+#include "xil_types.h"
+
+int usleep(unsigned long useconds);
+unsigned sleep(unsigned int seconds);
+
+#endif /* SLEEP_H */
@@ -0,0 +1,26 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef TASK_H
+#define TASK_H
+
+/*
+ * Simulation shim of task.h. The tasks are threads run one at a time, each
+ * up to its next block, the highest priority ready one first. Unlike
+ * FreeRTOS, vTaskStartScheduler() returns once all the tasks are deleted.
+ */
+
+#include "FreeRTOS.h"
+
+typedef struct w1_sim_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char *pcName, uint32_t usStackDepth,
+		       void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pxCreatedTask);
+void vTaskDelete(TaskHandle_t xTaskToDelete);
+void vTaskDelay(TickType_t xTicksToDelay);
+TickType_t xTaskGetTickCount(void);
+void vTaskStartScheduler(void);
+
+#endif /* TASK_H */
@@ -0,0 +1,19 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef XIL_IO_H
+#define XIL_IO_H
+
+/*
+ * Simulation shim of the BSP xil_io.h: the accesses go to the w1_sim
+ * instance mapped at the address, see w1_sim_init().
+ */
+
+#include "xil_types.h"
+#include "xil_printf.h"	/* As the BSP xil_io.h */
+
+u32 Xil_In32(UINTPTR Addr);
+void Xil_Out32(UINTPTR Addr, u32 Value);
+
+#endif /* XIL_IO_H */
@@ -0,0 +1,12 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef XIL_PRINTF_H
+#define XIL_PRINTF_H
+
+/* Simulation shim of the BSP xil_printf.h, printing to stdout */
+
+void xil_printf(const char *ctrl1, ...);
+
+#endif /* XIL_PRINTF_H */
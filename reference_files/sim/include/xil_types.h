@@ -0,0 +1,33 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef XIL_TYPES_H
+#define XIL_TYPES_H
+
+/* Simulation shim of the BSP xil_types.h */
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef uintptr_t UINTPTR;
+typedef intptr_t INTPTR;
+
+#ifndef TRUE
+#define TRUE	1U
+#endif
+#ifndef FALSE
+#define FALSE	0U
+#endif
+
+#define INLINE	inline
+
+#endif /* XIL_TYPES_H */
@@ -0,0 +1,13 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef XPARAMETERS_H
+#define XPARAMETERS_H
+
+/* Simulation shim of the generated xparameters.h */
+
+#define XPAR_AXI_1WIRE_HOST_0_BASEADDR	0xA0000000
+#define XPAR_AXI_1WIRE_HOST_0_HIGHADDR	0xA000003F
+
+#endif /* XPARAMETERS_H */
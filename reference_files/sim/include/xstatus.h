@@ -0,0 +1,19 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef XSTATUS_H
+#define XSTATUS_H
+
+/* Simulation shim of the BSP xstatus.h, the codes used by the drivers */
+
+typedef int XStatus;
+
+#define XST_SUCCESS		0L
+#define XST_FAILURE		1L
+#define XST_DEVICE_NOT_FOUND	2L
+#define XST_INVALID_PARAM	15L
+#define XST_DEVICE_BUSY		21L
+#define XST_TIMEOUT		1021L
+
+#endif /* XSTATUS_H */
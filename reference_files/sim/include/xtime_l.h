@@ -0,0 +1,21 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef XTIME_L_H
+#define XTIME_L_H
+
+/*
+ * Simulation shim of the BSP xtime_l.h: the global timer counts the virtual
+ * time of the model in ns, each read costing W1_SIM_TIMER_NS.
+ */
+
+#include "xil_types.h"
+
+typedef u64 XTime;
+
+#define COUNTS_PER_SECOND	1000000000ULL
+
+void XTime_GetTime(XTime *Xtime_Global);
+
+#endif /* XTIME_L_H */
@@ -0,0 +1,936 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#include <string.h>
+#include "w1_sim.h"
+#include "w1_crc.h"
+
+/* Register bits */
+#define INSTR_GPIO	0x80000000	/* Bus driven by the GPIO bits */
+#define INSTR_GPIO_T	0x00800000	/* GPIO mode: 1 to release the bus */
+#define INSTR_GPIO_O	0x00010000	/* GPIO mode: level driven */
+#define INSTR_SPU	0x00001000
+#define CTRL_RESET	0x80000000
+#define CTRL_GO		0x00000001
+#define BCNT_STREAM	0x80000000
+#define ROMIDX_ENTRIES	24	/* Number of entries, MSB of ROMIDX */
+#define CAPS_FIXED	0x1B	/* SPU, TIMING, ROM_TABLE and POLL_BIT */
+#define CAPS_BLOCK	0x04	/* Stream ports */
+#define CAPS_ROM_ENTRIES	8	/* Number of entries, CAPS[15:8] */
+#define STAT_DONE	0x00000001
+#define STAT_READY	0x00000010
+#define STAT_PRESENCE	0x80000000
+
+/* FSM states of w1_master.v, as issued in the command field */
+#define CMD_IDLE	0x1
+#define CMD_TX_RST_PLS	0x2
+#define CMD_RX_PRE_PLS	0x3
+#define CMD_DONE	0x4
+#define CMD_SPU		0x5
+#define CMD_PING_ALL	0x6	/* w1_romsel.v */
+#define CMD_POLL_BIT	0x7
+#define CMD_INIT	0x8
+#define CMD_RX_BLOCK	0x9	/* w1_bulk.v */
+#define CMD_SELECT_ROM	0xA	/* w1_romsel.v */
+#define CMD_TX_BLOCK	0xB
+#define CMD_RX_BIT	0xC
+#define CMD_RX_BYTE	0xD
+#define CMD_TX_BIT	0xE
+#define CMD_TX_BYTE	0xF
+
+/* Presence pulse of the devices after the reset pulse release */
+#define PDHIGH_US	30
+#define PDLOW_US	120
+
+/* Standard speed limits of the devices */
+#define DEV_TRSTL_MIN_US	480	/* Shorter low is not a reset */
+#define DEV_TSLOT_MIN_US	60	/* Shorter slot or recovery, the next */
+#define DEV_TREC_MIN_US		1	/* falling edge is missed */
+#define DEV_TLOW1_MIN_US	1	/* Shorter low is missed */
+#define DEV_TLOW1_MAX_US	15	/* Longer low is sampled as a 0 */
+#define DEV_TLOW0_MIN_US	60	/* Shorter low may be sampled as a 1 */
+#define DEV_TRDV_US		15	/* A read-0 is released after */
+
+#define US		1000ULL
+
+/* HOST_STALLED: block waiting for its stream, only a reset gets it out */
+enum { HOST_IDLE, HOST_BUSY, HOST_DONE, HOST_STUCK, HOST_STALLED };
+
+enum { DEV_ROM_CMD, DEV_MATCH, DEV_SEARCH, DEV_FUNCTION, DEV_INACTIVE };
+
+static uint64_t now_ns;
+static uint32_t axi_read_ns = W1_SIM_AXI_READ_NS;
+static uint32_t axi_write_ns = W1_SIM_AXI_WRITE_NS;
+static uint32_t timer_ns = W1_SIM_TIMER_NS;
+static struct w1_sim *hosts[W1_SIM_MAX_HOSTS];
+
+/************************** Virtual clock ***************************/
+uint64_t w1_sim_now_ns(void)
+{
+	return now_ns;
+}
+
+void w1_sim_advance_ns(uint64_t ns)
+{
+	now_ns += ns;
+}
+
+void w1_sim_set_costs(uint32_t axi_read, uint32_t axi_write, uint32_t timer)
+{
+	axi_read_ns = axi_read;
+	axi_write_ns = axi_write;
+	timer_ns = timer;
+}
+
+uint32_t w1_sim_timer_cost_ns(void)
+{
+	return timer_ns;
+}
+
+/* First rising edge of the AXI clock after t */
+static uint64_t edge(uint64_t t)
+{
+	return (t / W1_SIM_CLK_NS + 1) * W1_SIM_CLK_NS;
+}
+
+/************************** ROM layer ***************************/
+static int rom_bit(const struct w1_sim_device *dev, int n)
+{
+	return (dev->rom[n >> 3] >> (n & 7)) & 1;
+}
+
+static int tx_pending(const struct w1_sim_device *dev)
+{
+	return dev->tx_bit < dev->tx_len * 8;
+}
+
+void w1_sim_device_init(struct w1_sim_device *dev, uint8_t family, uint64_t serial,
+			const struct w1_sim_device_ops *ops)
+{
+	int i;
+
+	memset(dev, 0, sizeof(*dev));
+	dev->rom[0] = family;
+	for (i = 1; i < 7; i++)
+		dev->rom[i] = (uint8_t)(serial >> (8 * (i - 1)));
+	dev->rom[7] = w1_crc8(0, dev->rom, 7);
+	dev->ops = ops;
+	dev->state = DEV_INACTIVE;
+}
+
+void w1_sim_device_queue(struct w1_sim_device *dev, const uint8_t *buf, int len)
+{
+	if (!tx_pending(dev)) {
+		dev->tx_len = 0;
+		dev->tx_bit = 0;
+	}
+	if (len > W1_SIM_DEV_TX_SIZE - dev->tx_len)
+		len = W1_SIM_DEV_TX_SIZE - dev->tx_len;
+	memcpy(&dev->tx[dev->tx_len], buf, len);
+	dev->tx_len += len;
+}
+
+static void dev_reset(struct w1_sim_device *dev)
+{
+	if (dev->ops && dev->ops->reset)
+		dev->ops->reset(dev);
+	dev->state = DEV_ROM_CMD;
+	dev->nbits = 0;
+	dev->rx = 0;
+	dev->tx_len = 0;
+	dev->tx_bit = 0;
+}
+
+static void dev_rom_command(struct w1_sim_device *dev, uint8_t cmd)
+{
+	dev->nbits = 0;
+	dev->rx = 0;
+	if (cmd == 0xA5 && dev->has_resume) {
+		/* Resume: the device selected last, without its ROM ID */
+		dev->state = dev->resume ? DEV_FUNCTION : DEV_INACTIVE;
+		return;
+	}
+	dev->resume = 0;
+	switch (cmd) {
+	case 0x33:	/* Read ROM */
+		dev->state = DEV_FUNCTION;
+		w1_sim_device_queue(dev, dev->rom, 8);
+		break;
+	case 0x55:	/* Match ROM */
+		dev->state = DEV_MATCH;
+		break;
+	case 0xCC:	/* Skip ROM */
+		dev->state = DEV_FUNCTION;
+		break;
+	case 0xEC:	/* Alarm Search */
+		dev->state = dev->alarm ? DEV_SEARCH : DEV_INACTIVE;
+		break;
+	case 0xF0:	/* Search ROM */
+		dev->state = DEV_SEARCH;
+		break;
+	default:	/* Overdrive and unknown commands */
+		dev->state = DEV_INACTIVE;
+		break;
+	}
+}
+
+/* Level driven by the device in the current slot, 1 to release */
+static int dev_drive(struct w1_sim_device *dev)
+{
+	switch (dev->state) {
+	case DEV_SEARCH:
+		/* rx holds the step: bit, complement, direction from the host */
+		if (dev->rx == 0)
+			return rom_bit(dev, dev->nbits);
+		if (dev->rx == 1)
+			return !rom_bit(dev, dev->nbits);
+		return 1;
+	case DEV_FUNCTION:
+		if (tx_pending(dev))
+			return (dev->tx[dev->tx_bit >> 3] >> (dev->tx_bit & 7)) & 1;
+		if (dev->ops && dev->ops->idle_bit)
+			return dev->ops->idle_bit(dev);
+		return 1;
+	default:
+		return 1;
+	}
+}
+
+/* Level of the bus at the sampling point of the current slot */
+static void dev_sample(struct w1_sim_device *dev, int level)
+{
+	uint8_t byte;
+
+	switch (dev->state) {
+	case DEV_ROM_CMD:
+		dev->rx |= level << dev->nbits;
+		if (++dev->nbits == 8)
+			dev_rom_command(dev, dev->rx);
+		break;
+	case DEV_MATCH:
+		if (level != rom_bit(dev, dev->nbits))
+			dev->state = DEV_INACTIVE;
+		else if (++dev->nbits == 64) {
+			dev->state = DEV_FUNCTION;
+			dev->nbits = 0;
+			dev->resume = 1;
+		}
+		break;
+	case DEV_SEARCH:
+		if (dev->rx < 2) {
+			dev->rx++;
+			break;
+		}
+		dev->rx = 0;
+		if (level != rom_bit(dev, dev->nbits))
+			dev->state = DEV_INACTIVE;
+		else if (++dev->nbits == 64) {
+			dev->state = DEV_FUNCTION;
+			dev->nbits = 0;
+			dev->resume = 1;
+		}
+		break;
+	case DEV_FUNCTION:
+		if (tx_pending(dev)) {
+			if (++dev->tx_bit == dev->tx_len * 8) {
+				dev->tx_len = 0;
+				dev->tx_bit = 0;
+				if (dev->ops && dev->ops->tx_done)
+					dev->ops->tx_done(dev);
+			}
+			break;
+		}
+		dev->rx |= level << dev->nbits;
+		if (++dev->nbits == 8) {
+			byte = dev->rx;
+			dev->rx = 0;
+			dev->nbits = 0;
+			if (dev->ops && dev->ops->rx_byte)
+				dev->ops->rx_byte(dev, byte);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/************************** Bus ***************************/
+int w1_sim_add_device(struct w1_sim *sim, struct w1_sim_device *dev)
+{
+	if (sim->ndevices == W1_SIM_MAX_DEVICES)
+		return -1;
+	dev->host = sim;
+	dev->state = DEV_INACTIVE;
+	sim->devices[sim->ndevices++] = dev;
+	return 0;
+}
+
+void w1_sim_remove_device(struct w1_sim *sim, struct w1_sim_device *dev)
+{
+	int i;
+
+	for (i = 0; i < sim->ndevices; i++) {
+		if (sim->devices[i] == dev) {
+			sim->devices[i] = sim->devices[--sim->ndevices];
+			dev->host = NULL;
+			return;
+		}
+	}
+}
+
+static int gpio_mode(const struct w1_sim *sim)
+{
+	return (sim->instr & INSTR_GPIO) != 0;
+}
+
+static int gpio_driven_low(const struct w1_sim *sim)
+{
+	return gpio_mode(sim) && !(sim->instr & (INSTR_GPIO_T | INSTR_GPIO_O));
+}
+
+/* Bus level seen through the IOBUF outside of the FSM slots */
+static int bus_level(const struct w1_sim *sim)
+{
+	if (gpio_driven_low(sim))
+		return 0;
+	if (now_ns >= sim->pp_start_ns && now_ns < sim->pp_end_ns)
+		return 0;
+	return 1;
+}
+
+/* Slot timing register in ns */
+static uint64_t timing_ns(const struct w1_sim *sim, uint32_t reg)
+{
+	return (uint64_t)(sim->timing[(reg - W1_SIM_TRSTL_REG) / 4] & 0xFFFFF) * W1_SIM_CLK_NS;
+}
+
+/* Slot length of w1_master.v, the recovery being at least TREC */
+static uint64_t slot_ns(const struct w1_sim *sim)
+{
+	uint64_t slot = timing_ns(sim, W1_SIM_TW0L_REG) + timing_ns(sim, W1_SIM_TREC_REG);
+
+	if (slot < timing_ns(sim, W1_SIM_TSLOT_REG))
+		slot = timing_ns(sim, W1_SIM_TSLOT_REG);
+	return slot;
+}
+
+/* Reset pulse starting at t, returns 1 if a presence pulse was seen */
+static int bus_reset(struct w1_sim *sim, uint64_t t)
+{
+	uint64_t msp = timing_ns(sim, W1_SIM_TMSP_REG);
+	int i;
+
+	sim->stats.resets++;
+	if (gpio_mode(sim))
+		return 0;
+	sim->slot_ns = t;
+	if (timing_ns(sim, W1_SIM_TRSTL_REG) < DEV_TRSTL_MIN_US * US) {
+		sim->stats.timing_errors++;
+		return 0;
+	}
+	for (i = 0; i < sim->ndevices; i++)
+		dev_reset(sim->devices[i]);
+	if (!sim->ndevices)
+		return 0;
+	/* Presence pulse sampled outside of the pulse, or after the window */
+	if (msp < PDHIGH_US * US || msp >= (PDHIGH_US + PDLOW_US) * US ||
+	    msp >= timing_ns(sim, W1_SIM_TRSTL_REG)) {
+		sim->stats.timing_errors++;
+		return 0;
+	}
+	return 1;
+}
+
+/*
+ * Bit slot starting at t, bit being 1 for a write-1/read slot. Out of the
+ * limits of the devices, the slot goes wrong as it would on the wire: a
+ * missed falling edge leaves the bus high, a write low of the wrong length
+ * is sampled as the other bit, a read sampled too early sees the low of the
+ * host and too late sees a read-0 released.
+ */
+static int bus_slot(struct w1_sim *sim, int bit, uint64_t t)
+{
+	uint64_t low = bit ? timing_ns(sim, W1_SIM_TW1L_REG) : timing_ns(sim, W1_SIM_TW0L_REG);
+	uint64_t rdv = timing_ns(sim, W1_SIM_TRDV_REG);
+	int i, level, sent = bit, drive = 1;
+
+	sim->stats.slots++;
+	if (gpio_mode(sim))
+		return bus_level(sim);
+	sim->slot_ns = t;
+	if (slot_ns(sim) < DEV_TSLOT_MIN_US * US ||
+	    timing_ns(sim, W1_SIM_TREC_REG) < DEV_TREC_MIN_US * US ||
+	    (bit && low < DEV_TLOW1_MIN_US * US)) {
+		sim->stats.timing_errors++;
+		return 1;
+	}
+	if (bit && low > DEV_TLOW1_MAX_US * US)
+		sent = 0;
+	else if (!bit && low < DEV_TLOW0_MIN_US * US)
+		sent = 1;
+	for (i = 0; i < sim->ndevices; i++)
+		if (!dev_drive(sim->devices[i]))
+			drive = 0;
+	level = sent & drive;
+	for (i = 0; i < sim->ndevices; i++)
+		dev_sample(sim->devices[i], level);
+
+	if (bit && rdv < low)
+		level = 0;
+	else if (bit && !drive && rdv > DEV_TRDV_US * US)
+		level = 1;
+	if (sent != bit || level != (sent & drive))
+		sim->stats.timing_errors++;
+	return level;
+}
+
+/*
+ * GPIO mode: a low level of at least tRSTL seen released is a reset pulse,
+ * the devices answer with their presence pulse.
+ */
+static void gpio_update(struct w1_sim *sim, uint32_t old_instr)
+{
+	uint32_t instr = sim->instr;
+	int was_low, low, i;
+
+	sim->instr = old_instr;
+	was_low = gpio_driven_low(sim);
+	sim->instr = instr;
+	low = gpio_driven_low(sim);
+
+	if (!was_low && low) {
+		sim->gpio_low_ns = now_ns;
+	} else if (was_low && !low) {
+		if (now_ns - sim->gpio_low_ns >= DEV_TRSTL_MIN_US * US && sim->ndevices) {
+			sim->pp_start_ns = now_ns + PDHIGH_US * US;
+			sim->pp_end_ns = sim->pp_start_ns + PDLOW_US * US;
+			for (i = 0; i < sim->ndevices; i++)
+				dev_reset(sim->devices[i]);
+		}
+		sim->gpio_low_ns = 0;
+	}
+}
+
+/************************** IP ***************************/
+int w1_sim_init(struct w1_sim *sim, uintptr_t base)
+{
+	static const uint32_t timing_us[W1_SIM_TIMING_REGS] = {
+		W1_SIM_RESET_LOW_US, W1_SIM_PRESENCE_SAMPLE_US, W1_SIM_SLOT_DONE_US,
+		W1_SIM_RECOVERY_US, W1_SIM_READ_SAMPLE_US, W1_SIM_LOW1_US, W1_SIM_SLOT_US
+	};
+	int i;
+
+	memset(sim, 0, sizeof(*sim));
+	sim->base = base;
+	sim->ipver = W1_SIM_IPVER;
+	sim->ipid = W1_SIM_IPID;
+	for (i = 0; i < W1_SIM_TIMING_REGS; i++)
+		sim->timing[i] = timing_us[i] * W1_SIM_CLK_MHZ;
+	sim->stat = STAT_READY;
+	sim->gpiodata = 1;
+	sim->stream = 1;
+	for (i = 0; i < W1_SIM_MAX_HOSTS; i++) {
+		if (!hosts[i]) {
+			hosts[i] = sim;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+void w1_sim_unmap(struct w1_sim *sim)
+{
+	int i;
+
+	for (i = 0; i < W1_SIM_MAX_HOSTS; i++)
+		if (hosts[i] == sim)
+			hosts[i] = NULL;
+}
+
+struct w1_sim *w1_sim_find(uintptr_t addr)
+{
+	int i;
+
+	for (i = 0; i < W1_SIM_MAX_HOSTS; i++)
+		if (hosts[i] && addr - hosts[i]->base < W1_SIM_REG_SPACE)
+			return hosts[i];
+	return NULL;
+}
+
+void w1_sim_stream_rx(struct w1_sim *sim, uint8_t *buf, uint32_t len)
+{
+	sim->rx_buf = buf;
+	sim->rx_len = len;
+}
+
+void w1_sim_stream_tx(struct w1_sim *sim, const uint8_t *buf, uint32_t len)
+{
+	sim->tx_buf = buf;
+	sim->tx_len = len;
+}
+
+void w1_sim_reset_stats(struct w1_sim *sim)
+{
+	memset(&sim->stats, 0, sizeof(sim->stats));
+}
+
+/* Back in IDLE_M: reg_wr refreshes STAT, RXDATA and GPIODATA every cycle */
+static void host_idle(struct w1_sim *sim)
+{
+	sim->state = HOST_IDLE;
+	sim->stat = STAT_READY;
+	sim->rxdata = 0;
+	sim->gpiodata = bus_level(sim);
+}
+
+/* Bring the handshake state up to the current time */
+static void host_update(struct w1_sim *sim)
+{
+	uint64_t t;
+
+	if (sim->state == HOST_BUSY && now_ns >= sim->done_ns) {
+		sim->state = HOST_DONE;
+		sim->stat = sim->done_stat;
+		sim->rxdata = sim->done_rx;
+	}
+	if ((sim->state == HOST_DONE || sim->state == HOST_STUCK) && !(sim->ctrl & CTRL_GO)) {
+		/*
+		 * DONE_M is entered on the edge after DONE, it sees GO one edge
+		 * later. IDLE_M holds READY low until the recovery is over.
+		 */
+		t = sim->done_ns + 2 * W1_SIM_CLK_NS;
+		if (sim->go_clear_ns > t)
+			t = sim->go_clear_ns;
+		if (sim->rec_end_ns > t)
+			t = sim->rec_end_ns;
+		if (now_ns >= t)
+			host_idle(sim);
+	}
+}
+
+/*
+ * Block instruction of w1_bulk.v starting at t: one RX_BYTE/TX_BYTE of
+ * W1_MASTER per byte, the next one issued a few cycles after the previous
+ * one is done and its recovery over. Returns the time DONE is raised, or 0
+ * if the block stalls on a stream buffer too short.
+ */
+static uint64_t host_block(struct w1_sim *sim, int tx, uint64_t t)
+{
+	uint64_t slot = slot_ns(sim), rec = timing_ns(sim, W1_SIM_TREC_REG);
+	uint64_t dur = 7 * slot + timing_ns(sim, W1_SIM_TW0L_REG) + W1_SIM_CLK_NS;
+	uint64_t next;
+	uint8_t byte;
+	int i;
+
+	sim->bcnt = 0;
+	while (sim->bcnt < sim->blen) {
+		if (tx ? !sim->tx_len : !sim->rx_len)
+			return 0;
+		byte = tx ? *sim->tx_buf : 0xFF;
+		for (i = 0; i < 8; i++) {
+			if (tx)
+				bus_slot(sim, (byte >> i) & 1, t + i * slot);
+			else if (!bus_slot(sim, 1, t + i * slot))
+				byte &= (uint8_t)~(1 << i);
+		}
+		if (tx) {
+			sim->tx_buf++;
+			sim->tx_len--;
+		} else {
+			*sim->rx_buf++ = byte;
+			sim->rx_len--;
+		}
+		sim->done_rx = byte;
+		sim->bcnt++;
+		sim->rec_end_ns = t + dur - W1_SIM_CLK_NS + rec;
+		if (sim->bcnt == sim->blen)
+			break;
+		/* Go dropped, IDLE_M until the recovery is over, then GO again */
+		next = t + dur + 2 * W1_SIM_CLK_NS;
+		if (sim->rec_end_ns > next)
+			next = sim->rec_end_ns;
+		t = next + 2 * W1_SIM_CLK_NS;
+	}
+	/* The strong pull-up flag applies to the last byte written */
+	if (tx && sim->blen && (sim->instr & INSTR_SPU)) {
+		sim->spu_end_ns = t + dur + (uint64_t)(sim->spu & 0xFFFFFF) * US;
+		return sim->spu_end_ns + 2 * W1_SIM_CLK_NS;
+	}
+	return t + (sim->blen ? dur : 0) + W1_SIM_CLK_NS;
+}
+
+/*
+ * Step of w1_romsel.v on W1_MASTER, started at t and lasting dur, followed by
+ * the recovery of a slot if rec is set. Returns the time of the next step,
+ * issued as the next byte of a block.
+ */
+static uint64_t rom_step(struct w1_sim *sim, uint64_t t, uint64_t dur, int rec)
+{
+	uint64_t next = t + dur + 2 * W1_SIM_CLK_NS;
+
+	sim->rec_end_ns = rec ? t + dur - W1_SIM_CLK_NS + timing_ns(sim, W1_SIM_TREC_REG) : 0;
+	if (sim->rec_end_ns > next)
+		next = sim->rec_end_ns;
+	return next + 2 * W1_SIM_CLK_NS;
+}
+
+/*
+ * SELECT_ROM or PING_ALL instruction of w1_romsel.v starting at t: a reset,
+ * then Match ROM and the ROM ID of the entry, or a Search ROM forced along
+ * the ROM ID of each entry. Returns the time DONE is raised, *failure being
+ * set if a selected device did not answer the reset.
+ */
+static uint64_t host_romsel(struct w1_sim *sim, int ping, uint64_t t, int *failure)
+{
+	uint64_t slot = slot_ns(sim), bit = timing_ns(sim, W1_SIM_TW0L_REG) + W1_SIM_CLK_NS;
+	uint64_t init = W1_SIM_CLK_NS + 2 * timing_ns(sim, W1_SIM_TRSTL_REG);
+	uint64_t byte = 7 * slot + bit, end = t, id;
+	uint32_t entries = 1, e, idx;
+	uint8_t cmd = ping ? 0xF0 : 0x55;
+	int found, n, i, b, c;
+
+	if (ping) {
+		entries = sim->instr & 0x7F;
+		if (entries > W1_SIM_ROM_TABLE)
+			entries = W1_SIM_ROM_TABLE;
+		sim->ping = 0;
+	}
+	/* R_LOAD and R_FETCH */
+	t += 2 * W1_SIM_CLK_NS;
+	for (e = 0; e < entries; e++) {
+		idx = ping ? e : sim->instr & 0x3F;
+		id = idx < W1_SIM_ROM_TABLE ? sim->rom_table[idx] : 0;
+		found = bus_reset(sim, t + W1_SIM_CLK_NS);
+		end = t + init;
+		t = rom_step(sim, t, init, 0);
+		if (!found)
+			goto next;
+		for (i = 0; i < 8; i++)
+			bus_slot(sim, (cmd >> i) & 1, t + i * slot);
+		end = t + byte;
+		t = rom_step(sim, t, byte, 1);
+		for (n = 0; n < 64 && !ping; n += 8) {
+			for (i = 0; i < 8; i++)
+				bus_slot(sim, (id >> (n + i)) & 1, t + i * slot);
+			end = t + byte;
+			t = rom_step(sim, t, byte, 1);
+		}
+		for (n = 0; n < 64 && ping; n++) {
+			b = (id >> n) & 1;
+			i = bus_slot(sim, 1, t);
+			t = rom_step(sim, t, bit, 1);
+			c = bus_slot(sim, 1, t);
+			end = t + bit;
+			t = rom_step(sim, t, bit, 1);
+			/* Nobody answers with the bit of the entry */
+			if (b ? c : i) {
+				found = 0;
+				break;
+			}
+			bus_slot(sim, b, t);
+			end = t + bit;
+			t = rom_step(sim, t, bit, 1);
+		}
+next:
+		if (ping)
+			sim->ping |= (uint64_t)found << idx;
+		else
+			*failure = !found;
+		/* R_NEXT and R_LOAD */
+		t += 2 * W1_SIM_CLK_NS;
+	}
+	/* R_NEXT and R_DONE */
+	return end + 2 * W1_SIM_CLK_NS;
+}
+
+/*
+ * POLL_BIT instruction starting at t: read slots until one reads 1 or the
+ * POLL slot count is reached. After a 0, the slot runs to its end, then the
+ * bus stays released for the interval before the next one. Returns the
+ * length of the instruction, *rx being the last bit read.
+ */
+static uint64_t host_poll(struct w1_sim *sim, uint64_t t, uint8_t *rx)
+{
+	uint64_t start = t, slot = slot_ns(sim);
+	uint64_t last = timing_ns(sim, W1_SIM_TW0L_REG) + W1_SIM_CLK_NS;
+	uint64_t interval = (uint64_t)(sim->poll >> 16) * US;
+	uint32_t slots = sim->poll & 0xFFFF;
+
+	sim->pollcnt = 0;
+	for (;;) {
+		*rx = (uint8_t)bus_slot(sim, 1, t);
+		sim->pollcnt++;
+		if (*rx || sim->pollcnt >= slots)
+			break;
+		/* poll_wait: a cycle to enter it, one to leave it */
+		t += slot + interval + 2 * W1_SIM_CLK_NS;
+	}
+	sim->rec_end_ns = t + last - W1_SIM_CLK_NS + timing_ns(sim, W1_SIM_TREC_REG);
+	return t - start + last;
+}
+
+/* GO seen by IDLE_M: run the instruction on the devices, schedule DONE */
+static void host_start(struct w1_sim *sim)
+{
+	uint32_t cmd = (sim->instr >> 8) & 0xF;
+	uint64_t t = edge(now_ns), dur = 0, slot = slot_ns(sim);
+	uint64_t rstl = timing_ns(sim, W1_SIM_TRSTL_REG);
+	uint64_t last = timing_ns(sim, W1_SIM_TW0L_REG) + W1_SIM_CLK_NS;
+	int spu = 0, failure = 0, i;
+	uint8_t rx = 0;
+
+	sim->stats.instructions++;
+	sim->state = HOST_BUSY;
+	sim->stat = 0;
+	sim->rxdata = 0;
+	sim->rec_end_ns = 0;
+
+	/* The slot states leave at TW0L of their last slot, DONE one edge later */
+	switch (cmd) {
+	case CMD_TX_BIT:
+	case CMD_RX_BIT:
+		dur = last;
+		spu = cmd == CMD_TX_BIT && (sim->instr & INSTR_SPU);
+		break;
+	case CMD_TX_BYTE:
+	case CMD_RX_BYTE:
+		dur = 7 * slot + last;
+		spu = cmd == CMD_TX_BYTE && (sim->instr & INSTR_SPU);
+		break;
+	default:
+		break;
+	}
+	if (dur)
+		sim->rec_end_ns = t + dur - W1_SIM_CLK_NS + timing_ns(sim, W1_SIM_TREC_REG);
+	/* SPU_M counts down the duration in us, then DONE one edge later */
+	if (spu) {
+		sim->spu_end_ns = t + dur + (uint64_t)(sim->spu & 0xFFFFFF) * US;
+		dur = sim->spu_end_ns + W1_SIM_CLK_NS - t;
+	}
+
+	switch (cmd) {
+	case CMD_INIT:
+		/* One cycle in INIT_M, then TX_RST_PLS and RX_PRE_PLS */
+		failure = !bus_reset(sim, t + W1_SIM_CLK_NS);
+		dur = W1_SIM_CLK_NS + 2 * rstl;
+		break;
+	case CMD_TX_RST_PLS:
+		failure = !bus_reset(sim, t);
+		dur = 2 * rstl;
+		break;
+	case CMD_RX_PRE_PLS:
+		/* No reset pulse, nobody answers */
+		failure = 1;
+		dur = rstl;
+		break;
+	case CMD_RX_BIT:
+		rx = bus_slot(sim, 1, t);
+		break;
+	case CMD_TX_BIT:
+		bus_slot(sim, sim->instr & 1, t);
+		break;
+	case CMD_RX_BYTE:
+		for (i = 0; i < 8; i++)
+			rx |= bus_slot(sim, 1, t + i * slot) << i;
+		break;
+	case CMD_TX_BYTE:
+		for (i = 0; i < 8; i++)
+			bus_slot(sim, (sim->instr >> i) & 1, t + i * slot);
+		break;
+	case CMD_SPU:
+		sim->spu_end_ns = t + (uint64_t)(sim->spu & 0xFFFFFF) * US;
+		dur = sim->spu_end_ns + W1_SIM_CLK_NS - t;
+		break;
+	case CMD_POLL_BIT:
+		dur = host_poll(sim, t, &rx);
+		failure = !rx;
+		break;
+	case CMD_RX_BLOCK:
+	case CMD_TX_BLOCK:
+		if (sim->stream) {
+			sim->done_ns = host_block(sim, cmd == CMD_TX_BLOCK, t);
+			if (!sim->done_ns) {
+				sim->state = HOST_STALLED;
+				return;
+			}
+			sim->done_stat = STAT_DONE;
+			sim->stats.bus_ns += sim->done_ns - t;
+			return;
+		}
+		/* Unused codes without the stream ports */
+		/* fall through */
+	default:
+		if (cmd == CMD_SELECT_ROM || cmd == CMD_PING_ALL) {
+			sim->done_ns = host_romsel(sim, cmd == CMD_PING_ALL, t, &failure);
+			sim->done_stat = STAT_DONE | (failure ? STAT_PRESENCE : 0);
+			sim->done_rx = 0;
+			sim->stats.bus_ns += sim->done_ns - t;
+			return;
+		}
+		/*
+		 * IDLE_M, DONE_M and the unused codes never raise DONE, the
+		 * FSM waits for GO to be cleared
+		 */
+		sim->state = HOST_STUCK;
+		sim->done_ns = t;
+		return;
+	}
+
+	sim->done_ns = t + dur;
+	sim->done_stat = STAT_DONE | (failure ? STAT_PRESENCE : 0);
+	sim->done_rx = rx;
+	sim->stats.bus_ns += dur;
+}
+
+static void host_ctrl(struct w1_sim *sim, uint32_t value)
+{
+	uint32_t old = sim->ctrl;
+
+	sim->ctrl = value;
+	if (value & CTRL_RESET) {
+		/* The FSMs are held in IDLE_M, an instruction in progress is lost */
+		sim->bcnt = 0;
+		sim->ping = 0;
+		sim->pollcnt = 0;
+		host_idle(sim);
+		return;
+	}
+	if ((value & CTRL_GO) && sim->state == HOST_IDLE)
+		host_start(sim);
+	else if (!(value & CTRL_GO) && (old & CTRL_GO))
+		sim->go_clear_ns = edge(now_ns);
+}
+
+uint32_t w1_sim_read32(struct w1_sim *sim, uint32_t offset)
+{
+	now_ns += axi_read_ns;
+	sim->stats.axi_reads++;
+	host_update(sim);
+
+	switch (offset) {
+	case W1_SIM_INSTR_REG:
+		return sim->instr;
+	case W1_SIM_CTRL_REG:
+		return sim->ctrl;
+	case W1_SIM_IRQE_REG:
+		return sim->irqe;
+	case W1_SIM_STAT_REG:
+		return sim->stat;
+	case W1_SIM_RXDATA_REG:
+		return sim->rxdata;
+	case W1_SIM_GPIODATA_REG:
+		if (sim->state == HOST_IDLE)
+			sim->gpiodata = bus_level(sim);
+		return sim->gpiodata;
+	case W1_SIM_IPVER_REG:
+		return sim->ipver;
+	case W1_SIM_IPID_REG:
+		return sim->ipid;
+	case W1_SIM_SPU_REG:
+		return sim->spu;
+	case W1_SIM_TRSTL_REG:
+	case W1_SIM_TMSP_REG:
+	case W1_SIM_TW0L_REG:
+	case W1_SIM_TREC_REG:
+	case W1_SIM_TRDV_REG:
+	case W1_SIM_TW1L_REG:
+	case W1_SIM_TSLOT_REG:
+		return sim->timing[(offset - W1_SIM_TRSTL_REG) / 4];
+	case W1_SIM_TCLK_REG:
+		return W1_SIM_CLK_MHZ;
+	case W1_SIM_BLEN_REG:
+		return sim->blen;
+	case W1_SIM_BCNT_REG:
+		return (sim->stream ? BCNT_STREAM : 0) | sim->bcnt;
+	case W1_SIM_ROMIDX_REG:
+		return (uint32_t)W1_SIM_ROM_TABLE << ROMIDX_ENTRIES | (sim->romidx & 0xFFFFFF);
+	case W1_SIM_ROMLO_REG:
+		return sim->romlo;
+	case W1_SIM_ROMHI_REG:
+		return sim->romhi;
+	case W1_SIM_PING0_REG:
+		return (uint32_t)sim->ping;
+	case W1_SIM_PING1_REG:
+		return (uint32_t)(sim->ping >> 32);
+	case W1_SIM_POLL_REG:
+		return sim->poll;
+	case W1_SIM_POLLCNT_REG:
+		return sim->pollcnt;
+	case W1_SIM_CAPS_REG:
+		return CAPS_FIXED | (sim->stream ? CAPS_BLOCK : 0) |
+		       (uint32_t)W1_SIM_ROM_TABLE << CAPS_ROM_ENTRIES;
+	default:
+		return 0;
+	}
+}
+
+void w1_sim_write32(struct w1_sim *sim, uint32_t offset, uint32_t value)
+{
+	uint32_t old;
+
+	now_ns += axi_write_ns;
+	sim->stats.axi_writes++;
+	host_update(sim);
+
+	switch (offset) {
+	case W1_SIM_INSTR_REG:
+		old = sim->instr;
+		sim->instr = value;
+		gpio_update(sim, old);
+		break;
+	case W1_SIM_CTRL_REG:
+		host_ctrl(sim, value);
+		break;
+	case W1_SIM_IRQE_REG:
+		sim->irqe = value;
+		break;
+	case W1_SIM_IPVER_REG:
+		sim->ipver = value;
+		break;
+	case W1_SIM_IPID_REG:
+		sim->ipid = value;
+		break;
+	case W1_SIM_SPU_REG:
+		sim->spu = value;
+		break;
+	case W1_SIM_TRSTL_REG:
+	case W1_SIM_TMSP_REG:
+	case W1_SIM_TW0L_REG:
+	case W1_SIM_TREC_REG:
+	case W1_SIM_TRDV_REG:
+	case W1_SIM_TW1L_REG:
+	case W1_SIM_TSLOT_REG:
+		sim->timing[(offset - W1_SIM_TRSTL_REG) / 4] = value;
+		break;
+	case W1_SIM_BLEN_REG:
+		sim->blen = value & 0xFFFF;
+		break;
+	case W1_SIM_ROMIDX_REG:
+		sim->romidx = value;
+		break;
+	case W1_SIM_ROMLO_REG:
+		sim->romlo = value;
+		break;
+	case W1_SIM_ROMHI_REG:
+		sim->romhi = value;
+		if ((sim->romidx & 0x3F) < W1_SIM_ROM_TABLE)
+			sim->rom_table[sim->romidx & 0x3F] = (uint64_t)value << 32 | sim->romlo;
+		break;
+	case W1_SIM_POLL_REG:
+		sim->poll = value;
+		break;
+	default:
+		/*
+		 * STAT, RXDATA and GPIODATA are overwritten by reg_wr, TCLK,
+		 * BCNT, PING0, PING1 and POLLCNT are read only
+		 */
+		break;
+	}
+}
+
+int w1_sim_irq(struct w1_sim *sim)
+{
+	host_update(sim);
+	return (sim->irqe & sim->stat & (STAT_DONE | STAT_READY)) != 0;
+}
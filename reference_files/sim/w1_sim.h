@@ -0,0 +1,316 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#ifndef W1_SIM_H
+#define W1_SIM_H
+
+/*
+ * Host side model of the AXI 1-Wire Host IP and of 1-Wire devices, to run
+ * the baremetal driver and applications on a Linux machine without FPGA.
+ *
+ * The model reproduces the register map of axi_1wire_host_slave_lite and the
+ * GO/DONE/READY handshake of w1_master.v with its slot timing registers, on
+ * its AXI clock time base: an instruction starts on the edge following GO,
+ * DONE is raised TW0L into the last slot (after the strong pull-up, if any),
+ * a slot lasting TSLOT or TW0L + TREC if longer, and READY comes back once
+ * GO is cleared and the recovery of the last slot is over. STAT, RXDATA and
+ * GPIODATA follow the reg_wr updates of the RTL, so RXDATA and the presence
+ * bit are only valid while DONE is set.
+ *
+ * The IP is modelled with its AXI4-Stream ports (BULK_STREAM): the block
+ * instructions of w1_bulk.v move BLEN bytes between the bus and the buffers
+ * given to w1_sim_stream_rx/tx, which stand for the transfers of an AXI DMA.
+ * A block stalls, DONE never raised, when its buffer is too short.
+ *
+ * The ROM ID table of w1_romsel.v (ROM_TABLE) is modelled with
+ * W1_SIM_ROM_TABLE entries: SELECT_ROM and PING_ALL run their reset, byte
+ * and bit steps on the devices, the next step issued a few cycles after the
+ * previous one is done, as the block instructions.
+ *
+ * POLL_BIT repeats read slots, the POLL interval apart, until a device
+ * releases the bus, DONE being raised once in the slot reading 1 or the
+ * last one allowed.
+ *
+ * Time is virtual: every register access, timer read and sleep of the BSP
+ * shims (include/) advances a global clock by a fixed cost, so a run is
+ * deterministic and the measured times are the ones of the modelled system,
+ * whatever the speed of the host.
+ *
+ * The devices see the bus one slot at a time: each slot, every device tells
+ * the level it drives, then samples the resulting wired-AND level. A write-1
+ * slot and a read slot are the same slot, as on the wire. The devices have
+ * the standard speed limits of the datasheets: a slot timed out of them is
+ * counted in timing_errors and goes wrong as on the wire, so trimmed timing
+ * can be tried on the model before a real bus.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Register map */
+#define W1_SIM_INSTR_REG	0x00
+#define W1_SIM_CTRL_REG		0x04
+#define W1_SIM_IRQE_REG		0x08
+#define W1_SIM_STAT_REG		0x0C
+#define W1_SIM_RXDATA_REG	0x10
+#define W1_SIM_GPIODATA_REG	0x14
+#define W1_SIM_IPVER_REG	0x18
+#define W1_SIM_IPID_REG		0x1C
+#define W1_SIM_SPU_REG		0x20
+#define W1_SIM_TRSTL_REG	0x24	/* Slot timing, in AXI clock cycles */
+#define W1_SIM_TMSP_REG		0x28
+#define W1_SIM_TW0L_REG		0x2C
+#define W1_SIM_TREC_REG		0x30
+#define W1_SIM_TRDV_REG		0x34
+#define W1_SIM_TW1L_REG		0x38
+#define W1_SIM_TSLOT_REG	0x3C
+#define W1_SIM_TCLK_REG		0x40	/* Read only, AXI clock cycles per us */
+#define W1_SIM_BLEN_REG		0x44	/* Bytes of a block instruction */
+#define W1_SIM_BCNT_REG		0x48	/* Read only, bytes transferred, stream ports */
+#define W1_SIM_ROMIDX_REG	0x4C	/* ROM ID table entry, entries in the MSB */
+#define W1_SIM_ROMLO_REG	0x50
+#define W1_SIM_ROMHI_REG	0x54	/* Written, stores the entry */
+#define W1_SIM_PING0_REG	0x58	/* Read only, entries found by PING_ALL */
+#define W1_SIM_PING1_REG	0x5C
+#define W1_SIM_POLL_REG		0x60	/* POLL_BIT slots in the LSB, interval in us in the MSB */
+#define W1_SIM_POLLCNT_REG	0x64	/* Read only, slots issued by POLL_BIT */
+#define W1_SIM_CAPS_REG		0x68	/* Read only, optional features, see w1_caps.h */
+#define W1_SIM_REG_SPACE	0x80
+
+#define W1_SIM_IPVER		0x76000108
+#define W1_SIM_IPID		0x10EE4453
+
+/* AXI clock of w1_master.v, CLK_DIV_VAL_TO_1MHz cycles per us */
+#define W1_SIM_CLK_MHZ		100
+#define W1_SIM_CLK_NS		(1000 / W1_SIM_CLK_MHZ)
+#define W1_SIM_TIMING_REGS	7	/* TRSTL to TSLOT */
+
+/* Reset values of the slot timing registers, in us */
+#define W1_SIM_RESET_LOW_US	480	/* TRSTL, also the presence window */
+#define W1_SIM_PRESENCE_SAMPLE_US 70	/* TMSP, from the release */
+#define W1_SIM_SLOT_DONE_US	60	/* TW0L, DONE raised into the last slot */
+#define W1_SIM_RECOVERY_US	1	/* TREC */
+#define W1_SIM_READ_SAMPLE_US	15	/* TRDV */
+#define W1_SIM_LOW1_US		6	/* TW1L */
+#define W1_SIM_SLOT_US		80	/* TSLOT */
+
+/* Default costs of the host side, in ns of virtual time */
+#define W1_SIM_AXI_READ_NS	150
+#define W1_SIM_AXI_WRITE_NS	100
+#define W1_SIM_TIMER_NS		10
+
+#define W1_SIM_MAX_HOSTS	4
+#define W1_SIM_MAX_DEVICES	16
+#define W1_SIM_DEV_TX_SIZE	16
+#define W1_SIM_ROM_TABLE	64	/* ROM_TABLE of the modelled IP */
+
+/**************************** Type Definitions *****************************/
+struct w1_sim;
+struct w1_sim_device;
+
+/*
+ * Function layer of a device family, called once the device is selected by
+ * a ROM command. All callbacks are optional.
+ */
+struct w1_sim_device_ops {
+	/* Reset pulse seen, before the ROM layer restarts */
+	void (*reset)(struct w1_sim_device *dev);
+	/* Byte written by the host while nothing is queued for transmission */
+	void (*rx_byte)(struct w1_sim_device *dev, uint8_t byte);
+	/* Transmit queue drained, the device may queue more bytes */
+	void (*tx_done)(struct w1_sim_device *dev);
+	/* Level driven in a slot while nothing is queued, 1 to release (default) */
+	int (*idle_bit)(struct w1_sim_device *dev);
+};
+
+struct w1_sim_ds18b20 {
+	int32_t millideg;	/* Temperature seen by the next conversion */
+	uint8_t scratchpad[9];
+	uint8_t eeprom[3];	/* TH, TL, configuration */
+	int parasite;		/* Parasite powered: needs a strong pull-up to convert */
+	int state;
+	int nrx;
+	uint64_t busy_until_ns;	/* Conversion or EEPROM copy in progress */
+	int conv_pending;
+	int conv_ok;
+};
+
+struct w1_sim_ds2431 {
+	uint8_t mem[0x90];	/* 4 pages of 32 bytes, then the registers */
+	uint8_t scratchpad[8];
+	uint8_t ta[2];
+	uint8_t es;
+	int state;
+	int nrx;
+	uint16_t addr;
+	uint16_t crc;
+	uint64_t busy_until_ns;	/* Copy scratchpad programming */
+	int pattern;
+	int copying;		/* The row is not programmed yet */
+	uint32_t interrupted;	/* Copies disturbed by the bus within tPROG */
+};
+
+struct w1_sim_ds2413 {
+	uint8_t latch;		/* PIOA bit 0, PIOB bit 1, 0 = output transistor on */
+	uint8_t value;		/* Latch byte received, waiting for its complement */
+	int state;
+	uint64_t latched_ns;	/* End of the last PIO Access Write accepted */
+	uint32_t writes;	/* PIO Access Writes accepted */
+};
+
+struct w1_sim_device {
+	uint8_t rom[8];		/* ROM ID, CRC included */
+	int alarm;		/* Answers the Alarm Search ROM command */
+	int has_resume;		/* Answers the Resume ROM command (0xA5) */
+	const struct w1_sim_device_ops *ops;
+	struct w1_sim *host;
+
+	/* ROM layer, private */
+	int state;
+	int nbits;
+	int resume;		/* RC flag: selected by the last Match or Search ROM */
+	uint8_t rx;
+	uint8_t tx[W1_SIM_DEV_TX_SIZE];
+	int tx_len;
+	int tx_bit;
+
+	union {
+		struct w1_sim_ds18b20 ds18b20;
+		struct w1_sim_ds2431 ds2431;
+		struct w1_sim_ds2413 ds2413;
+	} u;
+};
+
+struct w1_sim_stats {
+	uint64_t instructions;	/* Instructions executed (GO) */
+	uint64_t slots;		/* Bit slots, reset/presence excluded */
+	uint64_t resets;
+	uint64_t bus_ns;	/* GO seen to DONE raised */
+	uint64_t timing_errors;	/* Slots and resets out of the limits of the devices */
+	uint64_t axi_reads;
+	uint64_t axi_writes;
+};
+
+/* One instance of the IP */
+struct w1_sim {
+	uintptr_t base;
+
+	/* Registers */
+	uint32_t instr;
+	uint32_t ctrl;
+	uint32_t irqe;
+	uint32_t stat;
+	uint32_t rxdata;
+	uint32_t gpiodata;
+	uint32_t ipver;
+	uint32_t ipid;
+	uint32_t spu;
+	uint32_t timing[W1_SIM_TIMING_REGS];
+	uint32_t blen;
+	uint32_t bcnt;
+	uint32_t romidx;
+	uint32_t romlo;
+	uint32_t romhi;
+	uint64_t ping;
+	uint32_t poll;
+	uint32_t pollcnt;
+
+	/* Handshake state, private */
+	int state;
+	uint64_t done_ns;	/* DONE raised */
+	uint64_t go_clear_ns;	/* Edge seeing GO cleared */
+	uint64_t rec_end_ns;	/* Recovery of the last slot over */
+	uint32_t done_stat;
+	uint8_t done_rx;
+
+	/* Bus */
+	struct w1_sim_device *devices[W1_SIM_MAX_DEVICES];
+	int ndevices;
+	uint64_t slot_ns;	/* Start of the slot being executed */
+	uint64_t spu_end_ns;	/* End of the last strong pull-up */
+	uint64_t gpio_low_ns;	/* GPIO mode: bus driven low since, 0 if released */
+	uint64_t pp_start_ns;	/* GPIO mode: presence pulse of the devices */
+	uint64_t pp_end_ns;
+
+	/* AXI4-Stream ports, buffers of the DMA transfers in progress */
+	int stream;		/* Built with BULK_STREAM, set by w1_sim_init */
+	uint8_t *rx_buf;
+	uint32_t rx_len;
+	const uint8_t *tx_buf;
+	uint32_t tx_len;
+
+	/* ROM ID table, the family code in the LSB */
+	uint64_t rom_table[W1_SIM_ROM_TABLE];
+
+	struct w1_sim_stats stats;
+};
+
+/************************** Function Prototypes ****************************/
+/**
+ *
+ * Initialize an IP instance and map it at a base address for the BSP shims.
+ *
+ * @param   sim is the instance.
+ *          base is the base address, as in xparameters.h.
+ *
+ * @return  0, or -1 if W1_SIM_MAX_HOSTS instances are already mapped
+ *
+ */
+int w1_sim_init(struct w1_sim *sim, uintptr_t base);
+void w1_sim_unmap(struct w1_sim *sim);
+struct w1_sim *w1_sim_find(uintptr_t addr);
+
+/* Register accesses, offset relative to the base address */
+uint32_t w1_sim_read32(struct w1_sim *sim, uint32_t offset);
+void w1_sim_write32(struct w1_sim *sim, uint32_t offset, uint32_t value);
+
+/* Level of the IRQ line (IRQE & STAT) */
+int w1_sim_irq(struct w1_sim *sim);
+/*
+ * FreeRTOS shims (w1_sim_rtos.c, built with AXI_1WIRE_HOST_RTOS): connect
+ * handler to the IRQ line of sim, as XScuGic_Connect(), NULL to disconnect
+ * it. The scheduler calls it with ref while the line is high.
+ */
+void w1_sim_rtos_connect(struct w1_sim *sim, void (*handler)(void *), void *ref);
+
+/* Virtual clock */
+uint64_t w1_sim_now_ns(void);
+void w1_sim_advance_ns(uint64_t ns);
+/* Host side costs, in ns, see W1_SIM_AXI_READ_NS and co */
+void w1_sim_set_costs(uint32_t axi_read_ns, uint32_t axi_write_ns, uint32_t timer_ns);
+uint32_t w1_sim_timer_cost_ns(void);
+
+/*
+ * DMA transfers on the stream ports: the bytes read by the next RX_BLOCK
+ * instructions are stored in buf, the TX_BLOCK ones written from buf, up to
+ * len bytes. A new transfer replaces the one in progress.
+ */
+void w1_sim_stream_rx(struct w1_sim *sim, uint8_t *buf, uint32_t len);
+void w1_sim_stream_tx(struct w1_sim *sim, const uint8_t *buf, uint32_t len);
+
+/* Bus */
+int w1_sim_add_device(struct w1_sim *sim, struct w1_sim_device *dev);
+void w1_sim_remove_device(struct w1_sim *sim, struct w1_sim_device *dev);
+void w1_sim_reset_stats(struct w1_sim *sim);
+
+/*
+ * Devices. serial is the 48 bits serial number, the family code and the CRC
+ * are added to make the ROM ID.
+ */
+void w1_sim_device_init(struct w1_sim_device *dev, uint8_t family, uint64_t serial,
+			const struct w1_sim_device_ops *ops);
+/* Queue bytes to transmit in the next read slots */
+void w1_sim_device_queue(struct w1_sim_device *dev, const uint8_t *buf, int len);
+
+/* DS18B20 at 25 C, 12 bits, TH=75 TL=70 in EEPROM */
+void w1_sim_ds18b20_init(struct w1_sim_device *dev, uint64_t serial);
+void w1_sim_ds18b20_set_temp(struct w1_sim_device *dev, int32_t millideg);
+
+/* DS2431 with a blank (0xFF) memory */
+void w1_sim_ds2431_init(struct w1_sim_device *dev, uint64_t serial);
+
+/* DS2413 with both outputs off, the pins pulled up: a pin reads as its latch */
+void w1_sim_ds2413_init(struct w1_sim_device *dev, uint64_t serial);
+
+#endif /* W1_SIM_H */
@@ -0,0 +1,69 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+/*
+ * BSP functions of the shims in include/, backed by the w1_sim model. An
+ * access to an address no instance is mapped at aborts, as a bus error
+ * would on the target.
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "xil_io.h"
+#include "xil_printf.h"
+#include "xtime_l.h"
+#include "sleep.h"
+#include "w1_sim.h"
+
+static struct w1_sim *bsp_find(UINTPTR Addr)
+{
+	struct w1_sim *sim = w1_sim_find(Addr);
+
+	if (!sim) {
+		fprintf(stderr, "w1_sim: access to unmapped address 0x%lx\n", (unsigned long)Addr);
+		abort();
+	}
+	return sim;
+}
+
+u32 Xil_In32(UINTPTR Addr)
+{
+	struct w1_sim *sim = bsp_find(Addr);
+
+	return w1_sim_read32(sim, Addr - sim->base);
+}
+
+void Xil_Out32(UINTPTR Addr, u32 Value)
+{
+	struct w1_sim *sim = bsp_find(Addr);
+
+	w1_sim_write32(sim, Addr - sim->base, Value);
+}
+
+void XTime_GetTime(XTime *Xtime_Global)
+{
+	w1_sim_advance_ns(w1_sim_timer_cost_ns());
+	*Xtime_Global = w1_sim_now_ns();
+}
+
+int usleep(unsigned long useconds)
+{
+	w1_sim_advance_ns((u64)useconds * 1000);
+	return 0;
+}
+
+unsigned sleep(unsigned int seconds)
+{
+	w1_sim_advance_ns((u64)seconds * 1000000000ULL);
+	return 0;
+}
+
+void xil_printf(const char *ctrl1, ...)
+{
+	va_list args;
+
+	va_start(args, ctrl1);
+	vprintf(ctrl1, args);
+	va_end(args);
+}
@@ -0,0 +1,437 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+#include <string.h>
+#include "w1_sim.h"
+#include "w1_crc.h"
+#include "w1_temp.h"
+
+#define MS		1000000ULL
+#define SAMPLE_NS	15000ULL	/* Devices sample 15 us into the slot */
+
+/* End of the byte being received, the slot time being its last slot */
+#define BYTE_END(dev)	((dev)->host->slot_ns + SAMPLE_NS)
+
+/******************************** DS18B20 **********************************/
+enum { DS18B20_CMD, DS18B20_WRITE_SP, DS18B20_CONVERT, DS18B20_COPY,
+       DS18B20_POWER, DS18B20_IGNORE };
+
+#define DS18B20_COPY_MS	10
+
+static void ds18b20_crc(struct w1_sim_ds18b20 *ds)
+{
+	ds->scratchpad[8] = w1_crc8(0, ds->scratchpad, 8);
+}
+
+/* Latch the conversion result once its time has elapsed */
+static void ds18b20_update(struct w1_sim_device *dev)
+{
+	struct w1_sim_ds18b20 *ds = &dev->u.ds18b20;
+	int32_t q4;
+	int r, t;
+
+	if (!ds->conv_pending || dev->host->slot_ns < ds->busy_until_ns)
+		return;
+	ds->conv_pending = 0;
+
+	if (ds->conv_ok) {
+		q4 = ds->millideg * 16 / 1000;
+		if (ds->millideg < 0 && q4 * 1000 != ds->millideg * 16)
+			q4--;
+		if (q4 < -55 * 16)
+			q4 = -55 * 16;
+		if (q4 > 125 * 16)
+			q4 = 125 * 16;
+		/* The bits below the resolution read as 0 */
+		r = (ds->scratchpad[4] >> 5) & 0x3;
+		q4 &= ~((1 << (3 - r)) - 1);
+	} else {
+		/* Browned out: the power-on value */
+		q4 = 85 * 16;
+	}
+	ds->scratchpad[0] = (uint8_t)q4;
+	ds->scratchpad[1] = (uint8_t)(q4 >> 8);
+	ds18b20_crc(ds);
+
+	t = q4 >> 4;
+	dev->alarm = t >= (int8_t)ds->scratchpad[2] || t <= (int8_t)ds->scratchpad[3];
+}
+
+static void ds18b20_reset(struct w1_sim_device *dev)
+{
+	ds18b20_update(dev);
+	dev->u.ds18b20.state = DS18B20_CMD;
+}
+
+static void ds18b20_rx_byte(struct w1_sim_device *dev, uint8_t byte)
+{
+	struct w1_sim_ds18b20 *ds = &dev->u.ds18b20;
+	int r;
+
+	ds18b20_update(dev);
+	switch (ds->state) {
+	case DS18B20_CMD:
+		switch (byte) {
+		case 0x44:	/* Convert T */
+			r = (ds->scratchpad[4] >> 5) & 0x3;
+			ds->busy_until_ns = BYTE_END(dev) +
+				w1_temp_conv_time_ms(W1_FAMILY_DS18B20, r + 9) * MS;
+			ds->conv_pending = 1;
+			/* A parasite powered device needs the strong pull-up throughout */
+			ds->conv_ok = !ds->parasite || dev->host->spu_end_ns >= ds->busy_until_ns;
+			ds->state = DS18B20_CONVERT;
+			break;
+		case 0x4E:	/* Write Scratchpad */
+			ds->nrx = 0;
+			ds->state = DS18B20_WRITE_SP;
+			break;
+		case 0xBE:	/* Read Scratchpad */
+			w1_sim_device_queue(dev, ds->scratchpad, 9);
+			ds->state = DS18B20_IGNORE;
+			break;
+		case 0x48:	/* Copy Scratchpad */
+			memcpy(ds->eeprom, &ds->scratchpad[2], 3);
+			ds->busy_until_ns = BYTE_END(dev) + DS18B20_COPY_MS * MS;
+			ds->state = DS18B20_COPY;
+			break;
+		case 0xB8:	/* Recall E2 */
+			memcpy(&ds->scratchpad[2], ds->eeprom, 3);
+			ds18b20_crc(ds);
+			ds->state = DS18B20_IGNORE;
+			break;
+		case 0xB4:	/* Read Power Supply */
+			ds->state = DS18B20_POWER;
+			break;
+		default:
+			ds->state = DS18B20_IGNORE;
+			break;
+		}
+		break;
+	case DS18B20_WRITE_SP:
+		/* TH, TL and configuration, only R1:R0 are writable */
+		if (ds->nrx == 2)
+			byte = (byte & 0x60) | 0x1F;
+		ds->scratchpad[2 + ds->nrx] = byte;
+		if (++ds->nrx == 3) {
+			ds18b20_crc(ds);
+			ds->state = DS18B20_IGNORE;
+		}
+		break;
+	default:
+		/* Busy polling slots and bytes after the command */
+		break;
+	}
+}
+
+static int ds18b20_idle_bit(struct w1_sim_device *dev)
+{
+	struct w1_sim_ds18b20 *ds = &dev->u.ds18b20;
+
+	switch (ds->state) {
+	case DS18B20_CONVERT:
+	case DS18B20_COPY:
+		/* A parasite powered device cannot pull the bus low to tell busy */
+		return ds->parasite || dev->host->slot_ns >= ds->busy_until_ns;
+	case DS18B20_POWER:
+		return !ds->parasite;
+	default:
+		return 1;
+	}
+}
+
+static const struct w1_sim_device_ops ds18b20_ops = {
+	.reset = ds18b20_reset,
+	.rx_byte = ds18b20_rx_byte,
+	.idle_bit = ds18b20_idle_bit,
+};
+
+void w1_sim_ds18b20_init(struct w1_sim_device *dev, uint64_t serial)
+{
+	struct w1_sim_ds18b20 *ds = &dev->u.ds18b20;
+	static const uint8_t por[9] = { 0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10, 0 };
+
+	w1_sim_device_init(dev, W1_FAMILY_DS18B20, serial, &ds18b20_ops);
+	memcpy(ds->scratchpad, por, sizeof(por));
+	memcpy(ds->eeprom, &por[2], 3);
+	ds18b20_crc(ds);
+	ds->millideg = 25000;
+}
+
+void w1_sim_ds18b20_set_temp(struct w1_sim_device *dev, int32_t millideg)
+{
+	dev->u.ds18b20.millideg = millideg;
+}
+
+/******************************** DS2431 ***********************************/
+#define W1_FAMILY_DS2431	0x2D
+#define DS2431_MEM_END		0x90
+#define DS2431_TPROG_MS		10
+
+#define DS2431_ES_PF		0x20	/* Partial write of the scratchpad */
+#define DS2431_ES_AA		0x80	/* Copy done */
+
+enum { DS2431_CMD, DS2431_WS_ADDR, DS2431_WS_DATA, DS2431_CP_AUTH, DS2431_CP_PROG,
+       DS2431_RM_ADDR, DS2431_RM_DATA, DS2431_IGNORE };
+
+static void ds2431_queue_crc(struct w1_sim_device *dev)
+{
+	struct w1_sim_ds2431 *ds = &dev->u.ds2431;
+	uint8_t crc[2];
+
+	crc[0] = (uint8_t)~ds->crc;
+	crc[1] = (uint8_t)(~ds->crc >> 8);
+	w1_sim_device_queue(dev, crc, 2);
+}
+
+/*
+ * End of a copy at the first bus activity after it. The device draws its
+ * programming current from the bus, which must stay idle for tPROG: a reset
+ * or a slot before leaves the row corrupted.
+ */
+static void ds2431_program(struct w1_sim_device *dev)
+{
+	struct w1_sim_ds2431 *ds = &dev->u.ds2431;
+	uint8_t *row = &ds->mem[ds->addr & ~7];
+
+	if (ds->state != DS2431_CP_PROG || !ds->copying)
+		return;
+	ds->copying = 0;
+	if (dev->host->slot_ns >= ds->busy_until_ns) {
+		memcpy(row, ds->scratchpad, 8);
+	} else {
+		memset(row, 0, 8);
+		ds->interrupted++;
+	}
+}
+
+static void ds2431_reset(struct w1_sim_device *dev)
+{
+	ds2431_program(dev);
+	dev->u.ds2431.state = DS2431_CMD;
+}
+
+static void ds2431_read_scratchpad(struct w1_sim_device *dev, uint8_t cmd)
+{
+	struct w1_sim_ds2431 *ds = &dev->u.ds2431;
+	uint8_t buf[3];
+	int start = ds->ta[0] & 7, end = ds->es & 7;
+
+	buf[0] = ds->ta[0];
+	buf[1] = ds->ta[1];
+	buf[2] = ds->es;
+	ds->crc = w1_crc16(0, &cmd, 1);
+	ds->crc = w1_crc16(ds->crc, buf, 3);
+	w1_sim_device_queue(dev, buf, 3);
+	if (end >= start) {
+		ds->crc = w1_crc16(ds->crc, &ds->scratchpad[start], end - start + 1);
+		w1_sim_device_queue(dev, &ds->scratchpad[start], end - start + 1);
+	}
+	ds2431_queue_crc(dev);
+}
+
+static void ds2431_rx_byte(struct w1_sim_device *dev, uint8_t byte)
+{
+	struct w1_sim_ds2431 *ds = &dev->u.ds2431;
+	int off;
+
+	ds2431_program(dev);
+	switch (ds->state) {
+	case DS2431_CMD:
+		ds->nrx = 0;
+		switch (byte) {
+		case 0x0F:	/* Write Scratchpad */
+			ds->crc = w1_crc16(0, &byte, 1);
+			ds->state = DS2431_WS_ADDR;
+			break;
+		case 0xAA:	/* Read Scratchpad */
+			ds2431_read_scratchpad(dev, byte);
+			ds->state = DS2431_IGNORE;
+			break;
+		case 0x55:	/* Copy Scratchpad */
+			ds->state = DS2431_CP_AUTH;
+			break;
+		case 0xF0:	/* Read Memory */
+			ds->state = DS2431_RM_ADDR;
+			break;
+		default:
+			ds->state = DS2431_IGNORE;
+			break;
+		}
+		break;
+	case DS2431_WS_ADDR:
+		ds->crc = w1_crc16(ds->crc, &byte, 1);
+		ds->ta[ds->nrx++] = byte;
+		if (ds->nrx == 2) {
+			ds->addr = ds->ta[0] | (ds->ta[1] << 8);
+			ds->es = DS2431_ES_PF | (ds->ta[0] & 7);
+			ds->nrx = ds->ta[0] & 7;
+			ds->state = DS2431_WS_DATA;
+		}
+		break;
+	case DS2431_WS_DATA:
+		ds->crc = w1_crc16(ds->crc, &byte, 1);
+		off = ds->nrx++;
+		ds->scratchpad[off] = byte;
+		ds->es = DS2431_ES_PF | off;
+		if (ds->nrx == 8) {
+			/* Scratchpad full: the CRC of the command, address and data */
+			ds->es = 7;
+			ds2431_queue_crc(dev);
+			ds->state = DS2431_IGNORE;
+		}
+		break;
+	case DS2431_CP_AUTH:
+		if (byte != (ds->nrx < 2 ? ds->ta[ds->nrx] : ds->es)) {
+			ds->state = DS2431_IGNORE;
+			break;
+		}
+		if (++ds->nrx < 3)
+			break;
+		if (ds->es & DS2431_ES_PF || ds->addr >= DS2431_MEM_END) {
+			ds->state = DS2431_IGNORE;
+			break;
+		}
+		ds->copying = 1;
+		ds->es |= DS2431_ES_AA;
+		ds->busy_until_ns = BYTE_END(dev) + DS2431_TPROG_MS * MS;
+		ds->pattern = 0;
+		ds->state = DS2431_CP_PROG;
+		break;
+	case DS2431_RM_ADDR:
+		ds->ta[ds->nrx++] = byte;
+		if (ds->nrx == 2) {
+			ds->addr = ds->ta[0] | (ds->ta[1] << 8);
+			ds->state = DS2431_RM_DATA;
+			dev->ops->tx_done(dev);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/* Read Memory streams the memory up to its end, one byte at a time */
+static void ds2431_tx_done(struct w1_sim_device *dev)
+{
+	struct w1_sim_ds2431 *ds = &dev->u.ds2431;
+
+	if (ds->state != DS2431_RM_DATA)
+		return;
+	if (ds->addr < DS2431_MEM_END)
+		w1_sim_device_queue(dev, &ds->mem[ds->addr++], 1);
+	else
+		ds->state = DS2431_IGNORE;
+}
+
+static int ds2431_idle_bit(struct w1_sim_device *dev)
+{
+	struct w1_sim_ds2431 *ds = &dev->u.ds2431;
+
+	ds2431_program(dev);
+	/* After tPROG, an alternating 0/1 pattern (0xAA) tells the copy is done */
+	if (ds->state == DS2431_CP_PROG && dev->host->slot_ns >= ds->busy_until_ns)
+		return ds->pattern++ & 1;
+	return 1;
+}
+
+static const struct w1_sim_device_ops ds2431_ops = {
+	.reset = ds2431_reset,
+	.rx_byte = ds2431_rx_byte,
+	.tx_done = ds2431_tx_done,
+	.idle_bit = ds2431_idle_bit,
+};
+
+void w1_sim_ds2431_init(struct w1_sim_device *dev, uint64_t serial)
+{
+	w1_sim_device_init(dev, W1_FAMILY_DS2431, serial, &ds2431_ops);
+	dev->has_resume = 1;
+	memset(dev->u.ds2431.mem, 0xFF, sizeof(dev->u.ds2431.mem));
+}
+
+/******************************** DS2413 ***********************************/
+enum { DS2413_CMD, DS2413_PIO_VALUE, DS2413_PIO_INV, DS2413_PIO_READ, DS2413_IGNORE };
+
+#define W1_FAMILY_DS2413	0x3A
+
+/* PIO Access Read/Write status: pin and latch of PIOA then PIOB, complemented above */
+static uint8_t ds2413_status(const struct w1_sim_ds2413 *ds)
+{
+	uint8_t a = ds->latch & 1, b = (ds->latch >> 1) & 1;
+	uint8_t low = a | a << 1 | b << 2 | b << 3;
+
+	return (uint8_t)(low | (uint8_t)~low << 4);
+}
+
+static void ds2413_reset(struct w1_sim_device *dev)
+{
+	dev->u.ds2413.state = DS2413_CMD;
+}
+
+static void ds2413_rx_byte(struct w1_sim_device *dev, uint8_t byte)
+{
+	struct w1_sim_ds2413 *ds = &dev->u.ds2413;
+	uint8_t rsp[2];
+
+	switch (ds->state) {
+	case DS2413_CMD:
+		switch (byte) {
+		case 0x5A:	/* PIO Access Write */
+			ds->state = DS2413_PIO_VALUE;
+			break;
+		case 0xF5:	/* PIO Access Read */
+			ds->state = DS2413_PIO_READ;
+			dev->ops->tx_done(dev);
+			break;
+		default:
+			ds->state = DS2413_IGNORE;
+			break;
+		}
+		break;
+	case DS2413_PIO_VALUE:
+		ds->value = byte;
+		ds->state = DS2413_PIO_INV;
+		break;
+	case DS2413_PIO_INV:
+		/* A corrupted byte leaves the latch alone, the bus reads 1s */
+		if ((uint8_t)(byte ^ ds->value) != 0xFF) {
+			ds->state = DS2413_IGNORE;
+			break;
+		}
+		ds->latch = ds->value & 3;
+		ds->latched_ns = BYTE_END(dev);
+		ds->writes++;
+		rsp[0] = 0xAA;
+		rsp[1] = ds2413_status(ds);
+		w1_sim_device_queue(dev, rsp, 2);
+		/* Another value may follow the status */
+		ds->state = DS2413_PIO_VALUE;
+		break;
+	default:
+		break;
+	}
+}
+
+/* PIO Access Read sends the status until a reset */
+static void ds2413_tx_done(struct w1_sim_device *dev)
+{
+	struct w1_sim_ds2413 *ds = &dev->u.ds2413;
+	uint8_t status;
+
+	if (ds->state != DS2413_PIO_READ)
+		return;
+	status = ds2413_status(ds);
+	w1_sim_device_queue(dev, &status, 1);
+}
+
+static const struct w1_sim_device_ops ds2413_ops = {
+	.reset = ds2413_reset,
+	.rx_byte = ds2413_rx_byte,
+	.tx_done = ds2413_tx_done,
+};
+
+void w1_sim_ds2413_init(struct w1_sim_device *dev, uint64_t serial)
+{
+	w1_sim_device_init(dev, W1_FAMILY_DS2413, serial, &ds2413_ops);
+	dev->u.ds2413.latch = 3;
+}
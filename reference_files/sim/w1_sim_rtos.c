@@ -0,0 +1,313 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+/*
+ * FreeRTOS shims of include/ (FreeRTOS.h, semphr.h, task.h), backed by
+ * threads, to run the port layer of the driver (axi_1wire_host_rtos.c)
+ * against the w1_sim model. Built with AXI_1WIRE_HOST_RTOS and -pthread.
+ *
+ * A single thread runs at a time, holding the kernel lock: a task up to its
+ * next block, or the scheduler. The scheduler calls the connected interrupt
+ * handlers while their IRQ line is high, then hands the CPU to the highest
+ * priority task ready, the one created first among equals. With no task
+ * ready, it advances the virtual time by W1_SIM_RTOS_STEP_NS, so a task
+ * blocked on a semaphore wakes up on the interrupt giving it or on its
+ * timeout, at the time of the model.
+ */
+#ifdef AXI_1WIRE_HOST_RTOS
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+#include "w1_sim.h"
+
+#define W1_SIM_RTOS_TASKS	8
+#define W1_SIM_RTOS_STEP_NS	1000
+#define W1_SIM_RTOS_TICK_NS	(1000000000ULL / configTICK_RATE_HZ)
+
+struct w1_sim_sem {
+	int recursive;
+	int count;			/* Binary semaphore given */
+	struct w1_sim_task *owner;	/* Recursive mutex */
+	int depth;
+};
+
+struct w1_sim_task {
+	pthread_t thread;
+	pthread_cond_t run;
+	TaskFunction_t code;
+	void *arg;
+	UBaseType_t priority;
+	int deleted;
+	/* Block: on sem if not NULL, up to deadline_ns */
+	struct w1_sim_sem *sem;
+	uint64_t deadline_ns;
+	int taken;
+};
+
+struct w1_sim_irq_handler {
+	struct w1_sim *sim;
+	void (*handler)(void *);
+	void *ref;
+};
+
+static pthread_mutex_t kernel = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sched_run = PTHREAD_COND_INITIALIZER;
+static struct w1_sim_task tasks[W1_SIM_RTOS_TASKS];
+static int ntasks;
+static struct w1_sim_task *current;
+static struct w1_sim_irq_handler handlers[W1_SIM_MAX_HOSTS];
+
+void w1_sim_rtos_connect(struct w1_sim *sim, void (*handler)(void *), void *ref)
+{
+	int i, free_slot = -1;
+
+	for (i = 0; i < W1_SIM_MAX_HOSTS; i++) {
+		if (handlers[i].sim == sim)
+			break;
+		if (free_slot < 0 && handlers[i].sim == NULL)
+			free_slot = i;
+	}
+	if (i == W1_SIM_MAX_HOSTS)
+		i = free_slot;
+	if (i < 0)
+		return;
+	handlers[i].sim = handler ? sim : NULL;
+	handlers[i].handler = handler;
+	handlers[i].ref = ref;
+}
+
+/******************************** Semaphores *******************************/
+static struct w1_sim_sem *sem_create(int recursive)
+{
+	struct w1_sim_sem *sem = calloc(1, sizeof(*sem));
+
+	if (sem)
+		sem->recursive = recursive;
+	return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+	return sem_create(0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+	return sem_create(1);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t xSemaphore)
+{
+	free(xSemaphore);
+}
+
+/* Take sem for task if it is free, kernel lock held */
+static int sem_try_take(struct w1_sim_sem *sem, struct w1_sim_task *task)
+{
+	if (!sem->recursive) {
+		if (sem->count == 0)
+			return 0;
+		sem->count = 0;
+		return 1;
+	}
+	if (sem->owner != NULL && sem->owner != task)
+		return 0;
+	sem->owner = task;
+	sem->depth++;
+	return 1;
+}
+
+/* Give the CPU back to the scheduler up to the end of the block of the task */
+static void task_block(struct w1_sim_task *task)
+{
+	current = NULL;
+	pthread_cond_signal(&sched_run);
+	while (current != task)
+		pthread_cond_wait(&task->run, &kernel);
+}
+
+static BaseType_t sem_take(struct w1_sim_sem *sem, TickType_t ticks)
+{
+	struct w1_sim_task *task = current;
+
+	if (sem_try_take(sem, task))
+		return pdTRUE;
+	if (ticks == 0)
+		return pdFALSE;
+	task->sem = sem;
+	task->deadline_ns = ticks == portMAX_DELAY ? UINT64_MAX :
+			    w1_sim_now_ns() + (uint64_t)ticks * W1_SIM_RTOS_TICK_NS;
+	task_block(task);
+	task->sem = NULL;
+	return task->taken ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xTicksToWait)
+{
+	return sem_take(xSemaphore, xTicksToWait);
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t xMutex, TickType_t xTicksToWait)
+{
+	return sem_take(xMutex, xTicksToWait);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore)
+{
+	if (xSemaphore->count)
+		return pdFALSE;
+	xSemaphore->count = 1;
+	return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t xSemaphore,
+				 BaseType_t *pxHigherPriorityTaskWoken)
+{
+	if (pxHigherPriorityTaskWoken)
+		*pxHigherPriorityTaskWoken = pdFALSE;
+	return xSemaphoreGive(xSemaphore);
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t xMutex)
+{
+	if (xMutex->owner != current || xMutex->depth == 0)
+		return pdFALSE;
+	if (--xMutex->depth == 0)
+		xMutex->owner = NULL;
+	return pdTRUE;
+}
+
+/*********************************** Tasks *********************************/
+static void *task_thread(void *arg)
+{
+	struct w1_sim_task *task = arg;
+
+	pthread_mutex_lock(&kernel);
+	while (current != task)
+		pthread_cond_wait(&task->run, &kernel);
+	task->code(task->arg);
+	/* A task must not return, delete it as if it did */
+	vTaskDelete(NULL);
+	return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char *pcName, uint32_t usStackDepth,
+		       void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pxCreatedTask)
+{
+	struct w1_sim_task *task;
+
+	(void)pcName;
+	(void)usStackDepth;
+	if (ntasks == W1_SIM_RTOS_TASKS)
+		return pdFAIL;
+	task = &tasks[ntasks];
+	pthread_cond_init(&task->run, NULL);
+	task->code = pxTaskCode;
+	task->arg = pvParameters;
+	task->priority = uxPriority;
+	task->deleted = 0;
+	task->sem = NULL;
+	task->deadline_ns = 0;
+	if (pthread_create(&task->thread, NULL, task_thread, task) != 0)
+		return pdFAIL;
+	ntasks++;
+	if (pxCreatedTask)
+		*pxCreatedTask = task;
+	return pdPASS;
+}
+
+/* Only a task deleting itself */
+void vTaskDelete(TaskHandle_t xTaskToDelete)
+{
+	struct w1_sim_task *task = current;
+
+	(void)xTaskToDelete;
+	task->deleted = 1;
+	current = NULL;
+	pthread_cond_signal(&sched_run);
+	pthread_mutex_unlock(&kernel);
+	pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t xTicksToDelay)
+{
+	struct w1_sim_task *task = current;
+
+	task->sem = NULL;
+	task->deadline_ns = w1_sim_now_ns() + (uint64_t)xTicksToDelay * W1_SIM_RTOS_TICK_NS;
+	task_block(task);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+	return (TickType_t)(w1_sim_now_ns() / W1_SIM_RTOS_TICK_NS);
+}
+
+/********************************* Scheduler *******************************/
+/* Run the handlers of the IRQ lines high, as the interrupt controller */
+static void sched_interrupts(void)
+{
+	int i;
+
+	for (i = 0; i < W1_SIM_MAX_HOSTS; i++)
+		if (handlers[i].sim && w1_sim_irq(handlers[i].sim))
+			handlers[i].handler(handlers[i].ref);
+}
+
+/* The task to run next, its semaphore taken if it got it, NULL if none is ready */
+static struct w1_sim_task *sched_pick(int *alive)
+{
+	struct w1_sim_task *task, *best = NULL;
+	uint64_t now = w1_sim_now_ns();
+	int i, ready;
+
+	*alive = 0;
+	for (i = 0; i < ntasks; i++) {
+		task = &tasks[i];
+		if (task->deleted)
+			continue;
+		(*alive)++;
+		if (task->sem)
+			ready = (task->sem->recursive ?
+				 task->sem->owner == NULL || task->sem->owner == task :
+				 task->sem->count != 0) || now >= task->deadline_ns;
+		else
+			ready = now >= task->deadline_ns;
+		if (ready && (best == NULL || task->priority > best->priority))
+			best = task;
+	}
+	if (best && best->sem)
+		best->taken = sem_try_take(best->sem, best);
+	return best;
+}
+
+void vTaskStartScheduler(void)
+{
+	struct w1_sim_task *task;
+	int alive;
+
+	pthread_mutex_lock(&kernel);
+	for (;;) {
+		sched_interrupts();
+		task = sched_pick(&alive);
+		if (alive == 0)
+			break;
+		if (task == NULL) {
+			w1_sim_advance_ns(W1_SIM_RTOS_STEP_NS);
+			continue;
+		}
+		current = task;
+		pthread_cond_signal(&task->run);
+		while (current != NULL)
+			pthread_cond_wait(&sched_run, &kernel);
+	}
+	pthread_mutex_unlock(&kernel);
+	for (alive = 0; alive < ntasks; alive++)
+		pthread_join(tasks[alive].thread, NULL);
+	ntasks = 0;
+}
+#endif /* AXI_1WIRE_HOST_RTOS */
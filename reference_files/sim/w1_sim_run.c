@@ -0,0 +1,797 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+/*
+ * w1_sim_run: run the baremetal driver against the w1_sim model.
+ *
+ * Bus 0 holds three DS18B20 and a DS2431, bus 1 a parasite powered DS18B20,
+ * then another DS2431 to program two EEPROMs at once and a DS2413 switch.
+ * The DS2431 memory is also read with the block instructions, the model
+ * standing for the AXI DMA on the stream ports, and the scratchpads with the
+ * devices selected from the ROM ID table of the IP.
+ * Each scenario checks the data read back against the models and reports the
+ * virtual time it took, the 1-Wire bus time and the handshake overhead, so a
+ * driver change can be regression-tested and benchmarked without hardware.
+ *
+ * Built with -DAXI_1WIRE_HOST_RTOS (and -pthread), the FreeRTOS port layer
+ * also runs on the shims of w1_sim_rtos.c: two tasks share bus 0, and every
+ * wait must time out with the interrupt disconnected.
+ *
+ * Usage: w1_sim_run [-b iterations] [-s iterations] [-r axi_read_ns] [-w axi_write_ns]
+ *                   [-t trace.bin]
+ *   -b  also run AXI_1WIRE_HOST_SelfTestBenchmark()
+ *   -s  also run the benchmark_suite() of the application on bus 0
+ *   -r, -w  cost of an AXI read/write (default 150/100 ns)
+ *   -t  write the bus trace of bus 0 (built with -DAXI_1WIRE_HOST_TRACE), see
+ *       tools/w1_trace_analyze.c
+ *
+ * The exit status is the number of failed checks.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "application_bench.h"
+#include "application_mem.h"
+#include "axi_1wire_host.h"
+#ifdef AXI_1WIRE_HOST_RTOS
+#include "axi_1wire_host_rtos.h"
+#endif
+#include "sleep.h"
+#include "w1_crc.h"
+#include "w1_sim.h"
+#include "w1_temp.h"
+
+#define BUS0_BASE	XPAR_AXI_1WIRE_HOST_0_BASEADDR
+#define BUS1_BASE	(XPAR_AXI_1WIRE_HOST_0_BASEADDR + 0x10000)
+
+#define MAX_ROMS	8
+#define TRACE_RECORDS	65536
+#define RTOS_TXNS	5	/* Scratchpad reads of each task */
+
+static struct w1_sim bus0, bus1;
+static struct w1_sim_device sensors[3], eeprom, parasite, eeprom1, pio;
+static int failures;
+#ifdef AXI_1WIRE_HOST_TRACE
+static u64 trace_mem[W1_TRACE_RING_BYTES(TRACE_RECORDS) / sizeof(u64)];
+#endif
+
+static void check(int ok, const char *what)
+{
+	if (!ok) {
+		printf("FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+struct phase {
+	const char *name;
+	struct w1_sim *sim;
+	uint64_t start_ns;
+};
+
+static void phase_start(struct phase *p, const char *name, struct w1_sim *sim)
+{
+	p->name = name;
+	p->sim = sim;
+	p->start_ns = w1_sim_now_ns();
+	w1_sim_reset_stats(sim);
+}
+
+/* Elapsed virtual time, bus time of the IP and what the host added */
+static void phase_end(const struct phase *p)
+{
+	const struct w1_sim_stats *s = &p->sim->stats;
+	uint64_t elapsed = w1_sim_now_ns() - p->start_ns;
+
+	printf("%-28s %10llu us, bus %10llu us (%3llu%%), %5llu instr, %7llu AXI rd, %5llu AXI wr\n",
+	       p->name, (unsigned long long)(elapsed / 1000),
+	       (unsigned long long)(s->bus_ns / 1000),
+	       (unsigned long long)(elapsed ? s->bus_ns * 100 / elapsed : 0),
+	       (unsigned long long)s->instructions, (unsigned long long)s->axi_reads,
+	       (unsigned long long)s->axi_writes);
+}
+
+static void write_bytes(u32 ba, const u8 *buf, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		AXI_1WIRE_HOST_WriteByte(ba, buf[i]);
+}
+
+static void read_bytes(u32 ba, u8 *buf, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = AXI_1WIRE_HOST_ReadByte(ba);
+}
+
+/* Reset and address one device, rom NULL for Skip ROM */
+static int select_rom(u32 ba, const u8 *rom)
+{
+	if (AXI_1WIRE_HOST_ResetBus(ba) != 0)
+		return -1;
+	if (rom) {
+		AXI_1WIRE_HOST_WriteByte(ba, 0x55);
+		write_bytes(ba, rom, 8);
+	} else {
+		AXI_1WIRE_HOST_WriteByte(ba, 0xCC);
+	}
+	return 0;
+}
+
+/* Search ROM with the touch-bit primitive, as the w1 core does */
+static int search(u32 ba, u8 cmd, u8 (*roms)[8], int max)
+{
+	u8 rom[8] = { 0 };
+	int last_discrepancy = -1, n = 0, bit, marker;
+	u8 id, cmp, dir;
+
+	do {
+		if (AXI_1WIRE_HOST_ResetBus(ba) != 0)
+			return 0;
+		AXI_1WIRE_HOST_WriteByte(ba, cmd);
+		marker = -1;
+		for (bit = 0; bit < 64; bit++) {
+			id = AXI_1WIRE_HOST_TouchBit(ba, 1);
+			cmp = AXI_1WIRE_HOST_TouchBit(ba, 1);
+			if (id && cmp)
+				return n;	/* Nobody left */
+			if (id != cmp)
+				dir = id;
+			else if (bit == last_discrepancy)
+				dir = 1;
+			else if (bit > last_discrepancy)
+				dir = 0;
+			else
+				dir = (rom[bit >> 3] >> (bit & 7)) & 1;
+			if (id == cmp && dir == 0)
+				marker = bit;
+			rom[bit >> 3] = (rom[bit >> 3] & ~(1 << (bit & 7))) | (dir << (bit & 7));
+			AXI_1WIRE_HOST_TouchBit(ba, dir);
+		}
+		if (w1_crc8(0, rom, 8) == 0 && n < max)
+			memcpy(roms[n++], rom, 8);
+		last_discrepancy = marker;
+	} while (last_discrepancy >= 0);
+
+	return n;
+}
+
+#ifdef AXI_1WIRE_HOST_TRACE
+static void write_trace(const char *path)
+{
+	static u64 snap[sizeof(trace_mem) / sizeof(u64)];
+	struct w1_trace_ring *s = (struct w1_trace_ring *)snap;
+	FILE *f;
+	u32 n;
+
+	AXI_1WIRE_HOST_TraceStop(BUS0_BASE);
+	n = w1_trace_snapshot((struct w1_trace_ring *)trace_mem, s);
+	check(n > 0, "bus trace recorded");
+	f = fopen(path, "wb");
+	if (!f || fwrite(s, W1_TRACE_RING_BYTES(n), 1, f) != 1)
+		check(0, "bus trace written");
+	if (f)
+		fclose(f);
+}
+#endif
+
+static int find_rom(u8 (*roms)[8], int n, const struct w1_sim_device *dev)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		if (memcmp(roms[i], dev->rom, 8) == 0)
+			return 1;
+	return 0;
+}
+
+static int16_t read_temp(u32 ba, const u8 *rom, int *crc_ok)
+{
+	u8 sp[W1_SCRATCHPAD_SIZE];
+
+	if (select_rom(ba, rom) != 0) {
+		*crc_ok = 0;
+		return 0;
+	}
+	AXI_1WIRE_HOST_WriteByte(ba, 0xBE);
+	read_bytes(ba, sp, sizeof(sp));
+	*crc_ok = w1_crc8(0, sp, sizeof(sp)) == 0;
+	return w1_temp_decode(W1_FAMILY_DS18B20, 0, sp);
+}
+
+/* The CAPS register, then the same features derived from older IP versions */
+static void run_caps(void)
+{
+	u32 caps = AXI_1WIRE_HOST_Capabilities(BUS0_BASE);
+
+	check(caps == (W1_CAP_SPU | W1_CAP_TIMING | W1_CAP_BLOCK | W1_CAP_ROM_TABLE |
+		       W1_CAP_POLL_BIT | W1_SIM_ROM_TABLE << W1_CAPS_ROM_SHIFT), "capabilities");
+
+	/* IPVER is writable, as slv_reg6 of the IP */
+	w1_sim_write32(&bus0, W1_SIM_IPVER_REG, 0x76000107);
+	check(AXI_1WIRE_HOST_Capabilities(BUS0_BASE) == caps, "capabilities of v1.7");
+	w1_sim_write32(&bus0, W1_SIM_IPVER_REG, 0x76000104);
+	check(AXI_1WIRE_HOST_Capabilities(BUS0_BASE) == (W1_CAP_SPU | W1_CAP_TIMING) &&
+	      !AXI_1WIRE_HOST_HasBlockStream(BUS0_BASE) && AXI_1WIRE_HOST_RomTableSize(BUS0_BASE) == 0,
+	      "capabilities of v1.4");
+	w1_sim_write32(&bus0, W1_SIM_IPVER_REG, 0x76000200);
+	check(AXI_1WIRE_HOST_Capabilities(BUS0_BASE) == 0, "no capabilities of v2.0");
+	w1_sim_write32(&bus0, W1_SIM_IPVER_REG, W1_SIM_IPVER);
+}
+
+static void run_search(void)
+{
+	u8 roms[MAX_ROMS][8];
+	struct phase p;
+	int n, i;
+
+	phase_start(&p, "Search ROM, 4 devices", &bus0);
+	n = search(BUS0_BASE, 0xF0, roms, MAX_ROMS);
+	phase_end(&p);
+	check(n == 4, "search finds the 4 devices");
+	for (i = 0; i < 3; i++)
+		check(find_rom(roms, n, &sensors[i]), "search finds each DS18B20");
+	check(find_rom(roms, n, &eeprom), "search finds the DS2431");
+}
+
+static void run_conversion(void)
+{
+	static const int32_t temps[3] = { 21500, -10125, 85000 };
+	struct phase p;
+	int16_t q4;
+	int i, crc_ok;
+
+	for (i = 0; i < 3; i++)
+		w1_sim_ds18b20_set_temp(&sensors[i], temps[i]);
+
+	/* One conversion for all, as the application does */
+	phase_start(&p, "Convert T, skip ROM + sleep", &bus0);
+	select_rom(BUS0_BASE, NULL);
+	AXI_1WIRE_HOST_WriteByte(BUS0_BASE, 0x44);
+	usleep(w1_temp_conv_time_ms(W1_FAMILY_DS18B20, 12) * 1000);
+	check(AXI_1WIRE_HOST_TouchBit(BUS0_BASE, 1) == 1, "conversion done after tCONV");
+	phase_end(&p);
+
+	phase_start(&p, "Read 3 scratchpads", &bus0);
+	for (i = 0; i < 3; i++) {
+		q4 = read_temp(BUS0_BASE, sensors[i].rom, &crc_ok);
+		check(crc_ok, "scratchpad CRC");
+		check(w1_temp_to_millideg(q4) == temps[i], "temperature read back");
+	}
+	phase_end(&p);
+
+	/* Busy polling instead of sleeping, for comparison */
+	phase_start(&p, "Convert T, read slot polling", &bus0);
+	select_rom(BUS0_BASE, sensors[0].rom);
+	AXI_1WIRE_HOST_WriteByte(BUS0_BASE, 0x44);
+	while (AXI_1WIRE_HOST_TouchBit(BUS0_BASE, 1) == 0) {}
+	phase_end(&p);
+
+	/* The same slots run by the IP, a single instruction */
+	phase_start(&p, "Convert T, POLL_BIT", &bus0);
+	select_rom(BUS0_BASE, sensors[0].rom);
+	AXI_1WIRE_HOST_WriteByte(BUS0_BASE, 0x44);
+	check(AXI_1WIRE_HOST_PollBit(BUS0_BASE, 0, AXI_1WIRE_HOST_POLL_MAX) == 1,
+	      "POLL_BIT sees the end of the conversion");
+	phase_end(&p);
+
+	/* Slots 1 ms apart: a timeout, then the end of the conversion */
+	select_rom(BUS0_BASE, sensors[0].rom);
+	AXI_1WIRE_HOST_WriteByte(BUS0_BASE, 0x44);
+	check(AXI_1WIRE_HOST_PollBit(BUS0_BASE, 1000, 5) == 0 &&
+	      AXI_1WIRE_HOST_mReadReg(BUS0_BASE, AXI_1WIRE_HOST_POLLCNT_REG_OFFSET) == 5,
+	      "POLL_BIT times out after its slots");
+	check(AXI_1WIRE_HOST_PollBit(BUS0_BASE, 1000,
+				     w1_temp_conv_time_ms(W1_FAMILY_DS18B20, 12) + 1) == 1,
+	      "POLL_BIT 1 ms apart");
+
+	/* Copy Scratchpad to the EEPROM, done within tWR */
+	phase_start(&p, "Copy scratchpad, POLL_BIT", &bus0);
+	select_rom(BUS0_BASE, sensors[1].rom);
+	AXI_1WIRE_HOST_WriteByte(BUS0_BASE, 0x48);
+	check(AXI_1WIRE_HOST_PollBit(BUS0_BASE, 1000, 2 * W1_TEMP_COPY_TIME_MS) == 1 &&
+	      AXI_1WIRE_HOST_mReadReg(BUS0_BASE, AXI_1WIRE_HOST_POLLCNT_REG_OFFSET) > 1,
+	      "copy scratchpad waited for by POLL_BIT");
+	phase_end(&p);
+}
+
+/* The scratchpads again with the slots trimmed, then out of the device limits */
+static void run_timing(void)
+{
+	AXI_1WIRE_HOST_Timing def, t;
+	struct phase p;
+	int16_t q4;
+	int i, crc_ok, ok = 1;
+
+	check(AXI_1WIRE_HOST_GetTiming(BUS0_BASE, &def) == XST_SUCCESS &&
+	      def.SlotNs == W1_SIM_SLOT_US * 1000 && def.Write1LowNs == W1_SIM_LOW1_US * 1000,
+	      "timing reset values");
+
+	memset(&t, 0, sizeof(t));
+	t.SlotNs = 61000;
+	t.RecoveryNs = 1000;
+	check(AXI_1WIRE_HOST_SetTiming(BUS0_BASE, &t) == XST_SUCCESS, "set timing");
+	phase_start(&p, "Read 3 scratchpads, 61us", &bus0);
+	for (i = 0; i < 3; i++) {
+		q4 = read_temp(BUS0_BASE, sensors[i].rom, &crc_ok);
+		ok &= crc_ok && w1_temp_to_millideg(q4) == sensors[i].u.ds18b20.millideg;
+	}
+	phase_end(&p);
+	check(ok && bus0.stats.timing_errors == 0, "temperatures read with trimmed slots");
+
+	/* A write-0 shorter than tLOW0 is not seen by the devices */
+	t.Write0LowNs = 30000;
+	AXI_1WIRE_HOST_SetTiming(BUS0_BASE, &t);
+	w1_sim_reset_stats(&bus0);
+	q4 = read_temp(BUS0_BASE, sensors[0].rom, &crc_ok);
+	check(!crc_ok && bus0.stats.timing_errors != 0, "write-0 below tLOW0 detected");
+
+	check(AXI_1WIRE_HOST_SetTiming(BUS0_BASE, &def) == XST_SUCCESS, "timing restored");
+}
+
+static void run_parasite(void)
+{
+	struct phase p;
+	int16_t q4;
+	int crc_ok;
+
+	w1_sim_ds18b20_set_temp(&parasite, 30000);
+
+	/* Without strong pull-up the device browns out and keeps 85 C */
+	select_rom(BUS1_BASE, NULL);
+	AXI_1WIRE_HOST_WriteByte(BUS1_BASE, 0x44);
+	usleep(750 * 1000);
+	q4 = read_temp(BUS1_BASE, NULL, &crc_ok);
+	check(crc_ok && w1_temp_to_millideg(q4) == 85000, "parasite conversion fails without SPU");
+
+	phase_start(&p, "Parasite convert, SPU", &bus1);
+	select_rom(BUS1_BASE, NULL);
+	AXI_1WIRE_HOST_WriteByteStrongPullup(BUS1_BASE, 0x44, 750 * 1000);
+	phase_end(&p);
+	q4 = read_temp(BUS1_BASE, NULL, &crc_ok);
+	check(crc_ok && w1_temp_to_millideg(q4) == 30000, "parasite conversion with SPU");
+}
+
+static void run_eeprom(void)
+{
+	static const u8 data[8] = { 0xDE, 0xAD, 0xBE, 0xEF, 0x01, 0x23, 0x45, 0x67 };
+	u8 buf[16], auth[3], mem[8];
+	struct phase p;
+	u16 crc;
+	int i;
+
+	phase_start(&p, "DS2431 write/copy/read row", &bus0);
+	/* Write Scratchpad at 0x0008, then read the inverted CRC-16 */
+	select_rom(BUS0_BASE, eeprom.rom);
+	buf[0] = 0x0F;
+	buf[1] = 0x08;
+	buf[2] = 0x00;
+	memcpy(&buf[3], data, 8);
+	write_bytes(BUS0_BASE, buf, 11);
+	read_bytes(BUS0_BASE, &buf[11], 2);
+	check(w1_crc16(0, buf, 13) == W1_CRC16_RESIDUE, "write scratchpad CRC-16");
+
+	/* Read Scratchpad: TA1, TA2, E/S, data, CRC-16 */
+	select_rom(BUS0_BASE, eeprom.rom);
+	buf[0] = 0xAA;
+	AXI_1WIRE_HOST_WriteByte(BUS0_BASE, buf[0]);
+	read_bytes(BUS0_BASE, &buf[1], 13);
+	check(w1_crc16(0, buf, 14) == W1_CRC16_RESIDUE, "read scratchpad CRC-16");
+	check(memcmp(&buf[4], data, 8) == 0, "scratchpad data");
+	memcpy(auth, &buf[1], 3);
+
+	/* Copy Scratchpad with the authorization, wait tPROG, expect 0xAA */
+	select_rom(BUS0_BASE, eeprom.rom);
+	AXI_1WIRE_HOST_WriteByte(BUS0_BASE, 0x55);
+	write_bytes(BUS0_BASE, auth, 3);
+	usleep(10 * 1000);
+	check(AXI_1WIRE_HOST_ReadByte(BUS0_BASE) == 0xAA, "copy scratchpad done");
+
+	/* Read Memory back */
+	select_rom(BUS0_BASE, eeprom.rom);
+	buf[0] = 0xF0;
+	buf[1] = 0x08;
+	buf[2] = 0x00;
+	write_bytes(BUS0_BASE, buf, 3);
+	read_bytes(BUS0_BASE, mem, 8);
+	AXI_1WIRE_HOST_ResetBus(BUS0_BASE);
+	phase_end(&p);
+	check(memcmp(mem, data, 8) == 0, "memory data");
+	crc = 0;
+	for (i = 0; i < 8; i++)
+		crc |= eeprom.u.ds2431.mem[i] != 0xFF;
+	check(crc == 0, "neighbouring row untouched");
+}
+
+/*
+ * Block transfer of an already started stream, the CPU being free during
+ * its bus time: sleep for it, then wait for DONE
+ */
+static u32 block(u32 ba, u32 instr, u32 bytes)
+{
+	AXI_1WIRE_HOST_Timing t;
+
+	if (AXI_1WIRE_HOST_BlockStart(ba, instr, bytes) != XST_SUCCESS)
+		return 0;
+	AXI_1WIRE_HOST_GetTiming(ba, &t);
+	usleep(bytes * 8 * (t.SlotNs / 1000));
+	return AXI_1WIRE_HOST_BlockWait(ba);
+}
+
+/* The whole DS2431 memory, one handshake per byte, then with the streams */
+static void run_stream(void)
+{
+	static const u8 cmd[3] = { 0xF0, 0x00, 0x00 };	/* Read Memory from 0 */
+	u8 pio[128], dma[128];
+	struct phase p;
+
+	phase_start(&p, "DS2431 read 128 bytes", &bus0);
+	select_rom(BUS0_BASE, eeprom.rom);
+	write_bytes(BUS0_BASE, cmd, 3);
+	read_bytes(BUS0_BASE, pio, sizeof(pio));
+	phase_end(&p);
+	check(memcmp(pio, eeprom.u.ds2431.mem, sizeof(pio)) == 0, "memory read");
+
+	check(AXI_1WIRE_HOST_HasBlockStream(BUS0_BASE), "block instructions");
+	phase_start(&p, "DS2431 read 128 bytes, DMA", &bus0);
+	select_rom(BUS0_BASE, eeprom.rom);
+	w1_sim_stream_tx(&bus0, cmd, 3);
+	check(block(BUS0_BASE, AXI_1WIRE_HOST_WRITEBLOCK, 3) == 3, "block written");
+	w1_sim_stream_rx(&bus0, dma, sizeof(dma));
+	check(block(BUS0_BASE, AXI_1WIRE_HOST_READBLOCK, sizeof(dma)) == sizeof(dma),
+	      "block read");
+	phase_end(&p);
+	check(memcmp(dma, pio, sizeof(dma)) == 0, "memory read with the streams");
+
+	/* A DMA transfer shorter than the block stalls it until a reset */
+	select_rom(BUS0_BASE, eeprom.rom);
+	w1_sim_stream_tx(&bus0, cmd, 2);
+	AXI_1WIRE_HOST_BlockStart(BUS0_BASE, AXI_1WIRE_HOST_WRITEBLOCK, 3);
+	usleep(1000);
+	check(!(w1_sim_read32(&bus0, W1_SIM_STAT_REG) & AXI_1WIRE_HOST_DONE) &&
+	      (w1_sim_read32(&bus0, W1_SIM_BCNT_REG) & AXI_1WIRE_HOST_BLOCK_MAX) == 2,
+	      "short stream stalls the block");
+	AXI_1WIRE_HOST_Reset(BUS0_BASE);
+	check(AXI_1WIRE_HOST_ResetBus(BUS0_BASE) == 0, "bus usable after the stall");
+}
+
+/* The scratchpads with SELECT_ROM from the ROM ID table, and PING_ALL */
+static void run_romtable(void)
+{
+	u8 roms[MAX_ROMS][8], sp[W1_SCRATCHPAD_SIZE];
+	struct phase p;
+	u64 found;
+	int n, i, ok = 1;
+
+	n = search(BUS0_BASE, 0xF0, roms, MAX_ROMS);
+	check(AXI_1WIRE_HOST_RomTableSize(BUS0_BASE) >= (u32)n, "ROM ID table");
+	check(AXI_1WIRE_HOST_RomTableLoad(BUS0_BASE, (const u8 (*)[8])roms, n) == XST_SUCCESS,
+	      "ROM ID table loaded");
+
+	/* Same as "Read 3 scratchpads", one instruction per select instead of ten */
+	phase_start(&p, "Read 3 scratchpads, table", &bus0);
+	for (i = 0; i < n; i++) {
+		if (roms[i][0] != W1_FAMILY_DS18B20)
+			continue;
+		if (AXI_1WIRE_HOST_SelectRom(BUS0_BASE, i) != 0) {
+			ok = 0;
+			continue;
+		}
+		AXI_1WIRE_HOST_WriteByte(BUS0_BASE, 0xBE);
+		read_bytes(BUS0_BASE, sp, sizeof(sp));
+		if (w1_crc8(0, sp, sizeof(sp)) != 0)
+			ok = 0;
+	}
+	phase_end(&p);
+	check(ok, "scratchpads read after SELECT_ROM");
+
+	phase_start(&p, "Ping 4 devices", &bus0);
+	found = AXI_1WIRE_HOST_PingAll(BUS0_BASE, n);
+	phase_end(&p);
+	check(found == (1ULL << n) - 1, "PING_ALL finds the devices");
+
+	/* A device gone does not answer its ping nor its select */
+	w1_sim_remove_device(&bus0, &sensors[1]);
+	for (i = 0; i < n && memcmp(roms[i], sensors[1].rom, 8) != 0; i++) {}
+	found = AXI_1WIRE_HOST_PingAll(BUS0_BASE, n);
+	check(found == (((1ULL << n) - 1) & ~(1ULL << i)), "PING_ALL misses the device removed");
+	w1_sim_add_device(&bus0, &sensors[1]);
+	check(AXI_1WIRE_HOST_SelectRom(BUS0_BASE, i) == 0, "SELECT_ROM after the device is back");
+}
+
+/*
+ * Whole DS2431 images with eeprom_program(): the two EEPROMs one after the
+ * other, then together, the copy on one bus overlapping the pages written on
+ * the other. The second one goes on bus 1 once the parasite sensor is no
+ * longer addressed with Skip ROM.
+ */
+static void run_eeprom_program(void)
+{
+	static const u8 patch[5] = { 0x11, 0x22, 0x33, 0x44, 0x55 };
+	u8 img0[128], img1[128], expect[128];
+	eeprom_job_t jobs[2];
+	struct phase p;
+	u64 seq_ns, pipe_ns;
+	int i;
+
+	w1_sim_ds2431_init(&eeprom1, 0x0000C0FFEE01ULL);
+	w1_sim_add_device(&bus1, &eeprom1);
+	for (i = 0; i < 128; i++) {
+		img0[i] = (u8)(i * 7 + 1);
+		img1[i] = (u8)~img0[i];
+	}
+
+	phase_start(&p, "DS2431 x2 images, one by one", &bus0);
+	check(eeprom_write(BUS0_BASE, eeprom.rom, 0, img0, 128) == XST_SUCCESS &&
+	      eeprom_write(BUS1_BASE, eeprom1.rom, 0, img1, 128) == XST_SUCCESS,
+	      "images programmed one by one");
+	seq_ns = w1_sim_now_ns() - p.start_ns;
+	phase_end(&p);
+
+	for (i = 0; i < 128; i++) {
+		img0[i] ^= 0x5A;
+		img1[i] ^= 0xA5;
+	}
+	memset(jobs, 0, sizeof(jobs));
+	jobs[0].baseaddr = BUS0_BASE;
+	jobs[0].rom = eeprom.rom;
+	jobs[0].data = img0;
+	jobs[0].len = 128;
+	jobs[1].baseaddr = BUS1_BASE;
+	jobs[1].rom = eeprom1.rom;
+	jobs[1].data = img1;
+	jobs[1].len = 128;
+	phase_start(&p, "DS2431 x2 images, pipelined", &bus0);
+	check(eeprom_program(jobs, 2) == XST_SUCCESS, "images programmed together");
+	pipe_ns = w1_sim_now_ns() - p.start_ns;
+	phase_end(&p);
+	check(memcmp(eeprom.u.ds2431.mem, img0, 128) == 0 &&
+	      memcmp(eeprom1.u.ds2431.mem, img1, 128) == 0, "images in the memories");
+	check(pipe_ns < seq_ns, "copies overlapped across the buses");
+	check(eeprom.u.ds2431.interrupted == 0 && eeprom1.u.ds2431.interrupted == 0,
+	      "bus idle during tPROG");
+
+	/* Across two rows, both read first and completed */
+	memcpy(expect, img0, 128);
+	memcpy(&expect[0x14], patch, sizeof(patch));
+	check(eeprom_write(BUS0_BASE, eeprom.rom, 0x14, patch, sizeof(patch)) == XST_SUCCESS,
+	      "partial rows programmed");
+	check(memcmp(eeprom.u.ds2431.mem, expect, 128) == 0, "partial rows read-modify-write");
+	check(eeprom_write(BUS0_BASE, eeprom.rom, 0x7E, patch, sizeof(patch)) == XST_INVALID_PARAM,
+	      "range past the memory refused");
+}
+
+/*
+ * DS2413 PIO Access Write on bus 1. The phase ends with the complement
+ * received, when the output switches: the floor of an actuation at standard
+ * speed. A corrupted complement must leave the latch alone.
+ */
+static void run_switch(void)
+{
+	static const u8 on[3] = { 0x5A, 0xFE, 0x01 }, bad[3] = { 0x5A, 0xFC, 0xFC };
+	u8 rsp[2];
+	struct phase p;
+
+	w1_sim_ds2413_init(&pio, 0x0000005A1300ULL);
+	w1_sim_add_device(&bus1, &pio);
+
+	phase_start(&p, "DS2413 PIO write, to latch", &bus1);
+	check(select_rom(BUS1_BASE, pio.rom) == 0, "DS2413 present");
+	write_bytes(BUS1_BASE, on, sizeof(on));
+	phase_end(&p);
+	read_bytes(BUS1_BASE, rsp, sizeof(rsp));
+	AXI_1WIRE_HOST_ResetBus(BUS1_BASE);
+	check(rsp[0] == 0xAA && rsp[1] == 0x3C && pio.u.ds2413.latch == 2, "PIOA switched on");
+
+	select_rom(BUS1_BASE, pio.rom);
+	write_bytes(BUS1_BASE, bad, sizeof(bad));
+	read_bytes(BUS1_BASE, rsp, 1);
+	AXI_1WIRE_HOST_ResetBus(BUS1_BASE);
+	check(rsp[0] == 0xFF && pio.u.ds2413.latch == 2 && pio.u.ds2413.writes == 1,
+	      "corrupted PIO write refused");
+}
+
+#ifdef AXI_1WIRE_HOST_RTOS
+static AXI_1WIRE_HOST_Rtos rtos;
+static int rtos_inside, rtos_overlaps, rtos_contended, rtos_reads;
+
+/*
+ * Read the scratchpad of a sensor RTOS_TXNS times, the bus held from the
+ * reset to the last byte: the other task, ready meanwhile, must wait.
+ */
+static void rtos_reader(void *arg)
+{
+	const u8 *rom = sensors[(uintptr_t)arg].rom;
+	u8 sp[W1_SCRATCHPAD_SIZE], presence = 1;
+	XStatus Status;
+	u64 start;
+	int n, i;
+
+	for (n = 0; n < RTOS_TXNS; n++) {
+		start = w1_sim_now_ns();
+		if (AXI_1WIRE_HOST_RTOS_Lock(&rtos) != XST_SUCCESS)
+			continue;
+		/* Blocked on the mutex, not only on its own READY wait */
+		if (w1_sim_now_ns() - start > 1000000)
+			rtos_contended++;
+		if (rtos_inside++)
+			rtos_overlaps++;
+		Status = AXI_1WIRE_HOST_RTOS_ResetBus(&rtos, &presence);
+		if (Status == XST_SUCCESS && presence == 0)
+			Status = AXI_1WIRE_HOST_RTOS_WriteByte(&rtos, 0x55);
+		for (i = 0; i < 8 && Status == XST_SUCCESS; i++)
+			Status = AXI_1WIRE_HOST_RTOS_WriteByte(&rtos, rom[i]);
+		if (Status == XST_SUCCESS)
+			Status = AXI_1WIRE_HOST_RTOS_WriteByte(&rtos, 0xBE);
+		for (i = 0; i < (int)sizeof(sp) && Status == XST_SUCCESS; i++)
+			Status = AXI_1WIRE_HOST_RTOS_ReadByte(&rtos, &sp[i]);
+		if (Status == XST_SUCCESS && presence == 0 && w1_crc8(0, sp, sizeof(sp)) == 0)
+			rtos_reads++;
+		rtos_inside--;
+		AXI_1WIRE_HOST_RTOS_Unlock(&rtos);
+		vTaskDelay(1);
+	}
+	vTaskDelete(NULL);
+}
+
+/* A wait with no interrupt coming must time out, after the instance timeout */
+static void rtos_check_timeout(XStatus Status, u64 start, u32 extra_ms, const char *what)
+{
+	u64 elapsed = w1_sim_now_ns() - start, timeout = (rtos.Timeout + extra_ms) * 1000000ULL;
+	char msg[64];
+
+	snprintf(msg, sizeof(msg), "RTOS %s timed out", what);
+	check(Status == XST_TIMEOUT && elapsed >= timeout && elapsed < timeout + 2000000, msg);
+	/* Clear GO, so READY comes back for the DONE wait of the next one */
+	AXI_1WIRE_HOST_mWriteReg(BUS0_BASE, AXI_1WIRE_HOST_CTRL_REG_OFFSET, 0);
+	vTaskDelay(1);
+}
+
+static void rtos_recover(void *arg)
+{
+	if (AXI_1WIRE_HOST_RTOS_ResetBus(&rtos, arg) != XST_SUCCESS)
+		*(u8 *)arg = 1;
+	vTaskDelete(NULL);
+}
+
+static void rtos_timeouts(void *arg)
+{
+	u8 value, presence = 1;
+	u64 start;
+
+	(void)arg;
+	start = w1_sim_now_ns();
+	rtos_check_timeout(AXI_1WIRE_HOST_RTOS_ResetBus(&rtos, &presence), start, 0, "reset");
+	start = w1_sim_now_ns();
+	rtos_check_timeout(AXI_1WIRE_HOST_RTOS_TouchBit(&rtos, 1, &value), start, 0, "read bit");
+	start = w1_sim_now_ns();
+	rtos_check_timeout(AXI_1WIRE_HOST_RTOS_TouchBit(&rtos, 0, &value), start, 0, "write bit");
+	start = w1_sim_now_ns();
+	rtos_check_timeout(AXI_1WIRE_HOST_RTOS_ReadByte(&rtos, &value), start, 0, "read byte");
+	start = w1_sim_now_ns();
+	rtos_check_timeout(AXI_1WIRE_HOST_RTOS_WriteByte(&rtos, 0xCC), start, 0, "write byte");
+	/* The conversion time, then the POLL_BIT instruction */
+	start = w1_sim_now_ns();
+	rtos_check_timeout(AXI_1WIRE_HOST_RTOS_WaitConversion(&rtos, 10), start, 20,
+			   "conversion wait");
+	start = w1_sim_now_ns();
+	rtos_check_timeout(AXI_1WIRE_HOST_RTOS_PioWrite(&rtos, pio.rom, 0xFF, NULL), start, 0,
+			   "PIO write");
+	/* GO left set: the READY wait of the next instruction */
+	AXI_1WIRE_HOST_RTOS_WriteByte(&rtos, 0xCC);
+	start = w1_sim_now_ns();
+	rtos_check_timeout(AXI_1WIRE_HOST_RTOS_WriteByte(&rtos, 0xCC), start, 0, "READY wait");
+	vTaskDelete(NULL);
+}
+
+/*
+ * The FreeRTOS port layer on the shims of w1_sim_rtos.c: two tasks of the
+ * same priority read the sensors of bus 0, then a task runs every primitive
+ * with the interrupt disconnected.
+ */
+static void run_rtos(void)
+{
+	struct phase p;
+	u8 presence = 1;
+
+	check(AXI_1WIRE_HOST_RTOS_Initialize(&rtos, BUS0_BASE, AXI_1WIRE_HOST_RTOS_TIMEOUT) ==
+	      XST_SUCCESS, "RTOS initialization");
+	w1_sim_rtos_connect(&bus0, AXI_1WIRE_HOST_RTOS_IntrHandler, &rtos);
+
+	phase_start(&p, "RTOS, 2 tasks, scratchpads", &bus0);
+	xTaskCreate(rtos_reader, "reader0", 1024, (void *)0, 1, NULL);
+	xTaskCreate(rtos_reader, "reader1", 1024, (void *)1, 1, NULL);
+	vTaskStartScheduler();
+	phase_end(&p);
+	check(rtos_reads == 2 * RTOS_TXNS, "RTOS scratchpads read");
+	check(rtos_overlaps == 0 && rtos_contended > 0, "RTOS bus mutex");
+
+	w1_sim_rtos_connect(&bus0, NULL, NULL);
+	xTaskCreate(rtos_timeouts, "timeouts", 1024, NULL, 1, NULL);
+	vTaskStartScheduler();
+
+	/* A reset recovers from the instruction left with GO set */
+	w1_sim_rtos_connect(&bus0, AXI_1WIRE_HOST_RTOS_IntrHandler, &rtos);
+	xTaskCreate(rtos_recover, "recover", 1024, &presence, 1, NULL);
+	vTaskStartScheduler();
+	check(presence == 0, "RTOS reset after the timeouts");
+	w1_sim_rtos_connect(&bus0, NULL, NULL);
+	AXI_1WIRE_HOST_mWriteReg(BUS0_BASE, AXI_1WIRE_HOST_IRQCTRL_REG_OFFSET, 0);
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+	unsigned long rd = W1_SIM_AXI_READ_NS, wr = W1_SIM_AXI_WRITE_NS;
+	int iterations = 0, suite = 0, i;
+#ifdef AXI_1WIRE_HOST_TRACE
+	const char *trace = NULL;
+#endif
+
+	for (i = 1; i < argc; i++) {
+		if (i + 1 < argc && strcmp(argv[i], "-b") == 0) {
+			iterations = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+			suite = atoi(argv[++i]);
+		} else if (i + 1 < argc && strcmp(argv[i], "-r") == 0) {
+			rd = strtoul(argv[++i], NULL, 0);
+		} else if (i + 1 < argc && strcmp(argv[i], "-w") == 0) {
+			wr = strtoul(argv[++i], NULL, 0);
+#ifdef AXI_1WIRE_HOST_TRACE
+		} else if (i + 1 < argc && strcmp(argv[i], "-t") == 0) {
+			trace = argv[++i];
+#endif
+		} else {
+			fprintf(stderr, "Usage: %s [-b iterations] [-s iterations] [-r axi_read_ns] "
+				"[-w axi_write_ns] [-t trace.bin]\n", argv[0]);
+			return 1;
+		}
+	}
+	w1_sim_set_costs(rd, wr, W1_SIM_TIMER_NS);
+
+	w1_sim_init(&bus0, BUS0_BASE);
+	w1_sim_init(&bus1, BUS1_BASE);
+	for (i = 0; i < 3; i++) {
+		w1_sim_ds18b20_init(&sensors[i], 0x000001A2B300ULL + i * 0x10001);
+		w1_sim_add_device(&bus0, &sensors[i]);
+	}
+	w1_sim_ds2431_init(&eeprom, 0x0000C0FFEE00ULL);
+	w1_sim_add_device(&bus0, &eeprom);
+	w1_sim_ds18b20_init(&parasite, 0x000000BEEF00ULL);
+	parasite.u.ds18b20.parasite = 1;
+	w1_sim_add_device(&bus1, &parasite);
+
+#ifdef AXI_1WIRE_HOST_TRACE
+	if (trace)
+		AXI_1WIRE_HOST_TraceStart(BUS0_BASE, trace_mem, sizeof(trace_mem));
+#endif
+	check(AXI_1WIRE_HOST_SelfTest(BUS0_BASE) == XST_SUCCESS, "self-test");
+	run_caps();
+	run_search();
+	run_conversion();
+	run_timing();
+	run_parasite();
+	run_eeprom();
+	run_stream();
+	run_eeprom_program();
+	run_switch();
+	run_romtable();
+#ifdef AXI_1WIRE_HOST_RTOS
+	run_rtos();
+#endif
+	if (iterations > 0)
+		AXI_1WIRE_HOST_SelfTestBenchmark(BUS0_BASE, iterations);
+	if (suite > 0)
+		check(benchmark_suite(BUS0_BASE, suite) == XST_SUCCESS, "benchmark suite");
+#ifdef AXI_1WIRE_HOST_TRACE
+	if (trace)
+		write_trace(trace);
+#endif
+
+	printf("%s, %d failed check(s)\n", failures ? "FAILED" : "PASSED", failures);
+	return failures;
+}
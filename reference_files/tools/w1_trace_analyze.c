@@ -0,0 +1,499 @@
+/*
+Copyright (C) 2024, Advanced Micro Devices, Inc. All rights reserved.
+SPDX-License-Identifier: MIT
+*/
+/*
+ * w1_trace_analyze: offline analysis of a bus trace recorded by the drivers,
+ * see w1_trace.h.
+ *
+ * Usage: w1_trace_analyze [-v] [-r] trace.bin
+ *   -v  print every primitive
+ *   -r  replay the primitives against the w1_sim model, with a model of each
+ *       DS18B20 and DS2431 addressed in the trace
+ *
+ * It reports:
+ *   - per instruction, the count, the IRQ and polled completions, the errors,
+ *     the READY wait and the time from the instruction write to DONE, with
+ *     the part of it above the bus time of w1_master.v
+ *   - the bus utilization: bus time of the primitives over the trace span
+ *   - the handshake gaps, from the end of a primitive to the instruction
+ *     write of the next one, the gaps over IDLE_NS counting as idle time
+ *   - per device (Match ROM, Skip ROM, searches), the transactions from a
+ *     reset to the next one, their latency and bus active time
+ *   - with -r, the time the model takes for the same primitives and the
+ *     data it reads that differ from the trace. The models start from their
+ *     defaults (85 C, blank memory), so the temperatures and the memory read
+ *     differ unless the trace wrote them first
+ *
+ * Build, from reference_files:
+ *   gcc -O2 -Isim/include -Isim -Icommon -Ibaremetal_driver/src tools/w1_trace_analyze.c
+ *       sim/w1_sim.c sim/w1_sim_bsp.c sim/w1_sim_devices.c
+ *       baremetal_driver/src/axi_1wire_host.c common/w1_crc.c common/w1_temp.c -o w1_trace_analyze
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "axi_1wire_host.h"
+#include "w1_sim.h"
+#include "w1_temp.h"
+#include "w1_trace.h"
+
+#define IDLE_NS		1000000ULL	/* Longer gaps are sleeps of the caller */
+#define MAX_DEVICES	64
+#define NOPS		7
+#define FAMILY_DS2431	0x2D
+
+enum { OP_INITPRES, OP_READBIT, OP_WRITEBIT, OP_READBYTE, OP_WRITEBYTE, OP_SPU, OP_POLLBIT };
+
+static const char *const op_names[NOPS] = {
+	"INITPRES", "READBIT", "WRITEBIT", "READBYTE", "WRITEBYTE", "WRITEBYTE+SPU", "POLLBIT",
+};
+
+/*
+ * Bus time of w1_master.v in us, GO to DONE. The recovery of the last slot
+ * overlaps the handshake of the next instruction.
+ */
+static const unsigned int op_done_us[NOPS] = { 961, 60, 60, 620, 620, 620, 60 };
+
+struct op_stats {
+	unsigned long count, irqs, errors;
+	uint64_t ready_ns, ready_max_ns;
+	uint64_t done_ns, done_max_ns;
+	uint64_t excess_ns;		/* GO to DONE above the bus time */
+};
+
+struct device {
+	char name[24];
+	unsigned long txns, errors;
+	uint64_t lat_ns, lat_max_ns;
+	uint64_t active_ns;
+};
+
+/* Transaction being decoded */
+struct txn {
+	int active;
+	uint8_t rom_cmd;
+	uint8_t rom[8];
+	int nrom;
+	uint64_t start_ns, end_ns, active_ns;
+	unsigned long errors;
+};
+
+static struct w1_trace_ring *ring;
+static struct w1_trace_rec *recs;
+static uint32_t nrecs;
+static struct device devices[MAX_DEVICES];
+static int ndevices;
+
+static int op_index(uint16_t instr)
+{
+	switch (instr & 0x0F00) {
+	case 0x0800:
+		return OP_INITPRES;
+	case 0x0C00:
+		return OP_READBIT;
+	case 0x0E00:
+		return OP_WRITEBIT;
+	case 0x0D00:
+		return OP_READBYTE;
+	case 0x0700:
+		return OP_POLLBIT;
+	default:
+		return (instr & 0x1000) ? OP_SPU : OP_WRITEBYTE;
+	}
+}
+
+static uint64_t ticks_ns(uint64_t ticks)
+{
+	return ring->clock_hz == 1000000000 ? ticks :
+	       ticks / ring->clock_hz * 1000000000ULL +
+	       ticks % ring->clock_hz * 1000000000ULL / ring->clock_hz;
+}
+
+static uint64_t rec_start(const struct w1_trace_rec *r)
+{
+	return ticks_ns(r->t);
+}
+
+static uint64_t rec_end(const struct w1_trace_rec *r)
+{
+	return ticks_ns(r->t + r->ready + r->done);
+}
+
+static int cmp_seq(const void *a, const void *b)
+{
+	uint32_t first = ring->head - ring->size;
+	uint32_t sa = ((const struct w1_trace_rec *)a)->seq - first;
+	uint32_t sb = ((const struct w1_trace_rec *)b)->seq - first;
+
+	return sa < sb ? -1 : sa > sb;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int load(const char *path)
+{
+	struct w1_trace_ring hdr;
+	FILE *f = fopen(path, "rb");
+	uint32_t i;
+
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+	if (fread(&hdr, sizeof(hdr), 1, f) != 1 || hdr.magic != W1_TRACE_MAGIC ||
+	    hdr.version != W1_TRACE_VERSION || hdr.rec_size != sizeof(struct w1_trace_rec) ||
+	    hdr.clock_hz == 0) {
+		fprintf(stderr, "%s: not a version %d bus trace\n", path, W1_TRACE_VERSION);
+		fclose(f);
+		return -1;
+	}
+	ring = malloc(W1_TRACE_RING_BYTES(hdr.size));
+	if (!ring) {
+		fclose(f);
+		return -1;
+	}
+	*ring = hdr;
+	ring->size = fread(ring->rec, sizeof(struct w1_trace_rec), hdr.size, f);
+	fclose(f);
+
+	/* Keep the valid records, oldest first */
+	recs = ring->rec;
+	for (i = 0; i < ring->size; i++)
+		if (w1_trace_valid(ring, &ring->rec[i]))
+			recs[nrecs++] = ring->rec[i];
+	qsort(recs, nrecs, sizeof(*recs), cmp_seq);
+	return 0;
+}
+
+static void print_rec(const struct w1_trace_rec *r)
+{
+	int op = op_index(r->instr);
+
+	printf("%10u %14.3f %-13s", r->seq, rec_start(r) / 1000.0, op_names[op]);
+	if (op == OP_WRITEBIT || op == OP_WRITEBYTE || op == OP_SPU)
+		printf(" tx %02x   ", r->instr & 0xFF);
+	else if (op == OP_INITPRES)
+		printf(" %-8s", r->rx ? "absent" : "present");
+	else
+		printf("    rx %02x", r->rx);
+	printf(" ready %9.3f us, done %9.3f us %s%s%s\n", ticks_ns(r->ready) / 1000.0,
+	       ticks_ns(r->done) / 1000.0, r->flags & W1_TRACE_IRQ ? "irq" : "poll",
+	       r->flags & W1_TRACE_CHAINED ? " chained" : "",
+	       r->flags & W1_TRACE_ERROR ? " ERROR" : "");
+}
+
+static struct device *device_get(const char *name)
+{
+	int i;
+
+	for (i = 0; i < ndevices; i++)
+		if (strcmp(devices[i].name, name) == 0)
+			return &devices[i];
+	if (ndevices == MAX_DEVICES)
+		return NULL;
+	snprintf(devices[ndevices].name, sizeof(devices[ndevices].name), "%s", name);
+	return &devices[ndevices++];
+}
+
+static void txn_end(struct txn *t)
+{
+	struct device *d;
+	char name[24];
+	uint64_t lat;
+
+	if (!t->active)
+		return;
+	t->active = 0;
+
+	switch (t->rom_cmd) {
+	case 0x55:
+		if (t->nrom < 8)
+			snprintf(name, sizeof(name), "match (truncated)");
+		else
+			snprintf(name, sizeof(name), "%02x-%02x%02x%02x%02x%02x%02x", t->rom[0],
+				 t->rom[6], t->rom[5], t->rom[4], t->rom[3], t->rom[2], t->rom[1]);
+		break;
+	case 0xCC:
+		snprintf(name, sizeof(name), "skip rom");
+		break;
+	case 0xF0:
+		snprintf(name, sizeof(name), "search rom");
+		break;
+	case 0xEC:
+		snprintf(name, sizeof(name), "alarm search");
+		break;
+	case 0x33:
+		snprintf(name, sizeof(name), "read rom");
+		break;
+	case 0:
+		snprintf(name, sizeof(name), "reset only");
+		break;
+	default:
+		snprintf(name, sizeof(name), "rom cmd %02x", t->rom_cmd);
+		break;
+	}
+
+	d = device_get(name);
+	if (!d)
+		return;
+	lat = t->end_ns - t->start_ns;
+	d->txns++;
+	d->errors += t->errors;
+	d->lat_ns += lat;
+	if (lat > d->lat_max_ns)
+		d->lat_max_ns = lat;
+	d->active_ns += t->active_ns;
+}
+
+/* Follow the ROM layer of the transactions */
+static void txn_add(struct txn *t, const struct w1_trace_rec *r)
+{
+	int op = op_index(r->instr);
+
+	if (op == OP_INITPRES) {
+		txn_end(t);
+		memset(t, 0, sizeof(*t));
+		t->active = 1;
+		t->start_ns = rec_start(r);
+	} else if (!t->active) {
+		return;
+	} else if (t->rom_cmd == 0 && (op == OP_WRITEBYTE || op == OP_SPU)) {
+		t->rom_cmd = r->instr & 0xFF;
+	} else if (t->rom_cmd == 0x55 && t->nrom < 8 && op == OP_WRITEBYTE) {
+		t->rom[t->nrom++] = r->instr & 0xFF;
+	}
+	t->end_ns = rec_end(r);
+	t->active_ns += ticks_ns(r->ready + r->done);
+	if (r->flags & W1_TRACE_ERROR)
+		t->errors++;
+}
+
+static void percentiles(uint64_t *v, size_t n, const char *what)
+{
+	if (n == 0) {
+		printf("%-28s none\n", what);
+		return;
+	}
+	qsort(v, n, sizeof(*v), cmp_u64);
+	printf("%-28s %8zu, p50 %9.3f us, p99 %9.3f us, max %9.3f us\n", what, n,
+	       v[n / 2] / 1000.0, v[(n * 99) / 100] / 1000.0, v[n - 1] / 1000.0);
+}
+
+static void analyze(int verbose)
+{
+	struct op_stats ops[NOPS];
+	uint64_t bus_ns = 0, idle_ns = 0, span, *gaps;
+	size_t ngaps = 0, nidle = 0;
+	struct txn t;
+	uint32_t i;
+	int op;
+
+	memset(ops, 0, sizeof(ops));
+	memset(&t, 0, sizeof(t));
+	gaps = calloc(nrecs ? nrecs : 1, sizeof(*gaps));
+	if (!gaps)
+		return;
+
+	if (verbose)
+		printf("%10s %14s %s\n", "seq", "start us", "primitive");
+	for (i = 0; i < nrecs; i++) {
+		const struct w1_trace_rec *r = &recs[i];
+		struct op_stats *s;
+		uint64_t ready = ticks_ns(r->ready), done = ticks_ns(r->done);
+
+		if (verbose)
+			print_rec(r);
+
+		op = op_index(r->instr);
+		s = &ops[op];
+		s->count++;
+		s->irqs += (r->flags & W1_TRACE_IRQ) != 0;
+		s->errors += (r->flags & W1_TRACE_ERROR) != 0;
+		s->ready_ns += ready;
+		if (ready > s->ready_max_ns)
+			s->ready_max_ns = ready;
+		s->done_ns += done;
+		if (done > s->done_max_ns)
+			s->done_max_ns = done;
+		/* The strong pull-up and the slots of a POLL_BIT are bus time */
+		if (op == OP_SPU || op == OP_POLLBIT)
+			bus_ns += done;
+		else
+			bus_ns += op_done_us[op] * 1000ULL;
+		if (op != OP_SPU && op != OP_POLLBIT && done > op_done_us[op] * 1000ULL)
+			s->excess_ns += done - op_done_us[op] * 1000ULL;
+
+		/* End of the previous primitive to the instruction write of this one */
+		if (i > 0 && recs[i - 1].seq + 1 == r->seq) {
+			uint64_t end = rec_end(&recs[i - 1]);
+			uint64_t issue = ticks_ns(r->t + r->ready);
+
+			if (issue >= end && issue - end > IDLE_NS) {
+				idle_ns += issue - end;
+				nidle++;
+			} else if (issue >= end) {
+				gaps[ngaps++] = issue - end;
+			}
+		}
+		txn_add(&t, r);
+	}
+	txn_end(&t);
+
+	span = nrecs ? rec_end(&recs[nrecs - 1]) - rec_start(&recs[0]) : 0;
+	printf("%u primitives over %.3f ms, %s clock at %u Hz\n", nrecs, span / 1e6,
+	       ring->head != nrecs ? "oldest records overwritten," : "complete,",
+	       ring->clock_hz);
+
+	printf("\n%-14s %8s %6s %6s %10s %10s %10s %10s %10s\n", "instruction", "count", "irq",
+	       "errors", "ready avg", "ready max", "done avg", "done max", "excess avg");
+	for (op = 0; op < NOPS; op++) {
+		struct op_stats *s = &ops[op];
+
+		if (!s->count)
+			continue;
+		printf("%-14s %8lu %6lu %6lu %10.3f %10.3f %10.3f %10.3f %10.3f\n", op_names[op],
+		       s->count, s->irqs, s->errors, s->ready_ns / 1000.0 / s->count,
+		       s->ready_max_ns / 1000.0, s->done_ns / 1000.0 / s->count,
+		       s->done_max_ns / 1000.0,
+		       op == OP_SPU || op == OP_POLLBIT ? 0.0 : s->excess_ns / 1000.0 / s->count);
+	}
+	printf("(times in us, excess: instruction write to DONE above the bus time of the IP)\n");
+
+	printf("\nbus utilization             %8.3f %% (%.3f ms of bus time)\n",
+	       span ? bus_ns * 100.0 / span : 0.0, bus_ns / 1e6);
+	if (span > idle_ns)
+		printf("   without the idle time    %8.3f %%\n", bus_ns * 100.0 / (span - idle_ns));
+	percentiles(gaps, ngaps, "handshake gaps");
+	printf("%-28s %8zu, %.3f ms\n", "idle periods over 1 ms", nidle, idle_ns / 1e6);
+
+	printf("\n%-18s %8s %6s %12s %12s %12s\n", "device", "txns", "errors", "latency avg",
+	       "latency max", "active avg");
+	for (i = 0; i < (uint32_t)ndevices; i++) {
+		struct device *d = &devices[i];
+
+		printf("%-18s %8lu %6lu %12.3f %12.3f %12.3f\n", d->name, d->txns, d->errors,
+		       d->lat_ns / 1000.0 / d->txns, d->lat_max_ns / 1000.0,
+		       d->active_ns / 1000.0 / d->txns);
+	}
+	printf("(times in us, from a reset to the end of the last primitive before the next one)\n");
+	free(gaps);
+}
+
+/* Replay the primitives on the model, idle periods included */
+static void replay(void)
+{
+	static struct w1_sim sim;
+	static struct w1_sim_device models[MAX_DEVICES];
+	uint32_t base = XPAR_AXI_1WIRE_HOST_0_BASEADDR;
+	unsigned long mismatches = 0;
+	uint64_t start, serial, traced;
+	int nmodels = 0, i, j;
+	uint32_t k;
+
+	w1_sim_init(&sim, base);
+	for (i = 0; i < ndevices && nmodels < MAX_DEVICES; i++) {
+		unsigned int family, b[6];
+
+		if (sscanf(devices[i].name, "%2x-%2x%2x%2x%2x%2x%2x", &family, &b[5], &b[4], &b[3],
+			   &b[2], &b[1], &b[0]) != 7)
+			continue;
+		for (serial = 0, j = 5; j >= 0; j--)
+			serial = (serial << 8) | b[j];
+		if (family == W1_FAMILY_DS18B20)
+			w1_sim_ds18b20_init(&models[nmodels], serial);
+		else if (family == FAMILY_DS2431)
+			w1_sim_ds2431_init(&models[nmodels], serial);
+		else
+			continue;
+		w1_sim_add_device(&sim, &models[nmodels++]);
+	}
+
+	start = w1_sim_now_ns();
+	for (k = 0; k < nrecs; k++) {
+		const struct w1_trace_rec *r = &recs[k];
+		int op = op_index(r->instr);
+		uint8_t rx = 0;
+
+		if (k > 0 && recs[k - 1].seq + 1 == r->seq) {
+			uint64_t end = rec_end(&recs[k - 1]), issue = ticks_ns(r->t + r->ready);
+
+			if (issue >= end && issue - end > IDLE_NS)
+				w1_sim_advance_ns(issue - end);
+		}
+
+		switch (op) {
+		case OP_INITPRES:
+			rx = AXI_1WIRE_HOST_ResetBus(base);
+			break;
+		case OP_READBIT:
+			rx = AXI_1WIRE_HOST_TouchBit(base, 1);
+			break;
+		case OP_WRITEBIT:
+			AXI_1WIRE_HOST_TouchBit(base, r->instr & 1);
+			break;
+		case OP_READBYTE:
+			rx = AXI_1WIRE_HOST_ReadByte(base);
+			break;
+		case OP_WRITEBYTE:
+			AXI_1WIRE_HOST_WriteByte(base, r->instr & 0xFF);
+			break;
+		case OP_SPU:
+			AXI_1WIRE_HOST_WriteByteStrongPullup(base, r->instr & 0xFF,
+				ticks_ns(r->done) / 1000 > op_done_us[op] ?
+				ticks_ns(r->done) / 1000 - op_done_us[op] : 0);
+			break;
+		case OP_POLLBIT:
+			/* Slots 1 ms apart for the traced time, rx is the timeout bit */
+			rx = !AXI_1WIRE_HOST_PollBit(base, 1000, ticks_ns(r->done) / 1000000 + 1);
+			break;
+		}
+		if ((op == OP_INITPRES || op == OP_READBIT || op == OP_READBYTE) && rx != r->rx) {
+			if (mismatches++ == 0)
+				printf("first data mismatch at seq %u: trace %02x, model %02x\n",
+				       r->seq, r->rx, rx);
+		}
+	}
+
+	traced = nrecs ? rec_end(&recs[nrecs - 1]) - rec_start(&recs[0]) : 0;
+	printf("\nreplay on the model with %d device(s): %.3f ms for %.3f ms traced, "
+	       "%lu data mismatch(es)\n", nmodels, (w1_sim_now_ns() - start) / 1e6, traced / 1e6,
+	       mismatches);
+	printf("   model bus time %.3f ms, %llu AXI reads, %llu AXI writes\n",
+	       sim.stats.bus_ns / 1e6, (unsigned long long)sim.stats.axi_reads,
+	       (unsigned long long)sim.stats.axi_writes);
+}
+
+int main(int argc, char *argv[])
+{
+	int verbose = 0, do_replay = 0, i;
+	const char *path = NULL;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-v") == 0)
+			verbose = 1;
+		else if (strcmp(argv[i], "-r") == 0)
+			do_replay = 1;
+		else if (!path && argv[i][0] != '-')
+			path = argv[i];
+		else
+			break;
+	}
+	if (!path || i < argc) {
+		fprintf(stderr, "Usage: %s [-v] [-r] trace.bin\n", argv[0]);
+		return 1;
+	}
+
+	if (load(path) != 0)
+		return 1;
+	analyze(verbose);
+	if (do_replay)
+		replay();
+	free(ring);
+	return 0;
+}